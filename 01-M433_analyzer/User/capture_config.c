@@ -0,0 +1,65 @@
+#include "capture_config.h"
+#include "protocol_store.h"
+
+//! The published configuration and the spare one
+static captureConfig_t		configs[2] = {
+	{ .filter = { .name = "Global" } },
+	{ .filter = { .name = "Global" } }
+};
+
+captureSettings_t			captureSettings = {
+	.enabled		= CAPTURE_ALL_DECODERS,
+	.minSentenceLen	= MIN_SENTENCE_LEN,
+	.numJokers		= NUM_JOKERS,
+	.jokerPeriod	= JOKER_PERIOD
+};
+
+// Empty until the first rebuild: the filter accepts no pulse
+const captureConfig_t * volatile	captureConfig = &configs[0];
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Build a configuration from captureSettings and the loaded protocols, and publish it
+ *
+ * The global filter is the union of the requirements of the enabled decoders,
+ * widened by the loaded protocols.
+ *
+ * @param[in]	decoders	Built-in decoders, indexed as in DECODER_TABLE
+ * @return The published configuration
+ * @remark Called from the main loop only: the receiver interrupt keeps reading
+ * the previous configuration until the pointer is written
+ */
+const captureConfig_t *captureConfig_rebuild(const decoderDesc_t * const *decoders, uint8_t nbDecoders)
+{
+	captureConfig_t	*next = (captureConfig == &configs[0] ? &configs[1] : &configs[0]);
+	uint8_t			i;
+	
+	
+	next->settings	= captureSettings;
+	next->decoders	= captureSettings.enabled & ~protoStore_disabledBuiltins();
+	
+	next->filter.minPulseLen	= 0xFFFFFFFF;
+	next->filter.maxPulseLen	= 0;
+	next->filter.minNumPulses	= 0xFFFF;
+	for (i = 0; i < nbDecoders; i++)
+	{
+		if ((next->decoders & DECODER_BIT(i)) == 0) {
+			continue;
+		}
+		if (decoders[i]->minPulseLen < next->filter.minPulseLen) {
+			next->filter.minPulseLen = decoders[i]->minPulseLen;
+		}
+		if (decoders[i]->maxPulseLen > next->filter.maxPulseLen) {
+			next->filter.maxPulseLen = decoders[i]->maxPulseLen;
+		}
+		if (decoders[i]->minNumPulses < next->filter.minNumPulses) {
+			next->filter.minNumPulses = decoders[i]->minNumPulses;
+		}
+	}
+	protoStore_widenFilter(&next->filter);
+	
+	// A single write: the interrupt sees either configuration, never a mix
+	captureConfig = next;
+	return next;
+}
@@ -0,0 +1,46 @@
+#ifndef CAPTURE_CONFIG_H
+#define CAPTURE_CONFIG_H
+
+#include "main.h"
+
+/*
+ * Run time configuration of the capture.
+ *
+ * The receiver interrupt reads the global filter, the recorder settings and
+ * the decoders to call from captureConfig. They change at run time (commands,
+ * see command.h; stored protocols, see protocol_store.h): the main loop edits
+ * captureSettings, then builds a whole new configuration into a spare buffer
+ * and publishes it with a single pointer write. The interrupt reads the
+ * pointer once per pulse, so it always sees a consistent configuration, the
+ * old one or the new one, and is never masked.
+ */
+
+//! Recorder settings, the defaults come from defines.h
+typedef struct {
+	decoderMask_t	enabled;			// Built-in decoders enabled by the user
+	uint32_t		minSentenceLen;		// MIN_SENTENCE_LEN
+	uint8_t			numJokers;			// NUM_JOKERS
+	uint16_t		jokerPeriod;		// JOKER_PERIOD, never 0
+} captureSettings_t;
+
+//! Configuration read by the receiver interrupt
+typedef struct {
+	captureSettings_t	settings;
+	decoderDesc_t		filter;			// Global pulse filter
+	decoderMask_t		decoders;		// Built-in decoders to call: enabled, and not disabled by the store
+} captureConfig_t;
+
+//! All the built-in decoders
+#define CAPTURE_ALL_DECODERS	((decoderMask_t)(DECODER_BIT(NUM_DECODERS - 1) * 2 - 1))
+
+//! Settings being edited, applied by captureConfig_rebuild()
+extern captureSettings_t				captureSettings;
+
+//! Published configuration
+extern const captureConfig_t * volatile	captureConfig;
+
+
+const captureConfig_t	*captureConfig_rebuild(const decoderDesc_t * const *decoders, uint8_t nbDecoders);
+
+
+#endif // CAPTURE_CONFIG_H
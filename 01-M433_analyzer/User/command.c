@@ -0,0 +1,316 @@
+#include <string.h>
+#include <stdlib.h>
+#include "command.h"
+#include "capture_config.h"
+#include "protocol_store.h"
+#include "frame_cache.h"
+#include "sentence_queue.h"
+#include "budget.h"
+#include "stream.h"
+#include "record.h"
+#include "esp8266.h"
+
+// End of a command line
+#define IS_END(c)			((c) == '\0' || (c) == '\r' || (c) == '\n')
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Send a reply line
+ */
+static void command_reply(commandReplyFunc_t reply, const char *status, const char *detail, uint32_t value)
+{
+	char	line[64];
+	
+	
+	snprintf(line, sizeof(line), "CMD,%s,%s,%lu\n", status, detail, (unsigned long)value);
+	reply(line);
+}
+
+/*!
+ * @brief Match a word at the start of a line
+ * @return The rest of the line, past the word and its separator, or NULL if the word doesn't match
+ */
+static const char *command_word(const char *line, const char *word)
+{
+	size_t	len = strlen(word);
+	
+	
+	if (strncmp(line, word, len) != 0) {
+		return NULL;
+	}
+	line += len;
+	
+	if (*line == ' ') {
+		return line + 1;
+	}
+	return (IS_END(*line) ? line : NULL);
+}
+
+/*!
+ * @brief Parse a decimal value ending the line
+ * @return 1 if the value is within [min, max]
+ */
+static uint8_t command_value(const char *arg, uint32_t min, uint32_t max, uint32_t *value)
+{
+	char			*end;
+	unsigned long	parsed;
+	
+	
+	if (arg == NULL || *arg < '0' || *arg > '9') {
+		return 0;
+	}
+	parsed = strtoul(arg, &end, 10);
+	if (!IS_END(*end) || parsed < min || parsed > max) {
+		return 0;
+	}
+	*value = (uint32_t)parsed;
+	return 1;
+}
+
+/*!
+ * @brief Enable or disable decoders
+ * @param[in]	arg		Decoder name, or ALL
+ * @return COMMAND_REBUILD if the name is known
+ */
+static uint8_t command_enable(const char *arg, uint8_t enable, const decoderDesc_t * const *decoders, uint8_t nbDecoders, commandReplyFunc_t reply)
+{
+	decoderMask_t	mask = 0;
+	uint8_t			i;
+	
+	
+	if (command_word(arg, "ALL") != NULL) {
+		mask = CAPTURE_ALL_DECODERS;
+	}
+	for (i = 0; mask == 0 && i < nbDecoders; i++)
+	{
+		if (command_word(arg, (const char *)decoders[i]->name) != NULL) {
+			mask = DECODER_BIT(i);
+		}
+	}
+	
+	if (mask == 0)
+	{
+		command_reply(reply, "ERROR", "DECODER", 0);
+		return 0;
+	}
+	
+	if (enable) {
+		captureSettings.enabled |= mask;
+	} else {
+		captureSettings.enabled &= ~mask;
+	}
+	command_reply(reply, "OK", (enable ? "ENABLE" : "DISABLE"), captureSettings.enabled);
+	return COMMAND_REBUILD;
+}
+
+/*!
+ * @brief Change a recorder setting
+ * @return COMMAND_REBUILD if the setting was changed
+ */
+static uint8_t command_set(const char *arg, commandReplyFunc_t reply)
+{
+	const char	*valueArg;
+	uint32_t	value;
+	
+	
+	if ((valueArg = command_word(arg, "MIN_SENTENCE_LEN")) != NULL)
+	{
+		if (command_value(valueArg, 0, 0xFFFFFFFF, &value))
+		{
+			captureSettings.minSentenceLen = value;
+			command_reply(reply, "OK", "MIN_SENTENCE_LEN", value);
+			return COMMAND_REBUILD;
+		}
+	}
+	else if ((valueArg = command_word(arg, "NUM_JOKERS")) != NULL)
+	{
+		if (command_value(valueArg, 0, 0xFF, &value))
+		{
+			captureSettings.numJokers = (uint8_t)value;
+			command_reply(reply, "OK", "NUM_JOKERS", value);
+			return COMMAND_REBUILD;
+		}
+	}
+	else if ((valueArg = command_word(arg, "JOKER_PERIOD")) != NULL)
+	{
+		if (command_value(valueArg, 1, MAX_NUM_PULSES, &value))
+		{
+			captureSettings.jokerPeriod = (uint16_t)value;
+			command_reply(reply, "OK", "JOKER_PERIOD", value);
+			return COMMAND_REBUILD;
+		}
+	}
+	else
+	{
+		command_reply(reply, "ERROR", "SETTING", 0);
+		return 0;
+	}
+	
+	command_reply(reply, "ERROR", "VALUE", 0);
+	return 0;
+}
+
+/*!
+ * @brief Dump the counters
+ */
+static void command_stats(const decoderDesc_t * const *decoders, uint8_t nbDecoders, commandReplyFunc_t reply)
+{
+	char			detail[DEC_MAX_NAME_LEN + 16];
+	const char		*name;
+	budgetStats_t	*stats;
+	uint8_t			i;
+	
+	
+	command_reply(reply, "OK", "FrameCacheHits", frameCacheHits);
+	command_reply(reply, "OK", "OutputSuppressed", outputSuppressed);
+	command_reply(reply, "OK", "Queued", sentenceQueueStats.queued);
+	command_reply(reply, "OK", "Shed", sentenceQueueStats.shed);
+	command_reply(reply, "OK", "ShedNoise", sentenceQueueStats.shedNoise);
+	command_reply(reply, "OK", "MaxDepth", sentenceQueueStats.maxDepth);
+#ifdef USE_STREAM_DECODERS
+	command_reply(reply, "OK", "StreamLost", streamLost);
+#endif
+	command_reply(reply, "OK", "TxDropped", uartTxStats.dropped);
+	command_reply(reply, "OK", "TxDroppedBytes", uartTxStats.droppedBytes);
+	command_reply(reply, "OK", "TxMaxUsed", uartTxStats.maxUsed);
+	command_reply(reply, "OK", "RecordsEmitted", recordStats.emitted);
+	command_reply(reply, "OK", "RecordsMerged", recordStats.merged);
+	command_reply(reply, "OK", "RecordsLost", recordStats.lost);
+	
+	// Metering of the decoders which were called
+	for (i = 0; i < BUDGET_NB_SLOTS; i++)
+	{
+		stats = &budgetStats[i];
+		if (stats->calls == 0 && stats->skipped == 0) {
+			continue;
+		}
+		name = (i < nbDecoders ? (const char *)decoders[i]->name : (i == BUDGET_SLOT_STORE ? "Store" : "Default"));
+	
+		snprintf(detail, sizeof(detail), "%s.Calls", name);
+		command_reply(reply, "OK", detail, stats->calls);
+		snprintf(detail, sizeof(detail), "%s.Overruns", name);
+		command_reply(reply, "OK", detail, stats->overruns);
+		snprintf(detail, sizeof(detail), "%s.Aborts", name);
+		command_reply(reply, "OK", detail, stats->aborts);
+		snprintf(detail, sizeof(detail), "%s.Skipped", name);
+		command_reply(reply, "OK", detail, stats->skipped);
+		snprintf(detail, sizeof(detail), "%s.MaxCycles", name);
+		command_reply(reply, "OK", detail, stats->maxCycles);
+	}
+	command_reply(reply, "OK", "STATS", 0);
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Run a CMD command line
+ *
+ * Only captureSettings is changed: the caller rebuilds the capture
+ * configuration (captureConfig_rebuild()) to apply it.
+ *
+ * @param[in]	decoders	Built-in decoders, indexed as in DECODER_TABLE
+ * @param[in]	reply		Function sending the reply lines
+ * @return COMMAND_REBUILD if captureSettings changed
+ */
+uint8_t command_run(const char *line, const decoderDesc_t * const *decoders, uint8_t nbDecoders, commandReplyFunc_t reply)
+{
+	const char	*arg;
+	uint8_t		i;
+	
+	
+	if ((line = command_word(line, "CMD")) == NULL) {
+		return 0;
+	}
+	
+	if (command_word(line, "LIST") != NULL)
+	{
+		for (i = 0; i < nbDecoders; i++) {
+			command_reply(reply, "OK", (const char *)decoders[i]->name, (captureSettings.enabled & DECODER_BIT(i)) != 0);
+		}
+		command_reply(reply, "OK", "LIST", nbDecoders);
+	}
+	else if ((arg = command_word(line, "ENABLE")) != NULL)
+	{
+		return command_enable(arg, 1, decoders, nbDecoders, reply);
+	}
+	else if ((arg = command_word(line, "DISABLE")) != NULL)
+	{
+		return command_enable(arg, 0, decoders, nbDecoders, reply);
+	}
+	else if ((arg = command_word(line, "SET")) != NULL)
+	{
+		return command_set(arg, reply);
+	}
+	else if (command_word(line, "GET") != NULL)
+	{
+		command_reply(reply, "OK", "MIN_SENTENCE_LEN", captureSettings.minSentenceLen);
+		command_reply(reply, "OK", "NUM_JOKERS", captureSettings.numJokers);
+		command_reply(reply, "OK", "JOKER_PERIOD", captureSettings.jokerPeriod);
+	}
+	else if (command_word(line, "STATS") != NULL)
+	{
+		command_stats(decoders, nbDecoders, reply);
+	}
+	else
+	{
+		command_reply(reply, "ERROR", "COMMAND", 0);
+	}
+	
+	return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Reply on the computer UART
+ */
+static void command_replyUart(const char *line)
+{
+	uartTx_write(line, strlen(line));
+}
+
+#ifdef USE_ESP8266
+/*!
+ * @brief Reply to the syslog host
+ */
+static void command_replyWifi(const char *line)
+{
+	esp8266_syslog((char *)line);
+}
+#endif
+
+/*!
+ * @brief Run a command line of any module
+ */
+static uint8_t command_dispatch(const char *line, const decoderDesc_t * const *decoders, uint8_t nbDecoders, commandReplyFunc_t reply)
+{
+	uint8_t	changes = command_run(line, decoders, nbDecoders, reply);
+	
+	
+	if (protoStore_command(line, reply)) {
+		changes |= COMMAND_RELOAD;
+	}
+	return changes;
+}
+
+/*!
+ * @brief Run the command lines received on the computer UART and from the syslog host
+ * @return What the lines changed (COMMAND_*)
+ * @remark Called from the main loop
+ */
+uint8_t command_poll(const decoderDesc_t * const *decoders, uint8_t nbDecoders)
+{
+	char	line[PROTO_STORE_LINE_LEN];
+	uint8_t	changes = 0;
+	
+	
+	while (TM_USART_Gets(COMPUTER_UART, line, sizeof(line)) > 0) {
+		changes |= command_dispatch(line, decoders, nbDecoders, command_replyUart);
+	}
+#ifdef USE_ESP8266
+	while (esp8266_receive(line, sizeof(line)) > 0) {
+		changes |= command_dispatch(line, decoders, nbDecoders, command_replyWifi);
+	}
+#endif
+	
+	return changes;
+}
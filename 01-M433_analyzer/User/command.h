@@ -0,0 +1,34 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "main.h"
+
+/*
+ * Commands received on the computer UART, or in UDP datagrams from the syslog
+ * host when USE_ESP8266 is defined. The main loop reads them one line at a
+ * time, never the receiver interrupt. Each line is answered by "CMD,OK,..."
+ * or "CMD,ERROR,..." lines (<detail>,<value>), on the link it came from:
+ * 		CMD LIST					List the built-in decoders (value: 1 if enabled)
+ * 		CMD ENABLE <name>|ALL		Enable a built-in decoder
+ * 		CMD DISABLE <name>|ALL		Disable a built-in decoder
+ * 		CMD SET <setting> <value>	Change MIN_SENTENCE_LEN, NUM_JOKERS or JOKER_PERIOD
+ * 		CMD GET						List the settings
+ * 		CMD STATS					Dump the counters
+ * The global filter only covers the enabled decoders and the stored protocols.
+ * The protocol store lines (PSTORE ..., see protocol_store.h) are read by the
+ * same poll.
+ */
+
+//! Send a reply line
+typedef void (*commandReplyFunc_t)(const char *line);
+
+//! What a command line changed
+#define COMMAND_REBUILD		1		// captureSettings: the capture configuration must be rebuilt
+#define COMMAND_RELOAD		2		// The stored protocols: they must be loaded again
+
+
+uint8_t	command_run(const char *line, const decoderDesc_t * const *decoders, uint8_t nbDecoders, commandReplyFunc_t reply);
+uint8_t	command_poll(const decoderDesc_t * const *decoders, uint8_t nbDecoders);
+
+
+#endif // COMMAND_H
@@ -0,0 +1,150 @@
+#ifndef BITVEC_H
+#define BITVEC_H
+
+#include "decoder.h"
+
+/*
+ * Bit accumulator for the decoders.
+ *
+ * Bits are appended to a 32 bits accumulator, which is stored as a whole word
+ * when full. Once the frame is complete, bitvec_finish() left-aligns the last
+ * word: the first bit received is then the MSB of words[0], as with the rawData
+ * values of the 32 bits decoders.
+ *
+ * Fields (up to 32 bits), nibbles and bytes can then be extracted at any bit
+ * offset, MSB first, or LSB first for the protocols sending their values
+ * backwards.
+ */
+
+//! Maximum number of bits in a frame
+#define BITVEC_MAX_BITS		256
+#define BITVEC_MAX_WORDS	(BITVEC_MAX_BITS / 32)
+
+typedef struct {
+	uint32_t	words[BITVEC_MAX_WORDS + 1];	// One spare word, so that fields can always read 2 words
+	uint32_t	acc;							// Bits of the current word, right-aligned
+	uint16_t	nbBits;
+} bitvec_t;
+
+
+// Cortex-M3/M4 have a single-cycle bit reversal instruction. Define BITVEC_PORTABLE
+// to build the decoders on another target (e.g. a host computer)
+#if defined(__CORTEX_M) && (__CORTEX_M >= 0x03) && !defined(BITVEC_PORTABLE)
+	#define bitvec_reverse(x)	__RBIT(x)
+#else
+static __INLINE uint32_t bitvec_reverse(uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+	x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);
+	x = ((x >> 8) & 0x00FF00FF) | ((x & 0x00FF00FF) << 8);
+	return (x >> 16) | (x << 16);
+}
+#endif
+
+
+static __INLINE void bitvec_reset(bitvec_t *v)
+{
+	v->acc		= 0;
+	v->nbBits	= 0;
+}
+
+static __INLINE uint8_t bitvec_full(const bitvec_t *v)
+{
+	return (v->nbBits >= BITVEC_MAX_BITS);
+}
+
+/*!
+ * @brief Append one bit (0 or 1). The caller must check bitvec_full() first
+ */
+static __INLINE void bitvec_append(bitvec_t *v, uint32_t bit)
+{
+	v->acc = (v->acc << 1) | bit;
+	
+	if ((++v->nbBits & 31) == 0) {
+		v->words[(v->nbBits >> 5) - 1] = v->acc;
+	}
+}
+
+/*!
+ * @brief Append the nbBits (1 to 32) LSBs of value, MSB first
+ */
+static __INLINE void bitvec_appendBits(bitvec_t *v, uint32_t value, uint8_t nbBits)
+{
+	uint8_t	used = v->nbBits & 31,
+			room = 32 - used;
+	
+	
+	if (nbBits < 32) {
+		value &= (1UL << nbBits) - 1;
+	}
+	
+	if (nbBits < room)
+	{
+		v->acc = (v->acc << nbBits) | value;
+	}
+	else
+	{
+		// Complete the current word, keep the remaining bits in the accumulator
+		v->words[v->nbBits >> 5] = (room == 32 ? value : (v->acc << room) | (value >> (nbBits - room)));
+		v->acc = value;
+	}
+	v->nbBits += nbBits;
+}
+
+/*!
+ * @brief Store the last word, and clear the following ones: bits past the end read as 0
+ */
+static __INLINE void bitvec_finish(bitvec_t *v)
+{
+	uint16_t	i = v->nbBits >> 5;
+	uint8_t		used = v->nbBits & 31;
+	
+	
+	if (used) {
+		v->words[i++] = v->acc << (32 - used);
+	}
+	for (; i <= BITVEC_MAX_WORDS; i++) {
+		v->words[i] = 0;
+	}
+}
+
+/*!
+ * @brief Extract a field, MSB first
+ * @param[in]	offset	Offset of the first bit of the field (< BITVEC_MAX_BITS)
+ * @param[in]	len		Field length (1 to 32 bits)
+ */
+static __INLINE uint32_t bitvec_field(const bitvec_t *v, uint16_t offset, uint8_t len)
+{
+	uint8_t		shift = offset & 31;
+	uint32_t	value = v->words[offset >> 5] << shift;
+	
+	
+	if (shift) {
+		value |= v->words[(offset >> 5) + 1] >> (32 - shift);
+	}
+	return value >> (32 - len);
+}
+
+/*!
+ * @brief Extract a field sent LSB first
+ */
+static __INLINE uint32_t bitvec_fieldLsb(const bitvec_t *v, uint16_t offset, uint8_t len)
+{
+	return bitvec_reverse(bitvec_field(v, offset, len)) >> (32 - len);
+}
+
+/*!
+ * @brief Flip a bit of a finished vector
+ */
+static __INLINE void bitvec_flip(bitvec_t *v, uint16_t i)
+{
+	v->words[i >> 5] ^= (0x80000000UL >> (i & 31));
+}
+
+#define bitvec_bit(v, i)		bitvec_field((v), (i), 1)
+#define bitvec_nibble(v, i)		bitvec_field((v), 4 * (i), 4)
+#define bitvec_byte(v, i)		bitvec_field((v), 8 * (i), 8)
+
+
+#endif // BITVEC_H
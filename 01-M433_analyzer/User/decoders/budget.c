@@ -0,0 +1,130 @@
+#include "budget.h"
+
+#ifdef BUDGET_PORTABLE
+	#define budget_cycles()		budgetFakeCycles
+#else
+	#define budget_cycles()		(DWT->CYCCNT)
+#endif
+
+//! No call being metered
+#define NO_SLOT					0xFF
+
+STATIC_ASSERT(BUDGET_NB_SLOTS < NO_SLOT);
+
+
+budgetStats_t		budgetStats[BUDGET_NB_SLOTS];
+
+#ifdef BUDGET_PORTABLE
+volatile uint32_t	budgetFakeCycles = 0;
+#endif
+
+//! Call being metered
+static uint8_t		slot = NO_SLOT;
+static uint8_t		expired;
+static uint32_t		start, allowance;
+
+//! Start of the current sentence, and whether one of its calls was stopped or skipped
+static uint32_t		sentenceStart;
+static uint8_t		sentenceCut;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Start the cycle counter
+ */
+void budget_init(void)
+{
+#ifndef BUDGET_PORTABLE
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	slot = NO_SLOT;
+}
+
+/*!
+ * @brief Start the budget of a sentence, before its first decoder
+ */
+void budget_startSentence(void)
+{
+	sentenceStart	= budget_cycles();
+	sentenceCut		= 0;
+}
+
+/*!
+ * @brief Start metering a call
+ * @return 1 if the call can be made, 0 if the sentence budget is spent
+ */
+uint8_t budget_start(uint8_t s)
+{
+	uint32_t	now = budget_cycles();
+	uint32_t	spent = now - sentenceStart;
+	
+	
+	if (spent >= BUDGET_SENTENCE_CYCLES)
+	{
+		budgetStats[s].skipped++;
+		sentenceCut = 1;
+		return 0;
+	}
+	
+	slot		= s;
+	start		= now;
+	expired		= 0;
+	allowance	= BUDGET_SENTENCE_CYCLES - spent;
+	if (allowance > BUDGET_DECODER_CYCLES) {
+		allowance = BUDGET_DECODER_CYCLES;
+	}
+	return 1;
+}
+
+/*!
+ * @brief Check if the call being metered is over its budget
+ * @return 1 if the call must stop (it is then counted as aborted)
+ * @remark Always 0 when no call is metered, e.g. in the host tools
+ */
+uint8_t budget_expired(void)
+{
+	if (slot != NO_SLOT && !expired && budget_cycles() - start > allowance)
+	{
+		expired		= 1;
+		sentenceCut	= 1;
+	}
+	return expired;
+}
+
+/*!
+ * @brief Stop metering a call, and update the stats of its slot
+ */
+void budget_stop(void)
+{
+	budgetStats_t	*stats;
+	uint32_t		elapsed = budget_cycles() - start;
+	
+	
+	if (slot == NO_SLOT) {
+		return;
+	}
+	stats = &budgetStats[slot];
+	
+	stats->calls++;
+	if (elapsed > stats->maxCycles) {
+		stats->maxCycles = elapsed;
+	}
+	if (elapsed > allowance) {
+		stats->overruns++;
+	}
+	stats->aborts += expired;
+	
+	slot = NO_SLOT;
+}
+
+/*!
+ * @brief Check if the decoding of the current sentence is incomplete
+ * @return 1 if one of its calls was stopped by budget_expired(), or skipped
+ * because the sentence budget was spent
+ */
+uint8_t budget_sentenceExhausted(void)
+{
+	return sentenceCut;
+}
@@ -0,0 +1,54 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include "decoder.h"
+
+/*
+ * Cycle budget of the decoders.
+ *
+ * While the decoders run, the sentences being received pile up in the sentence
+ * queue: every call is metered with the DWT cycle counter. A call may use
+ * BUDGET_DECODER_CYCLES, and all the calls on a sentence BUDGET_SENTENCE_CYCLES.
+ * Once the sentence budget is spent, the remaining decoders are skipped.
+ *
+ * Decoders can't be preempted: the long loops (frame after frame, the scans of
+ * the default decoder) check budget_expired() and stop when it returns 1. Calls
+ * which went over their budget, were stopped or skipped are counted per
+ * decoder. The result of a sentence one of whose calls was stopped or skipped
+ * is incomplete (budget_sentenceExhausted()): it must not stand for the
+ * repeats of the sentence.
+ *
+ * Define BUDGET_PORTABLE to meter on another target: the cycle counter is then
+ * budgetFakeCycles, which the caller advances itself.
+ */
+
+//! Metering slots: the built-in decoders (DECODER_INDEX_*), then these ones
+#define BUDGET_SLOT_STORE		NUM_DECODERS			// Protocols of the store
+#define BUDGET_SLOT_DEFAULT		(NUM_DECODERS + 1)		// Default decoder
+#define BUDGET_NB_SLOTS			(NUM_DECODERS + 2)
+
+//! Metering of a slot
+typedef struct {
+	uint32_t	calls;
+	uint32_t	overruns;		// Calls which went over their budget
+	uint32_t	aborts;			// Calls stopped by budget_expired()
+	uint32_t	skipped;		// Calls not made, the sentence budget being spent
+	uint32_t	maxCycles;		// Longest call
+} budgetStats_t;
+
+extern budgetStats_t	budgetStats[BUDGET_NB_SLOTS];
+
+#ifdef BUDGET_PORTABLE
+extern volatile uint32_t	budgetFakeCycles;
+#endif
+
+
+void	budget_init(void);
+void	budget_startSentence(void);
+uint8_t	budget_start(uint8_t slot);
+uint8_t	budget_expired(void);
+void	budget_stop(void);
+uint8_t	budget_sentenceExhausted(void);
+
+
+#endif // BUDGET_H
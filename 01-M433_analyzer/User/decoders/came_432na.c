@@ -1,5 +1,6 @@
 #include "main.h"
-#include "generic_rcswitch.h"
+#include "generic_pwm.h"
+#include "record.h"
 
 /*******************************************************************************
  * CAME432 DECODER                                                             *
@@ -11,8 +12,7 @@
  * DATA:
  *  	Similar to RCSwitch (fixed pair length with a 1/3-2/3 ratio)
  *      The pair begins with a low pulse, then a high pulse (instead of high-then-low),
- *      this is why we use decode_2ndPulse_rcswitch_sentence() instead of the default
- *      rcswitch decoder
+ *      this is why the bit is given by the 2nd pulse of each pair (PWM_BIT_SECOND)
  *
  ******************
  * INTERPRETATION *
@@ -30,8 +30,13 @@
 #define MIN_LONG_LEN	600
 #define MAX_LONG_LEN	750
 
-#define MIN_SYNC_LEN	14600	// Measured: 15.6ms
-#define MAX_SYNC_LEN	16600
+#define NOMINAL_SYNC_LEN	15600	// Measured: 15.6ms
+#define MIN_SYNC_LEN	PWM_SYNC_MIN(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+#define MAX_SYNC_LEN	PWM_SYNC_MAX(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+
+// Clock drift accepted (%): the sync gives the timebase of each frame
+#define DRIFT_TOLERANCE	20
+#define MIN_PULSE_LEN	(MIN_SHORT_LEN * (100 - DRIFT_TOLERANCE) / 100)
 
 // #define MIN_PAIR_LEN	900		// Measured: 1.009ms
 // #define MAX_PAIR_LEN	1100
@@ -41,33 +46,67 @@
 #define PROLOGUE		(rawData & 0x80000000)
 
 
-static uint16_t decode_came432(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_came432(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_Came432Na = 
+const decoderDesc_t decoder_Came432Na = 
 {
 	.name 			= "Came432Na",
-	.minPulseLen  	= MIN_SHORT_LEN,
+	.minPulseLen  	= MIN_PULSE_LEN,
 	.maxPulseLen  	= MAX_SYNC_LEN,
 	.minNumPulses 	= MIN_NUM_PULSES,
 	.decoderFunc	= decode_came432
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_CAME_432NA, MIN_PULSE_LEN, MAX_SYNC_LEN, MIN_NUM_PULSES);
+
+
+static const pwmProtocol_t came432Protocol =
+{
+	.syncShape		= PWM_SYNC_LOW,
+	.sync			= { MIN_SYNC_LEN, MAX_SYNC_LEN },
+	.nominalSync	= NOMINAL_SYNC_LEN,
+	.encoding		= PWM_BIT_SECOND,
+	.first			= PWM_ANY_PULSE,
+	.shortPulse		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.longPulse		= { MIN_LONG_LEN, MAX_LONG_LEN },
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 0,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+
+//! Records: code, and partial code
+static const recordType_t	recordCode = {
+	.format		= "%s,%db,0x%08X\n",
+	.nbValues	= 2,
+	.fields		= { "Length", "Data" }
+};
+static const recordType_t	recordPartial = {
+	.format		= "%s,%db,x%08X\n",
+	.nbValues	= 2,
+	.fields		= { "Length", "Data" }
+};
+
 
-static uint8_t interpret_came432(uint32_t rawData, uint8_t nbBits)
+static uint8_t interpret_came432(const pwmFrame_t *frame)
 {
+	uint32_t	rawData	= frame->bits.words[0];
+	uint16_t	nbBits	= frame->bits.nbBits;
+	
 	if (nbBits == 13 && PROLOGUE)
 	{
-		PRINTF("%s,%db,0x%08X\n", decoder_Came432Na.name, nbBits-1, rawData << 1);
+		record_emitBits((const char *)decoder_Came432Na.name, &recordCode, &frame->bits, nbBits-1, rawData << 1);
 		return 1;
 	}
 	else if (nbBits == 12)
 	{
-		PRINTF("%s,%db,0x%08X\n", decoder_Came432Na.name, nbBits, rawData);
+		record_emitBits((const char *)decoder_Came432Na.name, &recordCode, &frame->bits, nbBits, rawData);
 		return 1;
 	}
 	else if (nbBits >= 8)
 	{
-		PRINTF("%s,%db,x%08X\n", decoder_Came432Na.name, nbBits, rawData);
+		record_emitBits((const char *)decoder_Came432Na.name, &recordPartial, &frame->bits, nbBits, rawData);
 		return 1;
 	}
 	else
@@ -76,70 +115,7 @@ static uint8_t interpret_came432(uint32_t rawData, uint8_t nbBits)
 	}
 }
 
-static uint16_t decode_2ndPulse_rcswitch_sentence(uint32_t *pulseLens, uint16_t nbPulses, ui32InterpreterFunc_t dataHandler, uint32_t revert)
+static uint16_t decode_came432(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	i,
-				dataBitOffset	= RAW_DATA_LEN; // Bits to receive
-	uint32_t	rawData 		= 0;
-		
-	
-	// Each bit can be:
-	// short low+long high (1)
-	// long low+short high (0)
-	for (i = 0; i < nbPulses-1; i += 2)
-	{
-		if (IS_SHORT(pulseLens[i+1]))
-		{
-			rawData |= (revert << --dataBitOffset);
-		}
-		else if (IS_LONG(pulseLens[i+1]))
-		{
-			rawData |= ((1 - revert) << --dataBitOffset);
-		}
-		else
-		{
-			// Pulse len is invalid
-			break;
-		}
-		
-		if (!dataBitOffset)
-		{
-			i += 2;
-			break;
-		}
-	}
-	
-	if (dataHandler(rawData, RAW_DATA_LEN - dataBitOffset))
-	{
-		return i;
-	}
-	
-	return 0;
+	return PWM_DECODE_SENTENCE(&came432Protocol, pulseLens, nbPulses, interpret_came432);
 }
-
-
-static uint16_t decode_came432(uint32_t *pulseLens, uint16_t nbPulses)
-{
-	uint16_t	result = 0;
-	uint16_t	syncOffset = 0;
-	
-	while (nbPulses - syncOffset > MIN_NUM_PULSES)
-	{	
-		if (IS_SYNC(pulseLens[syncOffset+1]))
-		{
-			// Valid sync pulses found - try and decode the sentence 
-			// start @syncOffset+2)
-			syncOffset += 2;			
-			result = decode_2ndPulse_rcswitch_sentence(pulseLens + syncOffset, nbPulses - syncOffset, interpret_came432, 0);
-			syncOffset += result;
-		}
-		else
-		{
-			syncOffset += 2;
-		}
-	}
-	
-	return (result > 0);
-}
-
-
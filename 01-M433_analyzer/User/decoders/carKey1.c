@@ -1,5 +1,8 @@
 #include "main.h"
 #include "decoder.h"
+#include "generic_pwm.h"
+#include "keeloq.h"
+#include "record.h"
 
 /*******************************************************************************
  * CARKEY1 DECODER (Unknown model, seems to be a rolling code or keeloq)       *
@@ -9,12 +12,15 @@
  * SYNC:
  * 		A pair of pulses with an expected total len
  * DATA:
- *  	Similar to RCSwitch
+ *  	Similar to RCSwitch: short high + long low gives a 1, long high + short
+ *      low gives a 0 (KeeLoq convention)
  *
  ******************
  * INTERPRETATION *
  ******************
- * Expected: 64 data bits
+ * Expected: 64 data bits (66 with the status bits), split into the KeeLoq fields
+ * (see keeloq.h). Each fob is tracked, and only the first frame of a button press
+ * is printed.
  */
 
 
@@ -24,120 +30,106 @@
 #define MIN_LONG_LEN	1100
 #define MAX_LONG_LEN	1300
 
-#define MIN_SYNC_LEN	2900
-#define MAX_SYNC_LEN	3100
+#define NOMINAL_SYNC_LEN	3000	// Sync pair
+#define MIN_SYNC_LEN	PWM_SYNC_MIN(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+#define MAX_SYNC_LEN	PWM_SYNC_MAX(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
 
-#define RAW_DATA_LEN	64	// bits
+// Clock drift accepted (%): the sync gives the timebase of each frame
+#define DRIFT_TOLERANCE	20
+#define MIN_PULSE_LEN	(MIN_SHORT_LEN * (100 - DRIFT_TOLERANCE) / 100)
+
+#define RAW_DATA_LEN	KEELOQ_MAX_BITS
 #define MIN_NUM_PULSES	130	// at least 64b + 2 sync pulses
 
 
-static uint16_t decode_CarKey1(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_CarKey1(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_CarKey1 =
+const decoderDesc_t decoder_CarKey1 =
 {
 	.name			= "CarKey1",
-	.minPulseLen  	= MIN_SHORT_LEN,
+	.minPulseLen  	= MIN_PULSE_LEN,
 	.maxPulseLen  	= MAX_SYNC_LEN,
 	.minNumPulses 	= MIN_NUM_PULSES,
 	.decoderFunc	= decode_CarKey1
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_CARKEY_1, MIN_PULSE_LEN, MAX_SYNC_LEN, MIN_NUM_PULSES);
+
+
+static const pwmProtocol_t carKey1Protocol =
+{
+	.syncShape		= PWM_SYNC_PAIR,
+	.sync			= { MIN_SYNC_LEN, MAX_SYNC_LEN },
+	.nominalSync	= NOMINAL_SYNC_LEN,
+	.encoding		= PWM_BIT_BOTH,
+	.shortPulse		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.longPulse		= { MIN_LONG_LEN, MAX_LONG_LEN },
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 1,
+	.flags			= PWM_FIRST_FRAME_ONLY,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+//! Records: short frame, KeeLoq frame, and decrypted KeeLoq frame
+static const recordType_t	recordRaw = {
+	.format		= "%s,%d,%08X%08X\n",
+	.nbValues	= 3,
+	.fields		= { "Length", "Data", "Data2" }
+};
+static const recordType_t	recordKeeloq = {
+	.format		= "%s,Serial=0x%07X,Buttons=0x%X,Hop=0x%08X,LowBattery=%d,Presses=%d\n",
+	.nbValues	= 5,
+	.fields		= { "Serial", "Buttons", "Hop", "LowBattery", "Presses" }
+};
+static const recordType_t	recordDecrypted = {
+	.format		= "%s,Serial=0x%07X,Buttons=0x%X,Hop=0x%08X,LowBattery=%d,Presses=%d,Counter=%d,Valid=%d,Gap=%d,MaxGap=%d\n",
+	.nbValues	= 9,
+	.fields		= { "Serial", "Buttons", "Hop", "LowBattery", "Presses", "Counter", "Valid", "Gap", "MaxGap" }
+};
+
 
-static uint8_t interpret_CarKey1(uint32_t rawData, uint32_t rawData2, uint8_t nbBits)
+static uint8_t interpret_CarKey1(const pwmFrame_t *frame)
 {
+	uint32_t		rawData		= frame->bits.words[0],
+					rawData2	= frame->bits.words[1];
+	uint16_t		nbBits		= frame->bits.nbBits;
+	keeloqFrame_t	keeloq;
+	keeloqFob_t		*fob;
+	
 	if (nbBits < 12)
 	{
 		return 0;
 	}
 	
-	if (nbBits == 64)
+	if (nbBits < KEELOQ_MIN_BITS)
 	{
-		PRINTF("%s,%08X%08X\n", decoder_CarKey1.name, rawData, rawData2);
+		record_emitBits((const char *)decoder_CarKey1.name, &recordRaw, &frame->bits, nbBits, rawData, rawData2);
+		return 1;
 	}
-	else
+	
+	keeloq_parse(&frame->bits, &keeloq);
+	fob = keeloq_track(&keeloq);
+	if (fob == NULL)
 	{
-		PRINTF("%s,%d,%08X%08X\n", decoder_CarKey1.name, nbBits, rawData, rawData2);
+		// Repeat of a press which has already been printed
+		return 1;
 	}
-	return 1;
-}
-
-/*!
- * @param[in]	pulseLens	Durations of the pulses to decode
- * @param[in]	nbPulses	Number of pulses in pulseLens
- * @return		Number of pulses used, starting from offset 0
- */
-static uint16_t decode_synced_CarKey1(uint32_t *pulseLens, uint16_t nbPulses)
-{
-	uint16_t	i,
-				dataByteOffset  = 0,
-				dataBitOffset	= 32; // Bits to receive
-	uint32_t	rawData[2]		= {0, 0};
-
 	
-	// Each bit can be:
-	// short low+long high (1)
-	// long low+short high (0)
-	for (i = 0; i < nbPulses-1; i += 2)
+	if (keeloq.decrypted)
 	{
-		if (IS_SHORT(pulseLens[i]) && IS_LONG(pulseLens[i+1]))
-		{
-			--dataBitOffset;
-		}
-		else if (IS_LONG(pulseLens[i]) && IS_SHORT(pulseLens[i+1]))
-		{
-			rawData[dataByteOffset] |= (1 << --dataBitOffset);
-		}
-		else
-		{
-			// Pulse len is invalid
-			break;
-		}
-		
-		if (dataBitOffset == 0)
-		{
-			dataBitOffset = 32;
-			dataByteOffset++;
-		}
-		
-		if (dataByteOffset == 2)
-		{
-			i += 2;
-			break;
-		}
+		record_emitBits((const char *)decoder_CarKey1.name, &recordDecrypted, &frame->bits, keeloq.serial, keeloq.buttons,
+			keeloq.hop, keeloq.lowBattery, fob->presses, keeloq.counter, keeloq.valid, fob->gap, fob->maxGap);
 	}
-	
-	if (interpret_CarKey1(rawData[0], rawData[1], (32*dataByteOffset)+(32-dataBitOffset)))
+	else
 	{
-		return i;
+		record_emitBits((const char *)decoder_CarKey1.name, &recordKeeloq, &frame->bits, keeloq.serial, keeloq.buttons,
+			keeloq.hop, keeloq.lowBattery, fob->presses);
 	}
-	
-	return 0;
+	return 1;
 }
 
-static uint16_t decode_CarKey1(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_CarKey1(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	result = 0;
-	uint16_t	syncOffset = 0;
-	
-	while (nbPulses - syncOffset > MIN_NUM_PULSES)
-	{	
-		if (IS_SYNC(pulseLens[syncOffset] + pulseLens[syncOffset+1]))
-		{
-			// Valid sync pulses found - try and decode the sentence 
-			syncOffset += 2;
-			result = decode_synced_CarKey1(pulseLens + syncOffset, nbPulses - syncOffset);
-			syncOffset += result;
-		}
-		else
-		{
-			syncOffset += 2;
-		}
-		
-		if (result > 0) {
-			break;
-		}
-	}
-	
-	return (result > 0);
+	return PWM_DECODE_SENTENCE(&carKey1Protocol, pulseLens, nbPulses, interpret_CarKey1);
 }
-
@@ -0,0 +1,67 @@
+#include "combine.h"
+
+
+//! Combined frame (shared by the decoders, which are never run concurrently)
+static uint16_t	combined[COMBINE_MAX_PULSES];
+
+
+/*!
+ * @brief Combine the copies of a frame repeated in a sentence
+ *
+ * The frame length is the shortest distance between two consecutive sync
+ * offsets. The last copy is only used if the sentence holds it completely.
+ *
+ * @param[in]	pulseLens		Durations of the pulses of the sentence
+ * @param[in]	nbPulses		Number of pulses in pulseLens
+ * @param[in]	frameOffsets	Offset of the sync pulses of each copy, in increasing order
+ * @param[in]	nbFrames		Number of offsets in frameOffsets
+ * @param[out]	frameLen		Number of pulses in the combined frame
+ * @return		The combined frame (sync pulses included), or NULL if there are not
+ *				enough copies
+ */
+uint16_t *combine_frames(uint16_t *pulseLens, uint16_t nbPulses, const uint16_t *frameOffsets, uint8_t nbFrames, uint16_t *frameLen)
+{
+	uint16_t	i, len = COMBINE_MAX_PULSES;
+	uint8_t		j, k, nbCopies;
+	uint32_t	values[COMBINE_MAX_FRAMES], v;
+	
+	
+	if (nbFrames < COMBINE_MIN_FRAMES) {
+		return NULL;
+	}
+	if (nbFrames > COMBINE_MAX_FRAMES) {
+		nbFrames = COMBINE_MAX_FRAMES;
+	}
+	
+	for (j = 0; j < nbFrames - 1; j++)
+	{
+		if (frameOffsets[j+1] - frameOffsets[j] < len) {
+			len = frameOffsets[j+1] - frameOffsets[j];
+		}
+	}
+	
+	nbCopies = nbFrames;
+	if (nbPulses - frameOffsets[nbFrames-1] < len) {
+		nbCopies--;
+	}
+	if (nbCopies < COMBINE_MIN_FRAMES) {
+		return NULL;
+	}
+	
+	// Median of each pulse: insertion sort of the copies
+	for (i = 0; i < len; i++)
+	{
+		for (j = 0; j < nbCopies; j++)
+		{
+			v = pulseLens[frameOffsets[j] + i];
+			for (k = j; k > 0 && values[k-1] > v; k--) {
+				values[k] = values[k-1];
+			}
+			values[k] = v;
+		}
+		combined[i] = values[nbCopies / 2];
+	}
+	
+	*frameLen = len;
+	return combined;
+}
@@ -0,0 +1,29 @@
+#ifndef COMBINE_H
+#define COMBINE_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*
+ * Transmitters repeat their frames several times in a sentence. Instead of
+ * decoding each copy on its own (and losing the frame if every copy has one bad
+ * pulse), the copies are aligned on their sync pulses and combined: each pulse
+ * of the combined frame is the median of the matching pulses of the copies.
+ * The combined frame is then decoded and interpreted once.
+ */
+
+//! Minimum number of copies needed to combine a frame
+#define COMBINE_MIN_FRAMES	3
+
+//! Maximum number of copies combined
+#define COMBINE_MAX_FRAMES	8
+
+//! Maximum length of a combined frame: the longest PWM frame (2 pulses per bit,
+//! see generic_pwm.h) and its sync pulses
+#define COMBINE_MAX_PULSES	(2 * BITVEC_MAX_BITS + 2)
+
+
+uint16_t *combine_frames(uint16_t *pulseLens, uint16_t nbPulses, const uint16_t *frameOffsets, uint8_t nbFrames, uint16_t *frameLen);
+
+
+#endif // COMBINE_H
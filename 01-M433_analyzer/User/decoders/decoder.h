@@ -38,11 +38,8 @@
 //! Maximum length of the decoder "friendly name"
 #define DEC_MAX_NAME_LEN	16
 
-//! Maximum count of decoders handled by the analyzer
-#define	MAX_DECODERS		16
-
 //! Recurrent function prototypes
-typedef uint16_t (*decoderFunc_t)(uint32_t *pulseLens, uint16_t nbPulses);
+typedef uint16_t (*decoderFunc_t)(uint16_t *pulseLens, uint16_t nbPulses);
 typedef uint8_t (*ui32InterpreterFunc_t)(uint32_t rawData, uint8_t nbBits);
 
 //! Decoder description structure
@@ -55,62 +52,169 @@ typedef struct {
 } decoderDesc_t;
 
 
-// Known decoders
+/*
+ * Compile-time assertion, usable at file scope
+ */
+#define STATIC_ASSERT_CAT_(a, b)	a ## b
+#define STATIC_ASSERT_CAT(a, b)		STATIC_ASSERT_CAT_(a, b)
+#define STATIC_ASSERT(cond)			typedef char STATIC_ASSERT_CAT(static_assert_, __LINE__)[(cond) ? 1 : -1]
+
+
+/*******************************************************************************
+ * Decoder table
+ *******************************************************************************
+ * Every known decoder has a row (descriptor, minPulseLen, maxPulseLen, minNumPulses).
+ * The enabled ones are listed by DECODER_TABLE(X), which calls X once per row.
+ * This table is expanded at compile time to build the decoder list, the decoder
+ * count, the global filter and the dispatch masks: nothing is registered at boot.
+ *
+ * The limits of a row must match the decoder description: each decoder checks
+ * its own row with DECODER_CHECK_LIMITS().
+ */
+
+//										descriptor				minPulseLen	maxPulseLen	minNumPulses
+#define DECODER_ROW_OREGON_EW91			(decoder_OregonEW91,	1300,		4500,		66)
+#define DECODER_ROW_OREGON_V2			(decoder_OregonV2,		200,		1200,		150)
+#define DECODER_ROW_RCSWITCH			(decoder_RCSwitch,		300,		15500,		50)
+#define DECODER_ROW_HOME_EASY			(decoder_HomeEasy,		150,		1400,		48)
+#define DECODER_ROW_X10_RF				(decoder_X10Rf,			320,		12000,		64)
+#define DECODER_ROW_CAME_432NA			(decoder_Came432Na,		240,		18720,		26)
+#define DECODER_ROW_DIP_SWITCH			(decoder_dipSwitch,		488,		31200,		28)
+#define DECODER_ROW_CARKEY_1			(decoder_CarKey1,		320,		3600,		130)
+#define DECODER_ROW_SIEMENS_VDO			(decoder_siemensVdo,	150,		4000,		32)
+
+// Call X with the fields of a row
+#define DECODER_APPLY(X, row)			X row
+
 #ifdef USE_OREGON_EW91
-	extern decoderDesc_t decoder_OregonEW91;
-	#define REGISTER_OREGON_EW91	registerDecoder(&decoder_OregonEW91);
+	#define DECODER_OREGON_EW91(X)	DECODER_APPLY(X, DECODER_ROW_OREGON_EW91)
 #else
-	#define REGISTER_OREGON_EW91
+	#define DECODER_OREGON_EW91(X)
 #endif
 
 #ifdef USE_OREGON_V2
-	extern decoderDesc_t decoder_OregonV2;
-	#define REGISTER_OREGON_V2	registerDecoder(&decoder_OregonV2);
+	#define DECODER_OREGON_V2(X)	DECODER_APPLY(X, DECODER_ROW_OREGON_V2)
 #else
-	#define REGISTER_OREGON_V2
+	#define DECODER_OREGON_V2(X)
 #endif
 
 #ifdef USE_RCSWITCH
-	extern decoderDesc_t decoder_RCSwitch;
-	#define REGISTER_RCSWITCH	registerDecoder(&decoder_RCSwitch);
+	#define DECODER_RCSWITCH(X)		DECODER_APPLY(X, DECODER_ROW_RCSWITCH)
 #else
-	#define REGISTER_RCSWITCH
+	#define DECODER_RCSWITCH(X)
 #endif
 
 #ifdef USE_HOME_EASY
-	extern decoderDesc_t decoder_HomeEasy;
-	#define REGISTER_HOME_EASY	registerDecoder(&decoder_HomeEasy);
+	#define DECODER_HOME_EASY(X)	DECODER_APPLY(X, DECODER_ROW_HOME_EASY)
 #else
-	#define REGISTER_HOME_EASY
+	#define DECODER_HOME_EASY(X)
 #endif
 
-#ifdef USE_CAME_432NA
-	extern decoderDesc_t decoder_Came432Na;
-	#define REGISTER_CAME_432NA	registerDecoder(&decoder_Came432Na);
+#ifdef USE_X10_RF
+	#define DECODER_X10_RF(X)		DECODER_APPLY(X, DECODER_ROW_X10_RF)
 #else
-	#define REGISTER_CAME_432NA
+	#define DECODER_X10_RF(X)
 #endif
 
-#ifdef USE_CARKEY_1
-	extern decoderDesc_t decoder_CarKey1;
-	#define REGISTER_CARKEY_1	registerDecoder(&decoder_CarKey1);
+#ifdef USE_CAME_432NA
+	#define DECODER_CAME_432NA(X)	DECODER_APPLY(X, DECODER_ROW_CAME_432NA)
 #else
-	#define REGISTER_CARKEY_1
+	#define DECODER_CAME_432NA(X)
 #endif
 
 #ifdef USE_DIP_SWITCH
-	extern decoderDesc_t decoder_dipSwitch;
-	#define REGISTER_DIP_SWITCH	registerDecoder(&decoder_dipSwitch);
+	#define DECODER_DIP_SWITCH(X)	DECODER_APPLY(X, DECODER_ROW_DIP_SWITCH)
+#else
+	#define DECODER_DIP_SWITCH(X)
+#endif
+
+#ifdef USE_CARKEY_1
+	#define DECODER_CARKEY_1(X)		DECODER_APPLY(X, DECODER_ROW_CARKEY_1)
 #else
-	#define REGISTER_DIP_SWITCH
+	#define DECODER_CARKEY_1(X)
 #endif
 
 #ifdef USE_SIEMENS_VDO
-	extern decoderDesc_t decoder_siemensVdo;
-	#define REGISTER_SIEMENS_VDO	registerDecoder(&decoder_siemensVdo);
+	#define DECODER_SIEMENS_VDO(X)	DECODER_APPLY(X, DECODER_ROW_SIEMENS_VDO)
 #else
-	#define REGISTER_SIEMENS_VDO
+	#define DECODER_SIEMENS_VDO(X)
 #endif
 
+//! Enabled decoders, in the order they are called
+#define DECODER_TABLE(X) \
+	/* Sensors */ \
+	DECODER_OREGON_EW91(X) \
+	DECODER_OREGON_V2(X) \
+	/* Home automation */ \
+	DECODER_RCSWITCH(X) \
+	DECODER_HOME_EASY(X) \
+	DECODER_X10_RF(X) \
+	/* Garage doors */ \
+	DECODER_CAME_432NA(X) \
+	DECODER_DIP_SWITCH(X) \
+	/* Car key fobs */ \
+	DECODER_CARKEY_1(X) \
+	DECODER_SIEMENS_VDO(X)
+
+
+/*
+ * Table expansion helpers
+ */
+#define DECODER_EXTERN(desc, minLen, maxLen, minNum)		extern const decoderDesc_t desc;
+#define DECODER_ADDRESS(desc, minLen, maxLen, minNum)		&desc,
+#define DECODER_INDEX(desc, minLen, maxLen, minNum)			DECODER_INDEX_ ## desc,
+
+/*
+ * The global filter limits are folded with unions of char arrays: the size of
+ * such a union is the size of its largest member. Minimums are folded as
+ * (DECODER_LIMIT_CEIL - largest (DECODER_LIMIT_CEIL - value)).
+ */
+#define DECODER_LIMIT_CEIL									0x10000
+#define DECODER_MIN_PULSE_LEN_MEMBER(desc, minLen, maxLen, minNum)	char desc[DECODER_LIMIT_CEIL - (minLen)];
+#define DECODER_MAX_PULSE_LEN_MEMBER(desc, minLen, maxLen, minNum)	char desc[maxLen];
+#define DECODER_MIN_NUM_PULSES_MEMBER(desc, minLen, maxLen, minNum)	char desc[DECODER_LIMIT_CEIL - (minNum)];
+#define DECODER_FOLD(member)								sizeof(union { char none_; DECODER_TABLE(member) })
+
+// A decoder is called on a sentence holding more than minNumPulses pulses
+#define DECODER_DISPATCH_BIT(desc, minLen, maxLen, minNum)	((nbPulses > (minNum)) ? DECODER_BIT(DECODER_INDEX_ ## desc) : 0) |
+
+// Check a row against the constants used by the decoder description
+#define DECODER_CHECK_ROW(desc, minLen, maxLen, minNum, descMinLen, descMaxLen, descMinNum) \
+	STATIC_ASSERT((minLen) == (descMinLen) && (maxLen) == (descMaxLen) && (minNum) == (descMinNum))
+#define DECODER_ROW_FIELDS(desc, minLen, maxLen, minNum)	desc, minLen, maxLen, minNum
+#define DECODER_CHECK_LIMITS(row, descMinLen, descMaxLen, descMinNum) \
+	DECODER_APPLY(DECODER_CHECK_ROW, (DECODER_APPLY(DECODER_ROW_FIELDS, row), descMinLen, descMaxLen, descMinNum))
+
+
+// Declare the enabled decoders
+DECODER_TABLE(DECODER_EXTERN)
+
+//! Decoder indexes in the table, and number of enabled decoders
+enum {
+	DECODER_TABLE(DECODER_INDEX)
+	NUM_DECODERS
+};
+
+//! Set of decoders, one bit per decoder index
+typedef uint32_t decoderMask_t;
+
+#define DECODER_BIT(index)		((decoderMask_t)1 << (index))
+
+STATIC_ASSERT(NUM_DECODERS <= 8 * sizeof(decoderMask_t));
+
+//! Global filter: union of the requirements of all the enabled decoders
+#define GLOBAL_MIN_PULSE_LEN	((uint32_t)(DECODER_LIMIT_CEIL - DECODER_FOLD(DECODER_MIN_PULSE_LEN_MEMBER)))
+#define GLOBAL_MAX_PULSE_LEN	((uint32_t)DECODER_FOLD(DECODER_MAX_PULSE_LEN_MEMBER))
+#define GLOBAL_MIN_NUM_PULSES	((uint16_t)(DECODER_LIMIT_CEIL - DECODER_FOLD(DECODER_MIN_NUM_PULSES_MEMBER)))
+
+/*!
+ * @brief Get the decoders to call on a sentence of nbPulses pulses
+ * @remark Every row is a constant, so this folds down to a few comparisons
+ */
+static __INLINE decoderMask_t decoder_dispatchMask(uint16_t nbPulses)
+{
+	return DECODER_TABLE(DECODER_DISPATCH_BIT) 0;
+}
+
 
 #endif // DECODER_H
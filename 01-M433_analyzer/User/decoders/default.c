@@ -1,16 +1,21 @@
 #include "main.h"
 #include "generic_rcswitch.h"
+#include "generic_manchester.h"
+#include "learner.h"
+#include "budget.h"
+#include "record.h"
 
 
 #define MIN_SYNC_LEN	1000
 #define MAX_SYNC_LEN	100000
 
-#define PULSE_TOLERANCE	0.15	// Pulse len tolerance
+#define PULSE_TOLERANCE	15		// Pulse len tolerance (%)
 
 #undef 	IS_PAIR
 #define	IS_PAIR(n)		((n) > minPairLen && (n) < maxPairLen)
 
-#define SIMILAR(v,ref)	(((double)v / (double)ref) > (1-PULSE_TOLERANCE) && ((double)v / (double)ref) < (1+PULSE_TOLERANCE))
+// v/ref within 1 +/- PULSE_TOLERANCE, cross-multiplied (pulse lens fit in 16 bits, no overflow)
+#define SIMILAR(v,ref)	(100 * (v) > (100-PULSE_TOLERANCE) * (ref) && 100 * (v) < (100+PULSE_TOLERANCE) * (ref))
 
 #define MIN_NUM_PAIRS	10
 
@@ -18,6 +23,55 @@
 static uint32_t rawData;
 static uint8_t 	nbBits;
 
+//! Records of the reports
+static const recordType_t	recordManchester = {
+	.format		= "%s,NbPairs=%d,HalfBit=%d,Length=%d,Data=0x%08x\n",
+	.nbValues	= 4,
+	.fields		= { "NbPairs", "HalfBit", "Length", "Data" }
+};
+
+static const recordType_t	recordSamePulse = {
+	.format		= "%s,NbPairs=%d,SameHigh=%d,HighLen=%d,SameLow=%d,LowLen=%d\n",
+	.nbValues	= 5,
+	.fields		= { "NbPairs", "SameHigh", "HighLen", "SameLow", "LowLen" }
+};
+
+static const recordType_t	recordRCS = {
+	.format		= "%s,Prologue=%d+%d,Epilogue=%d+%d,PairLen=%d,Length=%d,Data=0x%08x\n",
+	.nbValues	= 7,
+	.fields		= { "PrologueHigh", "PrologueLow", "EpilogueHigh", "EpilogueLow", "PairLen", "Length", "Data" }
+};
+
+//! Record: the pulses of the sentence, "Raw,<pulse lens>,0"
+static const recordType_t	recordRaw = {
+	.format		= "%s,",
+	.nbValues	= 0,
+	.flags		= RECORD_TEXT_PULSES
+};
+
+#ifdef USE_LEARNER
+//! Report of the learner (a new protocol comes with its 120 digits descriptor)
+#define LEARNER_REPORT_LEN	320
+static char		learnerBuffer[LEARNER_REPORT_LEN];
+
+static void print_learned(const record_t *record);
+
+//! Record: a sentence of a learned protocol, its data in the bits
+static const recordType_t	recordUnknown = {
+	.format		= "%s,Sig=%08X,Bits=%d,Data=0x",
+	.nbValues	= 2,
+	.flags		= RECORD_TEXT_BITS,
+	.fields		= { "Sig", "Bits" }
+};
+
+//! Record: a new protocol, its shape in the values and its data in the bits
+static const recordType_t	recordLearned = {
+	.nbValues	= 8,
+	.fields		= { "Sig", "Sync", "Encoding", "Bits", "Short", "Long", "SyncLen", "SyncHigh" },
+	.print		= print_learned
+};
+#endif
+
 
 static uint8_t interpret_default(uint32_t r, uint8_t b)
 {
@@ -30,49 +84,40 @@ static uint8_t interpret_default(uint32_t r, uint8_t b)
 }
 
 
-uint16_t check_manchester_sentence(uint32_t *pulseLens, uint16_t nbPulses)
+uint16_t check_manchester_sentence(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	i;
-	uint32_t	ReferenceLen[2] 	= {0, 0};
-		
+	uint16_t			usedPulses = 0;
+	uint8_t				pendingShort;
+	uint32_t			halfBit;
+	manchesterState_t	manchester;
+	manchesterFrame_t	frame;
 	
-	for (i = 0; i < nbPulses; i++)
+	
+	halfBit = manchester_estimate(pulseLens, nbPulses);
+	if (halfBit == 0)
 	{
-		if (ReferenceLen[0] == 0)
-		{
-			ReferenceLen[0] = pulseLens[i];
-		}
-		else if (SIMILAR(pulseLens[i], ReferenceLen[0]))
-		{
-			continue;
-		}
-		else if (ReferenceLen[1] == 0 && (SIMILAR(2*pulseLens[i], ReferenceLen[0]) || SIMILAR(pulseLens[i]/2, ReferenceLen[0])))
-		{
-			ReferenceLen[1] = pulseLens[i];
-		}
-		else if (SIMILAR(pulseLens[i], ReferenceLen[1]))
-		{
-			continue;
-		}
-		else
-		{
-			// Invalid length
-			break;
-		}
+		return 0;
 	}
 	
-	if (i >= (2 * MIN_NUM_PAIRS))
+	// The sentence may start in the middle of a pair of short pulses: try both alignments
+	for (pendingShort = 0; pendingShort <= 1 && usedPulses < (2 * MIN_NUM_PAIRS); pendingShort++)
 	{
-		PRINTF("DefaultManchester,NbPairs=%d,length0=%d,length1=%d\n", i/2, ReferenceLen[0], ReferenceLen[1]);
+		manchester_init(&manchester, halfBit, 0, pendingShort);
+		usedPulses = manchester_decode(&manchester, pulseLens, nbPulses, &frame);
+	}
+	
+	if (usedPulses >= (2 * MIN_NUM_PAIRS))
+	{
+		record_emit("DefaultManchester", &recordManchester, usedPulses/2, frame.halfBit, frame.bits.nbBits, frame.bits.words[0]);
 		// Make sure the result is even
-		return 2 * (i/2);
+		return 2 * (usedPulses/2);
 	}
 	
 	return 0;
 }
 
 
-uint16_t check_samePulse_sentence(uint32_t *pulseLens, uint16_t nbPulses)
+uint16_t check_samePulse_sentence(uint16_t *pulseLens, uint16_t nbPulses)
 {
 	uint16_t	i;
 	uint32_t	ReferenceLen[2];
@@ -109,7 +154,7 @@ uint16_t check_samePulse_sentence(uint32_t *pulseLens, uint16_t nbPulses)
 	
 	if (i >= (2 * MIN_NUM_PAIRS))
 	{
-		PRINTF("DefaultSamePulse,NbPairs=%d,SameHigh=%d,HighLen=%d,SameLow=%d,LowLen=%d\n", i/2, sameHigh, ReferenceLen[0], sameLow, ReferenceLen[1]);
+		record_emit("DefaultSamePulse", &recordSamePulse, i/2, sameHigh, ReferenceLen[0], sameLow, ReferenceLen[1]);
 		// Make sure the result is even
 		return i;
 	}
@@ -118,19 +163,109 @@ uint16_t check_samePulse_sentence(uint32_t *pulseLens, uint16_t nbPulses)
 }
 
 
-uint16_t decode_default(uint32_t *pulseLens, uint16_t nbPulses)
+/*!
+ * @brief Dump the pulses of a sentence: "Raw,<pulse lens>,0"
+ * @remark Only refers to the pulses: the text sink prints them once the
+ * decoders are done
+ */
+static void dump_raw(uint16_t *pulseLens, uint16_t nbPulses)
+{
+	record_emitPulses("Raw", &recordRaw, pulseLens, nbPulses);
+}
+
+#ifdef USE_LEARNER
+/*!
+ * @brief Text sink of a new protocol: its report, with its descriptor (see learner_format())
+ */
+static void print_learned(const record_t *record)
+{
+	learnerEntry_t	entry;
+	learnerResult_t	result;
+	
+	
+	entry.shape.signature	= record->values[0];
+	entry.shape.syncShape	= record->values[1];
+	entry.shape.encoding	= record->values[2];
+	entry.shape.nbBits		= record->values[3];
+	entry.shape.shortLen	= record->values[4];
+	entry.shape.longLen		= record->values[5];
+	entry.shape.syncLen		= record->values[6];
+	entry.shape.syncHighLen	= record->values[7];
+	
+	result.entry	= &entry;
+	result.isNew	= 1;
+	result.nbBits	= record->bits.nbBits;
+	result.data[0]	= record->bits.words[0];
+	result.data[1]	= record->bits.words[1];
+	
+	learner_format(&result, learnerBuffer, LEARNER_REPORT_LEN);
+	output_send(learnerBuffer);
+}
+
+/*!
+ * @brief Queue the report of a learned sentence
+ */
+static void report_learned(const learnerResult_t *learned)
+{
+	const learnerShape_t	*shape = &learned->entry->shape;
+	bitvec_t				data;
+	
+	
+	// Its first 64 bits, as printed
+	bitvec_reset(&data);
+	data.words[0]	= learned->data[0];
+	data.words[1]	= learned->data[1];
+	data.nbBits		= (learned->nbBits > 64 ? 64 : learned->nbBits);
+	
+	if (learned->isNew)
+	{
+		record_emitBits("Learned", &recordLearned, &data, shape->signature, shape->syncShape, shape->encoding, shape->nbBits,
+			shape->shortLen, shape->longLen, shape->syncLen, shape->syncHighLen);
+	}
+	else
+	{
+		record_emitBits("Unknown", &recordUnknown, &data, shape->signature, learned->nbBits);
+	}
+}
+#endif
+
+
+/*!
+ * @brief Report a sentence no decoder matched
+ *
+ * A PWM protocol goes to the learner. Otherwise, the sentence is scanned for
+ * pairs of the same length (DefaultRCS, followed by the raw pulses) and for
+ * Manchester coding. Without USE_LEARNER, a sentence none of them reported is
+ * dumped raw.
+ *
+ * @return Number of reports queued
+ */
+uint16_t decode_default(uint16_t *pulseLens, uint16_t nbPulses)
 {
 	uint16_t	usedPulses = 0;
 	uint16_t	syncOffset = 0;
-	uint16_t	i = 0;
+	uint16_t	reported = 0;
+#ifdef USE_LEARNER
+	learnerResult_t	learned;
+#endif
+	
+#ifdef USE_LEARNER
+	// A PWM protocol: reported by its signature once learned
+	if (learner_learn(pulseLens, nbPulses, &learned))
+	{
+		report_learned(&learned);
+		return 1;
+	}
 	
-	while (nbPulses - syncOffset > (2*MIN_NUM_PAIRS))
+#endif
+	// Up to the room left for the reports (DefaultRCS comes with the raw pulses)
+	while (nbPulses - syncOffset > (2*MIN_NUM_PAIRS) && !budget_expired() && record_room() >= 2)
 	{	
 		// Try and decode the sentence by checking all the pairs have the same duration
 		
 		
 		if ((usedPulses = decode_generic_rcswitch_sentence(
-				pulseLens + syncOffset,		// uint32_t *pulseLens
+				pulseLens + syncOffset,		// uint16_t *pulseLens
 				nbPulses - syncOffset, 		// uint16_t nbPulses
 				0,							// pairLen
 				interpret_default,			// DataHandler
@@ -138,7 +273,7 @@ uint16_t decode_default(uint32_t *pulseLens, uint16_t nbPulses)
 			 )) >= 2*MIN_NUM_PAIRS)
 		{
 			
-			PRINTF("DefaultRCS,Prologue=%d+%d,Epilogue=%d+%d,PairLen=%d,Length=%d,Data=0x%08x\nRaw,",
+			record_emit("DefaultRCS", &recordRCS,
 				(syncOffset > 2 ? pulseLens[syncOffset-2] : 0),
 				(syncOffset > 1 ? pulseLens[syncOffset-1] : 0),
 				(syncOffset + usedPulses + 1 < nbPulses ? pulseLens[syncOffset+usedPulses+1] : 0),
@@ -147,22 +282,21 @@ uint16_t decode_default(uint32_t *pulseLens, uint16_t nbPulses)
 				nbBits,
 				rawData
 			);
-			for (i=0; i<nbPulses; i++) {
-				PRINTF("%d,", pulseLens[i]);
-			}
-			PRINTF("0\n");
+			dump_raw(pulseLens, nbPulses);
 			syncOffset += usedPulses;
+			reported++;
 		}
-		/*
 		else if ((usedPulses = check_manchester_sentence(
-				pulseLens + syncOffset,		// uint32_t *pulseLens
+				pulseLens + syncOffset,		// uint16_t *pulseLens
 				nbPulses - syncOffset 		// uint16_t nbPulses
 			 )) >= 2*MIN_NUM_PAIRS)
 		{
 			syncOffset += usedPulses;
+			reported++;
 		}
+		/*
 		else if ((usedPulses = check_samePulse_sentence(
-				pulseLens + syncOffset,		// uint32_t *pulseLens
+				pulseLens + syncOffset,		// uint16_t *pulseLens
 				nbPulses - syncOffset 		// uint16_t nbPulses
 			 )) >= 2*MIN_NUM_PAIRS)
 		{
@@ -175,5 +309,12 @@ uint16_t decode_default(uint32_t *pulseLens, uint16_t nbPulses)
 		}
 	}
 	
-	return 1;
+#ifndef USE_LEARNER
+	if (reported == 0)
+	{
+		dump_raw(pulseLens, nbPulses);
+		reported++;
+	}
+#endif
+	return reported;
 }
@@ -1,5 +1,6 @@
 #include "decoder.h"
-#include "generic_rcswitch.h"
+#include "generic_pwm.h"
+#include "record.h"
 
 /*******************************************************************************
  * DIPSWITCH DECODER                                                           *
@@ -11,8 +12,7 @@
  * DATA:
  *  	Similar to RCSwitch (fixed pair length with a 1/3-2/3 ratio)
  *      The pair begins with a low pulse, then a high pulse (instead of high-then-low),
- *      this is why we use decode_2ndPulse_rcswitch_sentence() instead of the default
- *      rcswitch decoder
+ *      this is why the bit is given by the 2nd pulse of each pair (PWM_BIT_SECOND)
  *
  ******************
  * INTERPRETATION *
@@ -27,8 +27,13 @@
 #define MIN_LONG_LEN	1320
 #define MAX_LONG_LEN	1520
 
-#define MIN_SYNC_LEN	25000	// Measured: 26ms
-#define MAX_SYNC_LEN	27000
+#define NOMINAL_SYNC_LEN	26000	// Measured: 26ms
+#define MIN_SYNC_LEN	PWM_SYNC_MIN(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+#define MAX_SYNC_LEN	PWM_SYNC_MAX(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+
+// Clock drift accepted (%): the sync gives the timebase of each frame
+#define DRIFT_TOLERANCE	20
+#define MIN_PULSE_LEN	(MIN_SHORT_LEN * (100 - DRIFT_TOLERANCE) / 100)
 
 #define AVG_PAIR_LEN	2130	// Measured: 2,135ms
 
@@ -42,101 +47,73 @@
 #define DIPCODE_SHIFT	21
 
 
-static uint16_t decode_dipswitch(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_dipswitch(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_dipSwitch =
+const decoderDesc_t decoder_dipSwitch =
 {
 	.name			= "DIPswitch",
-	.minPulseLen  	= MIN_SHORT_LEN,
+	.minPulseLen  	= MIN_PULSE_LEN,
 	.maxPulseLen  	= MAX_SYNC_LEN,
 	.minNumPulses 	= MIN_NUM_PULSES,
 	.decoderFunc	= decode_dipswitch
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_DIP_SWITCH, MIN_PULSE_LEN, MAX_SYNC_LEN, MIN_NUM_PULSES);
+
 
-static uint8_t interpret_dipswitch(uint32_t rawData, uint8_t nbBits)
+static const pwmProtocol_t dipswitchProtocol =
 {
+	.syncShape		= PWM_SYNC_HIGH_LOW,
+	.syncHigh		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.sync			= { MIN_SYNC_LEN, MAX_SYNC_LEN },
+	.nominalSync	= NOMINAL_SYNC_LEN,
+	.encoding		= PWM_BIT_SECOND,
+	.first			= PWM_ANY_PULSE,
+	.shortPulse		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.longPulse		= { MIN_LONG_LEN, MAX_LONG_LEN },
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 1,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+
+//! Records: DIP code (the line is not ended), and raw code
+static const recordType_t	recordDipCode = {
+	.format		= "%s: DIPcode value=0x%3X ",
+	.nbValues	= 1,
+	.fields		= { "DIPcode" }
+};
+static const recordType_t	recordRaw = {
+	.format		= "%s: Valid code (%db): 0x%08X\n",
+	.nbValues	= 2,
+	.fields		= { "Length", "Data" }
+};
+
+
+static uint8_t interpret_dipswitch(const pwmFrame_t *frame)
+{
+	uint32_t	rawData	= frame->bits.words[0];
+	uint16_t	nbBits	= frame->bits.nbBits;
+	
 	// Decode the raw data
 	if (nbBits == 12 && !PROLOGUE && EPILOGUE)
 	{
 		// None of the odd bits is set (we don't check the last 2 since the state value may be 0b00 or 0b11)
-		PRINTF("%s: DIPcode value=0x%3X ", decoder_dipSwitch.name, BIN_VALUE(DIPCODE));
+		record_emitBits((const char *)decoder_dipSwitch.name, &recordDipCode, &frame->bits, BIN_VALUE(DIPCODE));
 		return 1;
 	}
 	else if (nbBits >= 10)
 	{
 		// Decode the raw data
-		PRINTF("%s: Valid code (%db): 0x%08X\n", decoder_dipSwitch.name, nbBits, rawData);
+		record_emitBits((const char *)decoder_dipSwitch.name, &recordRaw, &frame->bits, nbBits, rawData);
 		return 1;
 	}
 	
 	return 0;
 }
 
-static uint16_t decode_2ndPulse_rcswitch_sentence(uint32_t *pulseLens, uint16_t nbPulses, ui32InterpreterFunc_t dataHandler, uint32_t revert)
-{
-	uint16_t	i,
-				dataBitOffset	= RAW_DATA_LEN; // Bits to receive
-	uint32_t	rawData 		= 0;
-		
-	
-	// Each bit can be:
-	// short low+long high (1)
-	// long low+short high (0)
-	for (i = 0; i < nbPulses-1; i += 2)
-	{
-		if (IS_SHORT(pulseLens[i+1]))
-		{
-			rawData |= (revert << --dataBitOffset);
-		}
-		else if (IS_LONG(pulseLens[i+1]))
-		{
-			rawData |= ((1 - revert) << --dataBitOffset);
-		}
-		else
-		{
-			// Pulse len is invalid
-			break;
-		}
-		
-		if (!dataBitOffset)
-		{
-			i += 2;
-			break;
-		}
-	}
-	
-	if (dataHandler(rawData, RAW_DATA_LEN - dataBitOffset))
-	{
-		return i;
-	}
-	
-	return 0;
-}
-
-static uint16_t decode_dipswitch(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_dipswitch(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	result = 0;
-	uint16_t	syncOffset = 0;
-	
-	while (nbPulses - syncOffset > MIN_NUM_PULSES)
-	{	
-		if (IS_SHORT(pulseLens[syncOffset]) && IS_SYNC(pulseLens[syncOffset+1]))
-		{
-			// Valid sync pulses found - try and decode the sentence 
-			
-			// start @syncOffset+2
-			syncOffset += 2;			
-			result = decode_2ndPulse_rcswitch_sentence(pulseLens + syncOffset, nbPulses - syncOffset, interpret_dipswitch, 1);
-			// syncOffset must be aligned back to a high pulse
-			syncOffset += result;
-		}
-		else
-		{
-			syncOffset += 2;
-		}
-	}
-	
-	return (result > 0);
+	return PWM_DECODE_SENTENCE(&dipswitchProtocol, pulseLens, nbPulses, interpret_dipswitch);
 }
-
@@ -1,17 +1,23 @@
 #include "main.h"
 #include "decoder.h"
+#include "generic_pwm.h"
+#include "record.h"
 
 #define MIN_HIGH_LEN	430
 #define MAX_HIGH_LEN	600
 
-#define MIN_SHORT_LEN	1800
-#define MAX_SHORT_LEN	2100
+#define MIN_SHORT_LEN	1750	// Measured: 1950us, long 4050us (+/-10 %: the pulses jitter)
+#define MAX_SHORT_LEN	2150
 
-#define MIN_LONG_LEN	3900
-#define MAX_LONG_LEN	4200
+#define MIN_LONG_LEN	3650
+#define MAX_LONG_LEN	4450
 
-#define MIN_SYNC_LEN	8500
-#define MAX_SYNC_LEN	8700
+#define NOMINAL_SYNC_LEN	8600
+#define MIN_SYNC_LEN	PWM_SYNC_MIN(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+#define MAX_SYNC_LEN	PWM_SYNC_MAX(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+
+// Clock drift accepted (%): the sync gives the timebase of each frame
+#define DRIFT_TOLERANCE	20
 
 #define RAW_DATA_LEN	32	// bits
 #define MIN_NUM_PULSES	20	// at least 4 bytes * 2 pulses + 2 sync pulses
@@ -26,9 +32,9 @@
 #define TDEC_SHIFT		8
 
 
-static uint16_t decode_UnknownTemp(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_UnknownTemp(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_UnknownTemp = {
+const decoderDesc_t decoder_UnknownTemp = {
 	.name 			= "UnknownTemp",
 	.minPulseLen  	= MIN_SHORT_LEN,
 	.maxPulseLen  	= MAX_SYNC_LEN,
@@ -37,20 +43,50 @@ decoderDesc_t decoder_UnknownTemp = {
 };
 
 
-static uint8_t interpret_UnknownTemp(uint32_t	rawData, uint8_t nbBits)
+static const pwmProtocol_t unknownTempProtocol =
+{
+	.syncShape		= PWM_SYNC_HIGH_LOW,
+	.syncHigh		= { MIN_HIGH_LEN, MAX_HIGH_LEN },
+	.sync			= { MIN_SYNC_LEN, MAX_SYNC_LEN },
+	.nominalSync	= NOMINAL_SYNC_LEN,
+	.encoding		= PWM_BIT_SECOND,
+	.first			= { MIN_HIGH_LEN, MAX_HIGH_LEN },
+	.shortPulse		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.longPulse		= { MIN_LONG_LEN, MAX_LONG_LEN },
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 0,
+	.flags			= PWM_FIRST_FRAME_ONLY,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+
+//! Records: humidity, and raw data
+static const recordType_t	recordHumidity = {
+	.format		= "%s,%08X,Humid=%d.%d %%\n",
+	.nbValues	= 3,
+	.fields		= { "Data", "Humid", "HumidDec" }
+};
+static const recordType_t	recordRaw = {
+	.format		= "%s,%d,%08X\n",
+	.nbValues	= 2,
+	.fields		= { "Length", "Data" }
+};
+
+
+static uint8_t interpret_UnknownTemp(const pwmFrame_t *frame)
 {
-	uint8_t	dataBytes[4];
-	memcpy(dataBytes, &rawData, 4);
+	uint32_t	rawData	= frame->bits.words[0];
+	uint16_t	nbBits	= frame->bits.nbBits;
 	
 	if (nbBits == 24)
 	{
 		if (BIN_VALUE(TDEC) <= 9 && ((rawData & 0xFF) == 0))
 		{
-			PRINTF("%s,%08X,Humid=%d.%d %%\n", decoder_UnknownTemp.name, rawData, BIN_VALUE(TLOW), BIN_VALUE(TDEC));
+			record_emitBits((const char *)decoder_UnknownTemp.name, &recordHumidity, &frame->bits, rawData, BIN_VALUE(TLOW), BIN_VALUE(TDEC));
 		}
 		else
 		{
-			PRINTF("%s,%d,%08X\n", decoder_UnknownTemp.name, nbBits, rawData);
+			record_emitBits((const char *)decoder_UnknownTemp.name, &recordRaw, &frame->bits, nbBits, rawData);
 		}
 		return 1;
 	}
@@ -58,83 +94,7 @@ static uint8_t interpret_UnknownTemp(uint32_t	rawData, uint8_t nbBits)
 	return 0;
 }
 
-/*!
- * @param[in]	pulseLens	Durations of the pulses to decode
- * @param[in]	nbPulses	Number of pulses in pulseLens
- * @return		Number of pulses used, starting from offset 0
- */
-static uint16_t decode_synced_UnknownTemp(uint32_t *pulseLens, uint16_t nbPulses, uint32_t revert)
-{
-	uint16_t	i;
-	
-	uint8_t		dataBitOffset	= RAW_DATA_LEN; // Bits to receive
-	uint32_t	rawData 		= 0;
-		
-	// Decode the raw data
-	// pulseLens should point to the first data pulse
-	for (i = 0; i < nbPulses-1; i += 2)
-	{
-		if (!IS_HIGH_PULSE(pulseLens[i]))
-		{
-			// Invalid high pulse len
-			break;
-		}		
-		else if (IS_SHORT(pulseLens[i+1]))
-		{
-			// Nothing to do
-			rawData |= (revert << --dataBitOffset);
-		}
-		else if (IS_LONG(pulseLens[i+1]))
-		{
-			rawData |= ((1 - revert) << --dataBitOffset);
-		}
-		else
-		{
-			// Invalid low pulse len
-			break;
-		}
-		
-		// If the receive buffer is full => break
-		if (!dataBitOffset)
-		{
-			break;
-		}
-	}
-	
-	if (interpret_UnknownTemp(rawData, RAW_DATA_LEN-dataBitOffset))
-	{
-		return i;
-	}
-	else
-	{
-		return 0;
-	}
-}
-
-static uint16_t decode_UnknownTemp(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_UnknownTemp(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	result = 0;
-	uint16_t	syncOffset = 0;
-	
-	while (nbPulses - syncOffset > MIN_NUM_PULSES)
-	{	
-		if (IS_HIGH_PULSE(pulseLens[syncOffset]) && IS_SYNC(pulseLens[syncOffset+1]))
-		{
-			// Valid sync pulses found - try and decode the sentence 
-			syncOffset += 2;
-			result = decode_synced_UnknownTemp(pulseLens + syncOffset, nbPulses - syncOffset, 0);
-			syncOffset += result;
-		}
-		else
-		{
-			syncOffset += 2;
-		}
-		
-		if (result > 0) {
-			break;
-		}
-	}
-	
-	return (result > 0);
+	return PWM_DECODE_SENTENCE(&unknownTempProtocol, pulseLens, nbPulses, interpret_UnknownTemp);
 }
-
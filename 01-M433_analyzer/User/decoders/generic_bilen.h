@@ -4,7 +4,7 @@
 #include "main.h"
 
 
-uint16_t decode_generic_b_sentence(uint32_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, ui32InterpreterFunc_t dataHandler, uint32_t revert);
+uint16_t decode_generic_b_sentence(uint16_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, ui32InterpreterFunc_t dataHandler, uint32_t revert);
 
 
 #endif // GENERIC_RCSWITCH_H
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "generic_manchester.h"
+
+
+/*!
+ * @brief Estimate the half-bit period of a Manchester sentence
+ *
+ * The shortest pulse gives a first estimate T0. The estimate is then the average
+ * of the 1T pulses and of the halves of the 2T pulses (pulses below 5/2 T0).
+ *
+ * @return Half-bit period, 0 if no estimate could be made
+ */
+uint32_t manchester_estimate(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i, count = 0;
+	uint32_t	minLen = 0xFFFFFFFF,
+				sum = 0;
+	
+	
+	if (nbPulses > MANCHESTER_ESTIMATE_LEN) {
+		nbPulses = MANCHESTER_ESTIMATE_LEN;
+	}
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		if (pulseLens[i] < minLen) {
+			minLen = pulseLens[i];
+		}
+	}
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		if (2 * pulseLens[i] < 3 * minLen)
+		{
+			sum += pulseLens[i];
+			count++;
+		}
+		else if (2 * pulseLens[i] < 5 * minLen)
+		{
+			sum += pulseLens[i] / 2;
+			count++;
+		}
+	}
+	
+	return (count > 0 ? sum / count : 0);
+}
+
+/*!
+ * @brief Reset the decoder state
+ * @param[in]	halfBit			Initial half-bit period
+ * @param[in]	firstBit		Value of the bit before the first pulse
+ * @param[in]	pendingShort	1 if the first pulse is the second half of a pair of 1T pulses
+ */
+void manchester_init(manchesterState_t *state, uint32_t halfBit, uint8_t firstBit, uint8_t pendingShort)
+{
+	state->halfBit		= halfBit;
+	state->bit			= firstBit;
+	state->pendingShort	= pendingShort;
+	state->symbol		= 2;
+}
+
+/*!
+ * @brief Feed a symbol to the decoder, for protocols coding each half-bit with a
+ * pair of pulses (first half 1 then 0 codes a 1, first half 0 then 1 codes a 0)
+ * @return The decoded bit, MANCHESTER_NO_BIT after the first half of a bit, or
+ * 		   MANCHESTER_ERROR if both halves are equal
+ */
+int8_t manchester_stepSymbol(manchesterState_t *state, uint8_t symbol)
+{
+	uint8_t	first = state->symbol;
+	
+	
+	if (first > 1)
+	{
+		state->symbol = symbol;
+		return MANCHESTER_NO_BIT;
+	}
+	
+	state->symbol = 2;
+	return (first != symbol ? first : MANCHESTER_ERROR);
+}
+
+/*!
+ * @brief Decode pulses until an invalid one is found, or the frame is full
+ * @param[in]	pulseLens	Durations of the pulses to decode
+ * @param[in]	nbPulses	Number of pulses in pulseLens
+ * @param[out]	frame		Decoded bits
+ * @return		Number of pulses used, starting from offset 0
+ */
+uint16_t manchester_decode(manchesterState_t *state, const uint16_t *pulseLens, uint16_t nbPulses, manchesterFrame_t *frame)
+{
+	uint16_t	i;
+	int8_t		bit;
+	
+	
+	bitvec_reset(&frame->bits);
+	
+	for (i = 0; i < nbPulses && !bitvec_full(&frame->bits); i++)
+	{
+		bit = manchester_step(state, pulseLens[i]);
+		
+		if (bit == MANCHESTER_ERROR) {
+			break;
+		}
+		
+		if (bit != MANCHESTER_NO_BIT) {
+			bitvec_append(&frame->bits, bit);
+		}
+	}
+	
+	bitvec_finish(&frame->bits);
+	frame->halfBit = state->halfBit;
+	return i;
+}
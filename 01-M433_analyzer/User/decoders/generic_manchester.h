@@ -0,0 +1,93 @@
+#ifndef GENERIC_MANCHESTER_H
+#define GENERIC_MANCHESTER_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*******************************************************************************
+ * GENERIC MANCHESTER / BIPHASE DECODER                                        *
+ *******************************************************************************
+ * With Manchester encoding, each pulse lasts either one half-bit period (T) or
+ * two (2T):
+ * - A 2T pulse spans a mid-bit transition: the bit value flips
+ * - Two 1T pulses keep the bit value
+ *
+ * The half-bit period is estimated from the sentence (or given by the decoder,
+ * e.g. from a preamble), then tracked by a simple PLL so that a slow clock drift
+ * of the transmitter doesn't break long frames. The bits are emitted in one
+ * linear pass over the pulses.
+ */
+
+//! PLL gain: the half-bit period moves by 1/2^MANCHESTER_PLL_SHIFT of the error
+#define MANCHESTER_PLL_SHIFT	3
+
+//! Number of pulses used to estimate the half-bit period
+#define MANCHESTER_ESTIMATE_LEN	32
+
+//! manchester_step() results
+#define MANCHESTER_NO_BIT		-1
+#define MANCHESTER_ERROR		-2
+
+//! Decoder state
+typedef struct {
+	uint32_t	halfBit;		// Current half-bit period (T)
+	uint8_t		bit;			// Value of the current bit
+	uint8_t		pendingShort;	// 1 if the first half of a pair of 1T pulses was received
+	uint8_t		symbol;			// manchester_stepSymbol(): first half of the bit (0, 1, or 2 if none)
+} manchesterState_t;
+
+//! Decoded frame
+typedef struct {
+	bitvec_t	bits;
+	uint32_t	halfBit;		// Half-bit period at the end of the frame
+} manchesterFrame_t;
+
+
+uint32_t	manchester_estimate(const uint16_t *pulseLens, uint16_t nbPulses);
+void		manchester_init(manchesterState_t *state, uint32_t halfBit, uint8_t firstBit, uint8_t pendingShort);
+int8_t		manchester_stepSymbol(manchesterState_t *state, uint8_t symbol);
+uint16_t	manchester_decode(manchesterState_t *state, const uint16_t *pulseLens, uint16_t nbPulses, manchesterFrame_t *frame);
+
+
+/*!
+ * @brief Feed a pulse to the decoder
+ * @return The decoded bit, MANCHESTER_NO_BIT if the pulse completes no bit, or
+ * 		   MANCHESTER_ERROR if the pulse len is invalid
+ * @remark Inline: it runs on every pulse of the Manchester decoders
+ */
+static __INLINE int8_t manchester_step(manchesterState_t *state, uint32_t pulseLen)
+{
+	uint32_t	halfBit = state->halfBit;
+	int32_t		error;
+	
+	
+	if (2 * pulseLen <= halfBit || 2 * pulseLen >= 5 * halfBit)
+	{
+		return MANCHESTER_ERROR;
+	}
+	
+	if (2 * pulseLen < 3 * halfBit)
+	{
+		// 1T pulse
+		error = (int32_t)pulseLen - (int32_t)halfBit;
+		state->halfBit = (uint32_t)((int32_t)halfBit + (error >> MANCHESTER_PLL_SHIFT));
+		
+		state->pendingShort ^= 1;
+		return (state->pendingShort ? MANCHESTER_NO_BIT : state->bit);
+	}
+	
+	// 2T pulse: may not split a pair of 1T pulses
+	if (state->pendingShort)
+	{
+		return MANCHESTER_ERROR;
+	}
+	
+	error = (int32_t)(pulseLen / 2) - (int32_t)halfBit;
+	state->halfBit = (uint32_t)((int32_t)halfBit + (error >> MANCHESTER_PLL_SHIFT));
+	
+	state->bit ^= 1;
+	return state->bit;
+}
+
+
+#endif // GENERIC_MANCHESTER_H
@@ -0,0 +1,24 @@
+#include "generic_pwm_kernel.h"
+
+
+/*!
+ * @brief Decode the data pairs following a sync
+ * @param[in]	pulseLens	Durations of the pulses to decode, starting with the first data pulse
+ * @param[in]	nbPulses	Number of pulses in pulseLens
+ * @param[in]	pairLen		PWM_BIT_RATIO: reference pair len (0: use the first pair)
+ * @param[out]	frame		Decoded bits
+ * @return		Number of pulses used, starting from offset 0
+ */
+uint16_t pwm_decode_frame(const pwmProtocol_t *proto, const uint16_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, pwmFrame_t *frame)
+{
+	return pwm_kernel_decodeFrame(proto, pulseLens, nbPulses, pairLen, PWM_SCALE_ONE, frame);
+}
+
+/*!
+ * @brief Decode and interpret all the frames of a sentence
+ * @return 1 if at least one frame was interpreted
+ */
+uint16_t pwm_decode_sentence(const pwmProtocol_t *proto, uint16_t *pulseLens, uint16_t nbPulses, pwmInterpreterFunc_t interpreter)
+{
+	return pwm_kernel_decodeSentence(proto, pulseLens, nbPulses, interpreter);
+}
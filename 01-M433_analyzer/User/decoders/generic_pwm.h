@@ -0,0 +1,116 @@
+#ifndef GENERIC_PWM_H
+#define GENERIC_PWM_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*******************************************************************************
+ * GENERIC PWM / PULSE-DISTANCE DECODER                                        *
+ *******************************************************************************
+ * Most remotes send their frames as:
+ * - A sync (a long low pulse, a specific high+low couple, or a whole pair with a
+ *   given length)
+ * - Data pairs (high pulse + low pulse), each coding one bit with the length of
+ *   its pulses
+ *
+ * Such a protocol is described by a const pwmProtocol_t, and decoded by a single
+ * engine: pwm_decode_sentence() looks for the syncs, combines the repeated frames
+ * (see combine.h), decodes the bits and hands them to the decoder's interpreter.
+ *
+ * The clock of cheap (or cold, or low on battery) transmitters drifts. When a
+ * protocol gives the nominal len of its sync, the syncs measured on the frames
+ * of a sentence give its timebase, and the pulse windows are scaled accordingly.
+ */
+
+//! Pulse len window (exclusive bounds, as with the IS_* macros)
+typedef struct {
+	uint32_t	min;
+	uint32_t	max;
+} pwmWindow_t;
+
+#define PWM_IN(n, w)		((n) > (w).min && (n) < (w).max)
+
+//! Pulse len window accepting any pulse (pulse lens are recorded on 16 bits)
+#define PWM_ANY_PULSE		{ 0, 0x10000 }
+
+//! Timebase of a sentence, relative to the nominal timings (fixed point)
+#define PWM_SCALE_SHIFT		8
+#define PWM_SCALE_ONE		(1 << PWM_SCALE_SHIFT)
+#define PWM_SCALE(n, scale)	(((n) * (scale)) >> PWM_SCALE_SHIFT)
+
+//! Timebases closer to the nominal one are taken as nominal: the syncs jitter
+#define PWM_SCALE_SNAP		(PWM_SCALE_ONE / 64)
+
+//! Sync window accepting a drift of tolerance % around the nominal len
+#define PWM_SYNC_MIN(nominal, tolerance)	((nominal) * (100 - (tolerance)) / 100)
+#define PWM_SYNC_MAX(nominal, tolerance)	((nominal) * (100 + (tolerance)) / 100)
+
+//! Shape of the sync pulses
+typedef enum {
+	PWM_SYNC_LOW,			// Low pulse in the sync window (whatever the high pulse before it)
+	PWM_SYNC_HIGH_LOW,		// High pulse in the syncHigh window, then low pulse in the sync window
+	PWM_SYNC_PAIR,			// High + low pulse lens in the sync window
+	PWM_SYNC_RATIO			// Low pulse more than syncRatio times longer than the high pulse
+} pwmSyncShape_t;
+
+//! Encoding of a bit in a pair of pulses (short/long pulse => bit 0/1 before polarity)
+typedef enum {
+	PWM_BIT_SECOND,			// First pulse in the first window, the second pulse gives the bit
+	PWM_BIT_BOTH,			// Short + long gives a 0, long + short gives a 1
+	PWM_BIT_RATIO			// Pair len close to the reference pair len, long + short gives a 1
+} pwmBitEncoding_t;
+
+//! Protocol flags
+#define PWM_FIRST_FRAME_ONLY	0x01	// Stop at the first frame interpreted
+
+//! Protocol description
+typedef struct {
+	pwmSyncShape_t		syncShape;
+	pwmWindow_t			syncHigh;		// PWM_SYNC_HIGH_LOW: high sync pulse
+	pwmWindow_t			sync;			// Low sync pulse, or whole sync pair
+	uint32_t			nominalSync;	// Nominal len of the sync window, to scale the other windows
+										// (0: fixed windows)
+	uint8_t				syncRatio;		// PWM_SYNC_RATIO: min low/high ratio
+	
+	pwmBitEncoding_t	encoding;
+	pwmWindow_t			first;			// PWM_BIT_SECOND: first pulse of each pair
+	pwmWindow_t			shortPulse;
+	pwmWindow_t			longPulse;
+	uint8_t				pairLenDivider;	// PWM_BIT_RATIO: reference pair len = sync pair len / pairLenDivider
+										// (0: the first pair is the reference)
+	uint8_t				pairTolerance;	// PWM_BIT_RATIO: pair len tolerance (%)
+	uint8_t				bitRatio;		// PWM_BIT_RATIO: min long/short ratio
+	
+	uint16_t			maxBits;		// Frame length, up to BITVEC_MAX_BITS
+	uint8_t				revert;			// 1 to swap the 0 and 1 bits
+	uint8_t				flags;
+	uint16_t			minNumPulses;	// Min number of pulses left to look for a sync
+} pwmProtocol_t;
+
+//! Decoded frame
+typedef struct {
+	bitvec_t	bits;
+	uint32_t	pairLen;				// PWM_BIT_RATIO: reference pair len
+	uint32_t	scale;					// Timebase (PWM_SCALE_ONE: nominal timings)
+} pwmFrame_t;
+
+typedef uint8_t (*pwmInterpreterFunc_t)(const pwmFrame_t *frame);
+
+
+uint16_t pwm_decode_frame(const pwmProtocol_t *proto, const uint16_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, pwmFrame_t *frame);
+uint16_t pwm_decode_sentence(const pwmProtocol_t *proto, uint16_t *pulseLens, uint16_t nbPulses, pwmInterpreterFunc_t interpreter);
+
+/*
+ * Decoders call PWM_DECODE_SENTENCE() with their const protocol: it is either
+ * the shared engine, or a loop specialized for this protocol (see
+ * generic_pwm_kernel.h)
+ */
+#ifdef PWM_SPECIALIZED_KERNELS
+	#include "generic_pwm_kernel.h"
+	#define PWM_DECODE_SENTENCE(proto, pulseLens, nbPulses, interpreter)	pwm_kernel_decodeSentence(proto, pulseLens, nbPulses, interpreter)
+#else
+	#define PWM_DECODE_SENTENCE(proto, pulseLens, nbPulses, interpreter)	pwm_decode_sentence(proto, pulseLens, nbPulses, interpreter)
+#endif
+
+
+#endif // GENERIC_PWM_H
@@ -0,0 +1,296 @@
+#ifndef GENERIC_PWM_KERNEL_H
+#define GENERIC_PWM_KERNEL_H
+
+#include "generic_pwm.h"
+#include "combine.h"
+#include "pulse_simd.h"
+#include "budget.h"
+
+/*
+ * Bodies of the PWM engine.
+ *
+ * They are always inlined: generic_pwm.c wraps them into the shared functions,
+ * which read the protocol description at run time. With PWM_SPECIALIZED_KERNELS,
+ * each decoder inlines them with its own const protocol instead: the timing
+ * windows are folded into the comparisons and the switches on the sync shape and
+ * bit encoding disappear, giving one dedicated loop per protocol (at the cost of
+ * some flash).
+ */
+
+#if defined(__CC_ARM)
+	#define PWM_KERNEL	static __forceinline
+#elif defined(__GNUC__)
+	#define PWM_KERNEL	static __INLINE __attribute__((always_inline))
+#else
+	#define PWM_KERNEL	static __INLINE
+#endif
+
+
+/*!
+ * @brief Len of the sync pulses measured against the nominal sync
+ */
+PWM_KERNEL uint32_t pwm_kernel_syncLen(const pwmProtocol_t *proto, const uint16_t *pulseLens)
+{
+	return (proto->syncShape == PWM_SYNC_PAIR ? pulseLens[0] + pulseLens[1] : pulseLens[1]);
+}
+
+/*!
+ * @brief Get the timebase of a frame from its sync pulses
+ * @return Measured / nominal timings, PWM_SCALE_ONE if the protocol uses fixed windows
+ */
+PWM_KERNEL uint32_t pwm_kernel_scale(const pwmProtocol_t *proto, const uint16_t *pulseLens)
+{
+	if (proto->nominalSync == 0) {
+		return PWM_SCALE_ONE;
+	}
+	
+	return (pwm_kernel_syncLen(proto, pulseLens) << PWM_SCALE_SHIFT) / proto->nominalSync;
+}
+
+/*!
+ * @brief Get the timebase of a sentence from the syncs of all its frames
+ *
+ * The frames of a sentence come from the same clock: averaging their syncs
+ * takes off most of the jitter of a single sync. A timebase within
+ * PWM_SCALE_SNAP of the nominal one is taken as nominal.
+ *
+ * @param[in]	syncLen		Sum of the lens of the syncs (see pwm_kernel_syncLen)
+ * @param[in]	nbSyncs		Number of syncs
+ * @return		Measured / nominal timings, PWM_SCALE_ONE if the protocol uses fixed windows
+ */
+PWM_KERNEL uint32_t pwm_kernel_sentenceScale(const pwmProtocol_t *proto, uint32_t syncLen, uint16_t nbSyncs)
+{
+	uint32_t	scale;
+	
+	
+	if (proto->nominalSync == 0 || nbSyncs == 0) {
+		return PWM_SCALE_ONE;
+	}
+	
+	scale = ((syncLen / nbSyncs) << PWM_SCALE_SHIFT) / proto->nominalSync;
+	if (scale + PWM_SCALE_SNAP >= PWM_SCALE_ONE && scale <= PWM_SCALE_ONE + PWM_SCALE_SNAP) {
+		return PWM_SCALE_ONE;
+	}
+	return scale;
+}
+
+/*!
+ * @brief Check if a pulse pair is a sync for this protocol
+ */
+PWM_KERNEL uint8_t pwm_kernel_isSync(const pwmProtocol_t *proto, const uint16_t *pulseLens)
+{
+	uint32_t	scale;
+	
+	
+	switch (proto->syncShape)
+	{
+		case PWM_SYNC_LOW:
+			return PWM_IN(pulseLens[1], proto->sync);
+		case PWM_SYNC_HIGH_LOW:
+			if (!PWM_IN(pulseLens[1], proto->sync)) {
+				return 0;
+			}
+			// The high pulse drifts along with the low pulse
+			scale = pwm_kernel_scale(proto, pulseLens);
+			return (pulseLens[0] > PWM_SCALE(proto->syncHigh.min, scale) && pulseLens[0] < PWM_SCALE(proto->syncHigh.max, scale));
+		case PWM_SYNC_PAIR:
+			return PWM_IN(pulseLens[0] + pulseLens[1], proto->sync);
+		case PWM_SYNC_RATIO:
+			return pulseLens[1] > proto->syncRatio * pulseLens[0];
+	}
+	return 0;
+}
+
+/*!
+ * @brief Decode the data pairs following a sync
+ * @param[in]	pulseLens	Durations of the pulses to decode, starting with the first data pulse
+ * @param[in]	nbPulses	Number of pulses in pulseLens
+ * @param[in]	pairLen		PWM_BIT_RATIO: reference pair len (0: use the first pair)
+ * @param[in]	scale		Timebase of the sentence
+ * @param[out]	frame		Decoded bits
+ * @return		Number of pulses used, starting from offset 0
+ */
+PWM_KERNEL uint16_t pwm_kernel_decodeFrame(const pwmProtocol_t *proto, const uint16_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, uint32_t scale, pwmFrame_t *frame)
+{
+	uint16_t		i;
+	uint32_t		bit, minPairLen = 0, maxPairLen = 0;
+	uint32_t		high, low, pair;
+	pwmWindow_t		first, shortPulse, longPulse;
+	pulseWindow2_t	zero = { 0, 0 }, one = { 0, 0 };	// Only used by PWM_BIT_SECOND and PWM_BIT_BOTH
+	
+	
+	bitvec_reset(&frame->bits);
+	frame->scale = scale;
+	
+	// Windows matching the timebase of this frame
+	first.min		= PWM_SCALE(proto->first.min, scale);
+	first.max		= PWM_SCALE(proto->first.max, scale);
+	shortPulse.min	= PWM_SCALE(proto->shortPulse.min, scale);
+	shortPulse.max	= PWM_SCALE(proto->shortPulse.max, scale);
+	longPulse.min	= PWM_SCALE(proto->longPulse.min, scale);
+	longPulse.max	= PWM_SCALE(proto->longPulse.max, scale);
+	
+	// Windows of the pairs coding a 0 and a 1, to check both pulses at once
+	if (proto->encoding == PWM_BIT_SECOND)
+	{
+		pulse_window2(&zero, first.min, first.max, shortPulse.min, shortPulse.max);
+		pulse_window2(&one, first.min, first.max, longPulse.min, longPulse.max);
+	}
+	else if (proto->encoding == PWM_BIT_BOTH)
+	{
+		pulse_window2(&zero, shortPulse.min, shortPulse.max, longPulse.min, longPulse.max);
+		pulse_window2(&one, longPulse.min, longPulse.max, shortPulse.min, shortPulse.max);
+	}
+	
+	if (proto->encoding == PWM_BIT_RATIO)
+	{
+		if (pairLen == 0 && nbPulses >= 2) {
+			pairLen = pulseLens[0] + pulseLens[1];
+		}
+		minPairLen = pairLen * (100 - proto->pairTolerance) / 100;
+		maxPairLen = pairLen * (100 + proto->pairTolerance) / 100;
+	}
+	frame->pairLen = pairLen;
+	
+	for (i = 0; i + 1 < nbPulses && frame->bits.nbBits < proto->maxBits; i += 2)
+	{
+		switch (proto->encoding)
+		{
+			case PWM_BIT_SECOND:
+			case PWM_BIT_BOTH:
+				pair = pulse_loadPair(pulseLens + i);
+				if (pulse_inWindow2(pair, &zero)) {
+					bit = 0;
+				} else if (pulse_inWindow2(pair, &one)) {
+					bit = 1;
+				} else {
+					goto end;
+				}
+				break;
+			
+			case PWM_BIT_RATIO:
+			default:
+				high	= pulseLens[i];
+				low		= pulseLens[i+1];
+				if (high + low <= minPairLen || high + low >= maxPairLen) {
+					goto end;
+				}
+				// Ratios are cross-multiplied: no division, no floating point
+				if (high > proto->bitRatio * low) {
+					bit = 1;
+				} else if (low > proto->bitRatio * high) {
+					bit = 0;
+				} else {
+					goto end;
+				}
+				break;
+		}
+		
+		bitvec_append(&frame->bits, bit ^ proto->revert);
+	}
+	
+end:
+	bitvec_finish(&frame->bits);
+	return i;
+}
+
+/*!
+ * @brief Decode a frame starting with its sync pulses, and interpret it
+ * @param[in]	scale	Timebase of the sentence (see pwm_kernel_sentenceScale)
+ * @return Number of data pulses used if the frame was interpreted, 0 otherwise
+ */
+PWM_KERNEL uint16_t pwm_kernel_decodeSynced(const pwmProtocol_t *proto, uint16_t *pulseLens, uint16_t nbPulses, uint32_t scale, pwmInterpreterFunc_t interpreter)
+{
+	uint16_t	used;
+	uint32_t	pairLen = 0;
+	pwmFrame_t	frame;
+	
+	
+	if (proto->encoding == PWM_BIT_RATIO && proto->pairLenDivider > 0) {
+		pairLen = (pulseLens[0] + pulseLens[1]) / proto->pairLenDivider;
+	}
+	
+	used = pwm_kernel_decodeFrame(proto, pulseLens + 2, nbPulses - 2, pairLen, scale, &frame);
+	
+	return (interpreter(&frame) ? used : 0);
+}
+
+/*!
+ * @brief Decode and interpret all the frames of a sentence
+ *
+ * The repeated frames are combined and decoded once. If this fails, each frame
+ * is decoded on its own.
+ *
+ * @return 1 if at least one frame was interpreted
+ */
+PWM_KERNEL uint16_t pwm_kernel_decodeSentence(const pwmProtocol_t *proto, uint16_t *pulseLens, uint16_t nbPulses, pwmInterpreterFunc_t interpreter)
+{
+	uint16_t	syncOffset, used, decoded = 0, nbSyncs, period;
+	uint16_t	frameOffsets[COMBINE_MAX_FRAMES], frameLen;
+	uint8_t		nbFrames = 0;
+	uint16_t	*combined;
+	uint32_t	syncLen = 0, scale;
+	
+	
+	// Combine the repeated frames and decode them once
+	for (syncOffset = 0; nbPulses - syncOffset > proto->minNumPulses && nbFrames < COMBINE_MAX_FRAMES; syncOffset += 2)
+	{
+		if (pwm_kernel_isSync(proto, pulseLens + syncOffset))
+		{
+			frameOffsets[nbFrames++] = syncOffset;
+			syncLen += pwm_kernel_syncLen(proto, pulseLens + syncOffset);
+		}
+	}
+	nbSyncs = nbFrames;
+	
+	// The syncs after the frames found, the last one included, also give the
+	// timebase of the sentence: they come at the period of the frames
+	if (proto->nominalSync > 0 && nbFrames >= 2)
+	{
+		period = frameOffsets[nbFrames-1] - frameOffsets[nbFrames-2];
+		for (syncOffset = frameOffsets[nbFrames-1] + period; syncOffset + 1 < nbPulses; syncOffset += period)
+		{
+			if (pwm_kernel_isSync(proto, pulseLens + syncOffset))
+			{
+				syncLen += pwm_kernel_syncLen(proto, pulseLens + syncOffset);
+				nbSyncs++;
+			}
+		}
+	}
+	scale = pwm_kernel_sentenceScale(proto, syncLen, nbSyncs);
+	
+	combined = combine_frames(pulseLens, nbPulses, frameOffsets, nbFrames, &frameLen);
+	if (combined != NULL && pwm_kernel_decodeSynced(proto, combined, frameLen, scale, interpreter) > 0) {
+		return 1;
+	}
+	
+	// Otherwise, decode each frame on its own
+	syncOffset = 0;
+	while (nbPulses - syncOffset > proto->minNumPulses)
+	{
+		if (pwm_kernel_isSync(proto, pulseLens + syncOffset))
+		{
+			// Valid sync pulses found - try and decode the frame
+			used = pwm_kernel_decodeSynced(proto, pulseLens + syncOffset, nbPulses - syncOffset, scale, interpreter);
+			syncOffset += 2 + used;
+			
+			if (used > 0)
+			{
+				decoded++;
+				// Stop printing frames when over budget
+				if ((proto->flags & PWM_FIRST_FRAME_ONLY) || budget_expired()) {
+					break;
+				}
+			}
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	}
+	
+	return (decoded > 0);
+}
+
+
+#endif // GENERIC_PWM_KERNEL_H
@@ -1,5 +1,7 @@
 #include "main.h"
 #include "decoder.h"
+#include "generic_manchester.h"
+#include "record.h"
 
 /*******************************************************************************
  * HOMEEASY DECODER                                                            *
@@ -48,9 +50,9 @@
 #define CODE_SHIFT			0
 
 
-static uint16_t decode_homeEasy(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_homeEasy(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_HomeEasy = {
+const decoderDesc_t decoder_HomeEasy = {
 	.name			= "HomeEasy",
 	.minPulseLen  	= MIN_HIGH_LEN,
 	.maxPulseLen  	= MAX_LONG_LOW_LEN,
@@ -58,24 +60,37 @@ decoderDesc_t decoder_HomeEasy = {
 	.decoderFunc	= decode_homeEasy
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_HOME_EASY, MIN_HIGH_LEN, MAX_LONG_LOW_LEN, MIN_NUM_PULSES);
 
-static uint16_t decode_synced_sentence_homeEasy(uint32_t *pulseLens, uint16_t nbPulses)
+//! Records: command, and partial frame
+static const recordType_t	recordCommand = {
+	.format		= "%s,Transmitter=0x%04X,Device=%d,State=%d,IsGroup=%d\n",
+	.nbValues	= 4,
+	.fields		= { "Transmitter", "Device", "State", "IsGroup" }
+};
+static const recordType_t	recordRaw = {
+	.format		= "%s,%d,0x%08X\n",
+	.nbValues	= 2,
+	.fields		= { "Length", "Data" }
+};
+
+
+static uint16_t decode_synced_sentence_homeEasy(uint16_t *pulseLens, uint16_t nbPulses)
 {
 	uint16_t	i;
-	uint8_t		dataBitOffset,
-	
-				// Usage: manchesterBit == 0 if we are receiving the first half of a bit
-				// manchesterBit == 1 if the first half of the bit was 1
-				// manchesterBit == 2 if the first half of the bit was 0
-				manchesterBit;	
-	
+	uint8_t		dataBitOffset;
+	int8_t		bit;
 	uint32_t	rawData			= 0;
 	
+	// Each pair of pulses codes a half-bit: long low is a 1, short low is a 0
+	manchesterState_t	manchester;
+	
 	
 	// Prepare the data buffer
 	rawData			= 0;
 	dataBitOffset	= RAW_DATA_LEN;
-	manchesterBit	= 0;
+	manchester_init(&manchester, 0, 0, 0);
 	
 	// Loop on the remaining pulses
 	// i is already pointing to the first data pulse
@@ -83,27 +98,18 @@ static uint16_t decode_synced_sentence_homeEasy(uint32_t *pulseLens, uint16_t nb
 	{
 		if (dataBitOffset && IS_HIGH_PULSE(pulseLens[i]))
 		{
-			if (manchesterBit == 0)
-			{
-				manchesterBit = (IS_LONG_LOW(pulseLens[i+1]) ? 1 : 2);
-			}
-			else if (manchesterBit == 1 && !IS_LONG_LOW(pulseLens[i+1]))
-			{
-				// Received manchester 10 => codes a 1
-				rawData |= (1 << --dataBitOffset);
-				manchesterBit = 0;
-			}
-			else if (manchesterBit == 2 && IS_LONG_LOW(pulseLens[i+1]))
-			{
-				// Received manchester 01 => codes a 0
-				dataBitOffset--;
-				manchesterBit = 0;
-			}
-			else
+			bit = manchester_stepSymbol(&manchester, IS_LONG_LOW(pulseLens[i+1]));
+			
+			if (bit == MANCHESTER_ERROR)
 			{
 				// Invalid bit
 				break;
 			}
+			else if (bit != MANCHESTER_NO_BIT)
+			{
+				// Received manchester 10 => codes a 1, 01 => codes a 0
+				rawData |= ((uint32_t)bit << --dataBitOffset);
+			}
 		}
 		else
 		{
@@ -114,20 +120,20 @@ static uint16_t decode_synced_sentence_homeEasy(uint32_t *pulseLens, uint16_t nb
 	if (dataBitOffset == 0)
 	{
 		// Decode the raw data
-		PRINTF("%s,Transmitter=0x%04X,Device=%d,State=%d,IsGroup=%d\n", decoder_HomeEasy.name, BIN_VALUE(TID), BIN_VALUE(CODE), BIN_VALUE(STATE), BIN_VALUE(GROUP));
+		record_emit((const char *)decoder_HomeEasy.name, &recordCommand, BIN_VALUE(TID), BIN_VALUE(CODE), BIN_VALUE(STATE), BIN_VALUE(GROUP));
 		return i;
 	}
 	else if (dataBitOffset <= 8)
 	{
 		// Display the raw data
-		PRINTF("%s,%d,0x%08X\n", decoder_HomeEasy.name, RAW_DATA_LEN - dataBitOffset, rawData);
+		record_emit((const char *)decoder_HomeEasy.name, &recordRaw, RAW_DATA_LEN - dataBitOffset, rawData);
 		return i;
 	}
 	
 	return 0;
 }
 
-static uint16_t decode_homeEasy(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_homeEasy(uint16_t *pulseLens, uint16_t nbPulses)
 {
 	uint16_t	result = 0;
 	uint16_t	syncOffset = 0;
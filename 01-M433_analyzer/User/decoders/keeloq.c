@@ -0,0 +1,157 @@
+#include "keeloq.h"
+#include "defines.h"
+
+// KEELOQ_PRESS_WINDOW in systick units (10us)
+#define WINDOW_TICKS		(KEELOQ_PRESS_WINDOW * 100)
+
+// Multiplicative hash of the serial number (Knuth)
+#define HASH_MULTIPLIER		2654435761u
+#define HASH_SLOT(serial)	(((serial) * HASH_MULTIPLIER) >> (32 - KEELOQ_FOB_TABLE_BITS))
+
+#define FOB_TABLE_SIZE		(1 << KEELOQ_FOB_TABLE_BITS)
+
+STATIC_ASSERT(KEELOQ_FOB_MAX_PROBES <= FOB_TABLE_SIZE);
+
+// Hopping part, once decrypted
+#define COUNTER_MASK		0x0000FFFF
+#define DISC_MASK			0x03FF0000
+#define DISC_SHIFT			16
+#define BUTTONS_MASK		0xF0000000
+#define BUTTONS_SHIFT		28
+
+#define KEELOQ_NLF			0x3A5C742E
+#define KEELOQ_ROUNDS		528
+
+
+static keeloqFob_t	fobs[FOB_TABLE_SIZE];
+
+
+#ifdef KEELOQ_MANUFACTURER_KEY
+
+#define BIT(x, n)			(((x) >> (n)) & 1)
+#define NLF_INDEX(x, a, b, c, d, e)	(BIT(x, a) | (BIT(x, b) << 1) | (BIT(x, c) << 2) | (BIT(x, d) << 3) | (BIT(x, e) << 4))
+
+static uint32_t keeloq_decrypt(uint32_t data, uint64_t key)
+{
+	uint16_t	r;
+	
+	
+	for (r = 0; r < KEELOQ_ROUNDS; r++)
+	{
+		data = (data << 1) ^ BIT(data, 31) ^ BIT(data, 15) ^ (uint32_t)BIT(key, (15 - r) & 63) ^
+			BIT(KEELOQ_NLF, NLF_INDEX(data, 0, 8, 19, 25, 30));
+	}
+	return data;
+}
+
+/*!
+ * @brief Key of a fob, derived from its serial number (normal learning)
+ */
+static uint64_t keeloq_deviceKey(uint32_t serial)
+{
+	return ((uint64_t)keeloq_decrypt(serial | 0x60000000, KEELOQ_MANUFACTURER_KEY) << 32) |
+		keeloq_decrypt(serial | 0x20000000, KEELOQ_MANUFACTURER_KEY);
+}
+
+#endif // KEELOQ_MANUFACTURER_KEY
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Split a frame into its fields
+ * @param[in]	bits	Finished frame, at least KEELOQ_MIN_BITS long
+ */
+void keeloq_parse(const bitvec_t *bits, keeloqFrame_t *frame)
+{
+	frame->hop			= bitvec_fieldLsb(bits, 0, 32);
+	frame->serial		= bitvec_fieldLsb(bits, 32, 28);
+	frame->buttons		= bitvec_fieldLsb(bits, 60, 4);
+	frame->lowBattery	= (bits->nbBits > 64 ? bitvec_bit(bits, 64) : 0);
+	frame->repeat		= (bits->nbBits > 65 ? bitvec_bit(bits, 65) : 0);
+	frame->decrypted	= 0;
+	frame->counter		= 0;
+	frame->valid		= 0;
+	
+#ifdef KEELOQ_MANUFACTURER_KEY
+	{
+		uint32_t	plain = keeloq_decrypt(frame->hop, keeloq_deviceKey(frame->serial));
+		
+		frame->decrypted	= 1;
+		frame->counter		= plain & COUNTER_MASK;
+		frame->valid		= ((plain & DISC_MASK) >> DISC_SHIFT) == (frame->serial & 0x3FF) &&
+							  ((plain & BUTTONS_MASK) >> BUTTONS_SHIFT) == frame->buttons;
+	}
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Record a frame in the fob table
+ *
+ * The serial is looked up in the KEELOQ_FOB_MAX_PROBES slots following its hash
+ * slot. An unknown fob takes the first free slot, or replaces the fob seen the
+ * longest time ago among these slots. Slots are never freed, so a lookup may
+ * stop at the first free slot.
+ *
+ * @return The fob entry if the frame starts a new press, NULL if it repeats the
+ * 		current press
+ */
+keeloqFob_t *keeloq_track(const keeloqFrame_t *frame)
+{
+	uint8_t		i;
+	uint32_t	now = sysTickTime;
+	keeloqFob_t	*fob, *oldest = NULL;
+	
+	
+	for (i = 0; i < KEELOQ_FOB_MAX_PROBES; i++)
+	{
+		fob = &fobs[(HASH_SLOT(frame->serial) + i) & (FOB_TABLE_SIZE - 1)];
+		
+		if (fob->presses == 0)
+		{
+			// Unknown fob
+			oldest = fob;
+			break;
+		}
+		
+		if (fob->serial == frame->serial)
+		{
+			if (fob->hop == frame->hop && now - fob->lastSeen < WINDOW_TICKS)
+			{
+				// Same press
+				fob->lastSeen = now;
+				fob->frames++;
+				return NULL;
+			}
+			
+			fob->presses++;
+			fob->frames		= 1;
+			fob->hop		= frame->hop;
+			fob->lastSeen	= now;
+			if (frame->decrypted)
+			{
+				fob->gap		= frame->counter - fob->counter;
+				fob->counter	= frame->counter;
+				if (fob->gap > fob->maxGap) {
+					fob->maxGap = fob->gap;
+				}
+			}
+			return fob;
+		}
+		
+		if (oldest == NULL || now - fob->lastSeen > now - oldest->lastSeen) {
+			oldest = fob;
+		}
+	}
+	
+	// New fob
+	oldest->serial		= frame->serial;
+	oldest->hop			= frame->hop;
+	oldest->lastSeen	= now;
+	oldest->presses		= 1;
+	oldest->frames		= 1;
+	oldest->counter		= frame->counter;
+	oldest->gap			= 0;
+	oldest->maxGap		= 0;
+	return oldest;
+}
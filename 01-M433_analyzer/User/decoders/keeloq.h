@@ -0,0 +1,60 @@
+#ifndef KEELOQ_H
+#define KEELOQ_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*
+ * KeeLoq rolling code frames.
+ *
+ * A frame holds 66 bits, sent LSB first:
+ * 		Bits 0-31		Encrypted (hopping) part: counter, discrimination, buttons
+ * 		Bits 32-59		Serial number of the fob
+ * 		Bits 60-63		Buttons (sent in clear as well)
+ * 		Bit 64			Low battery
+ * 		Bit 65			Repeat
+ *
+ * The fobs are tracked in a fixed-size open-addressing table (keyed by serial),
+ * so that a button press is reported once instead of once per frame: the fob
+ * repeats the same hopping code while the button is held, and a new press sends
+ * a new one.
+ *
+ * With KEELOQ_MANUFACTURER_KEY (defines.h), the hopping part is decrypted
+ * (normal learning) to give the press counter, and the gap between the counters
+ * of 2 presses tells how many presses were missed.
+ */
+
+//! Number of bits of a frame, without and with the status bits
+#define KEELOQ_MIN_BITS		64
+#define KEELOQ_MAX_BITS		66
+
+//! Frame fields
+typedef struct {
+	uint32_t	hop;			// Encrypted part
+	uint32_t	serial;			// 28 bits
+	uint8_t		buttons;		// 4 bits
+	uint8_t		lowBattery;
+	uint8_t		repeat;
+	uint8_t		decrypted;		// 1 if counter and valid are set (manufacturer key known)
+	uint16_t	counter;
+	uint8_t		valid;			// Decrypted discrimination bits and buttons match the clear part
+} keeloqFrame_t;
+
+//! Tracked fob
+typedef struct {
+	uint32_t	serial;
+	uint32_t	hop;			// Hopping code of the last press
+	uint32_t	lastSeen;		// sysTickTime of the last frame
+	uint16_t	presses;		// Number of presses (0: free slot)
+	uint16_t	frames;			// Number of frames of the last press
+	uint16_t	counter;		// Counter of the last press (decrypted frames only)
+	uint16_t	gap;			// Counter gap with the previous press
+	uint16_t	maxGap;
+} keeloqFob_t;
+
+
+void		keeloq_parse(const bitvec_t *bits, keeloqFrame_t *frame);
+keeloqFob_t	*keeloq_track(const keeloqFrame_t *frame);
+
+
+#endif // KEELOQ_H
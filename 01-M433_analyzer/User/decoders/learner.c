@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <string.h>
+#include "learner.h"
+
+//! Max number of timing classes of a sentence (the other pulses are noise)
+#define MAX_CLASSES			8
+#define NO_CLASS			0xFF
+
+//! Max frame length (bits), as for the PWM engine
+#define MAX_BITS			256
+
+//! The short pulses are at least 1/DATA_CLASS_RATIO of the pulses
+#define DATA_CLASS_RATIO	8
+
+//! Sync pulses are at least SYNC_RATIO times longer than the short pulses
+#define SYNC_RATIO			4
+
+//! Pairs breaking the bit encoding tolerated (1/NOISE_RATIO of the pairs)
+#define NOISE_RATIO			16
+
+//! Timing ratios of the sentences of a device, from a sentence to the next (%)
+#define RATIO_TOLERANCE		15
+
+//! Margins of the windows of a described protocol (%)
+#define DATA_MARGIN			30
+#define SYNC_MARGIN			35
+
+// FNV-1a parameters
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME			16777619u
+
+// v within tol % of ref (pulse lens fit in 16 bits, no overflow)
+#define SIMILAR(v, ref, tol)	(100 * (uint32_t)(v) > (100 - (tol)) * (uint32_t)(ref) && \
+								 100 * (uint32_t)(v) < (100 + (tol)) * (uint32_t)(ref))
+
+#define MIN(a, b)			((a) < (b) ? (a) : (b))
+#define MAX(a, b)			((a) > (b) ? (a) : (b))
+#define CLAMP16(n)			MIN((n), 0xFFFF)
+
+
+//! Timing class
+typedef struct {
+	uint32_t	sum;
+	uint16_t	count;
+	uint16_t	lowCount;		// Occurrences as a low pulse (odd index)
+	uint16_t	mean;
+} timingClass_t;
+
+static learnerEntry_t	learned[LEARNER_MAX_SIGNATURES];
+
+//! Number of sentences learned, to find the least recently seen entry
+static uint32_t			sentenceCount = 0;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Cluster the pulse lens into timing classes, sorted by mean len
+ * @return Number of classes
+ */
+static uint8_t learner_cluster(const uint16_t *pulseLens, uint16_t nbPulses, timingClass_t *classes)
+{
+	uint16_t		i;
+	uint8_t			c, nbClasses = 0;
+	timingClass_t	moved;
+	
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		for (c = 0; c < nbClasses && !SIMILAR(pulseLens[i], classes[c].mean, LEARNER_CLASS_TOLERANCE); c++);
+	
+		if (c == nbClasses)
+		{
+			if (nbClasses == MAX_CLASSES) {
+				continue;
+			}
+			memset(&classes[c], 0, sizeof(classes[c]));
+			nbClasses++;
+		}
+	
+		classes[c].sum		+= pulseLens[i];
+		classes[c].count	+= 1;
+		classes[c].lowCount	+= (i & 1);
+		classes[c].mean		= classes[c].sum / classes[c].count;
+	}
+	
+	// Insertion sort
+	for (i = 1; i < nbClasses; i++)
+	{
+		moved = classes[i];
+		for (c = i; c > 0 && classes[c-1].mean > moved.mean; c--) {
+			classes[c] = classes[c-1];
+		}
+		classes[c] = moved;
+	}
+	
+	// Merge the neighbour classes whose means drifted together
+	for (c = 1; c < nbClasses; )
+	{
+		if (SIMILAR(classes[c].mean, classes[c-1].mean, LEARNER_CLASS_TOLERANCE))
+		{
+			classes[c-1].sum		+= classes[c].sum;
+			classes[c-1].count		+= classes[c].count;
+			classes[c-1].lowCount	+= classes[c].lowCount;
+			classes[c-1].mean		= classes[c-1].sum / classes[c-1].count;
+			memmove(&classes[c], &classes[c+1], (nbClasses - c - 1) * sizeof(*classes));
+			nbClasses--;
+		}
+		else
+		{
+			c++;
+		}
+	}
+	
+	return nbClasses;
+}
+
+/*!
+ * @brief Timing class of a pulse
+ * @return Index of the class, or NO_CLASS
+ */
+static uint8_t learner_classOf(uint16_t pulseLen, const timingClass_t *classes, uint8_t nbClasses)
+{
+	uint8_t	c;
+	
+	
+	for (c = 0; c < nbClasses; c++)
+	{
+		if (SIMILAR(pulseLen, classes[c].mean, LEARNER_CLASS_TOLERANCE)) {
+			return c;
+		}
+	}
+	return NO_CLASS;
+}
+
+/*!
+ * @brief Round 2.log2(len / ref), i.e. the ratio of two timings in half octaves
+ */
+static uint8_t learner_halfOctaves(uint32_t len, uint32_t ref)
+{
+	// (len / ref)^2 * sqrt(2) ~= a / b
+	uint64_t	a = (uint64_t)len * len * 181,
+				b = (uint64_t)ref * ref * 128;
+	uint8_t		k;
+	
+	
+	for (k = 0; a >= 2 * b; k++) {
+		b *= 2;
+	}
+	return k;
+}
+
+static uint32_t learner_hash(uint32_t hash, uint32_t value)
+{
+	uint8_t	i;
+	
+	
+	for (i = 0; i < 4; i++, value >>= 8) {
+		hash = (hash ^ (value & 0xFF)) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/*!
+ * @brief Signature of a protocol
+ *
+ * Only the ratios of the timings to the short pulse are used, rounded to half
+ * octaves: the clock of a device drifts with its temperature and battery.
+ */
+static uint32_t learner_signature(const learnerShape_t *shape)
+{
+	uint32_t	hash = FNV_OFFSET_BASIS;
+	
+	
+	hash = learner_hash(hash, shape->syncShape | (shape->encoding << 8) | ((uint32_t)shape->nbBits << 16));
+	hash = learner_hash(hash, learner_halfOctaves(shape->longLen, shape->shortLen));
+	hash = learner_hash(hash, learner_halfOctaves(shape->syncLen, shape->shortLen));
+	hash = learner_hash(hash, learner_halfOctaves(shape->syncHighLen, shape->shortLen));
+	return hash;
+}
+
+/*!
+ * @brief Number of short/long pairs following the low pulses of a class
+ *
+ * A gap between the frames is as frequent as the sync, when each frame is
+ * followed by one: only the sync is followed by data.
+ */
+static uint16_t learner_pairsAfter(const uint16_t *pulseLens, uint16_t nbPulses, const timingClass_t *classes,
+	uint8_t nbClasses, uint8_t sync, uint8_t s, uint8_t l)
+{
+	uint16_t	i, j, nbPairs = 0;
+	uint8_t		hc, lc;
+	
+	
+	for (i = 1; i < nbPulses; i += 2)
+	{
+		if (learner_classOf(pulseLens[i], classes, nbClasses) != sync) {
+			continue;
+		}
+		for (j = i + 1; j + 1 < nbPulses; j += 2, nbPairs++)
+		{
+			hc = learner_classOf(pulseLens[j], classes, nbClasses);
+			lc = learner_classOf(pulseLens[j+1], classes, nbClasses);
+			if ((hc != s && hc != l) || (lc != s && lc != l)) {
+				break;
+			}
+		}
+	}
+	return nbPairs;
+}
+
+/*!
+ * @brief Timing ratios (len / short) of two shapes within RATIO_TOLERANCE %
+ */
+static uint8_t learner_sameRatio(uint16_t lenA, uint16_t shortA, uint16_t lenB, uint16_t shortB)
+{
+	uint64_t	a = (uint64_t)lenA * shortB,
+				b = (uint64_t)lenB * shortA;
+	
+	
+	return 100 * a >= (100 - RATIO_TOLERANCE) * b && 100 * a <= (100 + RATIO_TOLERANCE) * b;
+}
+
+/*!
+ * @brief Same protocol: same shape, and timing ratios within RATIO_TOLERANCE %
+ *
+ * A ratio close to a rounding boundary of the signature gives another signature
+ * to some sentences of a device: they still belong to its entry.
+ */
+static uint8_t learner_similar(const learnerShape_t *a, const learnerShape_t *b)
+{
+	return a->syncShape == b->syncShape && a->encoding == b->encoding && a->nbBits == b->nbBits &&
+		SIMILAR(a->shortLen, b->shortLen, LEARNER_CLASS_TOLERANCE) &&
+		learner_sameRatio(a->longLen, a->shortLen, b->longLen, b->shortLen) &&
+		learner_sameRatio(a->syncLen, a->shortLen, b->syncLen, b->shortLen) &&
+		learner_sameRatio(a->syncHighLen, a->shortLen, b->syncHighLen, b->shortLen);
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Infer the protocol of a sentence
+ * @param[out]	shape	Protocol (signature included)
+ * @param[out]	data	First 64 bits of the longest frame
+ * @return 1 if the sentence looks like a PWM protocol
+ */
+uint8_t learner_analyze(const uint16_t *pulseLens, uint16_t nbPulses, learnerShape_t *shape, uint32_t *data)
+{
+	timingClass_t	classes[MAX_CLASSES];
+	uint16_t		highVotes[MAX_CLASSES] = { 0 };
+	uint16_t		pairs[4] = { 0 };		// Short/long high pulse * 2 + short/long low pulse
+	uint16_t		i, j, nbBits = 0, frameBits, frameStart = 0, nbSyncs = 0, noise, syncPairs = 0, n;
+	uint8_t			nbClasses, c, hc, lc,
+					s = NO_CLASS, l = NO_CLASS, sync = NO_CLASS, syncHigh = NO_CLASS;
+	
+	
+	nbClasses = learner_cluster(pulseLens, nbPulses, classes);
+	
+	// Short pulses: the shortest frequent class
+	for (c = 0; c < nbClasses && s == NO_CLASS; c++)
+	{
+		if (classes[c].count * DATA_CLASS_RATIO >= nbPulses) {
+			s = c;
+		}
+	}
+	if (s == NO_CLASS) {
+		return 0;
+	}
+	
+	// Long pulses: the most frequent data class after it
+	for (c = s + 1; c < nbClasses && classes[c].mean < SYNC_RATIO * classes[s].mean; c++)
+	{
+		if (l == NO_CLASS || classes[c].count > classes[l].count) {
+			l = c;
+		}
+	}
+	if (l == NO_CLASS) {
+		return 0;
+	}
+	
+	// Sync: the long low pulse followed by the most data pairs (the shortest one
+	// on a tie)
+	for (; c < nbClasses; c++)
+	{
+		if (classes[c].lowCount > 0 &&
+			(n = learner_pairsAfter(pulseLens, nbPulses, classes, nbClasses, c, s, l)) > syncPairs)
+		{
+			sync = c;
+			syncPairs = n;
+		}
+	}
+	if (sync == NO_CLASS) {
+		return 0;
+	}
+	
+	// High sync pulse: a long pulse before most of the low sync pulses
+	for (i = 1; i < nbPulses; i += 2)
+	{
+		if (learner_classOf(pulseLens[i], classes, nbClasses) == sync)
+		{
+			nbSyncs++;
+			hc = learner_classOf(pulseLens[i-1], classes, nbClasses);
+			if (hc != NO_CLASS && classes[hc].mean >= SYNC_RATIO * classes[s].mean) {
+				highVotes[hc]++;
+			}
+		}
+	}
+	for (c = 0; c < nbClasses; c++)
+	{
+		if (2 * highVotes[c] > nbSyncs && (syncHigh == NO_CLASS || highVotes[c] > highVotes[syncHigh])) {
+			syncHigh = c;
+		}
+	}
+	
+	// Frames: short/long pairs after each sync
+	for (i = 1; i < nbPulses; i += 2)
+	{
+		if (learner_classOf(pulseLens[i], classes, nbClasses) != sync ||
+			(syncHigh != NO_CLASS && learner_classOf(pulseLens[i-1], classes, nbClasses) != syncHigh))
+		{
+			continue;
+		}
+	
+		for (j = i + 1, frameBits = 0; j + 1 < nbPulses && frameBits < MAX_BITS; j += 2, frameBits++)
+		{
+			hc = learner_classOf(pulseLens[j], classes, nbClasses);
+			lc = learner_classOf(pulseLens[j+1], classes, nbClasses);
+			if ((hc != s && hc != l) || (lc != s && lc != l)) {
+				break;
+			}
+			pairs[(hc == l) * 2 + (lc == l)]++;
+		}
+	
+		if (frameBits > nbBits)
+		{
+			nbBits = frameBits;
+			frameStart = i + 1;
+		}
+		// The pulse ending the frame may be the next sync
+		i = j - 1;
+	}
+	if (nbBits < LEARNER_MIN_BITS) {
+		return 0;
+	}
+	
+	// Bit encoding: the high pulses are short (the low pulse gives the bit), or
+	// the pairs are short + long / long + short
+	noise = (pairs[0] + pairs[1] + pairs[2] + pairs[3]) / NOISE_RATIO;
+	if (pairs[2] + pairs[3] <= noise) {
+		shape->encoding = PROTO_BIT_SECOND;
+	} else if (pairs[0] + pairs[3] <= noise) {
+		shape->encoding = PROTO_BIT_BOTH;
+	} else {
+		return 0;
+	}
+	
+	shape->syncShape	= (syncHigh == NO_CLASS ? PROTO_SYNC_LOW : PROTO_SYNC_HIGH_LOW);
+	shape->nbBits		= nbBits;
+	shape->shortLen		= classes[s].mean;
+	shape->longLen		= classes[l].mean;
+	shape->syncLen		= classes[sync].mean;
+	shape->syncHighLen	= (syncHigh == NO_CLASS ? 0 : classes[syncHigh].mean);
+	shape->signature	= learner_signature(shape);
+	
+	// Bits of the longest frame
+	data[0] = data[1] = 0;
+	for (i = 0; i < nbBits && i < 64; i++)
+	{
+		j = frameStart + 2 * i + (shape->encoding == PROTO_BIT_SECOND);
+		if (learner_classOf(pulseLens[j], classes, nbClasses) == l) {
+			data[i >> 5] |= 0x80000000 >> (i & 31);
+		}
+	}
+	
+	return 1;
+}
+
+/*!
+ * @brief Learn the protocol of a sentence no decoder matched
+ * @return 1 if the sentence looks like a PWM protocol
+ */
+uint8_t learner_learn(const uint16_t *pulseLens, uint16_t nbPulses, learnerResult_t *result)
+{
+	learnerShape_t	shape;
+	learnerEntry_t	*entry, *victim = &learned[0];
+	
+	
+	if (!learner_analyze(pulseLens, nbPulses, &shape, result->data)) {
+		return 0;
+	}
+	sentenceCount++;
+	
+	// The same device, or the same protocol at another speed
+	for (entry = learned; entry < learned + LEARNER_MAX_SIGNATURES; entry++)
+	{
+		if (entry->seen > 0 && ((entry->shape.signature == shape.signature &&
+			SIMILAR(shape.shortLen, entry->shape.shortLen, LEARNER_CLASS_TOLERANCE)) || learner_similar(&entry->shape, &shape)))
+		{
+			break;
+		}
+		if (entry->lastUse < victim->lastUse) {
+			victim = entry;
+		}
+	}
+	
+	result->isNew = (entry == learned + LEARNER_MAX_SIGNATURES);
+	if (result->isNew)
+	{
+		entry			= victim;
+		entry->shape	= shape;
+		entry->seen		= 0;
+	}
+	if (entry->seen < 0xFFFF) {
+		entry->seen++;
+	}
+	entry->lastUse	= sentenceCount;
+	
+	result->entry	= entry;
+	result->nbBits	= shape.nbBits;
+	return 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Protocol descriptor of a learned protocol (see protocol_store.h)
+ */
+void learner_describe(const learnerShape_t *shape, protoDesc_t *desc)
+{
+	// Short/long boundary, at the same relative distance from both timings
+	uint32_t	middle = 2 * (uint32_t)shape->shortLen * shape->longLen / (shape->shortLen + shape->longLen);
+	
+	
+	memset(desc, 0, sizeof(*desc));
+	snprintf(desc->name, PROTO_DESC_NAME_LEN, "L%06lX", (unsigned long)(shape->signature & 0xFFFFFF));
+	
+	desc->syncShape		= shape->syncShape;
+	desc->encoding		= shape->encoding;
+	desc->syncMin		= (uint32_t)shape->syncLen * (100 - SYNC_MARGIN) / 100;
+	desc->syncMax		= (uint32_t)shape->syncLen * (100 + SYNC_MARGIN) / 100;
+	desc->nominalSync	= shape->syncLen;
+	if (shape->syncShape == PROTO_SYNC_HIGH_LOW)
+	{
+		desc->syncHighMin	= (uint32_t)shape->syncHighLen * (100 - SYNC_MARGIN) / 100;
+		desc->syncHighMax	= CLAMP16((uint32_t)shape->syncHighLen * (100 + SYNC_MARGIN) / 100);
+	}
+	
+	desc->shortMin		= (uint32_t)shape->shortLen * (100 - DATA_MARGIN) / 100;
+	desc->shortMax		= MIN((uint32_t)shape->shortLen * (100 + DATA_MARGIN) / 100, middle);
+	desc->longMin		= MAX((uint32_t)shape->longLen * (100 - DATA_MARGIN) / 100, middle);
+	desc->longMax		= CLAMP16((uint32_t)shape->longLen * (100 + DATA_MARGIN) / 100);
+	desc->firstMin		= desc->shortMin;
+	desc->firstMax		= desc->shortMax;
+	
+	desc->maxBits		= shape->nbBits;
+	desc->minBits		= shape->nbBits;
+	desc->minNumPulses	= 2 * shape->nbBits;
+	desc->minPulseLen	= desc->shortMin;
+	desc->maxPulseLen	= CLAMP16(MAX(desc->syncMax, desc->syncHighMax));
+	desc->flags			= PROTO_FIRST_FRAME_ONLY;
+}
+
+/*!
+ * @brief Format the report of a learned sentence
+ *
+ * A new protocol is described along with its descriptor, in the format of the
+ * "PSTORE DESC" command. A known one is only reported by its signature.
+ *
+ * @return Length of the report (as snprintf)
+ */
+int learner_format(const learnerResult_t *result, char *buffer, uint16_t len)
+{
+	const learnerShape_t	*shape = &result->entry->shape;
+	protoDesc_t				desc;
+	char					data[20];
+	int						n;
+	uint8_t					i;
+	
+	
+	if (result->nbBits > 32) {
+		snprintf(data, sizeof(data), "%08lX%08lX", (unsigned long)result->data[0], (unsigned long)result->data[1]);
+	} else {
+		snprintf(data, sizeof(data), "%08lX", (unsigned long)result->data[0]);
+	}
+	
+	if (!result->isNew) {
+		return snprintf(buffer, len, "Unknown,Sig=%08lX,Bits=%d,Data=0x%s\n", (unsigned long)shape->signature, result->nbBits, data);
+	}
+	
+	learner_describe(shape, &desc);
+	n = snprintf(buffer, len, "Learned,Sig=%08lX,Sync=%s,Encoding=%s,Bits=%d,Short=%d,Long=%d,SyncLen=%d,SyncHigh=%d,Data=0x%s,Desc=",
+		(unsigned long)shape->signature, LEARNER_SYNC_NAME(shape->syncShape), LEARNER_BIT_NAME(shape->encoding),
+		shape->nbBits, shape->shortLen, shape->longLen, shape->syncLen, shape->syncHighLen, data);
+	
+	for (i = 0; i < sizeof(desc) && n + 3 < len; i++) {
+		n += snprintf(buffer + n, len - n, "%02X", ((const uint8_t *)&desc)[i]);
+	}
+	if (n + 1 < len) {
+		n += snprintf(buffer + n, len - n, "\n");
+	}
+	return n;
+}
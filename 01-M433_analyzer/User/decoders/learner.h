@@ -0,0 +1,69 @@
+#ifndef LEARNER_H
+#define LEARNER_H
+
+#include <stdint.h>
+#include "defines.h"
+#include "protocol_desc.h"
+
+/*
+ * Learner of unknown PWM protocols.
+ *
+ * The pulses of a sentence no decoder matched are clustered into timing classes
+ * (pulse lens within LEARNER_CLASS_TOLERANCE % of the class mean). The short
+ * and long data classes, and the sync (the long low pulse followed by the most
+ * short/long pairs, possibly after a long high pulse: not the gap after each
+ * frame), give the shape of the protocol. The short/long pairs following
+ * each sync give the bit encoding (PROTO_BIT_SECOND or PROTO_BIT_BOTH) and the
+ * frame length.
+ *
+ * The learned protocols are kept in a table of LEARNER_MAX_SIGNATURES entries
+ * (the least recently seen one is replaced), so that a recurring device is
+ * reported by its signature instead of its raw pulses. The signature only
+ * depends on the shape of the protocol and on the ratios of its timings, so a
+ * device keeps its signature from one capture to the next (but for the
+ * sentences whose ratios fall on a rounding boundary: a sentence whose ratios
+ * are close to those of a learned protocol is counted in its entry).
+ *
+ * This module does not depend on the target: tools/learn.c runs it over
+ * capture files.
+ */
+
+//! Learned sync shapes and bit encodings (same values as in protocol_desc.h)
+#define LEARNER_SYNC_NAME(shape)	((shape) == PROTO_SYNC_HIGH_LOW ? "HighLow" : "Low")
+#define LEARNER_BIT_NAME(encoding)	((encoding) == PROTO_BIT_BOTH ? "Both" : "Second")
+
+//! Shape of a learned protocol
+typedef struct {
+	uint32_t	signature;
+	uint8_t		syncShape;			// PROTO_SYNC_LOW or PROTO_SYNC_HIGH_LOW
+	uint8_t		encoding;			// PROTO_BIT_SECOND or PROTO_BIT_BOTH
+	uint16_t	nbBits;				// Longest frame
+	uint16_t	shortLen;			// Mean lens of the timing classes (us)
+	uint16_t	longLen;
+	uint16_t	syncLen;
+	uint16_t	syncHighLen;		// PROTO_SYNC_HIGH_LOW only
+} learnerShape_t;
+
+//! Learned protocol
+typedef struct {
+	learnerShape_t	shape;
+	uint16_t		seen;			// Number of sentences (0: free entry)
+	uint32_t		lastUse;		// Sentence counter when last seen
+} learnerEntry_t;
+
+//! Result of learner_learn()
+typedef struct {
+	learnerEntry_t	*entry;
+	uint8_t			isNew;			// 1 the first time the protocol is seen
+	uint16_t		nbBits;			// Bits of the longest frame
+	uint32_t		data[2];		// Its first 64 bits, the first one as the MSB of data[0]
+} learnerResult_t;
+
+
+uint8_t		learner_analyze(const uint16_t *pulseLens, uint16_t nbPulses, learnerShape_t *shape, uint32_t *data);
+uint8_t		learner_learn(const uint16_t *pulseLens, uint16_t nbPulses, learnerResult_t *result);
+void		learner_describe(const learnerShape_t *shape, protoDesc_t *desc);
+int			learner_format(const learnerResult_t *result, char *buffer, uint16_t len);
+
+
+#endif // LEARNER_H
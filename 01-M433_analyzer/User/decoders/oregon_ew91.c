@@ -1,4 +1,7 @@
 #include "main.h"
+#include "bitvec.h"
+#include "repair.h"
+#include "record.h"
 
 /*******************************************************************************
  * OREGON EW91 DECODER                                                         *
@@ -20,6 +23,14 @@
  ******************
  * Expected: 8 significant bytes, last 4 are complements of first 4.
  * Found a better byte alignment by inserting a first 0 in the burst.
+ * Low pulses falling between the short and long windows are decided by the
+ * nearest window: if the complement check then fails, the least confident bits
+ * are flipped to repair the frame. The lines of the frames which did not pass
+ * the check as received are flagged, so that they can be told from the checked
+ * readings:
+ * 	- ",Repaired=<n>":	n bits were flipped to pass it,
+ * 	- ",Unchecked=<h>":	it failed, half h (1: first, 2: second, inverted) was
+ * 						taken as the reading because its digits looked valid.
  * 4 Bytes meaning
  * XXXX-XXXX  XXCC-SXXX  XXXX-RHHH  LLLL-DDDD
  * CC = Channel
@@ -34,6 +45,9 @@
 #define MIN_LONG_LEN	3500
 #define MAX_LONG_LEN	4500
 
+// Low pulses shorter than this are 0 bits, longer ones are 1 bits
+#define BIT_THRESHOLD	((MAX_SHORT_LEN + MIN_LONG_LEN) / 2)
+
 #define RAW_DATA_BYTES	8	// bytes
 #define MIN_NUM_PULSES	66	// at least 4 bytes * 2 pulses + 2 sync pulses
 
@@ -57,9 +71,9 @@
 #define TDEC_MASK		15 //0b1111
 #define TDEC_SHIFT		0
 
-static uint16_t decode_oregon_ew91(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_oregon_ew91(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_OregonEW91 = {
+const decoderDesc_t decoder_OregonEW91 = {
 	.name 			= "OregonEW91",
 	.minPulseLen  	= MIN_SHORT_LEN,
 	.maxPulseLen  	= MAX_LONG_LEN,
@@ -67,8 +81,35 @@ decoderDesc_t decoder_OregonEW91 = {
 	.decoderFunc	= decode_oregon_ew91
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_OREGON_EW91, MIN_SHORT_LEN, MAX_LONG_LEN, MIN_NUM_PULSES);
+
+//! Record: channel and temperature digits
+static const recordType_t	recordTemp = {
+	.format		= "%s,%d,%c%d%d.%d\n",
+	.nbValues	= 5,
+	.fields		= { "Channel", "Sign", "TempTens", "TempUnits", "TempDec" }
+};
+
+//! Record: the same, for a frame which passed the check once repaired
+static const recordType_t	recordTempRepaired = {
+	.format		= "%s,%d,%c%d%d.%d,Repaired=%d\n",
+	.nbValues	= 6,
+	.fields		= { "Channel", "Sign", "TempTens", "TempUnits", "TempDec", "Repaired" }
+};
+
+//! Record: the same, for a frame which failed the check
+static const recordType_t	recordTempUnchecked = {
+	.format		= "%s,%d,%c%d%d.%d,Unchecked=%d\n",
+	.nbValues	= 6,
+	.fields		= { "Channel", "Sign", "TempTens", "TempUnits", "TempDec", "Unchecked" }
+};
+
 
-static uint8_t interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nbBytes)
+/*!
+ * @param[in]	repaired	Number of bits flipped to pass the check (see repair_bits())
+ */
+static uint8_t interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nbBytes, uint8_t repaired)
 {
 	if (nbBytes < 4) {
 		return 0;
@@ -83,7 +124,7 @@ static uint8_t interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nb
 		if (BIN_VALUE_MB(THIGH) <= 9 && BIN_VALUE_MB(TLOW) <= 9 && BIN_VALUE_MB(TDEC) <= 9)
 		{
 			// Normal sentence seems good! Use this one anyway
-			PRINTF("%s,%d,%c%d%d.%d\n", decoder_OregonEW91.name, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+			record_emit((const char *)decoder_OregonEW91.name, &recordTempUnchecked, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC), 1);
 			return 1;
 		}
 		
@@ -98,7 +139,7 @@ static uint8_t interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nb
 			if (BIN_VALUE_MB(THIGH) <= 9 && BIN_VALUE_MB(TLOW) <= 9 && BIN_VALUE_MB(TDEC) <= 9 && (BIN_VALUE_MB(CHANNEL) == 1 || BIN_VALUE_MB(CHANNEL) == 2))
 			{
 				// Normal sentence seems good! Use this one
-				PRINTF("%s,%d,%c%d%d.%d\n", decoder_OregonEW91.name, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+				record_emit((const char *)decoder_OregonEW91.name, &recordTempUnchecked, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC), 2);
 				return 1;
 			}
 		}
@@ -108,32 +149,50 @@ static uint8_t interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nb
 	}
 	
 	// Parity check succeeded
-	PRINTF("%s,%d,%c%d%d.%d\n", decoder_OregonEW91.name, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+	if (repaired > 0)
+	{
+		record_emit((const char *)decoder_OregonEW91.name, &recordTempRepaired, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC), repaired);
+		return 1;
+	}
+	record_emit((const char *)decoder_OregonEW91.name, &recordTemp, BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
 	return 1;
 }
 
+/*!
+ * @brief Check that the last 4 bytes are the complements of the first 4 ones
+ */
+static uint8_t check_oregon_ew91(const bitvec_t *bits)
+{
+	return ((bits->words[0] ^ bits->words[1]) == 0xFFFFFFFF);
+}
+
 /*!
  * @param[in]	pulseLens	Durations of the pulses to decode
  * @param[in]	nbPulses	Number of pulses in pulseLens
  * @return		Number of pulses used, starting from offset 0
  */
-static uint16_t decode_synced_sentence(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_synced_sentence(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	i,
-				dataByteOffset	= 0;
+	uint16_t			i;
+	uint8_t				j;
+	uint8_t				rawData[RAW_DATA_BYTES];
+	bitvec_t			bits;
+	repairCandidates_t	candidates;
+	uint8_t				repaired = 0;
 	
-	uint8_t		dataByte 		= 0,
-				dataBitOffset	= 7; // First bit of first offset must be left to 0 for alignment
 	
-	uint8_t		rawData[RAW_DATA_BYTES];
-		
+	// First bit of first offset must be left to 0 for alignment
+	bitvec_reset(&bits);
+	bitvec_append(&bits, 0);
+	repair_reset(&candidates);
+	
 	// Decode the raw data
 	// pulseLens should point to the first data pulse
 	for (i = 0; i < nbPulses-1; i += 2)
 	{
-		if (!IS_SHORT(pulseLens[i]))
+		if (pulseLens[i] <= MIN_SHORT_LEN || pulseLens[i] >= BIT_THRESHOLD)
 		{
-			if (dataByteOffset < 4)
+			if (bits.nbBits < 4 * 8)
 			{
 				// PRINTF("Oregon: Invalid pulse @%d, len=%dus\n", i, pulseLens[i]);
 				return 0;
@@ -144,31 +203,37 @@ static uint16_t decode_synced_sentence(uint32_t *pulseLens, uint16_t nbPulses)
 				break;
 			}
 		}
-		if (IS_SHORT(pulseLens[i+1]))
-		{
-			// Nothing to do
-			dataBitOffset--;
-		}
-		else if (IS_LONG(pulseLens[i+1]))
-		{
-			dataByte |= (1 << --dataBitOffset);
-		}
-		
-		// If this byte is complete, switch to the next one
-		if (!dataBitOffset)
+		if (IS_VALID_PULSE(pulseLens[i+1]))
 		{
-			rawData[dataByteOffset++] = dataByte;
-			dataBitOffset = 8;
-			dataByte = 0;
+			// Only the pulses out of both windows are uncertain: the closer to
+			// the threshold, the less confident
+			if (!IS_SHORT(pulseLens[i+1]) && !IS_LONG(pulseLens[i+1])) {
+				repair_note(&candidates, bits.nbBits, (pulseLens[i+1] < BIT_THRESHOLD ? BIT_THRESHOLD - pulseLens[i+1] : pulseLens[i+1] - BIT_THRESHOLD));
+			}
+			bitvec_append(&bits, pulseLens[i+1] >= BIT_THRESHOLD);
 		}
 		
-		if (dataByteOffset == RAW_DATA_BYTES)
+		if (bits.nbBits == 8 * RAW_DATA_BYTES)
 		{
 			break;
 		}
 	}
 	
-	if (interpret_oregon_ew91(rawData, dataByteOffset+1))
+	// Only complete bytes are kept
+	bitvec_finish(&bits);
+	
+	if (bits.nbBits == 8 * RAW_DATA_BYTES && !check_oregon_ew91(&bits))
+	{
+		repaired = repair_bits(&bits, &candidates, check_oregon_ew91);
+	}
+	
+	memset(rawData, 0, RAW_DATA_BYTES);
+	for (j = 0; j < bits.nbBits / 8; j++)
+	{
+		rawData[j] = bitvec_byte(&bits, j);
+	}
+	
+	if (interpret_oregon_ew91(rawData, j, repaired))
 	{
 		return i;
 	}
@@ -178,7 +243,7 @@ static uint16_t decode_synced_sentence(uint32_t *pulseLens, uint16_t nbPulses)
 	}
 }
 
-static uint16_t decode_oregon_ew91(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_oregon_ew91(uint16_t *pulseLens, uint16_t nbPulses)
 {
 	uint16_t	result = 0;
 	uint16_t	syncOffset = 0;
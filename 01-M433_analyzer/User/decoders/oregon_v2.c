@@ -1,33 +1,129 @@
 #include "main.h"
+#include "generic_manchester.h"
+#include "stream.h"
+#include "record.h"
 
 /*******************************************************************************
- * OREGON V2 DECODER (UNTESTED)                                                *
+ * OREGON SCIENTIFIC V2.1 / V3 DECODER                                         *
  *******************************************************************************
  * SENTENCE ENCODING *
  *********************
  * SYNC:
- * 		To be documented
+ * 		V2.1: preamble of at least 24 long (2T) pulses, then a short pulse
+ * 		V3: preamble of at least 32 short (1T) pulses, then a long pulse
  * DATA:
- *  	Manchester encoding (To be documented)
+ *  	Manchester encoding, T = 488us
+ * 		V2.1: each bit is sent twice (the second copy is inverted and ignored)
+ * 		V3: each bit is sent once
  *
- * Implementation from: http://connectingstuff.net/blog/decodage-protocole-oregon-arduino-1/
+ * The decoder is a state machine fed one pulse at a time: the preamble gives the
+ * clock, then each Manchester bit is appended to the frame as soon as it is
+ * decoded, and a known sensor is reported as soon as its checksum has arrived.
+ * The batch decoder runs it over a whole sentence; with USE_STREAM_DECODERS, the
+ * receiver interrupt feeds it each pulse as it is recorded (see stream.h).
+ *
+ * References:
+ * - http://connectingstuff.net/blog/decodage-protocole-oregon-arduino-1/
+ * - http://wmrx00.sourceforge.net/Arduino/OregonScientific-RF-Protocols.pdf
  *
  ******************
  * INTERPRETATION *
  ******************
- * Nothing has been done at the moment.
+ * Nibbles are sent LSB first. Nibble 0 is the sync nibble (0xA):
+ * 		Nibbles 0-3		Sensor ID (bytes 0-1, sync included, e.g. 0x1A2D)
+ * 		Nibble 5		Channel (1, 2 or 4 for channel 3)
+ * 		Nibbles 6-7		Rolling code
+ * 		Nibble 8		Flags (bit 2: low battery)
+ * 		Nibbles 9-11	Temperature (BCD: tenths, units, tens)
+ * 		Nibble 12		Temperature sign (non-zero: negative)
+ * 		Nibbles 13-14	Humidity (BCD: units, tens), for temperature + humidity sensors
+ * The checksum is the sum of the data nibbles (the sync nibble excluded), on 8 bits:
+ * 		Temperature sensors: nibbles 1-12, checksum in nibbles 13-14
+ * 		Temperature + humidity sensors: nibbles 1-15, checksum in nibbles 16-17
+ * A frame from an unknown sensor is only reported (as raw nibbles) if the sum of
+ * its nibbles 1 to c-1 is in nibbles c and c+1, with at most
+ * MAX_TRAILING_NIBBLES nibbles after them (e.g. the CRC of V3 frames), and c at
+ * least MIN_CHECKSUM_NIBBLE.
  */
 #define MIN_SHORT_LEN	200
+#define MAX_SHORT_LEN	700
 
 #define MIN_LONG_LEN	700
 #define MAX_LONG_LEN	1200
 
 #define MIN_NUM_PULSES	150
 
+#define MIN_PREAMBLE_V2	24		// long pulses
+#define MIN_PREAMBLE_V3	32		// short pulses
+
+#define SYNC_NIBBLE		0xA
+
+// Nibble offsets
+#define CHANNEL_NIBBLE	5
+#define FLAGS_NIBBLE	8
+#define TDEC_NIBBLE		9
+#define TUNIT_NIBBLE	10
+#define TTEN_NIBBLE		11
+#define TSIGN_NIBBLE	12
+#define HUNIT_NIBBLE	13
+#define HTEN_NIBBLE		14
+
+#define LOW_BATTERY		0x4		// In the flags nibble
+
+// Checksum of the frames from unknown sensors
+#define MIN_CHECKSUM_NIBBLE		13
+#define MAX_TRAILING_NIBBLES	4
 
-static uint16_t decode_oregon_v2(uint32_t *pulseLens, uint16_t nbPulses);
+#define ID_BITS			16		// Nibbles 0-3
+
+//! Sensor families
+typedef enum {
+	OREGON_TEMP,				// Checksum in nibbles 13-14
+	OREGON_TEMP_HUMID			// Checksum in nibbles 16-17
+} oregonSensorType_t;
+
+typedef struct {
+	uint16_t			id;
+	oregonSensorType_t	type;
+} oregonSensor_t;
+
+static const oregonSensor_t oregonSensors[] =
+{
+	{ 0xEA4C,	OREGON_TEMP },			// THN132N, THWR288A
+	{ 0xCA48,	OREGON_TEMP },			// THWR800
+	{ 0x1A2D,	OREGON_TEMP_HUMID },	// THGR228N, THGN122N
+	{ 0x1A3D,	OREGON_TEMP_HUMID },	// THGR918
+	{ 0xFA28,	OREGON_TEMP_HUMID },	// THGR810
+};
+
+#define NB_SENSORS		(sizeof(oregonSensors) / sizeof(oregonSensors[0]))
+
+//! First nibble of the checksum of a sensor
+#define CHECKSUM_NIBBLE(sensor)	((sensor)->type == OREGON_TEMP ? 13 : 16)
+
+//! Decoder state: on the stack for the batch decoder, which is reentrant
+typedef enum {
+	OREGON_PREAMBLE,
+	OREGON_DATA,
+	OREGON_DONE					// A frame was reported, the rest of the sentence is ignored
+} oregonStep_t;
+
+typedef struct {
+	oregonStep_t		step;
+	uint8_t				version;			// 2 (V2.1) or 3
+	uint16_t			nbShort, nbLong;	// Length of the current preamble run
+	uint32_t			sumShort, sumLong;
+	uint16_t			nbManchesterBits;
+	uint8_t				level;				// Level of the previous pulse (1: high)
+	manchesterState_t	manchester;
+	bitvec_t			bits;				// Data bits
+	uint16_t			completeBits;		// Length of the frame of a known sensor, 0 if unknown yet
+} oregonDecoder_t;
+
+
+static uint16_t decode_oregon_v2(uint16_t *pulseLens, uint16_t nbPulses);
 	
-decoderDesc_t decoder_OregonV2 = {
+const decoderDesc_t decoder_OregonV2 = {
 	.name			= "OregonV2",
 	.minPulseLen  	= MIN_SHORT_LEN,
 	.maxPulseLen  	= MAX_LONG_LEN,
@@ -35,155 +131,390 @@ decoderDesc_t decoder_OregonV2 = {
 	.decoderFunc	= decode_oregon_v2
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_OREGON_V2, MIN_SHORT_LEN, MAX_LONG_LEN, MIN_NUM_PULSES);
 
+//! Records: unknown sensor, and temperature (and humidity) sensor
+static const recordType_t	recordUnknown = {
+	.format		= "%s,Version=%d,Sensor=0x%04X,Nibbles=%d,Data=0x%08X%08X\n",
+	.nbValues	= 5,
+	.fields		= { "Version", "Sensor", "Nibbles", "Data", "Data2" }
+};
+static const recordType_t	recordSensor = {
+	.format		= "%s,Version=%d,Sensor=0x%04X,Channel=%d,Temp=%c%d.%d,Humid=%d,LowBattery=%d\n",
+	.nbValues	= 8,
+	.fields		= { "Version", "Sensor", "Channel", "TempSign", "Temp", "TempDec", "Humid", "LowBattery" }
+};
 
-////////////////////////////////////////////////////////////////////////////////
-//
-// http://connectingstuff.net/blog/decodage-protocole-oregon-arduino-1/
-//
-////////////////////////////////////////////////////////////////////////////////
-
-// Oregon V2 decoder modfied - Olivier Lebrun
-// Oregon V2 decoder added - Dominique Pierre
-// New code to decode OOK signals from weather sensors, etc.
-// 2010-04-11 <jcw@equi4.com> http://opensource.org/licenses/mit-license.php
-// $Id: ookDecoder.pde 5331 2010-04-17 10:45:17Z jcw $
 
-static uint8_t total_bits, flip, state, pos;
-static char data[32];
-enum { UNKNOWN, T0, OK, DONE }; 
- 
+#define NIBBLE(n)	bitvec_fieldLsb(bits, 4 * (n), 4)
 
-static uint8_t isDone ()
+/*!
+ * @brief Sum of the nibbles [first, last], on 8 bits
+ */
+static uint8_t sum_oregon(const bitvec_t *bits, uint8_t first, uint8_t last)
 {
-	return state == DONE;
+	uint8_t	i, sum = 0;
+	
+	
+	for (i = first; i <= last; i++) {
+		sum += NIBBLE(i);
+	}
+	return sum;
 }
 
-static void resetDecoder ()
+/*!
+ * @brief Sensor sending a frame
+ * @return The sensor, or NULL if unknown
+ */
+static const oregonSensor_t *sensor_oregon(const bitvec_t *bits)
 {
-	total_bits = pos = flip = 0;
-	memset(data, 0, 32);
-	state = UNKNOWN;
+	uint8_t		i;
+	uint16_t	id;
+	
+	
+	// The ID is read as the first 2 bytes (LSB first)
+	id = (bitvec_fieldLsb(bits, 0, 8) << 8) | bitvec_fieldLsb(bits, 8, 8);
+	for (i = 0; i < NB_SENSORS; i++)
+	{
+		if (oregonSensors[i].id == id) {
+			return &oregonSensors[i];
+		}
+	}
+	return NULL;
 }
 
+/*!
+ * @brief Validate the checksum of a frame from a known sensor
+ */
+static uint8_t checksum_oregon(const bitvec_t *bits, const oregonSensor_t *sensor)
+{
+	uint8_t	nbNibbles = bits->nbBits / 4;
+	uint8_t	checksumNibble = CHECKSUM_NIBBLE(sensor);
+	
+	
+	return (nbNibbles >= checksumNibble + 2 &&
+			sum_oregon(bits, 1, checksumNibble - 1) == (NIBBLE(checksumNibble) | (NIBBLE(checksumNibble + 1) << 4)));
+}
 
-// add one bit to the packet data buffer
-static void gotBit (char value)
+/*!
+ * @brief Find the checksum of a frame from an unknown sensor
+ * @return Number of nibbles up to the checksum included, 0 if none is valid
+ */
+static uint8_t genericChecksum_oregon(const bitvec_t *bits)
 {
-	if(!(total_bits & 0x01))
-	{
-		data[pos] = (data[pos] >> 1) | (value ? 0x80 : 00);
+	uint8_t	nbNibbles = bits->nbBits / 4;
+	uint8_t	c, sum;
+	
+	
+	if (nbNibbles < MIN_CHECKSUM_NIBBLE + 2) {
+		return 0;
 	}
-	total_bits++;
-	pos = total_bits >> 4;
-	if (pos >= sizeof data)
+	c = (nbNibbles - 2 > MIN_CHECKSUM_NIBBLE + MAX_TRAILING_NIBBLES ? nbNibbles - 2 - MAX_TRAILING_NIBBLES : MIN_CHECKSUM_NIBBLE);
+	for (sum = sum_oregon(bits, 1, c - 1); c <= nbNibbles - 2; sum += NIBBLE(c++))
 	{
-		resetDecoder();
-		return;
+		if (sum == (NIBBLE(c) | (NIBBLE(c + 1) << 4))) {
+			return c + 2;
+		}
 	}
-	state = OK;
+	return 0;
 }
 
-static void done ()
+/*!
+ * @brief Check a complete frame (finished bit vector)
+ * @return 1 if the frame must be reported: valid checksum, of a known sensor or
+ * generic for an unknown one
+ */
+static uint8_t check_oregon(const bitvec_t *bits)
 {
-	state = DONE;
+	const oregonSensor_t	*sensor;
+	
+	
+	if (bits->nbBits / 4 < MIN_CHECKSUM_NIBBLE + 2 || NIBBLE(0) != SYNC_NIBBLE) {
+		return 0;
+	}
+	sensor = sensor_oregon(bits);
+	return (sensor != NULL ? checksum_oregon(bits, sensor) : genericChecksum_oregon(bits) > 0);
 }
 
-// store a bit using Manchester encoding
-static void manchester (char value)
+/*!
+ * @brief Check if a frame being received is complete
+ *
+ * Its sensor is looked up once, when its ID has arrived: the frame of a known
+ * sensor is complete with its checksum, if valid.
+ */
+static uint8_t complete_oregon(oregonDecoder_t *dec)
 {
-	flip ^= value; // manchester code, long pulse flips the bit
-	gotBit(flip);
+	bitvec_t				*bits = &dec->bits;
+	const oregonSensor_t	*sensor;
+	
+	
+	if (bits->nbBits == ID_BITS)
+	{
+		bitvec_finish(bits);
+		if (NIBBLE(0) == SYNC_NIBBLE && (sensor = sensor_oregon(bits)) != NULL) {
+			dec->completeBits = 4 * (CHECKSUM_NIBBLE(sensor) + 2);
+		}
+		return 0;
+	}
+	if (bits->nbBits != dec->completeBits) {
+		return 0;
+	}
+	
+	bitvec_finish(bits);
+	return checksum_oregon(bits, sensor_oregon(bits));
 }
 
-static int8_t decode(uint16_t width)
+/*!
+ * @brief Print a frame accepted by check_oregon()
+ * @param frame Frame bits, and protocol version in info
+ */
+static void report_oregon(const streamFrame_t *frame)
 {
-	if (200 <= width && width < 1200)
+	const bitvec_t			*bits = &frame->bits;
+	const oregonSensor_t	*sensor = sensor_oregon(bits);
+	uint8_t					channel, humidity = 0;
+	uint16_t				id, temp;
+	
+	
+	id = (bitvec_fieldLsb(bits, 0, 8) << 8) | bitvec_fieldLsb(bits, 8, 8);
+	if (sensor == NULL)
 	{
-		//Serial.println(width);
-		uint8_t isLongPulse = width >= 700;
+		record_emitBits((const char *)decoder_OregonV2.name, &recordUnknown, bits, frame->info, id, genericChecksum_oregon(bits),
+			bits->words[0], bits->words[1]);
+		return;
+	}
+	
+	channel = NIBBLE(CHANNEL_NIBBLE);
+	if (channel == 4) {
+		channel = 3;
+	}
+	
+	temp = 100 * NIBBLE(TTEN_NIBBLE) + 10 * NIBBLE(TUNIT_NIBBLE) + NIBBLE(TDEC_NIBBLE);
+	if (sensor->type == OREGON_TEMP_HUMID) {
+		humidity = 10 * NIBBLE(HTEN_NIBBLE) + NIBBLE(HUNIT_NIBBLE);
+	}
+	
+	record_emitBits((const char *)decoder_OregonV2.name, &recordSensor, bits, frame->info, id, channel,
+		(NIBBLE(TSIGN_NIBBLE) ? '-' : '+'), temp / 10, temp % 10,
+		humidity, (NIBBLE(FLAGS_NIBBLE) & LOW_BATTERY) ? 1 : 0);
+}
 
-		switch (state)
+/*!
+ * @brief Look for a preamble, and start decoding the data when it ends
+ * @return 1 if the pulse starts the data
+ */
+static __INLINE uint8_t preamble_oregon(oregonDecoder_t *dec, uint32_t pulseLen)
+{
+	if (IS_LONG(pulseLen))
+	{
+		if (dec->nbShort >= MIN_PREAMBLE_V3)
 		{
-		case UNKNOWN:
-			if (isLongPulse) {
-				// Long pulse
-				++flip;
-			} else if (!isLongPulse && 24 <= flip) {
-				// Short pulse, start bit
-				flip = 0;
-				state = T0;
-			} else {
-				// Reset decoder
-				return -1;
-			}
-			break;
-		case OK:
-			if (!isLongPulse) {
-				// Short pulse
-				state = T0;
-			} else {
-				// Long pulse
-				manchester(1);
-			}
-			break;
-		case T0:
-			if (!isLongPulse) {
-			  // Second short pulse
-				manchester(0);
-			} else {
-				// Reset decoder
-				return -1;
-			}
-			break;
-		  }
+			// V3: the preamble bits are 1s, the long pulse flips to the first 0 of the sync nibble
+			dec->version = 3;
+			manchester_init(&dec->manchester, dec->sumShort / dec->nbShort, 1, 0);
+			return 1;
+		}
+		dec->nbShort = 0;
+		dec->sumShort = 0;
+		dec->nbLong++;
+		dec->sumLong += pulseLen;
 	}
-	else if (width >= 2500  && pos >= 8)
+	else if (IS_SHORT(pulseLen))
 	{
-		return 1;
+		if (dec->nbLong >= MIN_PREAMBLE_V2)
+		{
+			// V2.1: the short pulse is the first half of the first 0 of the sync nibble
+			dec->version = 2;
+			manchester_init(&dec->manchester, dec->sumLong / (2 * dec->nbLong), 0, 1);
+			return 1;
+		}
+		dec->nbLong = 0;
+		dec->sumLong = 0;
+		dec->nbShort++;
+		dec->sumShort += pulseLen;
 	}
 	else
 	{
-		return -1;
+		dec->nbShort = dec->nbLong = 0;
+		dec->sumShort = dec->sumLong = 0;
 	}
+	
 	return 0;
 }
 
-static uint8_t nextPulse (uint16_t width)
+/*!
+ * @brief Look for a new preamble
+ */
+static void reset_oregon(void *ctx)
+{
+	oregonDecoder_t	*dec = (oregonDecoder_t *)ctx;
+	
+	
+	dec->step = OREGON_PREAMBLE;
+	dec->nbShort = dec->nbLong = 0;
+	dec->sumShort = dec->sumLong = 0;
+	dec->level = 0;						// The first pulse of a sentence is high
+}
+
+/*!
+ * @brief The current frame ended: report it if valid, or look for another preamble
+ * @return 1 if the frame was copied to frame
+ */
+static uint8_t end_oregon(oregonDecoder_t *dec, streamFrame_t *frame)
 {
-	if (state != DONE)
+	bitvec_finish(&dec->bits);
+	if (!check_oregon(&dec->bits))
 	{
-		switch (decode(width))
+		reset_oregon(dec);
+		return 0;
+	}
+	
+	frame->bits = dec->bits;
+	frame->info = dec->version;
+	dec->step = OREGON_DONE;
+	return 1;
+}
+
+/*!
+ * @brief Start decoding the data, once the preamble ended
+ * @return 1 if the pulse which ended the preamble carries the first bit (V3)
+ */
+static uint8_t start_oregon(oregonDecoder_t *dec)
+{
+	dec->step = OREGON_DATA;
+	dec->nbManchesterBits = 0;
+	dec->completeBits = 0;
+	bitvec_reset(&dec->bits);
+	
+	// V2.1: the short pulse is already counted by manchester_init(). V3: the
+	// long pulse carries the first bit
+	return (dec->version == 3);
+}
+
+/*!
+ * @brief Decode a data pulse
+ * @param lostEdge 1 if the pulse has the level of the previous one
+ * @return 1 if a frame ended with this pulse (copied to frame)
+ */
+static __INLINE uint8_t data_oregon(oregonDecoder_t *dec, uint16_t pulseLen, uint8_t lostEdge, streamFrame_t *frame)
+{
+	int8_t	bit = (lostEdge ? MANCHESTER_ERROR : manchester_step(&dec->manchester, pulseLen));
+	
+	
+	if (bit >= 0)
+	{
+		// V2.1: only keep the first copy of each bit
+		if ((dec->version == 3 || (dec->nbManchesterBits & 1) == 0) && !bitvec_full(&dec->bits))
 		{
-			case -1: resetDecoder(); break;
-			case 1:  done(); break;
+			bitvec_append(&dec->bits, bit);
+			
+			// Don't wait for the end of the frame
+			if ((dec->bits.nbBits & 3) == 0 && complete_oregon(dec)) {
+				return end_oregon(dec, frame);
+			}
+		}
+		dec->nbManchesterBits++;
+	}
+	else if (bit == MANCHESTER_ERROR)
+	{
+		// End of the frame
+		if (end_oregon(dec, frame)) {
+			return 1;
 		}
+		
+		// Look for another preamble, starting with this pulse
+		preamble_oregon(dec, pulseLen);
 	}
-	return isDone();
+	
+	return 0;
 }
 
-////////////////////////////////////////////////////////////////////////////////
+/*!
+ * @brief Feed the next pulse
+ * @return 1 if a frame ended with this pulse (copied to frame)
+ */
+static uint8_t feed_oregon(void *ctx, uint16_t pulseLen, uint8_t level, streamFrame_t *frame)
+{
+	oregonDecoder_t	*dec = (oregonDecoder_t *)ctx;
+	uint8_t			lostEdge;
+	
+	
+	if (dec->step == OREGON_DONE) {
+		return 0;
+	}
+	
+	// The levels alternate: the same level twice means that the interrupt missed
+	// an edge (a glitch), the Manchester timing is lost
+	lostEdge = (level == dec->level);
+	
+	if (dec->step == OREGON_PREAMBLE)
+	{
+		dec->level = level;
+		if (!preamble_oregon(dec, pulseLen) || !start_oregon(dec)) {
+			return 0;
+		}
+	}
+	
+	if (data_oregon(dec, pulseLen, lostEdge, frame)) {
+		return 1;
+	}
+	dec->level = level;
+	return 0;
+}
+
+/*!
+ * @brief The sentence ended
+ * @return 1 if the frame being decoded was valid (copied to frame)
+ */
+static uint8_t flush_oregon(void *ctx, streamFrame_t *frame)
+{
+	oregonDecoder_t	*dec = (oregonDecoder_t *)ctx;
+	
+	
+	return (dec->step == OREGON_DATA && end_oregon(dec, frame));
+}
 
-static uint16_t decode_oregon_v2(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_oregon_v2(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	i, j;
-	char		printBuffer[(2*32)+1];
+	uint16_t		i;
+	oregonDecoder_t	dec;
+	streamFrame_t	frame;
 	
-	resetDecoder();
 	
-	for (i=0; i<nbPulses; i++)
+	// The levels of a recorded sentence alternate: the pulses go straight to the
+	// preamble search and to the data, without feed_oregon()
+	reset_oregon(&dec);
+	for (i = 0; i < nbPulses; i++)
 	{
-		if (nextPulse(pulseLens[i]))
+		if (dec.step == OREGON_PREAMBLE && (!preamble_oregon(&dec, pulseLens[i]) || !start_oregon(&dec))) {
+			continue;
+		}
+		if (data_oregon(&dec, pulseLens[i], 0, &frame))
 		{
-			for (j=0; j<32; j++)
-			{
-				sprintf(printBuffer + (2*i), "%02x", data[j]);
-			}
-			printBuffer[2*32] = '\0';
-			PRINTF("%s,%d,%s\n", decoder_OregonV2.name, total_bits, printBuffer);
-			return total_bits;
+			report_oregon(&frame);
+			return 1;
 		}
 	}
 	
+	if (flush_oregon(&dec, &frame))
+	{
+		report_oregon(&frame);
+		return 1;
+	}
 	return 0;
 }
+
+#if defined(USE_STREAM_DECODERS) && defined(USE_OREGON_V2)
+//! State of the streaming decoder
+static oregonDecoder_t	streamState;
+
+const streamDecoderDesc_t stream_OregonV2 = {
+	.index		= DECODER_INDEX_decoder_OregonV2,
+	.ctx		= &streamState,
+	.reset		= reset_oregon,
+	.feed		= feed_oregon,
+	.flush		= flush_oregon,
+	.report		= report_oregon
+};
+#endif
@@ -0,0 +1,102 @@
+#ifndef PROTOCOL_DESC_H
+#define PROTOCOL_DESC_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * BINARY PROTOCOL DESCRIPTORS                                                 *
+ *******************************************************************************
+ * PWM protocols (see generic_pwm.h) can be described at run time, without
+ * rebuilding the firmware: a store image holds a header and up to
+ * PROTO_STORE_MAX_DESCS descriptors. It is written to a flash sector (see
+ * protocol_store.h), and loaded at boot.
+ *
+ * This header is shared with the host tools (tools/protoc.c): it only depends on
+ * stdint.h, and every field is little-endian with a fixed offset.
+ */
+
+#define PROTO_STORE_MAGIC		0x44503334		// "43PD"
+#define PROTO_STORE_VERSION		1
+
+//! Maximum number of descriptors in a store image
+#define PROTO_STORE_MAX_DESCS	16
+
+#define PROTO_DESC_NAME_LEN		12				// NUL included
+
+//! Values of syncShape (same as pwmSyncShape_t)
+#define PROTO_SYNC_LOW			0
+#define PROTO_SYNC_HIGH_LOW		1
+#define PROTO_SYNC_PAIR			2
+#define PROTO_SYNC_RATIO		3
+
+//! Values of encoding (same as pwmBitEncoding_t)
+#define PROTO_BIT_SECOND		0
+#define PROTO_BIT_BOTH			1
+#define PROTO_BIT_RATIO			2
+
+//! Flags
+#define PROTO_FIRST_FRAME_ONLY	0x01			// Same as PWM_FIRST_FRAME_ONLY
+#define PROTO_DISABLE_BUILTIN	0x80			// Disable the built-in decoder with this name
+												// (the other fields are ignored)
+
+//! Protocol descriptor (60 bytes). Pulse windows have exclusive bounds, a max of
+//! 0xFFFF accepts any longer pulse
+typedef struct {
+	char		name[PROTO_DESC_NAME_LEN];
+	uint8_t		syncShape;
+	uint8_t		encoding;
+	uint8_t		syncRatio;
+	uint8_t		pairLenDivider;
+	uint8_t		pairTolerance;
+	uint8_t		bitRatio;
+	uint8_t		revert;
+	uint8_t		flags;
+	uint16_t	syncHighMin, syncHighMax;
+	uint16_t	firstMin, firstMax;
+	uint16_t	shortMin, shortMax;
+	uint16_t	longMin, longMax;
+	uint32_t	syncMin, syncMax;		// Low sync pulse, or whole sync pair
+	uint32_t	nominalSync;			// 0: fixed windows
+	uint16_t	maxBits;
+	uint16_t	minBits;				// Shorter frames are not printed
+	uint16_t	minNumPulses;
+	uint16_t	minPulseLen;			// Filter limits
+	uint16_t	maxPulseLen;
+	uint16_t	reserved;
+} protoDesc_t;
+
+//! Store image header (16 bytes), followed by nbDescs descriptors
+typedef struct {
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	nbDescs;
+	uint32_t	crc;					// CRC-32 of the descriptors
+	uint32_t	reserved;
+} protoStoreHeader_t;
+
+typedef char protoDesc_sizeCheck[(sizeof(protoDesc_t) == 60) ? 1 : -1];
+typedef char protoStoreHeader_sizeCheck[(sizeof(protoStoreHeader_t) == 16) ? 1 : -1];
+
+
+/*!
+ * @brief CRC-32 (IEEE 802.3, as used by zlib) of a buffer
+ */
+static __inline uint32_t proto_crc32(const void *data, uint32_t len)
+{
+	const uint8_t	*p = (const uint8_t *)data;
+	uint32_t		crc = 0xFFFFFFFF;
+	uint8_t			bit;
+	
+	
+	while (len--)
+	{
+		crc ^= *p++;
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+
+#endif // PROTOCOL_DESC_H
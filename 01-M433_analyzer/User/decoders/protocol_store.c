@@ -0,0 +1,439 @@
+#include "protocol_store.h"
+#include "generic_pwm.h"
+#include "budget.h"
+#include "record.h"
+
+//! Max pulse len of a descriptor window accepting any longer pulse
+#define ANY_PULSE_MAX		0xFFFF
+
+//! Measured / nominal sync beyond which the scaled windows (up to 0x10000) overflow 32 bits
+#define MAX_SYNC_RATIO		(0x10000 >> PWM_SCALE_SHIFT)
+
+// The descriptor values are copied as is
+STATIC_ASSERT(PROTO_SYNC_LOW == PWM_SYNC_LOW && PROTO_SYNC_HIGH_LOW == PWM_SYNC_HIGH_LOW &&
+			  PROTO_SYNC_PAIR == PWM_SYNC_PAIR && PROTO_SYNC_RATIO == PWM_SYNC_RATIO);
+STATIC_ASSERT(PROTO_BIT_SECOND == PWM_BIT_SECOND && PROTO_BIT_BOTH == PWM_BIT_BOTH && PROTO_BIT_RATIO == PWM_BIT_RATIO);
+STATIC_ASSERT(PROTO_FIRST_FRAME_ONLY == PWM_FIRST_FRAME_ONLY);
+
+//! Loaded protocol
+typedef struct {
+	pwmProtocol_t	pwm;
+	char			name[PROTO_DESC_NAME_LEN];
+	uint16_t		minBits;
+	uint16_t		minPulseLen;
+	uint16_t		maxPulseLen;
+} loadedProto_t;
+
+//! Loaded protocols, sorted by minNumPulses
+static loadedProto_t	loaded[PROTO_STORE_MAX_DESCS];
+static uint8_t			nbLoaded = 0;
+
+static decoderMask_t	disabledBuiltins = 0;
+
+//! Record of a loaded protocol: the bits in hex
+static const recordType_t	recordFrame = {
+	.format		= "%s,%db,0x",
+	.nbValues	= 1,
+	.flags		= RECORD_TEXT_BITS,
+	.fields		= { "Length" }
+};
+
+//! Protocol being decoded, for the interpreter (decoders are never run concurrently)
+static const loadedProto_t	*current;
+
+//! Image being uploaded
+static struct {
+	protoStoreHeader_t	header;
+	protoDesc_t			descs[PROTO_STORE_MAX_DESCS];
+} upload;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Copy a pulse window, the 0xFFFF max accepting any longer pulse
+ */
+static void protoStore_window(pwmWindow_t *w, uint32_t min, uint32_t max)
+{
+	w->min = min;
+	w->max = (max == ANY_PULSE_MAX ? 0x10000 : max);
+}
+
+/*!
+ * @brief Check a window of a descriptor (a max of 0xFFFF accepting any longer pulse)
+ */
+static uint8_t protoStore_validWindow(uint32_t min, uint32_t max)
+{
+	return (min < max);
+}
+
+/*!
+ * @brief Check a descriptor
+ *
+ * The descriptors come from an upload: the windows used by the sync shape and
+ * the bit encoding must not be empty, and the timebase given by the syncs (see
+ * generic_pwm_kernel.h) must keep the scaled windows within 32 bits.
+ *
+ * @return 1 if the descriptor is valid
+ */
+static uint8_t protoStore_check(const protoDesc_t *desc)
+{
+	uint32_t	maxSyncLen;
+	
+	
+	if (memchr(desc->name, 0, PROTO_DESC_NAME_LEN) == NULL) {
+		return 0;
+	}
+	if (desc->flags & PROTO_DISABLE_BUILTIN) {
+		return 1;
+	}
+	
+	if (desc->syncShape > PROTO_SYNC_RATIO || desc->encoding > PROTO_BIT_RATIO ||
+		desc->maxBits == 0 || desc->maxBits > BITVEC_MAX_BITS ||
+		desc->minBits > desc->maxBits || desc->minNumPulses < 2 ||
+		desc->minPulseLen >= desc->maxPulseLen || desc->pairTolerance > 100)
+	{
+		return 0;
+	}
+	
+	// Windows of the sync
+	if (desc->syncShape != PROTO_SYNC_RATIO && !protoStore_validWindow(desc->syncMin, desc->syncMax)) {
+		return 0;
+	}
+	if (desc->syncShape == PROTO_SYNC_HIGH_LOW && !protoStore_validWindow(desc->syncHighMin, desc->syncHighMax)) {
+		return 0;
+	}
+	
+	// Windows of the bits
+	if (desc->encoding == PROTO_BIT_SECOND && !protoStore_validWindow(desc->firstMin, desc->firstMax)) {
+		return 0;
+	}
+	if (desc->encoding != PROTO_BIT_RATIO &&
+		(!protoStore_validWindow(desc->shortMin, desc->shortMax) || !protoStore_validWindow(desc->longMin, desc->longMax)))
+	{
+		return 0;
+	}
+	
+	// Timebase: the longest sync accepted gives the largest scale
+	if (desc->nominalSync != 0)
+	{
+		maxSyncLen = (desc->syncShape == PROTO_SYNC_RATIO ? ANY_PULSE_MAX : desc->syncMax);
+		if (maxSyncLen / MAX_SYNC_RATIO >= desc->nominalSync) {
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+/*!
+ * @brief Check a descriptor and turn it into a PWM protocol
+ * @return 1 if the descriptor is valid
+ */
+static uint8_t protoStore_convert(const protoDesc_t *desc, loadedProto_t *proto)
+{
+	pwmProtocol_t	*pwm = &proto->pwm;
+	
+	
+	if (!protoStore_check(desc)) {
+		return 0;
+	}
+	
+	memset(pwm, 0, sizeof(*pwm));
+	pwm->syncShape		= (pwmSyncShape_t)desc->syncShape;
+	protoStore_window(&pwm->syncHigh, desc->syncHighMin, desc->syncHighMax);
+	pwm->sync.min		= desc->syncMin;
+	pwm->sync.max		= desc->syncMax;
+	pwm->nominalSync	= desc->nominalSync;
+	pwm->syncRatio		= desc->syncRatio;
+	pwm->encoding		= (pwmBitEncoding_t)desc->encoding;
+	protoStore_window(&pwm->first, desc->firstMin, desc->firstMax);
+	protoStore_window(&pwm->shortPulse, desc->shortMin, desc->shortMax);
+	protoStore_window(&pwm->longPulse, desc->longMin, desc->longMax);
+	pwm->pairLenDivider	= desc->pairLenDivider;
+	pwm->pairTolerance	= desc->pairTolerance;
+	pwm->bitRatio		= desc->bitRatio;
+	pwm->maxBits		= desc->maxBits;
+	pwm->revert			= desc->revert & 1;
+	pwm->flags			= desc->flags & PROTO_FIRST_FRAME_ONLY;
+	pwm->minNumPulses	= desc->minNumPulses;
+	
+	memcpy(proto->name, desc->name, PROTO_DESC_NAME_LEN);
+	proto->minBits		= desc->minBits;
+	proto->minPulseLen	= desc->minPulseLen;
+	proto->maxPulseLen	= desc->maxPulseLen;
+	return 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Load a store image
+ *
+ * Invalid descriptors are skipped. The protocols are sorted by minNumPulses, so
+ * that protoStore_decode() stops at the first one expecting more pulses.
+ *
+ * @param[in]	builtins	Built-in decoders, indexed as in DECODER_TABLE
+ * @return		Number of protocols loaded
+ */
+uint8_t protoStore_loadImage(const uint8_t *image, uint32_t len, const decoderDesc_t * const *builtins, uint8_t nbBuiltins)
+{
+	const protoStoreHeader_t	*header = (const protoStoreHeader_t *)image;
+	const protoDesc_t			*descs = (const protoDesc_t *)(header + 1);
+	loadedProto_t				proto;
+	uint8_t						i, j;
+	
+	
+	nbLoaded = 0;
+	disabledBuiltins = 0;
+	
+	if (len < sizeof(*header) || header->magic != PROTO_STORE_MAGIC || header->version != PROTO_STORE_VERSION ||
+		header->nbDescs > PROTO_STORE_MAX_DESCS || len < sizeof(*header) + header->nbDescs * sizeof(protoDesc_t) ||
+		proto_crc32(descs, header->nbDescs * sizeof(protoDesc_t)) != header->crc)
+	{
+		return 0;
+	}
+	
+	for (i = 0; i < header->nbDescs; i++)
+	{
+		if (descs[i].flags & PROTO_DISABLE_BUILTIN)
+		{
+			for (j = 0; j < nbBuiltins; j++)
+			{
+				if (strncmp((const char *)builtins[j]->name, descs[i].name, PROTO_DESC_NAME_LEN) == 0) {
+					disabledBuiltins |= DECODER_BIT(j);
+				}
+			}
+			continue;
+		}
+	
+		if (!protoStore_convert(&descs[i], &proto))
+		{
+			DEBUG_PRINTF("Invalid protocol descriptor %d\n", i);
+			continue;
+		}
+	
+		// Insertion sort
+		for (j = nbLoaded; j > 0 && loaded[j-1].pwm.minNumPulses > proto.pwm.minNumPulses; j--) {
+			loaded[j] = loaded[j-1];
+		}
+		loaded[j] = proto;
+		nbLoaded++;
+	}
+	
+	return nbLoaded;
+}
+
+/*!
+ * @brief Load the image stored in flash
+ * @return Number of protocols loaded
+ */
+uint8_t protoStore_load(const decoderDesc_t * const *builtins, uint8_t nbBuiltins)
+{
+	return protoStore_loadImage((const uint8_t *)PROTO_STORE_ADDRESS, sizeof(upload), builtins, nbBuiltins);
+}
+
+/*!
+ * @brief Widen a filter so that it accepts the sentences of the loaded protocols
+ */
+void protoStore_widenFilter(decoderDesc_t *filter)
+{
+	uint8_t	i;
+	
+	
+	for (i = 0; i < nbLoaded; i++)
+	{
+		if (loaded[i].minPulseLen < filter->minPulseLen) {
+			filter->minPulseLen = loaded[i].minPulseLen;
+		}
+		if (loaded[i].maxPulseLen > filter->maxPulseLen) {
+			filter->maxPulseLen = loaded[i].maxPulseLen;
+		}
+		if (loaded[i].pwm.minNumPulses < filter->minNumPulses) {
+			filter->minNumPulses = loaded[i].pwm.minNumPulses;
+		}
+	}
+}
+
+/*!
+ * @brief Built-in decoders disabled by the loaded image
+ */
+decoderMask_t protoStore_disabledBuiltins(void)
+{
+	return disabledBuiltins;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Print a frame of a loaded protocol
+ */
+static uint8_t interpret_loaded(const pwmFrame_t *frame)
+{
+	if (frame->bits.nbBits == 0 || frame->bits.nbBits < current->minBits) {
+		return 0;
+	}
+	
+	record_emitBits(current->name, &recordFrame, &frame->bits, frame->bits.nbBits);
+	return 1;
+}
+
+/*!
+ * @brief Run the loaded protocols expecting fewer than nbPulses pulses
+ * @return Number of protocols which decoded the sentence
+ */
+uint16_t protoStore_decode(uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint8_t		i;
+	uint16_t	result = 0;
+	
+	
+	for (i = 0; i < nbLoaded && loaded[i].pwm.minNumPulses < nbPulses && !budget_expired(); i++)
+	{
+		current = &loaded[i];
+		result += pwm_decode_sentence(&loaded[i].pwm, pulseLens, nbPulses, interpret_loaded);
+	}
+	
+	return result;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Reply to a command
+ */
+static void protoStore_reply(commandReplyFunc_t reply, const char *status, const char *detail, int value)
+{
+	char	line[64];
+	
+	
+	snprintf(line, sizeof(line), "PSTORE,%s,%s,%d\n", status, detail, value);
+	reply(line);
+}
+
+/*!
+ * @brief Erase the store sector and write an image to it
+ * @return 1 on success
+ */
+static uint8_t protoStore_write(const uint8_t *image, uint32_t len)
+{
+	uint32_t	i, word;
+	uint8_t		ok = 1;
+	
+	
+	FLASH_Unlock();
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+	
+	if (FLASH_EraseSector(PROTO_STORE_SECTOR, VoltageRange_3) != FLASH_COMPLETE) {
+		ok = 0;
+	}
+	
+	for (i = 0; ok && i < len; i += 4)
+	{
+		memcpy(&word, image + i, sizeof(word));
+		if (FLASH_ProgramWord(PROTO_STORE_ADDRESS + i, word) != FLASH_COMPLETE) {
+			ok = 0;
+		}
+	}
+	
+	FLASH_Lock();
+	return ok;
+}
+
+/*!
+ * @brief Parse the hex digits of a descriptor
+ * @return 1 if the line holds exactly one descriptor
+ */
+static uint8_t protoStore_parseHex(const char *hex, uint8_t *data)
+{
+	uint8_t		i, j, nibble;
+	
+	
+	for (i = 0; i < sizeof(protoDesc_t); i++)
+	{
+		data[i] = 0;
+		for (j = 0; j < 2; j++)
+		{
+			nibble = *hex++;
+			if (nibble >= '0' && nibble <= '9') {
+				nibble -= '0';
+			} else if (nibble >= 'A' && nibble <= 'F') {
+				nibble -= 'A' - 10;
+			} else if (nibble >= 'a' && nibble <= 'f') {
+				nibble -= 'a' - 10;
+			} else {
+				return 0;
+			}
+			data[i] = (data[i] << 4) | nibble;
+		}
+	}
+	
+	return (*hex == '\0' || *hex == '\r' || *hex == '\n');
+}
+
+/*!
+ * @brief Run a PSTORE command line
+ * @param[in]	reply	Function sending the reply lines
+ * @return 1 if the stored image changed, and must be loaded again
+ */
+uint8_t protoStore_command(const char *line, commandReplyFunc_t reply)
+{
+	uint8_t	i;
+	
+	
+	if (strncmp(line, "PSTORE ", 7) != 0) {
+		return 0;
+	}
+	line += 7;
+	
+	if (strncmp(line, "BEGIN", 5) == 0)
+	{
+		upload.header.nbDescs = 0;
+		protoStore_reply(reply, "OK", "BEGIN", 0);
+	}
+	else if (strncmp(line, "DESC ", 5) == 0)
+	{
+		if (upload.header.nbDescs == PROTO_STORE_MAX_DESCS) {
+			protoStore_reply(reply, "ERROR", "FULL", PROTO_STORE_MAX_DESCS);
+		} else if (!protoStore_parseHex(line + 5, (uint8_t *)&upload.descs[upload.header.nbDescs]) ||
+				   !protoStore_check(&upload.descs[upload.header.nbDescs])) {
+			protoStore_reply(reply, "ERROR", "DESC", upload.header.nbDescs);
+		} else {
+			upload.header.nbDescs++;
+			protoStore_reply(reply, "OK", "DESC", upload.header.nbDescs);
+		}
+	}
+	else if (strncmp(line, "COMMIT", 6) == 0)
+	{
+		upload.header.magic		= PROTO_STORE_MAGIC;
+		upload.header.version	= PROTO_STORE_VERSION;
+		upload.header.crc		= proto_crc32(upload.descs, upload.header.nbDescs * sizeof(protoDesc_t));
+		upload.header.reserved	= 0;
+	
+		if (!protoStore_write((const uint8_t *)&upload, sizeof(upload.header) + upload.header.nbDescs * sizeof(protoDesc_t))) {
+			protoStore_reply(reply, "ERROR", "FLASH", 0);
+			return 0;
+		}
+		protoStore_reply(reply, "OK", "COMMIT", upload.header.nbDescs);
+		return 1;
+	}
+	else if (strncmp(line, "ERASE", 5) == 0)
+	{
+		upload.header.magic = 0xFFFFFFFF;
+		if (!protoStore_write((const uint8_t *)&upload, sizeof(upload.header))) {
+			protoStore_reply(reply, "ERROR", "FLASH", 0);
+			return 0;
+		}
+		protoStore_reply(reply, "OK", "ERASE", 0);
+		return 1;
+	}
+	else if (strncmp(line, "LIST", 4) == 0)
+	{
+		for (i = 0; i < nbLoaded; i++) {
+			protoStore_reply(reply, "OK", loaded[i].name, loaded[i].pwm.minNumPulses);
+		}
+		protoStore_reply(reply, "OK", "LIST", nbLoaded);
+	}
+	else
+	{
+		protoStore_reply(reply, "ERROR", "COMMAND", 0);
+	}
+	
+	return 0;
+}
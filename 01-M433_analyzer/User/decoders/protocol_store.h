@@ -0,0 +1,38 @@
+#ifndef PROTOCOL_STORE_H
+#define PROTOCOL_STORE_H
+
+#include "main.h"
+#include "protocol_desc.h"
+#include "command.h"
+
+/*
+ * Protocols loaded at run time.
+ *
+ * The store image (see protocol_desc.h) lives in the flash sector
+ * PROTO_STORE_SECTOR (defines.h). At boot, its descriptors are checked and
+ * turned into pwmProtocol_t descriptions, sorted by minNumPulses: a sentence is
+ * only handed to the protocols expecting fewer pulses. The loaded protocols
+ * widen the global filter, and may disable built-in decoders.
+ *
+ * A new image is uploaded on the command links (see command.h), one line at a
+ * time (each line is acknowledged by "PSTORE,OK,..." or "PSTORE,ERROR,..."):
+ * 		PSTORE BEGIN			Start a new image
+ * 		PSTORE DESC <hex>		Append a descriptor (120 hex digits)
+ * 		PSTORE COMMIT			Write the image to flash, and load it
+ * 		PSTORE ERASE			Erase the image (built-in decoders only)
+ * 		PSTORE LIST				List the loaded protocols
+ * tools/protoc.c compiles a text description into these lines.
+ */
+
+//! Longest command line: PSTORE DESC and the hex digits of a descriptor
+#define PROTO_STORE_LINE_LEN	(16 + 2 * sizeof(protoDesc_t))
+
+uint8_t			protoStore_loadImage(const uint8_t *image, uint32_t len, const decoderDesc_t * const *builtins, uint8_t nbBuiltins);
+uint8_t			protoStore_load(const decoderDesc_t * const *builtins, uint8_t nbBuiltins);
+void			protoStore_widenFilter(decoderDesc_t *filter);
+decoderMask_t	protoStore_disabledBuiltins(void);
+uint16_t		protoStore_decode(uint16_t *pulseLens, uint16_t nbPulses);
+uint8_t			protoStore_command(const char *line, commandReplyFunc_t reply);
+
+
+#endif // PROTOCOL_STORE_H
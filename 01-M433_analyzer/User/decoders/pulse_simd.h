@@ -0,0 +1,78 @@
+#ifndef PULSE_SIMD_H
+#define PULSE_SIMD_H
+
+#include "decoder.h"
+
+/*
+ * Classification of two pulses at once.
+ *
+ * Pulse lens are stored on 16 bits: a pulse and the next one are loaded as a
+ * single word, the first pulse in the low halfword (little-endian). A pair of
+ * windows is packed the same way, with inclusive bounds. The saturating halfword
+ * subtraction (__UQSUB16) gives 0 for each pulse which is not below the min
+ * (resp. above the max) of its window: both pulses are in their windows when the
+ * two results are 0.
+ */
+
+// Cortex-M4/M7 have the DSP extension. Define PULSE_SIMD_PORTABLE to build the
+// decoders on another target (e.g. a host computer)
+#if defined(__CORTEX_M) && (__CORTEX_M >= 0x04) && !defined(PULSE_SIMD_PORTABLE)
+	#define pulse_uqsub16(a, b)	__UQSUB16(a, b)
+#else
+static __INLINE uint32_t pulse_uqsub16(uint32_t a, uint32_t b)
+{
+	uint32_t	lo = ((a & 0xFFFF) > (b & 0xFFFF) ? (a & 0xFFFF) - (b & 0xFFFF) : 0);
+	uint32_t	hi = ((a >> 16) > (b >> 16) ? (a >> 16) - (b >> 16) : 0);
+	
+	return lo | (hi << 16);
+}
+#endif
+
+//! Pack two 16 bits values, the first one in the low halfword
+#define PULSE_PACK(first, second)	((uint32_t)(first) | ((uint32_t)(second) << 16))
+
+//! Inclusive bounds of an exclusive window, clamped to the range of a pulse len
+//! (a window starting at 0xFFFF is empty: its max is set below its min)
+#define PULSE_MIN(min, max)			((min) >= 0xFFFF ? 0xFFFF : (min) + 1)
+#define PULSE_MAX(min, max)			((min) >= 0xFFFF ? 0 : (max) > 0xFFFF ? 0xFFFF : (max) - 1)
+
+//! Windows of two consecutive pulses (inclusive bounds, packed)
+typedef struct {
+	uint32_t	min;
+	uint32_t	max;
+} pulseWindow2_t;
+
+
+/*!
+ * @brief Pack the windows of two consecutive pulses
+ * @param[in]	firstMin, firstMax		Exclusive bounds of the first pulse (as with the IS_* macros)
+ * @param[in]	secondMin, secondMax	Exclusive bounds of the second pulse
+ */
+static __INLINE void pulse_window2(pulseWindow2_t *w, uint32_t firstMin, uint32_t firstMax, uint32_t secondMin, uint32_t secondMax)
+{
+	w->min = PULSE_PACK(PULSE_MIN(firstMin, firstMax), PULSE_MIN(secondMin, secondMax));
+	w->max = PULSE_PACK(PULSE_MAX(firstMin, firstMax), PULSE_MAX(secondMin, secondMax));
+}
+
+/*!
+ * @brief Load a pulse and the next one (pulseLens may not be word-aligned)
+ */
+static __INLINE uint32_t pulse_loadPair(const uint16_t *pulseLens)
+{
+	uint32_t	pair;
+	
+	
+	memcpy(&pair, pulseLens, sizeof(pair));
+	return pair;
+}
+
+/*!
+ * @brief Check if both pulses of a pair are in their windows
+ */
+static __INLINE uint8_t pulse_inWindow2(uint32_t pair, const pulseWindow2_t *w)
+{
+	return (pulse_uqsub16(w->min, pair) | pulse_uqsub16(pair, w->max)) == 0;
+}
+
+
+#endif // PULSE_SIMD_H
@@ -1,5 +1,6 @@
 #include "decoder.h"
-#include "generic_rcswitch.h"
+#include "generic_pwm.h"
+#include "record.h"
 
 /*******************************************************************************
  * RCSWITCH DECODER                                                            *
@@ -28,6 +29,15 @@
 #define MAX_SYNC_LEN	(31 * MAX_SHORT_LEN)
 #define MIN_NUM_PULSES	50		// 2 sync + 2 * 24
 
+// The sync low is more than SYNC_MIN_RATIO times longer than the sync high
+#define SYNC_MIN_RATIO	20
+
+// Each pair of pulses must last (sync high + sync low) / 32 * 4
+#define PAIR_LEN_DIVIDER		8
+#define PAIR_TOLERANCE			10		// Pair len tolerance (%)
+#define LONG_SHORT_MIN_RATIO	2
+#define RAW_DATA_LEN			32		// bits
+
 
 #define CHANNEL_MASK	0xFF000000
 #define CHANNEL_SHIFT	24
@@ -43,10 +53,9 @@
 
 #define EVEN_BITS_MASK	0x55555700	// 01010101 01010101 01010111 00000000
 
-static uint32_t	pairLen;
-static uint16_t decode_rcswitch(uint32_t *pulseLens, uint16_t nbPulses);
+static uint16_t decode_rcswitch(uint16_t *pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_RCSwitch = 
+const decoderDesc_t decoder_RCSwitch = 
 {
 	.name			= "RCswitch",
 	.minPulseLen  	= MIN_SHORT_LEN,
@@ -55,52 +64,61 @@ decoderDesc_t decoder_RCSwitch =
 	.decoderFunc	= decode_rcswitch
 };
 
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_RCSWITCH, MIN_SHORT_LEN, MAX_SYNC_LEN, MIN_NUM_PULSES);
+
+
+static const pwmProtocol_t rcswitchProtocol =
+{
+	.syncShape		= PWM_SYNC_RATIO,
+	.syncRatio		= SYNC_MIN_RATIO,
+	.encoding		= PWM_BIT_RATIO,
+	.pairLenDivider	= PAIR_LEN_DIVIDER,
+	.pairTolerance	= PAIR_TOLERANCE,
+	.bitRatio		= LONG_SHORT_MIN_RATIO,
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 0,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+
+//! Records: switch command, and raw code
+static const recordType_t	recordSwitch = {
+	.format		= "%s,Channel=%d,Addr=%d,Padd85=%d,Data=%d,PairLen=%d\n",
+	.nbValues	= 5,
+	.fields		= { "Channel", "Addr", "Padd85", "Data", "PairLen" }
+};
+static const recordType_t	recordRaw = {
+	.format		= "%s,Length=%d,Data=0x%08x,PairLen=%d\n",
+	.nbValues	= 3,
+	.fields		= { "Length", "Data", "PairLen" }
+};
+
 
-static uint8_t interpret_rcswitch(uint32_t rawData, uint8_t nbBits)
+static uint8_t interpret_rcswitch(const pwmFrame_t *frame)
 {
+	uint32_t	rawData	= frame->bits.words[0];
+	uint16_t	nbBits	= frame->bits.nbBits;
+	uint32_t	pairLen	= frame->pairLen;
+	
 	// Decode the raw data
 	if (nbBits == 24 && ((rawData & EVEN_BITS_MASK) == rawData))
 	{
 		// None of the odd bits is set (we don't check the last 2 since the state value may be 0b00 or 0b11)
-		PRINTF("%s,Channel=%d,Addr=%d,Padd85=%d,Data=%d,PairLen=%d\n", decoder_RCSwitch.name, BIN_VALUE(CHANNEL), BIN_VALUE(ADDR), BIN_VALUE(PAD), BIN_VALUE(STATE), pairLen);
+		record_emitBits((const char *)decoder_RCSwitch.name, &recordSwitch, &frame->bits, BIN_VALUE(CHANNEL), BIN_VALUE(ADDR), BIN_VALUE(PAD), BIN_VALUE(STATE), pairLen);
 		return 1;
 	}
 	else if (nbBits >= 10)
 	{
 		// Decode the raw data
-		PRINTF("%s,Length=%d,Data=0x%08x,PairLen=%d\n", decoder_RCSwitch.name, nbBits, rawData, pairLen);
+		record_emitBits((const char *)decoder_RCSwitch.name, &recordRaw, &frame->bits, nbBits, rawData, pairLen);
 		return 1;
 	}
 	
 	return 0;
 }
 
-static uint16_t decode_rcswitch(uint32_t *pulseLens, uint16_t nbPulses)
+static uint16_t decode_rcswitch(uint16_t *pulseLens, uint16_t nbPulses)
 {
-	uint16_t	result = 0;
-	uint16_t	syncOffset = 0;
-	double		syncRatio;
-	
-	while (nbPulses - syncOffset > MIN_NUM_PULSES)
-	{	
-		syncRatio = (double)pulseLens[syncOffset+1] / (double)pulseLens[syncOffset];
-		if (20.0 < syncRatio)
-		{
-			// Valid sync pulses found - try and decode the sentence 
-			// Each pair of pulses must last (pulseLens[syncOffset] + pulseLens[syncOffset+1]) / 32 * 4
-			pairLen = (pulseLens[syncOffset] + pulseLens[syncOffset+1]) / 8;
-			
-			// Shift to the first data pair
-			syncOffset += 2;
-			result = decode_generic_rcswitch_sentence(pulseLens + syncOffset, nbPulses - syncOffset, pairLen, interpret_rcswitch, 0);
-			syncOffset += result;
-		}
-		else
-		{
-			syncOffset += 2;
-		}
-	}
-	
-	return (result > 0);
+	return PWM_DECODE_SENTENCE(&rcswitchProtocol, pulseLens, nbPulses, interpret_rcswitch);
 }
-
@@ -0,0 +1,284 @@
+#include <stdarg.h>
+#include <string.h>
+#include "record.h"
+
+// Longest line printed by a sink
+#define LINE_LEN			256
+
+STATIC_ASSERT(RECORD_POOL_SIZE >= 2 && RECORD_POOL_SIZE <= 256);
+
+
+static void	record_sinkText(const record_t *record);
+#ifdef RECORD_SINK_FIELDS
+static void	record_sinkFields(const record_t *record);
+#endif
+
+//! Sinks, NULL-terminated
+static const recordSinkFunc_t	sinks[] = {
+	record_sinkText,
+#ifdef RECORD_SINK_FIELDS
+	record_sinkFields,
+#endif
+	NULL
+};
+
+//! Pool: the queued records are from tail to head, pool[head] is filled by the next record
+static record_t				pool[RECORD_POOL_SIZE];
+static volatile uint8_t		head = 0, tail = 0;
+
+//! Line built by the sinks
+static char					line[LINE_LEN];
+
+recordStats_t				recordStats;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Check if two records hold the same decoded data
+ */
+static uint8_t record_equal(const record_t *a, const record_t *b)
+{
+	return (a->type == b->type && a->decoder == b->decoder &&
+			memcmp(a->values, b->values, a->type->nbValues * sizeof(a->values[0])) == 0 &&
+			a->bits.nbBits == b->bits.nbBits &&
+			memcmp(a->bits.words, b->bits.words, ((a->bits.nbBits + 31) / 32) * sizeof(a->bits.words[0])) == 0 &&
+			a->pulses == b->pulses && a->nbPulses == b->nbPulses);
+}
+
+/*!
+ * @brief Fill pool[head] and queue it
+ */
+static void record_queue(const char *decoder, const recordType_t *type, const bitvec_t *bits, const uint16_t *pulses, uint16_t nbPulses, va_list values)
+{
+	record_t	*record = &pool[head];
+	record_t	*last = &pool[(head + RECORD_POOL_SIZE - 1) % RECORD_POOL_SIZE];
+	uint8_t		i, next = (head + 1) % RECORD_POOL_SIZE;
+	
+	
+	record->type		= type;
+	record->decoder		= decoder;
+	record->timestamp	= sysTickTime;
+	record->repeats		= 1;
+	for (i = 0; i < type->nbValues; i++) {
+		record->values[i] = va_arg(values, uint32_t);
+	}
+	if (bits != NULL) {
+		record->bits = *bits;
+	} else {
+		record->bits.nbBits = 0;
+	}
+	record->pulses		= pulses;
+	record->nbPulses	= nbPulses;
+	
+	// A repeated frame only counts
+	if (head != tail && record_equal(last, record))
+	{
+		last->repeats++;
+		recordStats.merged++;
+		return;
+	}
+	
+	if (next == tail)
+	{
+		recordStats.lost++;
+		return;
+	}
+	recordStats.emitted++;
+	head = next;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Append to the line being built
+ * @return The new length of the line
+ */
+static uint16_t record_append(uint16_t len, const char *format, ...)
+{
+	va_list	args;
+	int		n;
+	
+	
+	va_start(args, format);
+	n = vsnprintf(line + len, LINE_LEN - len, format, args);
+	va_end(args);
+	
+	return (n < 0 || len + n >= LINE_LEN ? LINE_LEN - 1 : len + n);
+}
+
+/*!
+ * @brief Append bits in hex, a word (8 digits) at a time
+ */
+static uint16_t record_appendBits(uint16_t len, const bitvec_t *bits)
+{
+	uint8_t	i, nbWords = (bits->nbBits + 31) / 32;
+	
+	
+	for (i = 0; i < nbWords; i++) {
+		len = record_append(len, "%08X", bits->words[i]);
+	}
+	return len;
+}
+
+/*!
+ * @brief Print the line of a RECORD_TEXT_PULSES record, in chunks as long as the line
+ */
+static void record_printPulses(const record_t *record)
+{
+	const uint32_t	*v = record->values;
+	uint16_t		len, i;
+	
+	
+	len = record_append(0, record->type->format, record->decoder, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9]);
+	for (i = 0; i <= record->nbPulses; i++)
+	{
+		// Room for "65535," or "0\n"
+		if (len + 7 > LINE_LEN)
+		{
+			output_send(line);
+			len = 0;
+		}
+		if (i < record->nbPulses) {
+			len = record_append(len, "%d,", record->pulses[i]);
+		} else {
+			record_append(len, "0\n");
+		}
+	}
+	output_send(line);
+}
+
+/*!
+ * @brief Text sink: print the line of the record type, once per repeat
+ *
+ * The repeats go through output_send() like the frames they stand for: its
+ * repeat counting (see output.h) works as before.
+ */
+static void record_sinkText(const record_t *record)
+{
+	const uint32_t	*v = record->values;
+	uint16_t		len, i;
+	
+	
+	// Lines longer than the line of the sink
+	if (record->type->print != NULL || (record->type->flags & RECORD_TEXT_PULSES))
+	{
+		for (i = 0; i < record->repeats; i++)
+		{
+			if (record->type->print != NULL) {
+				record->type->print(record);
+			} else {
+				record_printPulses(record);
+			}
+		}
+		return;
+	}
+	
+	len = record_append(0, record->type->format, record->decoder, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9]);
+	if (record->type->flags & RECORD_TEXT_BITS)
+	{
+		len = record_appendBits(len, &record->bits);
+		record_append(len, "\n");
+	}
+	
+	for (i = 0; i < record->repeats; i++) {
+		output_send(line);
+	}
+}
+
+#ifdef RECORD_SINK_FIELDS
+/*!
+ * @brief Fields sink: print every value of the record by name
+ */
+static void record_sinkFields(const record_t *record)
+{
+	uint16_t	len;
+	uint8_t		i;
+	
+	
+	len = record_append(0, "Record,%s,Time=%lu", record->decoder, (unsigned long)record->timestamp);
+	for (i = 0; i < record->type->nbValues; i++) {
+		len = record_append(len, ",%s=%lu", record->type->fields[i], (unsigned long)record->values[i]);
+	}
+	if (record->bits.nbBits > 0)
+	{
+		len = record_append(len, ",Bits=%d,Raw=0x", record->bits.nbBits);
+		len = record_appendBits(len, &record->bits);
+	}
+	if (record->pulses != NULL) {
+		len = record_append(len, ",Pulses=%d", record->nbPulses);
+	}
+	record_append(len, ",Repeats=%d\n", record->repeats);
+	
+	output_send(line);
+}
+#endif
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Queue a record
+ * @param[in]	decoder		Name of the decoder
+ * @param[in]	type		Record type, followed by its nbValues values (uint32_t)
+ */
+void record_emit(const char *decoder, const recordType_t *type, ...)
+{
+	va_list	values;
+	
+	
+	va_start(values, type);
+	record_queue(decoder, type, NULL, NULL, 0, values);
+	va_end(values);
+}
+
+/*!
+ * @brief Queue a record holding raw bits
+ */
+void record_emitBits(const char *decoder, const recordType_t *type, const bitvec_t *bits, ...)
+{
+	va_list	values;
+	
+	
+	va_start(values, bits);
+	record_queue(decoder, type, bits, NULL, 0, values);
+	va_end(values);
+}
+
+/*!
+ * @brief Queue a raw pulse record (RECORD_TEXT_PULSES)
+ * @param[in]	pulses	Pulses of the sentence: only referred to, they must stay in
+ * 						place until record_poll() (the sentence is being decoded)
+ */
+void record_emitPulses(const char *decoder, const recordType_t *type, const uint16_t *pulses, uint16_t nbPulses, ...)
+{
+	va_list	values;
+	
+	
+	va_start(values, nbPulses);
+	record_queue(decoder, type, NULL, pulses, nbPulses, values);
+	va_end(values);
+}
+
+/*!
+ * @brief Number of records which can be queued before the next record_poll()
+ */
+uint8_t record_room(void)
+{
+	return (tail + RECORD_POOL_SIZE - head - 1) % RECORD_POOL_SIZE;
+}
+
+/*!
+ * @brief Hand the queued records to the sinks
+ * @remark Called from the main loop, when no decoder is running: a record may
+ * not be merged into while it is printed
+ */
+void record_poll(void)
+{
+	const recordSinkFunc_t	*sink;
+	
+	
+	while (tail != head)
+	{
+		for (sink = sinks; *sink != NULL; sink++) {
+			(*sink)(&pool[tail]);
+		}
+		tail = (tail + 1) % RECORD_POOL_SIZE;
+	}
+}
@@ -0,0 +1,85 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*
+ * Decoded records.
+ *
+ * The decoders don't format their results: they fill a fixed-size typed record
+ * (decoder, timestamp, values, raw bits, repeat count) with record_emit(). The
+ * record waits in a pool until the main loop hands it to the sinks
+ * (record_poll()), once the decoders are done with the sentence:
+ * 	- the text sink prints the usual "<decoder>,..." line with output_send(),
+ * 	- the fields sink (RECORD_SINK_FIELDS in defines.h) prints every value by
+ * 	  name, whatever the decoder.
+ * Formatting is paid out of the decode path, and the output format belongs to
+ * the sinks and the record types, not to the decode functions.
+ *
+ * A raw pulse record (record_emitPulses()) only refers to the pulses of the
+ * sentence, which stay in place until the sentence is done: the text sink
+ * prints them, in chunks as long as its line. A record type whose line doesn't
+ * fit a format (or the line of the sink) gives its own print function.
+ *
+ * The pool is a ring of RECORD_POOL_SIZE records, lock free: head is only
+ * written by the producer (record_emit()), tail by the consumer
+ * (record_poll()). When the ring is full, the record is lost and counted: a
+ * decoder reporting many records checks record_room() first. A record
+ * identical to the last queued one (same decoder, type, values and bits) only
+ * bumps its repeat count.
+ */
+
+//! Values of a record
+#define RECORD_MAX_VALUES		10
+
+//! Record type flags
+#define RECORD_TEXT_BITS		0x01	// Text sink: the format is followed by the bits in hex and '\n'
+#define RECORD_TEXT_PULSES		0x02	// Text sink: the format is followed by "<len>," for each pulse and "0\n"
+
+struct record;
+
+//! Text sink of a record type: prints the line of a record with output_send()
+typedef void (*recordPrintFunc_t)(const struct record *record);
+
+//! Record type: the values of a record, and how the sinks print them
+typedef struct {
+	const char			*format;						// Text sink: printf format, fed with the decoder name then the values
+	uint8_t				nbValues;
+	uint8_t				flags;							// RECORD_*
+	const char			*fields[RECORD_MAX_VALUES];		// Names of the values (fields sink)
+	recordPrintFunc_t	print;							// Text sink: prints the line instead of the format (NULL: the format)
+} recordType_t;
+
+//! Decoded record
+typedef struct record {
+	const recordType_t	*type;
+	const char			*decoder;		// Decoder ID: its name
+	uint32_t			timestamp;		// sysTickTime when the record was emitted
+	uint16_t			repeats;		// Number of identical records merged into this one
+	uint32_t			values[RECORD_MAX_VALUES];
+	bitvec_t			bits;			// Raw bits (nbBits is 0 if the decoder gave none)
+	const uint16_t		*pulses;		// Pulses of the sentence (NULL if the decoder gave none), see record_emitPulses()
+	uint16_t			nbPulses;
+} record_t;
+
+//! Pool counters
+typedef struct {
+	uint32_t	emitted;
+	uint32_t	merged;			// Records merged into the previous one
+	uint32_t	lost;			// Records lost because the pool was full
+} recordStats_t;
+
+typedef void (*recordSinkFunc_t)(const record_t *record);
+
+extern recordStats_t	recordStats;
+
+
+void	record_emit(const char *decoder, const recordType_t *type, ...);
+void	record_emitBits(const char *decoder, const recordType_t *type, const bitvec_t *bits, ...);
+void	record_emitPulses(const char *decoder, const recordType_t *type, const uint16_t *pulses, uint16_t nbPulses, ...);
+void	record_poll(void);
+uint8_t	record_room(void);
+
+
+#endif // RECORD_H
@@ -0,0 +1,107 @@
+#include "repair.h"
+
+
+void repair_reset(repairCandidates_t *candidates)
+{
+	candidates->nbCandidates = 0;
+}
+
+/*!
+ * @brief Remember a bit if it is one of the least confident ones so far
+ * @param[in]	pos		Bit offset in the frame
+ * @param[in]	conf	Confidence of the bit (the lower, the more likely to be wrong)
+ */
+void repair_note(repairCandidates_t *candidates, uint16_t pos, uint32_t conf)
+{
+	uint8_t	i = candidates->nbCandidates;
+	
+	
+	if (i == REPAIR_MAX_CANDIDATES)
+	{
+		if (conf >= candidates->conf[i-1]) {
+			return;
+		}
+		// Drop the most confident candidate
+		i--;
+	}
+	else
+	{
+		candidates->nbCandidates++;
+	}
+	
+	// Insertion sort
+	for (; i > 0 && candidates->conf[i-1] > conf; i--)
+	{
+		candidates->pos[i]	= candidates->pos[i-1];
+		candidates->conf[i]	= candidates->conf[i-1];
+	}
+	candidates->pos[i]	= pos;
+	candidates->conf[i]	= conf;
+}
+
+/*!
+ * @brief Flip the candidates of a set
+ * @param[in]	set		Bit i set: flip candidate i
+ */
+static void repair_flip(bitvec_t *bits, const repairCandidates_t *candidates, uint8_t set)
+{
+	uint8_t	i;
+	
+	
+	for (i = 0; i < candidates->nbCandidates; i++)
+	{
+		if (set & (1 << i)) {
+			bitvec_flip(bits, candidates->pos[i]);
+		}
+	}
+}
+
+/*!
+ * @brief Flip the least confident bits so that the check succeeds
+ *
+ * Every set of up to REPAIR_MAX_FLIPS candidates is tried. The frame is only
+ * repaired if a single set makes the check succeed: with several ones, the
+ * errors are beyond what the check can correct, and any of them may give wrong
+ * values.
+ *
+ * @param[in,out]	bits	Finished frame. Left repaired on success, unchanged otherwise
+ * @return Number of bits flipped, 0 if the frame couldn't be repaired
+ */
+uint8_t repair_bits(bitvec_t *bits, const repairCandidates_t *candidates, repairCheckFunc_t check)
+{
+	uint8_t	i, j, nbFound = 0, found = 0, nbFlips = 0;
+	
+	
+	for (i = 0; i < candidates->nbCandidates; i++)
+	{
+		bitvec_flip(bits, candidates->pos[i]);
+		if (check(bits) && nbFound++ == 0) {
+			found	= 1 << i;
+			nbFlips	= 1;
+		}
+		bitvec_flip(bits, candidates->pos[i]);
+	}
+	
+#if REPAIR_MAX_FLIPS >= 2
+	for (i = 0; i < candidates->nbCandidates; i++)
+	{
+		bitvec_flip(bits, candidates->pos[i]);
+		for (j = i + 1; j < candidates->nbCandidates; j++)
+		{
+			bitvec_flip(bits, candidates->pos[j]);
+			if (check(bits) && nbFound++ == 0) {
+				found	= (1 << i) | (1 << j);
+				nbFlips	= 2;
+			}
+			bitvec_flip(bits, candidates->pos[j]);
+		}
+		bitvec_flip(bits, candidates->pos[i]);
+	}
+#endif
+	
+	if (nbFound != 1) {
+		return 0;
+	}
+	repair_flip(bits, candidates, found);
+	return nbFlips;
+}
@@ -0,0 +1,40 @@
+#ifndef REPAIR_H
+#define REPAIR_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*
+ * Soft-decision bit repair.
+ *
+ * While decoding, the decoder gives the confidence of each bit (e.g. how far its
+ * pulse was from the short/long threshold). The REPAIR_MAX_CANDIDATES least
+ * confident bits are remembered. If the frame then fails its checksum, these
+ * bits are flipped (one at a time, then by pairs, up to REPAIR_MAX_FLIPS), and
+ * the frame is repaired if a single one of these sets makes the checksum match.
+ * With several ones, the frame has more errors than the checksum can tell apart:
+ * it is left as it was. The decoder should still flag the repaired frames in
+ * its output, since a repair is less sure than a frame received right.
+ */
+
+//! Number of least confident bits remembered
+#define REPAIR_MAX_CANDIDATES	4
+
+//! Maximum number of bits flipped at once (bounds the number of checks: 10 with 4 candidates)
+#define REPAIR_MAX_FLIPS		2
+
+typedef struct {
+	uint16_t	pos[REPAIR_MAX_CANDIDATES];		// Bit offsets, sorted by increasing confidence
+	uint32_t	conf[REPAIR_MAX_CANDIDATES];
+	uint8_t		nbCandidates;
+} repairCandidates_t;
+
+typedef uint8_t (*repairCheckFunc_t)(const bitvec_t *bits);
+
+
+void	repair_reset(repairCandidates_t *candidates);
+void	repair_note(repairCandidates_t *candidates, uint16_t pos, uint32_t conf);
+uint8_t	repair_bits(bitvec_t *bits, const repairCandidates_t *candidates, repairCheckFunc_t check);
+
+
+#endif // REPAIR_H
@@ -0,0 +1,119 @@
+#include "router.h"
+#include "router_tree.h"
+
+// Cortex-M3/M4 count the leading zeros in one instruction. Define
+// PULSE_SIMD_PORTABLE to build the router on another target (see pulse_simd.h)
+#if defined(__CORTEX_M) && (__CORTEX_M >= 0x03) && !defined(PULSE_SIMD_PORTABLE)
+	#define router_clz(x)	__CLZ(x)
+#elif defined(__GNUC__)
+	#define router_clz(x)	__builtin_clz(x)
+#else
+static __INLINE uint8_t router_clz(uint32_t x)
+{
+	uint8_t	n = 0;
+	
+	
+	for (; !(x & 0x80000000); x <<= 1) {
+		n++;
+	}
+	return n;
+}
+#endif
+
+// Half-octave bin of a pulse len (> 1): 2.log2(len), rounded down
+#define ROUTER_BIN(msb, len)		(2 * (msb) + (((len) >> ((msb) - 1)) & 1))
+
+// Lower bound of a bin
+#define ROUTER_BIN_MIN(bin)			((2 | ((bin) & 1)) << ((bin) / 2 - 1))
+
+STATIC_ASSERT(ROUTER_NB_LABELS <= 16);
+
+// A decoder the tree was not trained with would only be called at the
+// ROUTER_ALL_LABELS leaves: generate router_tree.h again
+STATIC_ASSERT(ROUTER_TREE_LABELS == ROUTER_DECODER_LABELS);
+STATIC_ASSERT(sizeof(routerTree) / sizeof(*routerTree) <= ROUTER_LEAF);
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Compute the features of a sentence (single pass)
+ * @param[out]	features	ROUTER_NB_FEATURES values
+ */
+void router_features(const uint16_t *pulseLens, uint16_t nbPulses, uint16_t *features)
+{
+	uint16_t	hist[ROUTER_NB_BINS] = { 0 };
+	uint32_t	len, maxLen = 0, highLen = 0, totalLen = 0, ratio;
+	uint16_t	i;
+	uint8_t		msb, bin, peak = 0, second = 1;
+	
+	
+	// The histogram only needs the first pulses
+	for (i = 0; i < nbPulses && i < ROUTER_SCAN_PULSES; i++)
+	{
+		len = pulseLens[i] | 2;		// msb >= 1
+		msb = 31 - router_clz(len);
+		hist[ROUTER_BIN(msb, len)]++;
+	
+		if (len > maxLen) {
+			maxLen = len;
+		}
+		if (!(i & 1)) {
+			highLen += len;
+		}
+		totalLen += len;
+	}
+	
+	for (bin = 2; bin < ROUTER_NB_BINS; bin++)
+	{
+		if (hist[bin] > hist[peak]) {
+			second = peak;
+			peak = bin;
+		} else if (hist[bin] > hist[second] && bin != peak) {
+			second = bin;
+		}
+	}
+	ratio = 4 * maxLen / ROUTER_BIN_MIN(peak > 2 ? peak : 2);
+	
+	features[ROUTER_FEATURE_NB_PULSES]	= nbPulses;
+	features[ROUTER_FEATURE_PEAK_BIN]	= peak;
+	features[ROUTER_FEATURE_SECOND_BIN]	= second;
+	features[ROUTER_FEATURE_MAX_LEN]	= maxLen;
+	features[ROUTER_FEATURE_SYNC_RATIO]	= (ratio > 0xFFFF ? 0xFFFF : ratio);
+	features[ROUTER_FEATURE_DUTY_CYCLE]	= (totalLen > 0 ? (highLen << 8) / totalLen : 0);
+}
+
+/*!
+ * @brief Walk down the decision tree
+ * @return Labels of the leaf reached
+ */
+uint16_t router_labels(const uint16_t *features)
+{
+	const routerNode_t	*node = &routerTree[0];
+	
+	
+	while (node->feature != ROUTER_LEAF) {
+		node = &routerTree[features[node->feature] <= node->value ? node->left : node->right];
+	}
+	return node->value;
+}
+
+/*!
+ * @brief Enabled decoders among labels
+ * @remark The labels of the decoders are their decoder bits
+ */
+decoderMask_t router_decoders(uint16_t labels)
+{
+	return labels & ROUTER_DECODER_LABELS;
+}
+
+/*!
+ * @brief Decoders which may match a sentence
+ */
+decoderMask_t router_route(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	features[ROUTER_NB_FEATURES];
+	
+	
+	router_features(pulseLens, nbPulses, features);
+	return router_decoders(router_labels(features));
+}
@@ -0,0 +1,71 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include "decoder.h"
+
+/*
+ * Decoder router.
+ *
+ * A few features are computed on each sentence in a single pass, then a
+ * decision tree, trained offline on captures (tools/router_train.c), predicts
+ * the decoders which may match it. A leaf gives one or two decoders when its
+ * training sentences agreed, no decoder at all for noise, and every decoder
+ * (ROUTER_ALL_LABELS) when it is unsure.
+ *
+ * The leaves hold labels: one per decoder of DECODER_TABLE, in its order, and
+ * one for no decoder. The labels of the decoders are their decoder bits, so a
+ * decoder added to the table gets its label without any other change. The
+ * tree (router_tree.h) is trained with the decoders enabled in defines.h: it
+ * must be generated again when they change, else router.c does not build.
+ */
+
+//! Sentence features
+enum {
+	ROUTER_FEATURE_NB_PULSES,
+	ROUTER_FEATURE_PEAK_BIN,		// Most frequent half-octave bin of the pulse lens
+	ROUTER_FEATURE_SECOND_BIN,		// Second most frequent bin
+	ROUTER_FEATURE_MAX_LEN,			// Longest pulse
+	ROUTER_FEATURE_SYNC_RATIO,		// Longest pulse / lower bound of the peak bin
+	ROUTER_FEATURE_DUTY_CYCLE,		// High pulses / total len (1/256)
+	ROUTER_NB_FEATURES
+};
+
+//! Labels: the enabled decoders (ROUTER_LABEL_decoder_*), and no decoder
+#define ROUTER_LABEL(desc, minLen, maxLen, minNum)		ROUTER_LABEL_ ## desc = DECODER_INDEX_ ## desc,
+
+enum {
+	DECODER_TABLE(ROUTER_LABEL)
+	ROUTER_LABEL_NONE = NUM_DECODERS,
+	ROUTER_NB_LABELS
+};
+
+#define ROUTER_LABEL_BIT(label)		((uint16_t)1 << (label))
+#define ROUTER_ALL_LABELS			0xFFFF
+
+//! Labels of all the decoders: their decoder bits
+#define ROUTER_DECODER_LABELS		(ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) - 1)
+
+//! Node of the decision tree
+#define ROUTER_LEAF					0xFF
+
+typedef struct {
+	uint8_t		feature;		// ROUTER_LEAF for a leaf
+	uint8_t		left;			// Next node when feature <= value
+	uint8_t		right;			// Next node when feature > value
+	uint16_t	value;			// Threshold, or labels of a leaf
+} routerNode_t;
+
+//! Half-octave bins of the pulse lens
+#define ROUTER_NB_BINS				32
+
+//! Pulses scanned to compute the features (the others only count)
+#define ROUTER_SCAN_PULSES			128
+
+
+void			router_features(const uint16_t *pulseLens, uint16_t nbPulses, uint16_t *features);
+uint16_t		router_labels(const uint16_t *features);
+decoderMask_t	router_decoders(uint16_t labels);
+decoderMask_t	router_route(const uint16_t *pulseLens, uint16_t nbPulses);
+
+
+#endif // ROUTER_H
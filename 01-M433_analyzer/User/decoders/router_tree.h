@@ -0,0 +1,108 @@
+#ifndef ROUTER_TREE_H
+#define ROUTER_TREE_H
+
+#include "router.h"
+
+/*
+ * Decision tree of the decoder router: generated by tools/router_train.c, do
+ * not edit.
+ * Trained on 10000 sentences, tested on 10000: 99.91% routed to all their
+ * decoders, 0.94 decoder calls per sentence instead of 7.83.
+ */
+
+//! Decoders the tree was trained with (see router.c)
+#define ROUTER_TREE_LABELS ( \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonV2) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_X10Rf) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_Came432Na) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) | \
+	ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_siemensVdo))
+
+static const routerNode_t routerTree[] = {
+	/*   0 */ { ROUTER_FEATURE_MAX_LEN, 1, 78, 30030 },
+	/*   1 */ { ROUTER_FEATURE_MAX_LEN, 2, 19, 2270 },
+	/*   2 */ { ROUTER_FEATURE_MAX_LEN, 3, 4, 1126 },
+	/*   3 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonV2) },
+	/*   4 */ { ROUTER_FEATURE_NB_PULSES, 5, 12, 136 },
+	/*   5 */ { ROUTER_FEATURE_MAX_LEN, 6, 11, 2163 },
+	/*   6 */ { ROUTER_FEATURE_DUTY_CYCLE, 7, 10, 124 },
+	/*   7 */ { ROUTER_FEATURE_MAX_LEN, 8, 9, 2022 },
+	/*   8 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*   9 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) },
+	/*  10 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  11 */ { ROUTER_LEAF, 0, 0, ROUTER_ALL_LABELS },
+	/*  12 */ { ROUTER_FEATURE_NB_PULSES, 13, 18, 330 },
+	/*  13 */ { ROUTER_FEATURE_DUTY_CYCLE, 14, 17, 125 },
+	/*  14 */ { ROUTER_FEATURE_PEAK_BIN, 15, 16, 17 },
+	/*  15 */ { ROUTER_LEAF, 0, 0, ROUTER_ALL_LABELS },
+	/*  16 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  17 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) },
+	/*  18 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_CarKey1) },
+	/*  19 */ { ROUTER_FEATURE_MAX_LEN, 20, 55, 5002 },
+	/*  20 */ { ROUTER_FEATURE_SECOND_BIN, 21, 30, 18 },
+	/*  21 */ { ROUTER_FEATURE_DUTY_CYCLE, 22, 27, 66 },
+	/*  22 */ { ROUTER_FEATURE_MAX_LEN, 23, 24, 2491 },
+	/*  23 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  24 */ { ROUTER_FEATURE_MAX_LEN, 25, 26, 2723 },
+	/*  25 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) },
+	/*  26 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  27 */ { ROUTER_FEATURE_MAX_LEN, 28, 29, 2310 },
+	/*  28 */ { ROUTER_LEAF, 0, 0, ROUTER_ALL_LABELS },
+	/*  29 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_siemensVdo) },
+	/*  30 */ { ROUTER_FEATURE_MAX_LEN, 31, 52, 4578 },
+	/*  31 */ { ROUTER_FEATURE_PEAK_BIN, 32, 45, 16 },
+	/*  32 */ { ROUTER_FEATURE_SYNC_RATIO, 33, 38, 43 },
+	/*  33 */ { ROUTER_FEATURE_MAX_LEN, 34, 37, 2755 },
+	/*  34 */ { ROUTER_FEATURE_MAX_LEN, 35, 36, 2730 },
+	/*  35 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) },
+	/*  36 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  37 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  38 */ { ROUTER_FEATURE_SYNC_RATIO, 39, 44, 51 },
+	/*  39 */ { ROUTER_FEATURE_NB_PULSES, 40, 43, 264 },
+	/*  40 */ { ROUTER_FEATURE_NB_PULSES, 41, 42, 132 },
+	/*  41 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  42 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  43 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  44 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_HomeEasy) },
+	/*  45 */ { ROUTER_FEATURE_SYNC_RATIO, 46, 47, 9 },
+	/*  46 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  47 */ { ROUTER_FEATURE_MAX_LEN, 48, 49, 3866 },
+	/*  48 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  49 */ { ROUTER_FEATURE_MAX_LEN, 50, 51, 4454 },
+	/*  50 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) },
+	/*  51 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  52 */ { ROUTER_FEATURE_DUTY_CYCLE, 53, 54, 102 },
+	/*  53 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_OregonEW91) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  54 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  55 */ { ROUTER_FEATURE_MAX_LEN, 56, 65, 12531 },
+	/*  56 */ { ROUTER_FEATURE_SYNC_RATIO, 57, 58, 44 },
+	/*  57 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  58 */ { ROUTER_FEATURE_NB_PULSES, 59, 64, 52 },
+	/*  59 */ { ROUTER_FEATURE_SYNC_RATIO, 60, 61, 167 },
+	/*  60 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) },
+	/*  61 */ { ROUTER_FEATURE_MAX_LEN, 62, 63, 11066 },
+	/*  62 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  63 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) },
+	/*  64 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_RCSwitch) },
+	/*  65 */ { ROUTER_FEATURE_MAX_LEN, 66, 67, 18018 },
+	/*  66 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_Came432Na) },
+	/*  67 */ { ROUTER_FEATURE_NB_PULSES, 68, 69, 28 },
+	/*  68 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  69 */ { ROUTER_FEATURE_NB_PULSES, 70, 71, 54 },
+	/*  70 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  71 */ { ROUTER_FEATURE_NB_PULSES, 72, 73, 80 },
+	/*  72 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  73 */ { ROUTER_FEATURE_DUTY_CYCLE, 74, 75, 53 },
+	/*  74 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  75 */ { ROUTER_FEATURE_MAX_LEN, 76, 77, 26262 },
+	/*  76 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) | ROUTER_LABEL_BIT(ROUTER_LABEL_NONE) },
+	/*  77 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_dipSwitch) },
+	/*  78 */ { ROUTER_LEAF, 0, 0, ROUTER_LABEL_BIT(ROUTER_LABEL_decoder_X10Rf) },
+};
+
+
+#endif // ROUTER_TREE_H
@@ -1,5 +1,8 @@
 #include "decoder.h"
 #include "main.h"
+#include "bitvec.h"
+#include "budget.h"
+#include "record.h"
 
 /*******************************************************************************
  * SIEMENSVDO DECODER (Car key fob)                                            *
@@ -9,7 +12,11 @@
  * SYNC:
  * 		High sync, Low sync
  * DATA:
- *  	Each high and low pulse may be short or long
+ *  	Each high and low pulse may be short or long, and gives one bit (0 or 1)
+ *
+ * The pulses are read in a single pass: each pulse is visited at most twice
+ * (once more when it ends a frame, to look for the next sync), so that long
+ * sentences cost a linear time.
  *
  ******************
  * INTERPRETATION *
@@ -30,11 +37,12 @@
 
 #define MIN_NUM_PULSES	32
 
-#define RAW_DATA_LEN	8
+#define RAW_DATA_LEN	8	// bytes
+#define MIN_DATA_LEN	40	// bits
 
-static uint16_t decode_siemens(uint32_t	*pulseLens, uint16_t nbPulses);
+static uint16_t decode_siemens(uint16_t	*pulseLens, uint16_t nbPulses);
 
-decoderDesc_t decoder_siemensVdo = 
+const decoderDesc_t decoder_siemensVdo = 
 {
 	.name 	= "SiemensVdo",
 	.minPulseLen  	= MIN_SHORT_LEN,
@@ -43,94 +51,95 @@ decoderDesc_t decoder_siemensVdo =
 	.decoderFunc	= decode_siemens
 };
 
-static uint16_t decode_siemens(uint32_t	*pulseLens, uint16_t nbPulses)
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_SIEMENS_VDO, MIN_SHORT_LEN, MAX_SYNC_LEN, MIN_NUM_PULSES);
+
+//! Record: length, then the first 8 bytes
+static const recordType_t	recordFrame = {
+	.format		= "%s,%d,%02x.%02x.%02x.%02x.%02x.%02x.%02x.%02x\n",
+	.nbValues	= 9,
+	.fields		= { "Length", "Byte0", "Byte1", "Byte2", "Byte3", "Byte4", "Byte5", "Byte6", "Byte7" }
+};
+
+/*!
+ * @brief Print a frame if it holds enough complete bytes
+ * @return 1 if the frame was printed
+ */
+static uint8_t interpret_siemens(bitvec_t *bits)
 {
-	uint16_t	i				= 0,
-				dataOffset 		= 0,
-				dataByteOffset 	= 0,
-				parseOffset		= 1,	// each bit is a (low,high) couple
-				result			= 0;
+	// Only complete bytes are kept
+	bits->acc >>= (bits->nbBits & 7);
+	bits->nbBits &= ~7;
+	bitvec_finish(bits);
+	
+	if (bits->nbBits < MIN_DATA_LEN) {
+		return 0;
+	}
+	
+	record_emitBits((const char *)decoder_siemensVdo.name, &recordFrame, bits, bits->nbBits,
+		bitvec_byte(bits, 0), bitvec_byte(bits, 1), bitvec_byte(bits, 2), bitvec_byte(bits, 3),
+		bitvec_byte(bits, 4), bitvec_byte(bits, 5), bitvec_byte(bits, 6), bitvec_byte(bits, 7));
+	return 1;
+}
 
-	uint8_t		rawData[RAW_DATA_LEN],
-				dataByte 		= 0,
-				dataBitOffset	= 0;
+static uint16_t decode_siemens(uint16_t	*pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i, result = 0;
+	uint8_t		inFrame = 0;
+	bitvec_t	bits;
 	
 	
-	// We may try to parse the sentence from different offsets if we find valid sync pulses,
-	// until valid data can be decoded
-	while (nbPulses - parseOffset > 42)
+	for (i = 0; i < nbPulses; i++)
 	{
-		// Skip the preamble, look for the first pause
-		// Sync: pause low, pause high
-		
-		for (i = parseOffset; i < nbPulses-1; i+=2)
+		if (!inFrame)
 		{
-			// Skip the preamble, just look for the next pause
-			if (IS_SYNC(pulseLens[i]) && IS_SYNC(pulseLens[i+1]))
+			// Skip the preamble, look for the sync (pause low, pause high)
+			if (i + 1 < nbPulses && IS_SYNC(pulseLens[i]) && IS_SYNC(pulseLens[i+1]))
 			{
-				i += 2;
-				break;
+				// No more frames when over budget
+				if (budget_expired()) {
+					break;
+				}
+				inFrame = 1;
+				bitvec_reset(&bits);
+				i++;
 			}
+			continue;
 		}
 		
-		if (i == (nbPulses-1)) {
-			break;
+		if (IS_SHORT(pulseLens[i]))
+		{
+			bitvec_append(&bits, 0);
 		}
-
-		// PRINTF("Sync len: %d (%d%%)\n", nbSync, nbSync*100/128);
-		
-		memset(rawData, 0, RAW_DATA_LEN);
-		dataByte = dataByteOffset = 0;
-		dataBitOffset = 8;
-		
-		for (i = dataOffset; i < nbPulses-1; i++)
+		else if (IS_LONG(pulseLens[i]))
 		{
-			if (IS_SHORT(pulseLens[i]))
-			{
-				// Nothing to do
-				dataBitOffset--;
-			}
-			else if (IS_LONG(pulseLens[i]))
-			{
-				dataByte |= (1 << --dataBitOffset);
-			}
-			else
-			{
-				break;
-			}
-			
-			// If this byte is complete, switch to the next one
-			if (!dataBitOffset)
-			{
-				rawData[dataByteOffset++] = dataByte;
-				dataBitOffset = 8;
-				dataByte = 0;
-			}
-			
-			if (dataByteOffset == RAW_DATA_LEN)
-			{
-				break;
+			bitvec_append(&bits, 1);
+		}
+		else
+		{
+			// End of the frame: this pulse may start the next sync
+			if (interpret_siemens(&bits)) {
+				result = i;
 			}
+			inFrame = 0;
+			i--;
+			continue;
 		}
 		
-		if (dataByteOffset >= 5)
+		if (bits.nbBits == 8 * RAW_DATA_LEN)
 		{
-			// We decoded at least 40 bits. Display the code
-			PRINTF("Siemens: message: %02x.%02x.%02x.%02x.%02x.%02x.%02x.%02x\n", 
-				rawData[0], rawData[1], rawData[2], rawData[3], rawData[4], rawData[5], rawData[6], rawData[7]);
-			result = i;
-			
-			memset(rawData, 0, RAW_DATA_LEN);
-			dataByte = dataByteOffset = 0;
-			dataBitOffset = 8;
+			// Frame complete
+			if (interpret_siemens(&bits)) {
+				result = i + 1;
+			}
+			inFrame = 0;
 		}
-		
-		parseOffset = i;
 	}
 	
-	if (result > 0) {
-		return result;
+	// Frame cut by the end of the sentence
+	if (inFrame && interpret_siemens(&bits)) {
+		result = nbPulses;
 	}
 	
-	return 0;
+	return result;
 }
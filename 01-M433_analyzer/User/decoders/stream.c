@@ -0,0 +1,146 @@
+#include "stream.h"
+
+#if defined(USE_STREAM_DECODERS) && defined(USE_OREGON_V2)
+extern const streamDecoderDesc_t	stream_OregonV2;
+#endif
+
+//! Streaming decoders, NULL-terminated
+static const streamDecoderDesc_t * const streamDecoders[] = {
+#if defined(USE_STREAM_DECODERS) && defined(USE_OREGON_V2)
+	&stream_OregonV2,
+#endif
+	NULL
+};
+
+//! Frame waiting to be printed
+typedef struct {
+	const streamDecoderDesc_t	*decoder;
+	streamFrame_t				frame;
+} streamReport_t;
+
+//! Mailbox: filled by the receiver interrupt (head), emptied by the main loop (tail)
+static streamReport_t		mailbox[STREAM_MAILBOX_SIZE];
+static volatile uint8_t		head = 0, tail = 0;
+
+//! Frame reported while the mailbox is full
+static streamFrame_t		lostFrame;
+
+//! Decoders which reported a frame of the current sentence
+static decoderMask_t		reported;
+
+//! Decoders fed with the current sentence
+static decoderMask_t		active;
+
+uint32_t					streamLost = 0;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Frame to be filled by the next report
+ */
+static streamFrame_t *stream_slot(void)
+{
+	return ((head + 1) % STREAM_MAILBOX_SIZE == tail ? &lostFrame : &mailbox[head].frame);
+}
+
+/*!
+ * @brief Post a frame filled by a decoder
+ */
+static void stream_post(const streamDecoderDesc_t *decoder, streamFrame_t *frame)
+{
+	reported |= DECODER_BIT(decoder->index);
+	
+	if (frame == &lostFrame)
+	{
+		streamLost++;
+		return;
+	}
+	mailbox[head].decoder = decoder;
+	head = (head + 1) % STREAM_MAILBOX_SIZE;
+}
+
+/*!
+ * @brief Batch decoders replaced by the streaming decoders
+ */
+decoderMask_t stream_decoders(void)
+{
+	const streamDecoderDesc_t * const	*d;
+	decoderMask_t						mask = 0;
+	
+	
+	for (d = streamDecoders; *d != NULL; d++) {
+		mask |= DECODER_BIT((*d)->index);
+	}
+	return mask;
+}
+
+/*!
+ * @brief A sentence starts: reset the decoders
+ * @param decoders Decoders enabled (DECODER_BIT of the batch decoders): the others are not fed
+ * @remark Called from the receiver interrupt, as are stream_feed() and stream_end()
+ */
+void stream_start(decoderMask_t decoders)
+{
+	const streamDecoderDesc_t * const	*d;
+	
+	
+	for (d = streamDecoders; *d != NULL; d++) {
+		(*d)->reset((*d)->ctx);
+	}
+	reported = 0;
+	active = decoders;
+}
+
+/*!
+ * @brief Feed a recorded pulse to the decoders
+ * @param level 1 for a high pulse
+ */
+void stream_feed(uint16_t pulseLen, uint8_t level)
+{
+	const streamDecoderDesc_t * const	*d;
+	streamFrame_t						*frame = stream_slot();
+	
+	
+	for (d = streamDecoders; *d != NULL; d++)
+	{
+		if ((active & DECODER_BIT((*d)->index)) && (*d)->feed((*d)->ctx, pulseLen, level, frame))
+		{
+			stream_post(*d, frame);
+			frame = stream_slot();
+		}
+	}
+}
+
+/*!
+ * @brief The sentence ended: flush the decoders
+ * @return The decoders which reported a frame of the sentence
+ */
+decoderMask_t stream_end(void)
+{
+	const streamDecoderDesc_t * const	*d;
+	streamFrame_t						*frame = stream_slot();
+	
+	
+	for (d = streamDecoders; *d != NULL; d++)
+	{
+		if ((active & DECODER_BIT((*d)->index)) && (*d)->flush((*d)->ctx, frame))
+		{
+			stream_post(*d, frame);
+			frame = stream_slot();
+		}
+	}
+	return reported;
+}
+
+/*!
+ * @brief Print the reported frames
+ * @remark Called from the main loop
+ */
+void stream_poll(void)
+{
+	while (tail != head)
+	{
+		mailbox[tail].decoder->report(&mailbox[tail].frame);
+		tail = (tail + 1) % STREAM_MAILBOX_SIZE;
+	}
+}
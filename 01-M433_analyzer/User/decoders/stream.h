@@ -0,0 +1,58 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "main.h"
+#include "bitvec.h"
+
+/*
+ * Streaming decoders.
+ *
+ * A batch decoder (decoderDesc_t) sees a sentence once it has ended: its
+ * latency is the sentence length plus the final timeout, and the whole
+ * sentence must be stored. A streaming decoder is an incremental state machine
+ * instead: the receiver interrupt feeds it each pulse as it is recorded, and
+ * it reports a frame as soon as the frame is complete.
+ *
+ * The interrupt doesn't print: a reported frame is copied to a mailbox, which
+ * the main loop empties (stream_poll()) with the report function of the
+ * decoder. A streaming decoder replaces its batch decoder: the sentences it
+ * reported a frame of are not handed to the default decoder, nor queued at all
+ * if no other decoder may match them.
+ */
+
+//! Frame reported by a streaming decoder
+typedef struct {
+	bitvec_t	bits;
+	uint8_t		info;			// Decoder specific (e.g. protocol version)
+} streamFrame_t;
+
+typedef void	(*streamResetFunc_t)(void *ctx);
+typedef uint8_t	(*streamFeedFunc_t)(void *ctx, uint16_t pulseLen, uint8_t level, streamFrame_t *frame);
+typedef uint8_t	(*streamFlushFunc_t)(void *ctx, streamFrame_t *frame);
+typedef void	(*streamReportFunc_t)(const streamFrame_t *frame);
+
+//! Streaming decoder description
+typedef struct {
+	uint8_t				index;		// DECODER_INDEX_* of the batch decoder it replaces
+	void				*ctx;		// Decoder state
+	streamResetFunc_t	reset;		// Called when a sentence starts
+	streamFeedFunc_t	feed;		// Called with each pulse (level: 1 for a high pulse): 1 if a frame was reported
+	streamFlushFunc_t	flush;		// Called when the sentence ends: 1 if a frame was reported
+	streamReportFunc_t	report;		// Print a reported frame, from the main loop
+} streamDecoderDesc_t;
+
+//! Number of reported frames waiting to be printed
+#define STREAM_MAILBOX_SIZE		4
+
+//! Frames lost because the mailbox was full
+extern uint32_t	streamLost;
+
+
+decoderMask_t	stream_decoders(void);
+void			stream_start(decoderMask_t decoders);
+void			stream_feed(uint16_t pulseLen, uint8_t level);
+decoderMask_t	stream_end(void);
+void			stream_poll(void);
+
+
+#endif // STREAM_H
@@ -0,0 +1,198 @@
+#include "main.h"
+#include "generic_pwm.h"
+#include "record.h"
+
+/*******************************************************************************
+ * X10 RF DECODER                                                              *
+ *******************************************************************************
+ * SENTENCE ENCODING *
+ *********************
+ * SYNC:
+ * 		8.8ms high, 4.4ms low
+ * DATA:
+ *  	Pulse-distance encoding: each bit is a 550us high pulse, followed by a
+ *      550us (0) or 1650us (1) low pulse (PWM_BIT_SECOND), MSB first
+ *      The frame is sent 5 times, separated by a 40ms gap
+ *
+ ******************
+ * INTERPRETATION *
+ ******************
+ * 32 data bits: 4 bytes b0, ~b0, b2, ~b2 (each byte is followed by its complement)
+ * 		b0, bits 7-4	House code, coded with the X10 house table (see houseCodes)
+ * 		b0, bit 2		Unit + 8
+ * 		b2, bit 7		Dim/bright/all units command (the unit is not sent)
+ * 		b2, bit 6		Unit + 4
+ * 		b2, bit 5		Off (0: on)
+ * 		b2, bit 4		Unit + 1
+ * 		b2, bit 3		Unit + 2
+ * Units are numbered from 1 to 16.
+ */
+
+#define MIN_FIRST_LEN	400		// High pulse of each pair: 550us
+#define MAX_FIRST_LEN	750
+
+#define MIN_SHORT_LEN	400		// 550us
+#define MAX_SHORT_LEN	800
+
+#define MIN_LONG_LEN	1300	// 1650us
+#define MAX_LONG_LEN	2000
+
+#define MIN_SYNC_HIGH_LEN	7500	// 8.8ms
+#define MAX_SYNC_HIGH_LEN	10000
+
+#define NOMINAL_SYNC_LEN	4400	// 4.4ms
+#define MIN_SYNC_LEN	PWM_SYNC_MIN(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+#define MAX_SYNC_LEN	PWM_SYNC_MAX(NOMINAL_SYNC_LEN, DRIFT_TOLERANCE)
+
+// Clock drift accepted (%): the sync gives the timebase of each frame
+#define DRIFT_TOLERANCE	20
+#define MIN_PULSE_LEN	(MIN_SHORT_LEN * (100 - DRIFT_TOLERANCE) / 100)
+#define MAX_PULSE_LEN	(MAX_SYNC_HIGH_LEN * (100 + DRIFT_TOLERANCE) / 100)
+
+#define RAW_DATA_LEN	32		// bits
+#define MIN_NUM_PULSES	64		// 2 * 32
+
+#define HOUSE_MASK		0xF0000000
+#define HOUSE_SHIFT		28
+
+#define UNIT8_MASK		0x04000000
+#define UNIT8_SHIFT		26
+
+#define COMMAND_MASK	0x00008000
+#define COMMAND_SHIFT	15
+
+#define UNIT4_MASK		0x00004000
+#define UNIT4_SHIFT		14
+
+#define OFF_MASK		0x00002000
+#define OFF_SHIFT		13
+
+#define UNIT1_MASK		0x00001000
+#define UNIT1_SHIFT		12
+
+#define UNIT2_MASK		0x00000800
+#define UNIT2_SHIFT		11
+
+#define B0_MASK			0xFF000000
+#define B0_SHIFT		24
+
+#define B1_MASK			0x00FF0000
+#define B1_SHIFT		16
+
+#define B2_MASK			0x0000FF00
+#define B2_SHIFT		8
+
+#define B3_MASK			0x000000FF
+#define B3_SHIFT		0
+
+// Commands sent in b2 when its bit 7 is set
+#define CMD_ALL_UNITS_OFF	0x80
+#define CMD_ALL_LIGHTS_ON	0x90
+#define CMD_BRIGHT			0x88
+#define CMD_DIM				0x98
+
+
+static uint16_t decode_x10rf(uint16_t *pulseLens, uint16_t nbPulses);
+
+const decoderDesc_t decoder_X10Rf =
+{
+	.name 			= "X10",
+	.minPulseLen  	= MIN_PULSE_LEN,
+	.maxPulseLen  	= MAX_PULSE_LEN,
+	.minNumPulses 	= MIN_NUM_PULSES,
+	.decoderFunc	= decode_x10rf
+};
+
+// Keep the filter limits in sync with the decoder table
+DECODER_CHECK_LIMITS(DECODER_ROW_X10_RF, MIN_PULSE_LEN, MAX_PULSE_LEN, MIN_NUM_PULSES);
+
+
+static const pwmProtocol_t x10rfProtocol =
+{
+	.syncShape		= PWM_SYNC_HIGH_LOW,
+	.syncHigh		= { MIN_SYNC_HIGH_LEN, MAX_SYNC_HIGH_LEN },
+	.sync			= { MIN_SYNC_LEN, MAX_SYNC_LEN },
+	.nominalSync	= NOMINAL_SYNC_LEN,
+	.encoding		= PWM_BIT_SECOND,
+	.first			= { MIN_FIRST_LEN, MAX_FIRST_LEN },
+	.shortPulse		= { MIN_SHORT_LEN, MAX_SHORT_LEN },
+	.longPulse		= { MIN_LONG_LEN, MAX_LONG_LEN },
+	.maxBits		= RAW_DATA_LEN,
+	.revert			= 0,
+	.flags			= PWM_FIRST_FRAME_ONLY,
+	.minNumPulses	= MIN_NUM_PULSES
+};
+
+//! House letter of each house code
+static const char houseCodes[16] = "MNOPCDABEFGHKLIJ";
+
+//! Records: one per command, and unit commands
+#define X10_COMMAND_RECORD(name, cmd) \
+	static const recordType_t	name = { .format = "%s,House=%c,Cmd=" cmd "\n", .nbValues = 1, .fields = { "House" } };
+
+X10_COMMAND_RECORD(recordAllUnitsOff,	"AllUnitsOff")
+X10_COMMAND_RECORD(recordAllLightsOn,	"AllLightsOn")
+X10_COMMAND_RECORD(recordBright,		"Bright")
+X10_COMMAND_RECORD(recordDim,			"Dim")
+static const recordType_t	recordCommand = {
+	.format		= "%s,House=%c,Cmd=0x%02X\n",
+	.nbValues	= 2,
+	.fields		= { "House", "Cmd" }
+};
+static const recordType_t	recordUnitOn = {
+	.format		= "%s,House=%c,Unit=%d,Cmd=On\n",
+	.nbValues	= 2,
+	.fields		= { "House", "Unit" }
+};
+static const recordType_t	recordUnitOff = {
+	.format		= "%s,House=%c,Unit=%d,Cmd=Off\n",
+	.nbValues	= 2,
+	.fields		= { "House", "Unit" }
+};
+
+
+static uint8_t interpret_x10rf(const pwmFrame_t *frame)
+{
+	uint32_t	rawData	= frame->bits.words[0];
+	uint8_t		unit;
+	
+	
+	// Each byte is followed by its complement
+	if (frame->bits.nbBits != RAW_DATA_LEN ||
+		(BIN_VALUE(B0) ^ BIN_VALUE(B1)) != 0xFF ||
+		(BIN_VALUE(B2) ^ BIN_VALUE(B3)) != 0xFF)
+	{
+		return 0;
+	}
+	
+	if (BIN_VALUE(COMMAND))
+	{
+		switch (BIN_VALUE(B2))
+		{
+			case CMD_ALL_UNITS_OFF:
+				record_emitBits((const char *)decoder_X10Rf.name, &recordAllUnitsOff, &frame->bits, houseCodes[BIN_VALUE(HOUSE)]);
+				return 1;
+			case CMD_ALL_LIGHTS_ON:
+				record_emitBits((const char *)decoder_X10Rf.name, &recordAllLightsOn, &frame->bits, houseCodes[BIN_VALUE(HOUSE)]);
+				return 1;
+			case CMD_BRIGHT:
+				record_emitBits((const char *)decoder_X10Rf.name, &recordBright, &frame->bits, houseCodes[BIN_VALUE(HOUSE)]);
+				return 1;
+			case CMD_DIM:
+				record_emitBits((const char *)decoder_X10Rf.name, &recordDim, &frame->bits, houseCodes[BIN_VALUE(HOUSE)]);
+				return 1;
+			default:
+				record_emitBits((const char *)decoder_X10Rf.name, &recordCommand, &frame->bits, houseCodes[BIN_VALUE(HOUSE)], BIN_VALUE(B2));
+				return 1;
+		}
+	}
+	
+	unit = 1 + (BIN_VALUE(UNIT8) << 3) + (BIN_VALUE(UNIT4) << 2) + (BIN_VALUE(UNIT2) << 1) + BIN_VALUE(UNIT1);
+	record_emitBits((const char *)decoder_X10Rf.name, (BIN_VALUE(OFF) ? &recordUnitOff : &recordUnitOn), &frame->bits, houseCodes[BIN_VALUE(HOUSE)], unit);
+	return 1;
+}
+	
+static uint16_t decode_x10rf(uint16_t *pulseLens, uint16_t nbPulses)
+{
+	return PWM_DECODE_SENTENCE(&x10rfProtocol, pulseLens, nbPulses, interpret_x10rf);
+}
@@ -21,7 +21,7 @@
  * DEFAULT VALUES:
  *
  * -Computer UART: TX=PA2 --> to be connected to the RX pin of your UART module
- * -Computer UART: RX is not used (i.e. you cannot send character from your computer)
+ * -Computer UART: RX=PA3 --> receives the commands (see command.h)
  *
  * -ESP8266 UART: TX=PB10 --> to be connected to the RX pin of the ESP8266 module
  * -ESP8266 UART: RX=PB11 --> to be connected to the TX pin of the ESP8266 module
@@ -30,6 +30,15 @@
 #define COMPUTER_UART_PINSPACK	TM_USART_PinsPack_1
 #define COMPUTER_UART_BAUDRATE	57600
 
+//! DMA stream sending on the computer UART (USART2 TX: DMA1 stream 6, channel 4)
+#define COMPUTER_UART_DMA_STREAM	DMA1_Stream6
+#define COMPUTER_UART_DMA_CHANNEL	DMA_Channel_4
+#define COMPUTER_UART_DMA_CLOCK		RCC_AHB1Periph_DMA1
+#define COMPUTER_UART_DMA_IRQ		DMA1_Stream6_IRQn
+#define COMPUTER_UART_DMA_HANDLER	DMA1_Stream6_IRQHandler
+#define COMPUTER_UART_DMA_TC		DMA_IT_TCIF6
+#define COMPUTER_UART_DMA_FLAGS		(DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6)
+
 #define ESP8266_UART			USART3
 #define ESP8266_UART_PINSPACK	TM_USART_PinsPack_1
 #define ESP8266_UART_BAUDRATE	9600
@@ -41,6 +50,36 @@
 //! Enable debug messages with DEBUG_PRINTF (will be prefixed with a #)
 #define DEBUG 1
 
+/*
+ * Identical output lines sent less than OUTPUT_DEDUPE_WINDOW ms apart are only
+ * sent once, followed by a single record holding their repeat count.
+ * OUTPUT_DEDUPE_SIZE lines of at most OUTPUT_DEDUPE_LINE_LEN characters are
+ * remembered. Set OUTPUT_DEDUPE_WINDOW to 0 to send every line.
+ */
+#define OUTPUT_DEDUPE_SIZE		16
+#define OUTPUT_DEDUPE_WINDOW	2000
+#define OUTPUT_DEDUPE_LINE_LEN	80
+
+/*
+ * The computer UART is written through a ring of UART_TX_RING_SIZE bytes,
+ * drained by DMA (see uart_tx.h): printing doesn't wait for the characters to
+ * be sent. A message which doesn't fit in the ring is dropped and counted.
+ * Define UART_TX_OVERFLOW_WAIT to wait for room instead, as TM_USART_Puts() did
+ * (here, or from the compiler command line, e.g. for tools/uart_tx_stress.c).
+ */
+#define UART_TX_RING_SIZE		4096
+//#define UART_TX_OVERFLOW_WAIT
+
+/*
+ * The decoders queue typed records (see record.h) in a pool of
+ * RECORD_POOL_SIZE records, which the sinks print once the sentence is
+ * decoded (the default decoder may report about 20 records on a long sentence,
+ * and stops once the pool is full). Define RECORD_SINK_FIELDS to also print every record field by name
+ * ("Record,<decoder>,Time=...,<field>=<value>,...").
+ */
+#define RECORD_POOL_SIZE		32
+#undef RECORD_SINK_FIELDS
+
 
 /*******************************************************************************
  * Decoders to enable
@@ -51,10 +90,21 @@
 #define USE_OREGON_V2		1
 #define USE_RCSWITCH		1
 #define USE_HOME_EASY		1
+#define USE_X10_RF			1
 #define USE_CAME_432NA		1
 #define USE_DIP_SWITCH		1
 #define USE_CARKEY_1		1
-#undef USE_SIEMENS_VDO		
+#define USE_SIEMENS_VDO		1
+
+/*
+ * Decoders built on the PWM engine (generic_pwm.h) get their own copy of the
+ * decoding loop, specialized for their protocol: faster, but bigger.
+ * Undefine to share a single engine between all of them (PWM_SHARED_ENGINE does
+ * it from the compiler command line, e.g. for tools/pwm_bench.c).
+ */
+#ifndef PWM_SHARED_ENGINE
+#define PWM_SPECIALIZED_KERNELS	1
+#endif
 
 
 /*******************************************************************************
@@ -80,6 +130,88 @@
 // Earn a joker every JOKER_PERIOD valid pulses
 #define JOKER_PERIOD		48
 
+/*
+ * Repeated frames are not decoded again: a sentence identical to one received
+ * less than FRAME_CACHE_WINDOW ms earlier reuses its decoding result.
+ * Pulse lens are rounded to FRAME_CACHE_QUANTUM s before being compared.
+ */
+#define FRAME_CACHE_SIZE	8
+#define FRAME_CACHE_WINDOW	500
+#define FRAME_CACHE_QUANTUM	100
+
+/*
+ * KeeLoq fobs (CarKey1) are tracked in a table of 2^KEELOQ_FOB_TABLE_BITS
+ * entries, a fob being looked up in at most KEELOQ_FOB_MAX_PROBES of them.
+ * Frames repeating the hopping code of the last press less than
+ * KEELOQ_PRESS_WINDOW ms later belong to the same press.
+ * Define KEELOQ_MANUFACTURER_KEY (64 bits) to decrypt the press counters.
+ */
+#define KEELOQ_FOB_TABLE_BITS	5
+#define KEELOQ_FOB_MAX_PROBES	8
+#define KEELOQ_PRESS_WINDOW		1000
+#undef KEELOQ_MANUFACTURER_KEY
+
+/*
+ * Protocols loaded at run time (see protocol_store.h) are stored in this flash
+ * sector (the last 128kB sector of the STM32F407), which the firmware must not
+ * use.
+ */
+#define PROTO_STORE_SECTOR		FLASH_Sector_11
+#define PROTO_STORE_ADDRESS		0x080E0000
+
+/*
+ * Sentences no decoder matched are handed to the learner (see learner.h),
+ * which infers their PWM protocol. A learned protocol is reported once with
+ * its descriptor, then by its signature only. LEARNER_MAX_SIGNATURES protocols
+ * are remembered. Pulses within LEARNER_CLASS_TOLERANCE % belong to the same
+ * timing class, and frames shorter than LEARNER_MIN_BITS are not learned.
+ * Undefine USE_LEARNER to dump the raw pulses of every unknown sentence
+ * (RAW_DUMP_ONLY does it from the compiler command line, e.g. for
+ * tools/x10_dump.c).
+ */
+#ifndef RAW_DUMP_ONLY
+#define USE_LEARNER					1
+#endif
+#define LEARNER_MAX_SIGNATURES		16
+#define LEARNER_CLASS_TOLERANCE		25
+#define LEARNER_MIN_BITS			8
+
+/*
+ * A decision tree (see router.h) picks the decoders a sentence may match, and
+ * only those are called, all of them when the tree is unsure. The committed
+ * router_tree.h was trained on synthetic sentences (tools/router_captures.c):
+ * define USE_ROUTER once it is generated again with tools/router_train.c from
+ * captures of the actual transmitters. Undefined, every decoder is called.
+ */
+#undef USE_ROUTER
+
+/*
+ * Every decoder call is metered with the DWT cycle counter (see budget.h): a
+ * call may run BUDGET_DECODER_CYCLES, and all the calls on a sentence
+ * BUDGET_SENTENCE_CYCLES, while the next sentences wait in the queue (10 and
+ * 20 ms at 168 MHz).
+ * Longer calls stop at their next checkpoint, the remaining ones are skipped.
+ */
+#define BUDGET_DECODER_CYCLES		(168 * 10000)
+#define BUDGET_SENTENCE_CYCLES		(168 * 20000)
+
+/*
+ * Recorded sentences wait in a priority queue (see sentence_queue.h) until the
+ * main loop decodes them, the most promising first. When SENTENCE_QUEUE_SIZE
+ * sentences are waiting, the worst one (likely noise) is shed. Each slot holds
+ * MAX_NUM_PULSES pulses (2kB), and two more slots are used for recording and
+ * decoding.
+ */
+#define SENTENCE_QUEUE_SIZE			6
+
+/*
+ * The decoders having a streaming version (see stream.h: Oregon V2) are fed by
+ * the receiver interrupt as the pulses arrive, instead of once the sentence has
+ * ended, and report their frames as soon as they are complete. Undefine
+ * USE_STREAM_DECODERS to run their batch version from the main loop.
+ */
+#define USE_STREAM_DECODERS			1
+
 
 /*******************************************************************************
  * Internal settings of the TM libraries
@@ -90,5 +222,8 @@
 #define TM_DELAY_TIM_IRQ			TIM4_IRQn
 #define TM_DELAY_TIM_IRQ_HANDLER	TIM4_IRQHandler
 
+/* Computer UART RX buffer: holds a whole protocol store command line */
+#define TM_USART2_BUFFER_SIZE		256
+
 
 #endif // DEFINES_H
@@ -166,3 +166,31 @@ uint8_t esp8266_syslog(char *message)
 		
 	return 1;
 }
+
+//------------------------------------------------------------------------------
+/*!
+ * @brief Read a line received in a UDP datagram from the syslog host
+ *
+ * The module forwards a datagram as "+IPD,<len>:<data>": the data must end
+ * with a newline. Other lines (late responses) are dropped.
+ *
+ * @return The length of the line, 0 if none was received
+ */
+uint16_t esp8266_receive(char *line, uint16_t len)
+{
+	char	*data;
+	
+	
+	while (connectOk && getLineFromUart() > 0)
+	{
+		if (strncmp(WifiRxBuffer, "+IPD,", 5) != 0 || (data = strchr(WifiRxBuffer, ':')) == NULL) {
+			continue;
+		}
+		
+		strncpy(line, data + 1, len - 1);
+		line[len - 1] = '\0';
+		return strlen(line);
+	}
+	
+	return 0;
+}
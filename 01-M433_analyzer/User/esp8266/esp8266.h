@@ -6,6 +6,7 @@
 uint8_t esp8266_init(void);
 uint8_t esp8266_connect(void);
 uint8_t esp8266_syslog(char *message);
+uint16_t esp8266_receive(char *line, uint16_t len);
 
 
 
@@ -0,0 +1,129 @@
+#include "frame_cache.h"
+#include "defines.h"
+
+// FRAME_CACHE_WINDOW in systick units (10s)
+#define WINDOW_TICKS		(FRAME_CACHE_WINDOW * 100)
+
+// FNV-1a parameters
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME			16777619u
+
+
+static frameCacheEntry_t	cache[FRAME_CACHE_SIZE];
+
+//! Never matches a sentence: an entry holding it is free
+#define NO_PULSES			0
+
+uint32_t					frameCacheHits = 0;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Compute the fingerprint of a sentence
+ *
+ * Pulse lens are rounded to FRAME_CACHE_QUANTUM so that the jitter between
+ * two repeats of a frame doesn't change the fingerprint.
+ */
+uint32_t frameCache_hash(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i;
+	uint32_t	hash = FNV_OFFSET_BASIS;
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		hash ^= (pulseLens[i] + FRAME_CACHE_QUANTUM/2) / FRAME_CACHE_QUANTUM;
+		hash *= FNV_PRIME;
+	}
+	
+	return hash;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Find the entry of a sentence
+ */
+static frameCacheEntry_t *frameCache_find(uint32_t hash, uint16_t nbPulses)
+{
+	uint8_t		i;
+	
+	for (i = 0; i < FRAME_CACHE_SIZE; i++)
+	{
+		if (cache[i].hash == hash && cache[i].nbPulses == nbPulses) {
+			return &cache[i];
+		}
+	}
+	
+	return NULL;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Reuse the decoding result of a recent sentence with the same fingerprint
+ *
+ * The line the sentence printed is sent again through the output, which counts
+ * it as a repeat (see output.h).
+ *
+ * @return 1 if the sentence must not be decoded, 0 if it is not a repeat, or if
+ * its line is no longer known by the output
+ */
+uint8_t frameCache_reuse(uint32_t hash, uint16_t nbPulses)
+{
+	frameCacheEntry_t	*entry = frameCache_find(hash, nbPulses);
+	uint32_t			now = sysTickTime;
+	
+	if (entry == NULL || now - entry->lastSeen >= WINDOW_TICKS) {
+		return 0;
+	}
+	if (entry->line != 0 && !output_repeat(entry->line, entry->lineCount))
+	{
+		// Decode it again, and store its new result
+		entry->nbPulses = NO_PULSES;
+		return 0;
+	}
+	
+	entry->lastSeen = now;
+	frameCacheHits++;
+	return 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Remember a decoded sentence, replacing its entry or the oldest one
+ * @param line What the decoding printed, and how many times (see output_lastLine())
+ */
+void frameCache_store(uint32_t hash, uint16_t nbPulses, uint32_t line, uint16_t lineCount)
+{
+	uint8_t				i, oldest = 0;
+	uint32_t			now = sysTickTime;
+	frameCacheEntry_t	*entry = frameCache_find(hash, nbPulses);
+	
+	if (line == OUTPUT_LINES_MIXED || line == OUTPUT_LINE_NEW)
+	{
+		// Its result can't be replayed, or not yet: the decoder may not print
+		// the line again for the next copy (once per press)
+		if (entry != NULL) {
+			entry->nbPulses = NO_PULSES;
+		}
+		return;
+	}
+	
+	// A free entry, or the oldest one
+	for (i = 1; entry == NULL && i < FRAME_CACHE_SIZE; i++)
+	{
+		if (cache[oldest].nbPulses == NO_PULSES) {
+			break;
+		}
+		if (cache[i].nbPulses == NO_PULSES || now - cache[i].lastSeen > now - cache[oldest].lastSeen) {
+			oldest = i;
+		}
+	}
+	if (entry == NULL) {
+		entry = &cache[oldest];
+	}
+	
+	entry->hash			= hash;
+	entry->lastSeen		= now;
+	entry->line			= line;
+	entry->lineCount	= lineCount;
+	entry->nbPulses		= nbPulses;
+}
@@ -0,0 +1,40 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include "main.h"
+
+/*
+ * Remotes send the same frame several times per button press. The frame cache
+ * remembers the fingerprint of the last decoded sentences, with the line their
+ * decoding printed (see output_lastLine()). A sentence whose fingerprint was
+ * seen less than FRAME_CACHE_WINDOW ms ago is a repeat: the decoders are not
+ * called, and its line goes through the output again (output_repeat()), so
+ * that the output deduplication counts it as if it had been decoded.
+ *
+ * A sentence which printed something else than a single line (several lines,
+ * a raw dump), or whose decoding the cycle budget cut short (see budget.h), is
+ * not cached: its repeats are decoded again. Neither is a line the output sent
+ * rather than counting it as a repeat: the next copy is decoded again, and
+ * cached with what it printed. A decoder printing once per press (CarKey1
+ * ignores the copies of a hopping code) prints nothing for it, and nothing is
+ * replayed for the following copies: the press keeps its single line, without
+ * a repeat record.
+ */
+
+//! Frame cache entry
+typedef struct {
+	uint32_t	hash;			// Fingerprint of the quantized pulses
+	uint32_t	lastSeen;		// sysTickTime of the last occurrence
+	uint32_t	line;			// Line printed by the decoding, 0 if none (see output_lastLine())
+	uint16_t	lineCount;		// Number of times it was printed
+	uint16_t	nbPulses;		// Number of pulses in the sentence
+} frameCacheEntry_t;
+
+//! Total number of sentences which were not decoded again
+extern uint32_t frameCacheHits;
+
+uint32_t	frameCache_hash(const uint16_t *pulseLens, uint16_t nbPulses);
+uint8_t		frameCache_reuse(uint32_t hash, uint16_t nbPulses);
+void		frameCache_store(uint32_t hash, uint16_t nbPulses, uint32_t line, uint16_t lineCount);
+
+#endif // FRAME_CACHE_H
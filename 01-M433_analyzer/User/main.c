@@ -4,6 +4,15 @@
 #include <math.h>
 #include "decoder.h"
 #include "esp8266.h"
+#include "frame_cache.h"
+#include "protocol_store.h"
+#include "router.h"
+#include "budget.h"
+#include "sentence_queue.h"
+#include "stream.h"
+#include "record.h"
+#include "capture_config.h"
+#include "command.h"
 #include "defines.h"
 #include "main.h"
 
@@ -18,110 +27,204 @@
 
 /* External functions --------------------------------------------------------*/
 void 		SystemClock_Config(void);
-uint16_t 	decode_default(uint32_t *pulseLens, uint16_t nbPulses);
+uint16_t 	decode_default(uint16_t *pulseLens, uint16_t nbPulses);
 
 
 /* Global variables ----------------------------------------------------------*/
-//! Decoder descriptions
-static decoderDesc_t 	*decoders[16];
-
-//! Number of registered decoders
-static uint8_t			numDecoders = 0;
-
-//! Global pulse filter
-static decoderDesc_t	globalFilter;
+//! Decoder descriptions, indexed as in DECODER_TABLE
+static const decoderDesc_t * const decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
 
 /*!
- * Array of recorded pulse lens
+ * Sentence being recorded, in a slot of the sentence queue
  * @remark The first pulse is always a HIGH pulse
  */
-static uint32_t		pulseLens[MAX_NUM_PULSES];
+static sentence_t	*recording;
 
-//! Number of pulses stored in pulseLens[]
+//! Number of pulses stored in recording->pulseLens[]
 static uint16_t 	numPulses;
 
-//! Total length of the sentence stored in pulseLens
+//! Total length of the sentence being recorded
 static uint32_t		sentenceLen;
 
 //! UART transmission buffer
 char 				UartBuffer[BUFFER_LEN];
 uint16_t			UartBufSz;
 
+//! Period of the main loop tasks (ms), and number of periods between two heartbeats
+#define MAIN_LOOP_PERIOD	10
+#define HEARTBEAT_PERIODS	50
+
 //! Systick counter
 volatile uint32_t	sysTickTime = 0;
 
 
 /*----------------------------------------------------------------------------*/
 /*!
- * @brief Register a decoder to the analyzer. Its min and max ranges are merged
- *        with the global filter
+ * @brief Setup the interrupts triggered when the 433MHz receiver's data value changes
+ * @remark The GPIO port and pin number must be defined in defines.h
+ */
+static void RadioInterrupt_Config(void)
+{
+	TM_GPIO_Init(RECEIVER_PORT, RECEIVER_PIN, TM_GPIO_Mode_IN, TM_GPIO_OType_OD, TM_GPIO_PuPd_NOPULL, TM_GPIO_Speed_Medium);
+	
+	if (TM_EXTI_Attach(RECEIVER_PORT, RECEIVER_PIN, TM_EXTI_Trigger_Rising_Falling) != TM_EXTI_Result_Ok)
+	{
+		TM_DISCO_LedOn(LED_FAIL);
+		while (1);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Run the decoders on a queued sentence
  */
-int registerDecoder(decoderDesc_t *decoder)
+static void processSentence(sentence_t *sentence)
 {
-	if (decoder == NULL || numDecoders >= MAX_DECODERS) {
-		return 0;
+	uint8_t			i, result = (sentence->streamed != 0);
+	decoderMask_t	mask;
+	uint32_t		hash, line;
+	uint16_t		lineCount;
+	uint16_t		*pulseLens = sentence->pulseLens;
+	uint16_t		nbPulses = sentence->nbPulses;
+	
+	
+	// Skip the decoders if the same sentence was just decoded: its line is
+	// sent again instead
+	hash = frameCache_hash(pulseLens, nbPulses);
+	if (frameCache_reuse(hash, nbPulses)) {
+		return;
 	}
+	output_mark();
 	
-	decoders[numDecoders++] = decoder;
-	if (decoder->minNumPulses < globalFilter.minNumPulses) {
-		globalFilter.minNumPulses = decoder->minNumPulses;
+	// Every call is metered, and skipped once the sentence budget is spent
+	budget_startSentence();
+	for (i=0, mask = sentence->candidates; mask != 0; i++, mask >>= 1)
+	{
+		if ((mask & 1) && budget_start(i))
+		{
+			result += decoders[i]->decoderFunc(pulseLens, nbPulses);
+			budget_stop();
+		}
 	}
-	if (decoder->minPulseLen < globalFilter.minPulseLen) {
-		globalFilter.minPulseLen = decoder->minPulseLen;
+	if (budget_start(BUDGET_SLOT_STORE))
+	{
+		result += protoStore_decode(pulseLens, nbPulses);
+		budget_stop();
 	}
-	if (decoder->maxPulseLen > globalFilter.maxPulseLen) {
-		globalFilter.maxPulseLen = decoder->maxPulseLen;
+	
+	if (result == 0 && budget_start(BUDGET_SLOT_DEFAULT))
+	{
+		// No decoder matched the sentence - call the default decoder
+		decode_default(pulseLens, nbPulses);
+		budget_stop();
 	}
 	
-	DEBUG_PRINTF("* Registered decoder #%d: %s\n", numDecoders, decoder->name);	
-	return 1;
+	// Print what the decoders found, outside the decode path, and remember
+	// it for the repeats of the sentence, unless the budget cut the decoding
+	record_poll();
+	if (!budget_sentenceExhausted())
+	{
+		line = output_lastLine(&lineCount);
+		frameCache_store(hash, nbPulses, line, lineCount);
+	}
 }
 
 /*----------------------------------------------------------------------------*/
 /*!
- * @brief Setup the interrupts triggered when the 433MHz receiver's data value changes
- * @remark The GPIO port and pin number must be defined in defines.h
+ * @brief Queue the sentence just recorded, and start recording into another slot
+ * @param config Capture configuration the sentence was recorded with
+ * @param nbJokers Number of jokers used by the recording
+ * @remark Called from the receiver interrupt: only cheap checks here
  */
-static void RadioInterrupt_Config(void)
+static void queueSentence(const captureConfig_t *config, uint16_t nbJokers)
 {
-	TM_GPIO_Init(RECEIVER_PORT, RECEIVER_PIN, TM_GPIO_Mode_IN, TM_GPIO_OType_OD, TM_GPIO_PuPd_NOPULL, TM_GPIO_Speed_Medium);
+	decoderMask_t	candidates, streamed = 0;
 	
-	if (TM_EXTI_Attach(RECEIVER_PORT, RECEIVER_PIN, TM_EXTI_Trigger_Rising_Falling) != TM_EXTI_Result_Ok)
-	{
-		TM_DISCO_LedOn(LED_FAIL);
-		while (1);
+	
+	// The enabled decoders expecting this many pulses...
+	candidates = decoder_dispatchMask(numPulses) & config->decoders;
+#ifdef USE_ROUTER
+	// ... and among them, the ones the router predicts
+	candidates &= router_route(recording->pulseLens, numPulses);
+#endif
+#ifdef USE_STREAM_DECODERS
+	// ... but the streaming decoders, which were fed as the pulses arrived
+	streamed = stream_end();
+	candidates &= ~stream_decoders();
+	if (streamed != 0 && candidates == 0) {
+		// Nothing left to decode, the slot is recorded over
+		return;
 	}
+#endif
+	
+	recording->nbPulses		= numPulses;
+	recording->candidates	= candidates;
+	recording->streamed		= streamed;
+	recording->score		= sentenceQueue_score(numPulses, candidates, (uint8_t)(nbJokers < 0xFF ? nbJokers : 0xFF));
+	recording = sentenceQueue_push(recording);
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Load the protocols stored in flash
+ * @remark The receiver interrupt doesn't use them: it keeps running with the
+ * current capture configuration until captureConfig_rebuild() is called
+ */
+static void loadProtocols(void)
+{
+	uint8_t	nbLoaded = protoStore_load(decoders, NUM_DECODERS);
+	
+	
+	DEBUG_PRINTF("* %d protocols loaded\n", nbLoaded);
 }
 
 /*----------------------------------------------------------------------------*/
 /*!
- * @brief Run all the decoders on a sentence once the recording ends
+ * @brief Report the decoders which went over their cycle budget, the sentences
+ * shed by the queue and the messages dropped by the UART ring, since the last report
  */
-static void processSentence()
+static void reportOverloads(void)
 {
-	uint8_t			i, result = 0;
-	decoderDesc_t	*dec;
+	static uint32_t	reported[BUDGET_NB_SLOTS];
+	static uint32_t	reportedShed = 0;
+	static uint32_t	reportedDropped = 0;
 	
+	uint8_t			i;
+	uint32_t		events;
+	budgetStats_t	*stats;
 	
-	// Disable the upcoming IT
-	NVIC_DisableIRQ(EXTI0_IRQn);
 	
-	for (i=0; i<numDecoders; i++)
+	for (i = 0; i < BUDGET_NB_SLOTS; i++)
 	{
-		dec = decoders[i];
-		if (numPulses > dec->minNumPulses) {
-			result += dec->decoderFunc(pulseLens, numPulses);
+		stats = &budgetStats[i];
+		events = stats->overruns + stats->aborts + stats->skipped;
+		if (events == reported[i]) {
+			continue;
 		}
+		reported[i] = events;
+		
+		PRINTF("Budget,%s,Calls=%lu,Overruns=%lu,Aborts=%lu,Skipped=%lu,MaxCycles=%lu\n",
+			(i < NUM_DECODERS ? (const char *)decoders[i]->name : (i == BUDGET_SLOT_STORE ? "Store" : "Default")),
+			(unsigned long)stats->calls, (unsigned long)stats->overruns, (unsigned long)stats->aborts,
+			(unsigned long)stats->skipped, (unsigned long)stats->maxCycles);
 	}
 	
-	if (result == 0)
+	if (sentenceQueueStats.shed != reportedShed)
 	{
-		// No decoder matched the sentence - call the default decoder
-		decode_default(pulseLens, numPulses);
+		reportedShed = sentenceQueueStats.shed;
+		PRINTF("Queue,Queued=%lu,Shed=%lu,ShedNoise=%lu,MaxDepth=%d\n",
+			(unsigned long)sentenceQueueStats.queued, (unsigned long)sentenceQueueStats.shed,
+			(unsigned long)sentenceQueueStats.shedNoise, sentenceQueueStats.maxDepth);
+	}
+	
+	if (uartTxStats.dropped != reportedDropped)
+	{
+		reportedDropped = uartTxStats.dropped;
+		PRINTF("Tx,Dropped=%lu,DroppedBytes=%lu,MaxUsed=%d\n",
+			(unsigned long)uartTxStats.dropped, (unsigned long)uartTxStats.droppedBytes, uartTxStats.maxUsed);
 	}
-		
-	// Enable the interrupts again
-	NVIC_EnableIRQ(EXTI0_IRQn);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -138,10 +241,13 @@ void TM_EXTI_Handler(uint16_t GPIO_Pin)
 {
 	// Date of the previous interrupt
 	static uint32_t	lastTime = 0;
-	static uint8_t	jokers;
+	static uint32_t	jokers;
+	static uint16_t	usedJokers;
 
+	// Read once: the main loop may publish a new configuration between two pulses
+	const captureConfig_t	*config = captureConfig;
 	uint32_t 	pulseLen, pinValue;
-	uint8_t		validPulse = 0;		
+	uint8_t		validPulse = 0, inFilter;
 		
 	if (GPIO_Pin != RECEIVER_PIN) {
 		return;
@@ -154,42 +260,56 @@ void TM_EXTI_Handler(uint16_t GPIO_Pin)
 	lastTime = sysTickTime;
 	
 	pinValue = TM_GPIO_GetInputPinValue(RECEIVER_PORT, RECEIVER_PIN);
+	inFilter = (pulseLen < config->filter.maxPulseLen && pulseLen > config->filter.minPulseLen);
 	
 	
 	if (numPulses > 0)
 	{
 		// We had already started recording -> validate pulse len or use a joker
-		if ((pulseLen < globalFilter.maxPulseLen && pulseLen > globalFilter.minPulseLen) ||
-			jokers-- > 0)
+		if (inFilter || jokers > 0)
 		{
-			pulseLens[numPulses++] = (uint16_t)pulseLen;
+			if (!inFilter) {
+				// Each joker used hints at noise
+				jokers--;
+				usedJokers++;
+			}
+			recording->pulseLens[numPulses++] = (uint16_t)pulseLen;
 			sentenceLen += pulseLen;
 			validPulse = 1;
-			if (numPulses % JOKER_PERIOD == 0) {
+#ifdef USE_STREAM_DECODERS
+			// The pin just left the level of this pulse
+			stream_feed((uint16_t)pulseLen, pinValue == RESET);
+#endif
+			if (numPulses % config->settings.jokerPeriod == 0) {
 				// Enough pulses have been recorded, we earned a joker!
-				jokers += NUM_JOKERS;
+				jokers += config->settings.numJokers;
 			}
 		}
 	}
-	else if (pinValue == RESET && pulseLen < globalFilter.maxPulseLen && pulseLen > globalFilter.minPulseLen)
+	else if (pinValue == RESET && inFilter)
 	{
 		// we just received a suitable HIGH pulse -> start recording
-		jokers 		= NUM_JOKERS;
+		jokers 		= config->settings.numJokers;
+		usedJokers	= 0;
 		sentenceLen = 0;
 		
-		pulseLens[numPulses++] = (uint16_t)pulseLen;
+		recording->pulseLens[numPulses++] = (uint16_t)pulseLen;
 		sentenceLen += pulseLen;
 
 		validPulse = 1;
+#ifdef USE_STREAM_DECODERS
+		stream_start(config->decoders);
+		stream_feed((uint16_t)pulseLen, 1);
+#endif
 	}
 	
 	if (!validPulse || (numPulses == MAX_NUM_PULSES))
 	{
 		// Recording may stop if an invalid pulse is received
-		// or if the record buffer is full
-		if (sentenceLen > MIN_SENTENCE_LEN || numPulses > globalFilter.minNumPulses)
+		// or if the record buffer is full. The main loop decodes it.
+		if (numPulses > 0 && (sentenceLen > config->settings.minSentenceLen || numPulses > config->filter.minNumPulses))
 		{
-			processSentence();
+			queueSentence(config, usedJokers);
 		}
 		
 		// Reset the pulse counter
@@ -204,6 +324,11 @@ void TM_EXTI_Handler(uint16_t GPIO_Pin)
 
 int main(void)
 {	
+	uint8_t		loops = 0, changes;
+	uint32_t	lastPeriod;
+	sentence_t	*sentence;
+	
+	
 	/* Initialize system */
 	SystemInit();
 	
@@ -222,6 +347,9 @@ int main(void)
 	/* Initialize the computer USART */
 	TM_USART_Init(COMPUTER_UART, COMPUTER_UART_PINSPACK, COMPUTER_UART_BAUDRATE);
 	
+	/* Send on it by DMA: printing doesn't wait */
+	uartTx_init();
+	
 	DEBUG_PRINTF("* Decoder starting!\n\n");	
 	
 	
@@ -237,42 +365,71 @@ int main(void)
 	}
 #endif
 	
-	// Initialize the global pulse filter
-	globalFilter.minNumPulses = 0xFFFF;
-	globalFilter.minPulseLen = 0xFFFFFFFF;
-	globalFilter.maxPulseLen = 0;
-	
-	// Register the available decoders
-	// Sensors
-	REGISTER_OREGON_EW91;
-	REGISTER_OREGON_V2;
+	// Decoders are built at compile time (see DECODER_TABLE), then completed
+	// by the protocols stored in flash. The global filter covers them all.
+	DEBUG_PRINTF("* %d decoders enabled\n", NUM_DECODERS);
+	loadProtocols();
+	captureConfig_rebuild(decoders, NUM_DECODERS);
 	
-	// Home automation
-	REGISTER_RCSWITCH;
-	REGISTER_HOME_EASY;
-	
-	// Garage doors
-	REGISTER_CAME_432NA;
-	REGISTER_DIP_SWITCH;
-	
-	// Car key fobs
-	REGISTER_CARKEY_1;
-	REGISTER_SIEMENS_VDO;
+	// Start the cycle counter metering the decoders
+	budget_init();
 	
 	// Initialize the record variables
 	numPulses = sentenceLen = 0;
+	recording = sentenceQueue_init();
 	
 	// Initialize the 433MHz receiver interrupts
 	RadioInterrupt_Config();
 	
 	// GO!
-	DEBUG_PRINTF("Main globalFilter: minNumPulses=%d, minPulseLen=%d, maxPulseLen=%d\n", globalFilter.minNumPulses, globalFilter.minPulseLen, globalFilter.maxPulseLen);
+	DEBUG_PRINTF("Main globalFilter: minNumPulses=%d, minPulseLen=%d, maxPulseLen=%d\n", captureConfig->filter.minNumPulses, captureConfig->filter.minPulseLen, captureConfig->filter.maxPulseLen);
 	
 	/* Infinite loop */
+	lastPeriod = sysTickTime;
 	while (1)
 	{
-		Delayms(500);
-		TM_DISCO_LedToggle(LED_HEARTBEAT);
+#ifdef USE_STREAM_DECODERS
+		// Print the frames reported by the streaming decoders
+		stream_poll();
+		record_poll();
+#endif
+		
+		// Decode the queued sentences, the most promising first
+		NVIC_DisableIRQ(EXTI0_IRQn);
+		sentence = sentenceQueue_pop();
+		NVIC_EnableIRQ(EXTI0_IRQn);
+		
+		if (sentence != NULL)
+		{
+			processSentence(sentence);
+			sentenceQueue_release(sentence);
+		}
+		
+		// The other tasks run every MAIN_LOOP_PERIOD (systick is 10us)
+		if (sysTickTime - lastPeriod < MAIN_LOOP_PERIOD * 100) {
+			continue;
+		}
+		lastPeriod = sysTickTime;
+		
+		// Run the commands received from the computer, then apply their
+		// changes: the interrupt switches to the new configuration at once
+		changes = command_poll(decoders, NUM_DECODERS);
+		if (changes & COMMAND_RELOAD) {
+			loadProtocols();
+		}
+		if (changes != 0) {
+			captureConfig_rebuild(decoders, NUM_DECODERS);
+		}
+		
+		if (++loops == HEARTBEAT_PERIODS)
+		{
+			loops = 0;
+			TM_DISCO_LedToggle(LED_HEARTBEAT);
+			
+			// Send the repeat count of the lines which are no longer repeated
+			output_flush();
+			reportOverloads();
+		}
 	}
 }
 
@@ -13,6 +13,8 @@
 #include "decoder.h"
 #include "tm_stm32f4_disco.h"
 #include "tm_stm32f4_usart.h"
+#include "output.h"
+#include "uart_tx.h"
 
 /* Exported constants --------------------------------------------------------*/
 
@@ -56,26 +58,15 @@ extern uint16_t		UartBufSz;
 #ifdef DEBUG
 	#define DEBUG_PRINTF(...) \
 		UartBufSz = snprintf(UartBuffer, BUFFER_LEN, "# " __VA_ARGS__); \
-		TM_DISCO_LedOn(LED_UART); \
-		TM_USART_Puts(COMPUTER_UART, UartBuffer); \
-		TM_DISCO_LedOff(LED_UART);
+		uartTx_write(UartBuffer, UartBufSz < BUFFER_LEN ? UartBufSz : BUFFER_LEN - 1);
 #else
 	#define DEBUG_PRINTF(...)
 #endif
 
-#ifdef USE_ESP8266
-	#define PRINTF(...) \
-		UartBufSz = snprintf(UartBuffer, BUFFER_LEN, __VA_ARGS__); \
-		TM_DISCO_LedOn(LED_WIFI); \
-		esp8266_syslog(UartBuffer); \
-		TM_DISCO_LedOff(LED_WIFI);
-#else
-	#define PRINTF(...) \
-		UartBufSz = snprintf(UartBuffer, BUFFER_LEN, __VA_ARGS__); \
-		TM_DISCO_LedOn(LED_UART); \
-		TM_USART_Puts(COMPUTER_UART, UartBuffer); \
-		TM_DISCO_LedOff(LED_UART);
-#endif
+// Decoded data goes through the output module (see output.h)
+#define PRINTF(...) \
+	UartBufSz = snprintf(UartBuffer, BUFFER_LEN, __VA_ARGS__); \
+	output_send(UartBuffer);
 
 
 /* Exported functions ------------------------------------------------------- */
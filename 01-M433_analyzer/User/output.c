@@ -0,0 +1,240 @@
+#include <string.h>
+#include <stdio.h>
+#include "main.h"
+#include "output.h"
+#include "esp8266.h"
+
+// OUTPUT_DEDUPE_WINDOW in systick units (10s)
+#define WINDOW_TICKS		(OUTPUT_DEDUPE_WINDOW * 100)
+
+#ifdef OUTPUT_PORTABLE
+#define LED_ON(led)
+#define LED_OFF(led)
+#else
+#define LED_ON(led)			TM_DISCO_LedOn(led)
+#define LED_OFF(led)		TM_DISCO_LedOff(led)
+#endif
+
+// FNV-1a parameters
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME			16777619u
+
+
+//! Recently sent line
+typedef struct {
+	uint32_t	hash;								// Hash of the line (decoder name + payload)
+	uint32_t	lastSeen;							// sysTickTime of the last occurrence
+	uint16_t	repeats;							// Occurrences which were not sent
+	char		line[OUTPUT_DEDUPE_LINE_LEN + 1];	// Line sent, without its '\n'
+} dedupeEntry_t;
+
+static dedupeEntry_t	dedupe[OUTPUT_DEDUPE_SIZE];
+
+//! Set when the last message sent ended a line
+static uint8_t			atLineStart = 1;
+
+//! Buffer used to build the repeat records
+static char				repeatBuffer[BUFFER_LEN];
+
+//! Buffer used to send a line again
+static char				replayBuffer[OUTPUT_DEDUPE_LINE_LEN + 2];
+
+//! Line sent since output_mark(): 0 if none, OUTPUT_LINES_MIXED if not a single one
+static uint32_t			markedLine = 0;
+static uint16_t			markedCount = 0;
+static uint8_t			markedNew = 0;		// Set if it was not only counted as a repeat
+
+uint32_t				outputSuppressed = 0;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Send a message to the selected output module
+ */
+static void output_write(char *message)
+{
+#ifdef USE_ESP8266
+	LED_ON(LED_WIFI);
+	esp8266_syslog(message);
+	LED_OFF(LED_WIFI);
+#else
+	LED_ON(LED_UART);
+	uartTx_write(message, strlen(message));
+	LED_OFF(LED_UART);
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Send the repeat record of an entry, if it was repeated, and free it
+ */
+static void dedupe_release(dedupeEntry_t *entry)
+{
+	if (entry->repeats > 0)
+	{
+		snprintf(repeatBuffer, BUFFER_LEN, "Repeated,Count=%d,%s\n", entry->repeats, entry->line);
+		output_write(repeatBuffer);
+	}
+	
+	entry->hash		= 0;
+	entry->repeats	= 0;
+	entry->line[0]	= '\0';
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Check if a line was recently sent
+ * @param len Length of the line, without its '\n'
+ * @return 1 if the line must not be sent
+ */
+static uint8_t dedupe_check(const char *line, uint16_t len)
+{
+	uint16_t		i;
+	uint32_t		hash = FNV_OFFSET_BASIS,
+					now = sysTickTime;
+	dedupeEntry_t	*entry, *victim = &dedupe[0];
+	
+	
+	for (i = 0; i < len; i++)
+	{
+		hash ^= (uint8_t)line[i];
+		hash *= FNV_PRIME;
+	}
+	markedLine = (markedLine == 0 || markedLine == hash ? hash : OUTPUT_LINES_MIXED);
+	markedCount++;
+	
+	for (i = 0; i < OUTPUT_DEDUPE_SIZE; i++)
+	{
+		entry = &dedupe[i];
+		if (entry->line[0] != '\0' && entry->hash == hash &&
+			strncmp(entry->line, line, len) == 0 && entry->line[len] == '\0')
+		{
+			if (now - entry->lastSeen < WINDOW_TICKS)
+			{
+				entry->lastSeen = now;
+				entry->repeats++;
+				outputSuppressed++;
+				return 1;
+			}
+			victim = entry;
+			break;
+		}
+		
+		if (now - entry->lastSeen > now - victim->lastSeen) {
+			victim = entry;
+		}
+	}
+	
+	// Recycle the matching or the oldest entry
+	markedNew = 1;
+	dedupe_release(victim);
+	victim->hash		= hash;
+	victim->lastSeen	= now;
+	memcpy(victim->line, line, len);
+	victim->line[len]	= '\0';
+	return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Send a message (see PRINTF), unless it is a repeat of a recent line
+ */
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	uint8_t		isLine;
+	
+	
+	if (len == 0) {
+		return;
+	}
+	
+	// Only single complete lines are deduplicated
+	isLine = atLineStart && message[len-1] == '\n' && len - 1 <= OUTPUT_DEDUPE_LINE_LEN &&
+			 memchr(message, '\n', len-1) == NULL;
+	atLineStart = (message[len-1] == '\n');
+	
+	if (!isLine) {
+		markedLine = OUTPUT_LINES_MIXED;
+	}
+	else if (dedupe_check(message, len-1)) {
+		return;
+	}
+	
+	output_write(message);
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Send the repeat records of the lines which are no longer repeated
+ * @remark Must be called periodically from the main loop
+ */
+void output_flush(void)
+{
+	uint8_t		i;
+	
+	
+	for (i = 0; i < OUTPUT_DEDUPE_SIZE; i++)
+	{
+		if (dedupe[i].repeats > 0 && sysTickTime - dedupe[i].lastSeen >= WINDOW_TICKS && atLineStart) {
+			dedupe_release(&dedupe[i]);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Start watching the lines sent (see output_lastLine())
+ */
+void output_mark(void)
+{
+	markedLine	= 0;
+	markedCount	= 0;
+	markedNew	= 0;
+}
+
+/*!
+ * @brief Get the line sent since output_mark()
+ * @param[out] count Number of times it was sent
+ * @return Its hash, 0 if nothing was sent, OUTPUT_LINES_MIXED if several
+ * different lines or other messages were sent, OUTPUT_LINE_NEW if the line
+ * was not only counted as a repeat of a recent one
+ */
+uint32_t output_lastLine(uint16_t *count)
+{
+	*count = markedCount;
+	if (markedNew && markedLine != 0 && markedLine != OUTPUT_LINES_MIXED) {
+		return OUTPUT_LINE_NEW;
+	}
+	return markedLine;
+}
+
+/*!
+ * @brief Send a line again, as if it had been produced again
+ * @param line Hash of the line (see output_lastLine())
+ * @param count Number of times to send it
+ * @return 1 if the line was sent or counted as a repeat, 0 if it is no longer known
+ */
+uint8_t output_repeat(uint32_t line, uint16_t count)
+{
+	uint8_t		i;
+	uint16_t	len;
+	
+	
+	for (i = 0; i < OUTPUT_DEDUPE_SIZE; i++)
+	{
+		if (dedupe[i].line[0] != '\0' && dedupe[i].hash == line)
+		{
+			len = strlen(dedupe[i].line);
+			memcpy(replayBuffer, dedupe[i].line, len);
+			replayBuffer[len]		= '\n';
+			replayBuffer[len + 1]	= '\0';
+			while (count-- > 0) {
+				output_send(replayBuffer);
+			}
+			return 1;
+		}
+	}
+	
+	return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/**
+  ******************************************************************************
+  * @file    output.h 
+  * @brief   Output path of the decoded sentences (computer UART or ESP8266)
+  */
+
+#include "stm32f4xx.h"
+
+/*
+ * Identical lines are not sent again and again while a transmitter repeats its
+ * frames: a line already sent less than OUTPUT_DEDUPE_WINDOW ms ago is only
+ * counted. When the repeats stop, a single "Repeated,Count=<n>,<line>" record
+ * is sent.
+ *
+ * Only complete lines (starting a new line, ending with a single '\n' and not
+ * longer than OUTPUT_DEDUPE_LINE_LEN) are deduplicated. Other messages, such
+ * as the pieces of a raw dump, are always sent.
+ *
+ * The lines are identified by their hash: output_lastLine() gives the line
+ * sent since output_mark() and how many times it was sent, which
+ * output_repeat() does again (see frame_cache.h). Define OUTPUT_PORTABLE to run the module on another target
+ * (no LED).
+ */
+
+//! output_lastLine(): something else than a single line was sent
+#define OUTPUT_LINES_MIXED		0xFFFFFFFF
+
+//! output_lastLine(): the line was sent, not only counted as a repeat
+#define OUTPUT_LINE_NEW			0xFFFFFFFE
+
+//! Total number of lines which were not sent
+extern uint32_t outputSuppressed;
+
+void		output_send(char *message);
+void		output_flush(void);
+void		output_mark(void);
+uint32_t	output_lastLine(uint16_t *count);
+uint8_t		output_repeat(uint32_t line, uint16_t count);
+
+#endif // OUTPUT_H
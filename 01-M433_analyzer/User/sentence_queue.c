@@ -0,0 +1,158 @@
+#include "sentence_queue.h"
+#include "defines.h"
+
+// Slots: the queued sentences, plus the one being recorded and the one being decoded
+#define NB_SLOTS			(SENTENCE_QUEUE_SIZE + 2)
+
+// Slot states
+#define SLOT_FREE			0
+#define SLOT_RECORDING		1
+#define SLOT_QUEUED			2
+#define SLOT_DECODING		3
+
+// A candidate decoder outweighs any number of pulses
+#define SCORE_CANDIDATES	0x8000
+
+// Penalty of each joker used by the recording
+#define SCORE_JOKER			64
+
+// a is a better sentence than b
+#define IS_BETTER(a, b)		((a)->score > (b)->score || ((a)->score == (b)->score && (int32_t)((b)->seq - (a)->seq) > 0))
+
+STATIC_ASSERT(MAX_NUM_PULSES < SCORE_CANDIDATES);
+
+
+static sentence_t			slots[NB_SLOTS];
+static uint8_t				depth;
+static uint32_t				seq;
+
+sentenceQueueStats_t		sentenceQueueStats;
+
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Score a sentence when its recording ends (the higher, the sooner decoded)
+ * @param[in]	candidates	Decoders which may match the sentence
+ * @param[in]	nbJokers	Number of out of filter pulses recorded
+ */
+uint16_t sentenceQueue_score(uint16_t nbPulses, decoderMask_t candidates, uint8_t nbJokers)
+{
+	uint16_t	penalty = (uint16_t)nbJokers * SCORE_JOKER;
+	
+	
+	if (nbPulses > MAX_NUM_PULSES) {
+		nbPulses = MAX_NUM_PULSES;
+	}
+	return (candidates != 0 ? SCORE_CANDIDATES : 0) + (nbPulses > penalty ? nbPulses - penalty : 0);
+}
+
+/*!
+ * @brief Empty the queue
+ * @return The slot to record the first sentence into
+ */
+sentence_t *sentenceQueue_init(void)
+{
+	uint8_t	i;
+	
+	
+	for (i = 0; i < NB_SLOTS; i++) {
+		slots[i].state = SLOT_FREE;
+	}
+	depth = 0;
+	
+	slots[0].state = SLOT_RECORDING;
+	return &slots[0];
+}
+
+/*!
+ * @brief Queue a recorded sentence (its nbPulses, score and candidates are set)
+ *
+ * If the queue is full, the worst of the queued sentences and this one is shed.
+ *
+ * @return The slot to record the next sentence into
+ * @remark Called from the receiver interrupt
+ */
+sentence_t *sentenceQueue_push(sentence_t *recorded)
+{
+	sentence_t	*worst = recorded;
+	uint8_t		i;
+	
+	
+	recorded->seq = seq++;
+	
+	if (depth == SENTENCE_QUEUE_SIZE)
+	{
+		for (i = 0; i < NB_SLOTS; i++)
+		{
+			if (slots[i].state == SLOT_QUEUED && IS_BETTER(worst, &slots[i])) {
+				worst = &slots[i];
+			}
+		}
+		sentenceQueueStats.shed++;
+		if (worst->candidates == 0) {
+			sentenceQueueStats.shedNoise++;
+		}
+	
+		if (worst == recorded)
+		{
+			// Record the next sentence over this one
+			recorded->state = SLOT_RECORDING;
+			return recorded;
+		}
+		worst->state = SLOT_FREE;
+		depth--;
+	}
+	
+	recorded->state = SLOT_QUEUED;
+	sentenceQueueStats.queued++;
+	if (++depth > sentenceQueueStats.maxDepth) {
+		sentenceQueueStats.maxDepth = depth;
+	}
+	
+	// There is always a free slot left
+	for (i = 0; slots[i].state != SLOT_FREE; i++);
+	slots[i].state = SLOT_RECORDING;
+	return &slots[i];
+}
+
+/*!
+ * @brief Take the best queued sentence, to decode it
+ * @return The sentence, to be released after decoding, or NULL if the queue is empty
+ * @remark The receiver interrupt must not be running
+ */
+sentence_t *sentenceQueue_pop(void)
+{
+	sentence_t	*best = NULL;
+	uint8_t		i;
+	
+	
+	for (i = 0; i < NB_SLOTS; i++)
+	{
+		if (slots[i].state == SLOT_QUEUED && (best == NULL || IS_BETTER(&slots[i], best))) {
+			best = &slots[i];
+		}
+	}
+	
+	if (best != NULL)
+	{
+		best->state = SLOT_DECODING;
+		depth--;
+	}
+	return best;
+}
+
+/*!
+ * @brief Give back the slot of a decoded sentence
+ */
+void sentenceQueue_release(sentence_t *sentence)
+{
+	sentence->state = SLOT_FREE;
+}
+
+/*!
+ * @brief Number of queued sentences
+ */
+uint8_t sentenceQueue_depth(void)
+{
+	return depth;
+}
@@ -0,0 +1,51 @@
+#ifndef SENTENCE_QUEUE_H
+#define SENTENCE_QUEUE_H
+
+#include "main.h"
+
+/*
+ * Sentences are recorded by the receiver interrupt and decoded by the main
+ * loop. In between, they wait in a bounded priority queue of
+ * SENTENCE_QUEUE_SIZE sentences.
+ *
+ * Each sentence is scored when its recording ends, from what the interrupt
+ * already knows: whether some decoder may match it (candidate mask), its
+ * number of pulses, and how many jokers it used (noise). The main loop decodes
+ * the best sentence first. When the traffic outpaces the decoders and the
+ * queue is full, the worst sentence is shed: the likely noise goes first.
+ *
+ * Sentences are recorded in place: the interrupt records into a free slot,
+ * which is queued as is, and gets another free slot for the next recording.
+ */
+
+//! Sentence slot
+typedef struct {
+	uint16_t		pulseLens[MAX_NUM_PULSES];	// The first pulse is always a HIGH pulse
+	uint16_t		nbPulses;
+	uint16_t		score;
+	decoderMask_t	candidates;					// Decoders which may match the sentence
+	decoderMask_t	streamed;					// Streaming decoders which already reported it
+	uint32_t		seq;						// Push order, to decode equal scores in order
+	uint8_t			state;
+} sentence_t;
+
+//! Queue counters
+typedef struct {
+	uint32_t	queued;
+	uint32_t	shed;			// Sentences dropped because the queue was full
+	uint32_t	shedNoise;		// ... among them, sentences without a candidate decoder
+	uint16_t	maxDepth;		// Highest number of queued sentences
+} sentenceQueueStats_t;
+
+extern sentenceQueueStats_t	sentenceQueueStats;
+
+
+uint16_t	sentenceQueue_score(uint16_t nbPulses, decoderMask_t candidates, uint8_t nbJokers);
+sentence_t	*sentenceQueue_init(void);
+sentence_t	*sentenceQueue_push(sentence_t *recorded);
+sentence_t	*sentenceQueue_pop(void);
+void		sentenceQueue_release(sentence_t *sentence);
+uint8_t		sentenceQueue_depth(void);
+
+
+#endif // SENTENCE_QUEUE_H
@@ -0,0 +1,234 @@
+#include <string.h>
+#include "main.h"
+#include "uart_tx.h"
+
+// Free bytes: one byte always stays empty (head == tail means empty), and one
+// is kept to close a line when a message is dropped
+#define RING_FREE()			((uint16_t)((tail - head - 1 + UART_TX_RING_SIZE) % UART_TX_RING_SIZE))
+#define RING_ROOM()			(RING_FREE() > 0 ? RING_FREE() - 1 : 0)
+
+#ifdef UART_TX_PORTABLE
+#define DMA_START(data, len)	uartTx_fakeDmaStart(data, len)
+#define DMA_IRQ_DISABLE()
+#define DMA_IRQ_ENABLE()
+#define IN_INTERRUPT()			0
+#define MEMORY_BARRIER()		__sync_synchronize()
+#else
+#define DMA_START(data, len)	uartTx_dmaStart(data, len)
+#define DMA_IRQ_DISABLE()		NVIC_DisableIRQ(COMPUTER_UART_DMA_IRQ)
+#define DMA_IRQ_ENABLE()		NVIC_EnableIRQ(COMPUTER_UART_DMA_IRQ)
+#define IN_INTERRUPT()			(__get_IPSR() != 0)
+#define MEMORY_BARRIER()		__DMB()
+#endif
+
+STATIC_ASSERT(UART_TX_RING_SIZE > 2 && UART_TX_RING_SIZE <= 0x8000);
+
+
+static char					ring[UART_TX_RING_SIZE];
+
+//! Next byte written by uartTx_write(), next byte sent by the DMA
+static volatile uint16_t	head = 0, tail = 0;
+
+//! Length of the transfer in progress, 0 if the DMA is idle
+static volatile uint16_t	sending = 0;
+
+//! Set while the last queued byte doesn't end a line
+static uint8_t				lineOpen = 0;
+
+//! Set while the rest of a dropped line is dropped
+static uint8_t				dropping = 0;
+
+//! Called when a transfer completed, NULL if none
+static volatile uartTxCompleteFunc_t	completeFunc = NULL;
+
+uartTxStats_t				uartTxStats;
+
+
+/*----------------------------------------------------------------------------*/
+#ifndef UART_TX_PORTABLE
+/*!
+ * @brief Start a DMA transfer to the computer UART
+ */
+static void uartTx_dmaStart(const char *data, uint16_t len)
+{
+	DMA_ClearFlag(COMPUTER_UART_DMA_STREAM, COMPUTER_UART_DMA_FLAGS);
+	COMPUTER_UART_DMA_STREAM->M0AR	= (uint32_t)data;
+	COMPUTER_UART_DMA_STREAM->NDTR	= len;
+	DMA_Cmd(COMPUTER_UART_DMA_STREAM, ENABLE);
+}
+
+/*!
+ * @brief DMA interrupt: a transfer completed
+ */
+void COMPUTER_UART_DMA_HANDLER(void)
+{
+	if (DMA_GetITStatus(COMPUTER_UART_DMA_STREAM, COMPUTER_UART_DMA_TC) != RESET)
+	{
+		DMA_ClearITPendingBit(COMPUTER_UART_DMA_STREAM, COMPUTER_UART_DMA_TC);
+		uartTx_complete();
+	}
+}
+#endif
+
+/*!
+ * @brief Start sending the queued bytes, if the DMA is idle
+ * @remark The DMA interrupt must not be running
+ */
+static void uartTx_kick(void)
+{
+	uint16_t	len;
+	
+	
+	if (sending != 0 || head == tail) {
+		return;
+	}
+	
+	// Up to the end of the ring: the rest goes with the next transfer
+	len = (head > tail ? head - tail : UART_TX_RING_SIZE - tail);
+	sending = len;
+	DMA_START(&ring[tail], len);
+}
+
+/*!
+ * @brief Copy bytes into the ring
+ * @remark The caller checked there is enough room
+ */
+static void uartTx_copy(const char *data, uint16_t len)
+{
+	uint16_t	first = UART_TX_RING_SIZE - head;
+	uint16_t	used;
+	
+	
+	if (first > len) {
+		first = len;
+	}
+	memcpy(&ring[head], data, first);
+	memcpy(&ring[0], data + first, len - first);
+	
+	// The bytes must be in memory before the DMA may see them
+	MEMORY_BARRIER();
+	head = (head + len) % UART_TX_RING_SIZE;
+	
+	used = UART_TX_RING_SIZE - 1 - RING_FREE();
+	if (used > uartTxStats.maxUsed) {
+		uartTxStats.maxUsed = used;
+	}
+	lineOpen = (data[len - 1] != '\n');
+}
+
+/*----------------------------------------------------------------------------*/
+/*!
+ * @brief Enable the DMA of the computer UART TX
+ * @remark The computer UART must be initialized (TM_USART_Init())
+ */
+void uartTx_init(void)
+{
+#ifndef UART_TX_PORTABLE
+	DMA_InitTypeDef		DMA_InitStruct;
+	NVIC_InitTypeDef	NVIC_InitStruct;
+	
+	
+	RCC_AHB1PeriphClockCmd(COMPUTER_UART_DMA_CLOCK, ENABLE);
+	DMA_DeInit(COMPUTER_UART_DMA_STREAM);
+	
+	DMA_StructInit(&DMA_InitStruct);
+	DMA_InitStruct.DMA_Channel				= COMPUTER_UART_DMA_CHANNEL;
+	DMA_InitStruct.DMA_PeripheralBaseAddr	= (uint32_t)&COMPUTER_UART->DR;
+	DMA_InitStruct.DMA_Memory0BaseAddr		= (uint32_t)ring;
+	DMA_InitStruct.DMA_DIR					= DMA_DIR_MemoryToPeripheral;
+	DMA_InitStruct.DMA_BufferSize			= 1;
+	DMA_InitStruct.DMA_MemoryInc			= DMA_MemoryInc_Enable;
+	DMA_Init(COMPUTER_UART_DMA_STREAM, &DMA_InitStruct);
+	DMA_ITConfig(COMPUTER_UART_DMA_STREAM, DMA_IT_TC, ENABLE);
+	
+	NVIC_InitStruct.NVIC_IRQChannel						= COMPUTER_UART_DMA_IRQ;
+	NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority	= UART_TX_NVIC_PRIORITY;
+	NVIC_InitStruct.NVIC_IRQChannelSubPriority			= 0;
+	NVIC_InitStruct.NVIC_IRQChannelCmd					= ENABLE;
+	NVIC_Init(&NVIC_InitStruct);
+	
+	USART_DMACmd(COMPUTER_UART, USART_DMAReq_Tx, ENABLE);
+#endif
+	
+	head = tail = sending = 0;
+	lineOpen = dropping = 0;
+}
+
+/*!
+ * @brief Queue a message, without waiting for it to be sent
+ * @return 1 if the message was queued, 0 if it was dropped
+ * @remark Not reentrant: only called from the main loop (see PRINTF)
+ */
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	uint8_t	queued = 0;
+	
+	
+	if (len == 0) {
+		return 1;
+	}
+	
+#ifdef UART_TX_OVERFLOW_WAIT
+	// Wait for the DMA to make room, unless the message can never fit
+	while (!dropping && len > RING_ROOM() && len <= UART_TX_RING_SIZE - 2 && !IN_INTERRUPT())
+	{
+#ifdef UART_TX_PORTABLE
+		uartTx_fakeDmaWait();
+#endif
+	}
+#endif
+	
+	if (!dropping && len <= RING_ROOM())
+	{
+		uartTx_copy(message, len);
+		uartTxStats.messages++;
+		uartTxStats.bytes += len;
+		queued = 1;
+	}
+	else
+	{
+		// Drop the message and the rest of its line, but close the line
+		// already started (there is always room left for that)
+		if (lineOpen) {
+			uartTx_copy("\n", 1);
+		}
+		dropping = (message[len - 1] != '\n');
+		uartTxStats.dropped++;
+		uartTxStats.droppedBytes += len;
+	}
+	
+	DMA_IRQ_DISABLE();
+	uartTx_kick();
+	DMA_IRQ_ENABLE();
+	
+	return queued;
+}
+
+/*!
+ * @brief A DMA transfer completed: release its bytes, and start the next one
+ * @remark Called from the DMA interrupt
+ */
+void uartTx_complete(void)
+{
+	uint16_t				len = sending;
+	uartTxCompleteFunc_t	complete = completeFunc;
+	
+	
+	tail = (tail + len) % UART_TX_RING_SIZE;
+	sending = 0;
+	uartTxStats.transfers++;
+	
+	uartTx_kick();
+	if (complete != NULL) {
+		complete(len);
+	}
+}
+
+/*!
+ * @brief Register the function called when a transfer completed
+ * @param complete The function, or NULL for none
+ */
+void uartTx_setCompleteFunc(uartTxCompleteFunc_t complete)
+{
+	completeFunc = complete;
+}
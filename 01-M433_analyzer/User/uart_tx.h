@@ -0,0 +1,64 @@
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include "stm32f4xx.h"
+
+/*
+ * Non-blocking transmission on the computer UART.
+ *
+ * TM_USART_Puts() waits for each character: at 57600 baud, a raw dump keeps
+ * the main loop busy for seconds. uartTx_write() copies the message into a ring
+ * of UART_TX_RING_SIZE bytes instead, and returns at once. The USART TX DMA
+ * stream drains the ring in the background: when a transfer completes, its
+ * interrupt releases the bytes sent (uartTx_complete()) and starts the next
+ * transfer, the longest contiguous run of queued bytes.
+ *
+ * Overflow: a message which doesn't fit in the ring is dropped whole, and
+ * counted. The rest of its line is dropped too, and a line left open is closed
+ * by a '\n', so that the computer never gets two lines mixed. With
+ * UART_TX_OVERFLOW_WAIT defined, the main loop waits for room instead (an
+ * interrupt never waits).
+ *
+ * A completion function may be registered (uartTx_setCompleteFunc()): it is
+ * called from the DMA interrupt after each transfer, once its bytes are
+ * released, with their number. It must not queue messages: uartTx_write() is
+ * only called from the main loop.
+ *
+ * Define UART_TX_PORTABLE to run the ring on another target: the DMA engine is
+ * then provided by the caller (uartTx_fakeDmaStart() is called to start a
+ * transfer, which the caller ends with uartTx_complete()).
+ */
+
+//! Interrupt priority of the DMA completion: below the receiver interrupt
+#ifndef UART_TX_NVIC_PRIORITY
+#define UART_TX_NVIC_PRIORITY		0x0C
+#endif
+
+//! Transmission counters
+typedef struct {
+	uint32_t	messages;		// Messages queued
+	uint32_t	bytes;			// Bytes queued
+	uint32_t	dropped;		// Messages dropped: the ring was full
+	uint32_t	droppedBytes;
+	uint32_t	transfers;		// DMA transfers completed
+	uint16_t	maxUsed;		// Highest number of queued bytes
+} uartTxStats_t;
+
+extern uartTxStats_t	uartTxStats;
+
+//! Called from the DMA interrupt when a transfer completed, with the number of bytes it sent
+typedef void (*uartTxCompleteFunc_t)(uint16_t len);
+
+#ifdef UART_TX_PORTABLE
+void	uartTx_fakeDmaStart(const char *data, uint16_t len);
+void	uartTx_fakeDmaWait(void);
+#endif
+
+
+void	uartTx_init(void);
+uint8_t	uartTx_write(const char *message, uint16_t len);
+void	uartTx_complete(void);
+void	uartTx_setCompleteFunc(uartTxCompleteFunc_t complete);
+
+
+#endif // UART_TX_H
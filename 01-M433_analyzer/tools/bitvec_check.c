@@ -0,0 +1,281 @@
+/*******************************************************************************
+ * BIT ACCUMULATOR CHECK                                                       *
+ *******************************************************************************
+ * Host tool: checks the bit accumulator (see User/decoders/bitvec.h) against a
+ * plain array of bits, and times it against the byte array code it replaced.
+ *
+ * Random frames of 0 to BITVEC_MAX_BITS bits are built with bitvec_append()
+ * and bitvec_appendBits(), mixed at random, and finished. Every field which
+ * fits in the frame (and the spare word after it) is then read, MSB first and
+ * LSB first, and compared with the reference: the bits past the end of the
+ * frame must read as 0. bitvec_flip() and the bit, nibble and byte macros are
+ * checked on the same frames, and bitvec_reverse() on random words.
+ *
+ * The benchmark appends the same random bits one by one to a bit vector, and
+ * to a byte array the way the decoders did it before (see git history of
+ * oregon_ew91.c), then reads the bytes of the frame.
+ *
+ * Build (from 01-M433_analyzer; bitvec.h is self-contained, no decoder needed):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o bitvec_check tools/bitvec_check.c
+ * Usage:	bitvec_check [-n <frames>] [-s <seed>]
+ *
+ * Exits with 1 if any read differs from the reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "bitvec.h"
+
+#define NB_TIMED_FRAMES		100000
+#define TIMED_FRAME_BITS	64
+#define TIMED_FRAME_BYTES	(TIMED_FRAME_BITS / 8)
+
+//! Reference: one byte per bit, and the spare word
+static uint8_t		reference[BITVEC_MAX_BITS + 32];
+static bitvec_t		vector;
+
+static uint32_t		nbErrors = 0;
+static uint64_t		nbChecks = 0;
+
+//! Random bits of the timed frames, and the result of the reads (not to be optimized out)
+static uint8_t				timedBits[NB_TIMED_FRAMES][TIMED_FRAME_BITS];
+static volatile uint32_t	timingSink;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void check(uint32_t got, uint32_t expected, const char *what, uint16_t nbBits, uint16_t offset, uint8_t len)
+{
+	nbChecks++;
+	if (got != expected && nbErrors++ < 10)
+	{
+		printf("%s (%d bits, offset %d, len %d): 0x%08lX, expected 0x%08lX\n", what, nbBits, offset, len,
+			(unsigned long)got, (unsigned long)expected);
+	}
+}
+
+/*!
+ * @brief Field of the reference, MSB first or LSB first
+ */
+static uint32_t referenceField(uint16_t offset, uint8_t len, uint8_t lsbFirst)
+{
+	uint32_t	value = 0;
+	uint8_t		i;
+	
+	
+	for (i = 0; i < len; i++)
+	{
+		if (lsbFirst) {
+			value |= (uint32_t)reference[offset + i] << i;
+		} else {
+			value = (value << 1) | reference[offset + i];
+		}
+	}
+	return value;
+}
+
+/*!
+ * @brief Build a random frame in the vector and the reference
+ */
+static uint16_t buildFrame(void)
+{
+	uint16_t	nbBits = rand() % (BITVEC_MAX_BITS + 1), n = 0, i;
+	uint32_t	value;
+	uint8_t		len;
+	
+	
+	memset(reference, 0, sizeof(reference));
+	bitvec_reset(&vector);
+	
+	// Dirty words: the bits past the end must be cleared by bitvec_finish()
+	memset(vector.words, 0xA5, sizeof(vector.words));
+	
+	while (n < nbBits)
+	{
+		if (rand() & 1)
+		{
+			reference[n++] = rand() & 1;
+			bitvec_append(&vector, reference[n - 1]);
+			continue;
+		}
+		len = 1 + rand() % 32;
+		if (len > nbBits - n) {
+			len = nbBits - n;
+		}
+		value = random32();
+		bitvec_appendBits(&vector, value, len);
+		for (i = 0; i < len; i++) {
+			reference[n++] = (value >> (len - 1 - i)) & 1;
+		}
+	}
+	bitvec_finish(&vector);
+	
+	return nbBits;
+}
+
+static void checkFrame(void)
+{
+	uint16_t	nbBits = buildFrame(), offset, i;
+	uint8_t		len;
+	
+	
+	check(vector.nbBits, nbBits, "nbBits", nbBits, 0, 0);
+	check(bitvec_full(&vector), nbBits >= BITVEC_MAX_BITS, "bitvec_full", nbBits, 0, 0);
+	
+	for (offset = 0; offset < BITVEC_MAX_BITS; offset++)
+	{
+		for (len = 1; len <= 32; len++)
+		{
+			check(bitvec_field(&vector, offset, len), referenceField(offset, len, 0), "bitvec_field", nbBits, offset, len);
+			check(bitvec_fieldLsb(&vector, offset, len), referenceField(offset, len, 1), "bitvec_fieldLsb", nbBits, offset, len);
+		}
+		check(bitvec_bit(&vector, offset), reference[offset], "bitvec_bit", nbBits, offset, 1);
+		if (offset < BITVEC_MAX_BITS / 4) {
+			check(bitvec_nibble(&vector, offset), referenceField(4 * offset, 4, 0), "bitvec_nibble", nbBits, 4 * offset, 4);
+		}
+		if (offset < BITVEC_MAX_BITS / 8) {
+			check(bitvec_byte(&vector, offset), referenceField(8 * offset, 8, 0), "bitvec_byte", nbBits, 8 * offset, 8);
+		}
+	}
+	
+	// Flips, read back
+	for (i = 0; i < 8; i++)
+	{
+		offset = rand() % BITVEC_MAX_BITS;
+		bitvec_flip(&vector, offset);
+		reference[offset] ^= 1;
+		check(bitvec_field(&vector, offset - offset % 32, 32), referenceField(offset - offset % 32, 32, 0), "bitvec_flip", nbBits, offset, 1);
+	}
+}
+
+/*!
+ * @brief Reference bit reversal
+ */
+static uint32_t reverseBits(uint32_t x)
+{
+	uint32_t	y = 0;
+	uint8_t		i;
+	
+	
+	for (i = 0; i < 32; i++) {
+		y |= ((x >> i) & 1) << (31 - i);
+	}
+	return y;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t		nbFrames = 20000, n, x, sum = 0;
+	uint16_t		i, dataByteOffset;
+	uint8_t			rawData[TIMED_FRAME_BYTES], dataByte, dataBitOffset;
+	unsigned int	seed = 1;
+	double			t0, t1, t2;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	for (n = 0; n < nbFrames; n++) {
+		checkFrame();
+	}
+	for (n = 0; n < 1000000; n++)
+	{
+		x = random32();
+		check(bitvec_reverse(x), reverseBits(x), "bitvec_reverse", 32, 0, 32);
+	}
+	printf("Frames: %lu, %llu checks\n", (unsigned long)nbFrames, (unsigned long long)nbChecks);
+	
+	// Timings: the same bits, then the same bytes read
+	for (n = 0; n < NB_TIMED_FRAMES; n++)
+	{
+		for (i = 0; i < TIMED_FRAME_BITS; i++) {
+			timedBits[n][i] = rand() & 1;
+		}
+	}
+	t0 = now();
+	for (n = 0; n < NB_TIMED_FRAMES; n++)
+	{
+		bitvec_reset(&vector);
+		for (i = 0; i < TIMED_FRAME_BITS; i++) {
+			bitvec_append(&vector, timedBits[n][i]);
+		}
+		bitvec_finish(&vector);
+		for (i = 0; i < TIMED_FRAME_BYTES; i++) {
+			sum += bitvec_byte(&vector, i);
+		}
+	}
+	t1 = now();
+	for (n = 0; n < NB_TIMED_FRAMES; n++)
+	{
+		dataByte = 0;
+		dataByteOffset = 0;
+		dataBitOffset = 8;
+		for (i = 0; i < TIMED_FRAME_BITS; i++)
+		{
+			if (timedBits[n][i] == 0) {
+				dataBitOffset--;
+			} else {
+				dataByte |= (1 << --dataBitOffset);
+			}
+	
+			// If this byte is complete, switch to the next one
+			if (!dataBitOffset)
+			{
+				rawData[dataByteOffset++] = dataByte;
+				dataBitOffset = 8;
+				dataByte = 0;
+			}
+		}
+		for (i = 0; i < TIMED_FRAME_BYTES; i++) {
+			sum += rawData[i];
+		}
+	}
+	t2 = now();
+	timingSink = sum;
+	printf("Host time:  %.2f ns/bit bit vector, %.2f ns/bit byte array (%d-bit frames, bytes read)\n",
+		(t1 - t0) / ((double)NB_TIMED_FRAMES * TIMED_FRAME_BITS), (t2 - t1) / ((double)NB_TIMED_FRAMES * TIMED_FRAME_BITS),
+		TIMED_FRAME_BITS);
+	
+	if (nbErrors > 0)
+	{
+		printf("%lu reads differ\n", (unsigned long)nbErrors);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * CYCLE BUDGET CHECK                                                          *
+ *******************************************************************************
+ * Host tool: checks the metering of the decoder calls (see
+ * User/decoders/budget.h) with the fake cycle counter of BUDGET_PORTABLE, and
+ * its effect on the frame cache (see User/frame_cache.h).
+ *
+ * The decoders are replaced by calls which advance budgetFakeCycles by STEP
+ * cycles at a time, checking budget_expired() between two steps or not. The
+ * sentences run as processSentence() (User/main.c) does: the calls on the
+ * sentence, then the frame cache only stores the result when the decoding was
+ * complete. Checked:
+ * 	- no call metered:	budget_expired() stays 0,
+ * 	- short calls:		neither counted as overruns nor aborted, the result is
+ * 						cached and the repeat of the sentence reused,
+ * 	- looping call:		stopped at its first check past BUDGET_DECODER_CYCLES,
+ * 						counted as an overrun and an abort, and the result of
+ * 						the sentence is not cached: its repeat is decoded again,
+ * 	- sentence budget:	a second looping call only gets what is left of
+ * 						BUDGET_SENTENCE_CYCLES, the next one is skipped,
+ * 	- no checkpoint:	a long call which never checks is an overrun, but not
+ * 						an abort, and its result is complete,
+ * 	- wrap-around:		the same, with the counter wrapping during the calls,
+ * 	- next sentence:	budget_sentenceExhausted() is cleared.
+ *
+ * Build (from 01-M433_analyzer):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -DBUDGET_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o budget_check tools/budget_check.c User/decoders/budget.c User/frame_cache.c
+ * Usage:	budget_check
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "budget.h"
+#include "frame_cache.h"
+
+#ifndef BUDGET_PORTABLE
+	#error "Build with -DBUDGET_PORTABLE"
+#endif
+
+//! Cycles of a step of the fake decoders
+#define STEP				1000
+#define FOREVER				0xFFFFFFFF
+
+//! Line printed by the sentences (see output_lastLine())
+#define SENTENCE_LINE		0x1234
+
+// Stubs of the target modules
+volatile uint32_t	sysTickTime = 0;
+
+uint8_t output_repeat(uint32_t line, uint16_t count)
+{
+	(void)line;
+	(void)count;
+	return 1;
+}
+
+//! A call of a sentence: slot, cycles to run, and whether it checks budget_expired()
+typedef struct {
+	uint8_t		slot;
+	uint32_t	cycles;
+	uint8_t		checks;
+} call_t;
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+static uint32_t		cyclesRun[4];		// Cycles of each call of the last sentence
+
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+/*!
+ * @brief Fake decoder
+ * @return Cycles it ran
+ */
+static uint32_t runDecoder(const call_t *call)
+{
+	uint32_t	done = 0;
+	
+	
+	while (done < call->cycles && !(call->checks && budget_expired()))
+	{
+		budgetFakeCycles += STEP;
+		done += STEP;
+	}
+	return done;
+}
+
+/*!
+ * @brief Run the calls of a sentence as processSentence() does
+ * @return 1 if the decoders were called, 0 if the cached result was reused
+ */
+static uint8_t processSentence(uint32_t hash, const call_t *calls, uint8_t nbCalls)
+{
+	uint8_t	i;
+	
+	
+	memset(cyclesRun, 0, sizeof(cyclesRun));
+	if (frameCache_reuse(hash, 100)) {
+		return 0;
+	}
+	budget_startSentence();
+	for (i = 0; i < nbCalls; i++)
+	{
+		if (budget_start(calls[i].slot))
+		{
+			cyclesRun[i] = runDecoder(&calls[i]);
+			budget_stop();
+		}
+	}
+	if (!budget_sentenceExhausted()) {
+		frameCache_store(hash, 100, SENTENCE_LINE, 1);
+	}
+	return 1;
+}
+
+static void resetStats(void)
+{
+	memset(budgetStats, 0, sizeof(budgetStats));
+}
+
+/*!
+ * @brief Looping calls, the counter starting at a given value
+ */
+static void checkLooping(uint32_t counterStart, uint32_t hash, const char *what)
+{
+	const call_t	loops[3] = { { 0, FOREVER, 1 }, { 1, FOREVER, 1 }, { 2, STEP, 1 } };
+	char			label[80];
+	
+	
+	resetStats();
+	budgetFakeCycles = counterStart;
+	check(processSentence(hash, loops, 3), what);
+	
+	snprintf(label, sizeof(label), "%s: first call stopped at its budget", what);
+	check(cyclesRun[0] > BUDGET_DECODER_CYCLES && cyclesRun[0] <= BUDGET_DECODER_CYCLES + STEP, label);
+	snprintf(label, sizeof(label), "%s: first call counted as overrun and abort", what);
+	check(budgetStats[0].calls == 1 && budgetStats[0].overruns == 1 && budgetStats[0].aborts == 1, label);
+	snprintf(label, sizeof(label), "%s: second call gets what is left of the sentence budget", what);
+	check(cyclesRun[0] + cyclesRun[1] > BUDGET_SENTENCE_CYCLES && cyclesRun[0] + cyclesRun[1] <= BUDGET_SENTENCE_CYCLES + STEP, label);
+	snprintf(label, sizeof(label), "%s: third call skipped", what);
+	check(cyclesRun[2] == 0 && budgetStats[2].calls == 0 && budgetStats[2].skipped == 1, label);
+	snprintf(label, sizeof(label), "%s: sentence exhausted", what);
+	check(budget_sentenceExhausted(), label);
+	snprintf(label, sizeof(label), "%s: repeat decoded again", what);
+	check(processSentence(hash, loops, 3), label);
+}
+
+int main(void)
+{
+	const call_t	shortCalls[3] = { { 0, 10 * STEP, 1 }, { 1, 10 * STEP, 1 }, { BUDGET_SLOT_DEFAULT, 10 * STEP, 1 } };
+	const call_t	oneLoop[2] = { { 0, FOREVER, 1 }, { 1, 10 * STEP, 1 } };
+	const call_t	noCheck[2] = { { 0, 3 * BUDGET_DECODER_CYCLES / 2, 0 }, { 1, 10 * STEP, 1 } };
+	
+	
+	budget_init();
+	
+	// Nothing metered
+	budgetFakeCycles += 10 * BUDGET_SENTENCE_CYCLES;
+	check(budget_expired() == 0, "No call metered: never expired");
+	
+	// Short calls: cached
+	resetStats();
+	check(processSentence(1, shortCalls, 3), "Short calls decoded");
+	check(budgetStats[0].calls == 1 && budgetStats[0].overruns == 0 && budgetStats[0].aborts == 0 &&
+		budgetStats[BUDGET_SLOT_DEFAULT].calls == 1, "Short calls counted");
+	check(budgetStats[0].maxCycles == 10 * STEP, "Longest call");
+	check(!budget_sentenceExhausted(), "Short calls: sentence complete");
+	check(!processSentence(1, shortCalls, 3), "Short calls: repeat reused");
+	
+	// One looping call: stopped, its result not cached
+	resetStats();
+	check(processSentence(2, oneLoop, 2), "Looping call decoded");
+	check(cyclesRun[0] > BUDGET_DECODER_CYCLES && cyclesRun[0] <= BUDGET_DECODER_CYCLES + STEP, "Looping call stopped at its budget");
+	check(budgetStats[0].aborts == 1 && budgetStats[1].calls == 1 && cyclesRun[1] == 10 * STEP, "Next call made");
+	check(budget_sentenceExhausted(), "Looping call: sentence exhausted");
+	check(processSentence(2, oneLoop, 2), "Looping call: repeat decoded again");
+	
+	// Looping calls, then with the counter wrapping
+	checkLooping(0, 3, "Looping calls");
+	checkLooping(0xFFFFFFFF - BUDGET_DECODER_CYCLES / 2, 4, "Counter wrap");
+	
+	// A long call without checkpoint: overrun, but complete
+	resetStats();
+	check(processSentence(5, noCheck, 2), "Call without checkpoint decoded");
+	check(budgetStats[0].overruns == 1 && budgetStats[0].aborts == 0 && cyclesRun[0] == 3 * BUDGET_DECODER_CYCLES / 2,
+		"Call without checkpoint: overrun, not aborted");
+	check(budgetStats[1].skipped == 0 && cyclesRun[1] == 10 * STEP, "Next call made within the sentence budget");
+	check(!budget_sentenceExhausted(), "Call without checkpoint: sentence complete");
+	check(!processSentence(5, noCheck, 2), "Call without checkpoint: repeat reused");
+	
+	// The next sentence starts complete
+	budget_startSentence();
+	check(!budget_sentenceExhausted(), "Next sentence not exhausted");
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
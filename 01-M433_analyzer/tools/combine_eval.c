@@ -0,0 +1,286 @@
+/*******************************************************************************
+ * FRAME COMBINING EVALUATION                                                  *
+ *******************************************************************************
+ * Host tool: measures how many sentences the combining of the repeated frames
+ * (see User/decoders/combine.h) recovers when their pulses are corrupted.
+ *
+ * The sentences of the captures are first decoded as captured, by the decoders
+ * enabled in defines.h, without and with the combining: the lines they print
+ * are the references. Noise is then injected: each pulse is replaced, with a
+ * probability of RATE per mil, by a random duration between a third and three
+ * times its own. The noisy sentences are decoded again, without and with the
+ * combining, and each sentence decoded in the reference is counted as:
+ * 	- recovered:	the same lines are printed,
+ * 	- wrong:		other lines are printed,
+ * 	- lost:			nothing is printed.
+ * The noise is the same for both passes. Every pass runs in a child process, so
+ * that the decoders keeping state (key fobs) start from the same state.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes combine.c itself, to switch the combining off):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o combine_eval tools/combine_eval.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "combine\|default\|learner\|protocol_store\|router")
+ * Usage:	combine_eval [-s <seed>] <capture> [...]
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines).
+ * Prints a table of the results for each noise rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// The real combine_frames() is renamed, the decoders call the switch below
+#define combine_frames		combine_framesReal
+#include "combine.c"
+#undef combine_frames
+
+#include "record.h"
+
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+#define MAX_SENTENCES		100000
+
+//! Noise rates evaluated, in pulses per mil
+static const uint16_t	rates[] = { 5, 10, 20, 50, 100 };
+#define NB_RATES			(sizeof(rates) / sizeof(rates[0]))
+
+// FNV-1a parameters
+#define FNV_OFFSET_BASIS	2166136261u
+#define FNV_PRIME			16777619u
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Hash of the lines printed for the current sentence, 0 if none
+static uint32_t		printed;
+
+void output_send(char *message)
+{
+	if (printed == 0) {
+		printed = FNV_OFFSET_BASIS;
+	}
+	for (; *message != '\0'; message++)
+	{
+		printed ^= (uint8_t)*message;
+		printed *= FNV_PRIME;
+	}
+}
+
+//! Combining switch
+static uint8_t		combining;
+
+uint16_t *combine_frames(uint16_t *pulseLens, uint16_t nbPulses, const uint16_t *frameOffsets, uint8_t nbFrames, uint16_t *frameLen)
+{
+	if (!combining) {
+		return NULL;
+	}
+	return combine_framesReal(pulseLens, nbPulses, frameOffsets, nbFrames, frameLen);
+}
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+
+//! Sentences of the captures
+static uint16_t		*sentences[MAX_SENTENCES];
+static uint16_t		sentenceLens[MAX_SENTENCES];
+static uint32_t		nbSentences = 0;
+
+//! Lines printed for each sentence: as captured, then noisy, without and with the combining
+static uint32_t		results[4][MAX_SENTENCES];
+
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode every sentence, corrupted with rate pulses per mil
+ *
+ * Runs in a child process: the decoders start from the same state at each pass.
+ */
+static void runPass(uint8_t combine, uint16_t rate, unsigned int seed, uint32_t *result)
+{
+	FILE			*file = tmpfile();
+	decoderMask_t	mask;
+	uint32_t		s;
+	uint16_t		i, nbPulses;
+	uint8_t			d;
+	
+	
+	fflush(stdout);
+	if (fork() != 0)
+	{
+		wait(NULL);
+		rewind(file);
+		if (fread(result, sizeof(result[0]), nbSentences, file) != nbSentences) {
+			exit(1);
+		}
+		fclose(file);
+		return;
+	}
+	
+	combining = combine;
+	srand(seed + rate);
+	for (s = 0; s < nbSentences; s++)
+	{
+		nbPulses = sentenceLens[s];
+		for (i = 0; i < nbPulses; i++)
+		{
+			pulseLens[i] = sentences[s][i];
+			if ((uint16_t)(rand() % 1000) < rate) {
+				pulseLens[i] = (uint16_t)(pulseLens[i] / 3 + rand() % (8 * pulseLens[i] / 3 + 1));
+			}
+		}
+	
+		printed = 0;
+		mask = decoder_dispatchMask(nbPulses);
+		for (d = 0; d < NUM_DECODERS; d++)
+		{
+			if (mask & DECODER_BIT(d))
+			{
+				memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+				decoders[d]->decoderFunc(work, nbPulses);
+			}
+		}
+		record_poll();
+		result[s] = printed;
+	
+		// Far enough apart not to be taken for repeats
+		sysTickTime += 1000000;
+	}
+	
+	fwrite(result, sizeof(result[0]), nbSentences, file);
+	fclose(file);
+	exit(0);
+}
+
+int main(int argc, char **argv)
+{
+	FILE			*file;
+	uint32_t		s, nbDecoded[2] = { 0, 0 }, counts[2][3];
+	uint16_t		nbPulses;
+	uint8_t			r, c;
+	unsigned int	seed = 1;
+	int				a = 1;
+	
+	
+	if (a + 1 < argc && strcmp(argv[a], "-s") == 0)
+	{
+		seed = atoi(argv[a + 1]);
+		a += 2;
+	}
+	if (a >= argc)
+	{
+		fprintf(stderr, "Usage: %s [-s <seed>] <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+		while (nbSentences < MAX_SENTENCES && fgets(line, sizeof(line), file) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			sentences[nbSentences] = malloc(nbPulses * sizeof(pulseLens[0]));
+			memcpy(sentences[nbSentences], pulseLens, nbPulses * sizeof(pulseLens[0]));
+			sentenceLens[nbSentences++] = nbPulses;
+		}
+		fclose(file);
+	}
+	
+	// References: the sentences as captured, without and with the combining
+	for (c = 0; c < 2; c++)
+	{
+		runPass(c, 0, seed, results[c]);
+		for (s = 0; s < nbSentences; s++)
+		{
+			if (results[c][s] != 0) {
+				nbDecoded[c]++;
+			}
+		}
+		if (nbDecoded[c] == 0)
+		{
+			fprintf(stderr, "No decoded sentence\n");
+			return 1;
+		}
+	}
+	
+	printf("Sentences: %lu, decoded %lu without combining, %lu with it\n", (unsigned long)nbSentences,
+		(unsigned long)nbDecoded[0], (unsigned long)nbDecoded[1]);
+	printf("Noise     |   Without combining     |    With combining\n");
+	printf("(per mil) | recovered  wrong   lost | recovered  wrong   lost\n");
+	for (r = 0; r < NB_RATES; r++)
+	{
+		memset(counts, 0, sizeof(counts));
+		for (c = 0; c < 2; c++)
+		{
+			runPass(c, rates[r], seed, results[2 + c]);
+			for (s = 0; s < nbSentences; s++)
+			{
+				if (results[c][s] == 0) {
+					continue;
+				}
+				if (results[2 + c][s] == results[c][s]) {
+					counts[c][0]++;
+				} else if (results[2 + c][s] != 0) {
+					counts[c][1]++;
+				} else {
+					counts[c][2]++;
+				}
+			}
+		}
+	
+		printf("%9d | %8.1f%% %5.1f%% %5.1f%% | %8.1f%% %5.1f%% %5.1f%%\n", rates[r],
+			100.0 * counts[0][0] / nbDecoded[0], 100.0 * counts[0][1] / nbDecoded[0], 100.0 * counts[0][2] / nbDecoded[0],
+			100.0 * counts[1][0] / nbDecoded[1], 100.0 * counts[1][1] / nbDecoded[1], 100.0 * counts[1][2] / nbDecoded[1]);
+	}
+	
+	return 0;
+}
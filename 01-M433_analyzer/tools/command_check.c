@@ -0,0 +1,389 @@
+/*******************************************************************************
+ * COMMAND AND CAPTURE CONFIGURATION CHECK                                     *
+ *******************************************************************************
+ * Host tool: checks the CMD commands (see User/command.h) and the rebuild of
+ * the capture configuration (see User/capture_config.h), with the USART and
+ * FLASH functions stubbed.
+ *
+ * The lines are run by command_run(), or read by command_poll() from a stubbed
+ * TM_USART_Gets(), and the replies checked. Checked:
+ * 	- defaults:		before the first rebuild, the published filter accepts no
+ * 					pulse; with every decoder enabled, the rebuilt filter equals
+ * 					the compile-time GLOBAL_* limits, and the settings the
+ * 					defines.h values,
+ * 	- buffers:		each rebuild publishes the other of the two buffers, and
+ * 					leaves the configuration published before it unchanged,
+ * 	- settings:		SET changes captureSettings only, the published
+ * 					configuration changes at the next rebuild; the bounds of each
+ * 					setting are accepted,
+ * 	- decoders:		random ENABLE / DISABLE sequences, the rebuilt filter
+ * 					compared with the union of the enabled decoders; DISABLE ALL
+ * 					leaves a filter accepting no pulse, ENABLE ALL the GLOBAL_*
+ * 					limits again,
+ * 	- errors:		unknown command, decoder or setting, values out of range or
+ * 					not numbers, lines which are not CMD lines: nothing changes,
+ * 	- replies:		LIST, GET and STATS, and command_poll() with CRLF lines.
+ * The FLASH functions must not be called: no PSTORE line is sent.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the decoders and of the
+ * command modules):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders -IUser/esp8266 \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o command_check tools/command_check.c User/command.c User/capture_config.c \
+ * 			User/frame_cache.c User/sentence_queue.c $(ls User/decoders/[a-z]*.c)
+ * Usage:	command_check [-n <sequences>] [-s <seed>]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "capture_config.h"
+#include "command.h"
+
+#define MAX_LINES			8
+#define MAX_LINE_LEN		64
+
+// Stubs of the target modules
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+uint32_t			outputSuppressed = 0;
+uartTxStats_t		uartTxStats;
+
+void output_send(char *message)
+{
+	(void)message;
+}
+
+uint8_t output_repeat(uint32_t line, uint16_t count)
+{
+	(void)line;
+	(void)count;
+	return 0;
+}
+
+//! Calls of the FLASH functions
+static uint32_t		flashCalls = 0;
+
+void FLASH_Unlock(void)
+{
+	flashCalls++;
+}
+
+void FLASH_Lock(void)
+{
+	flashCalls++;
+}
+
+void FLASH_ClearFlag(uint32_t FLASH_FLAG)
+{
+	(void)FLASH_FLAG;
+	flashCalls++;
+}
+
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange)
+{
+	(void)FLASH_Sector;
+	(void)VoltageRange;
+	flashCalls++;
+	return FLASH_ERROR_OPERATION;
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+	(void)Address;
+	(void)Data;
+	flashCalls++;
+	return FLASH_ERROR_OPERATION;
+}
+
+//! Lines received on the computer UART, and replies sent on it
+static char			rxLines[MAX_LINES][MAX_LINE_LEN];
+static uint8_t		nbRxLines, nextRxLine;
+static char			replies[4096];
+static uint16_t		repliesLen;
+
+uint16_t TM_USART_Gets(USART_TypeDef *USARTx, char *buffer, uint16_t bufsize)
+{
+	(void)USARTx;
+	if (nextRxLine == nbRxLines) {
+		return 0;
+	}
+	snprintf(buffer, bufsize, "%s", rxLines[nextRxLine++]);
+	return strlen(buffer);
+}
+
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	if (repliesLen + len < sizeof(replies))
+	{
+		memcpy(replies + repliesLen, message, len);
+		repliesLen += len;
+		replies[repliesLen] = '\0';
+	}
+	return 1;
+}
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+static void reply(const char *line)
+{
+	uartTx_write(line, strlen(line));
+}
+
+/*!
+ * @brief Run a command line, its replies in replies
+ * @return What it changed
+ */
+static uint8_t run(const char *line)
+{
+	repliesLen = 0;
+	replies[0] = '\0';
+	return command_run(line, decoders, NUM_DECODERS, reply);
+}
+
+/*!
+ * @brief Run a line which must be rejected with a given reply, changing nothing
+ */
+static void checkError(const char *line, const char *expected)
+{
+	captureSettings_t	before = captureSettings;
+	char				label[96];
+	
+	
+	snprintf(label, sizeof(label), "\"%s\" rejected", line);
+	check(run(line) == 0 && strcmp(replies, expected) == 0 &&
+		memcmp(&before, &captureSettings, sizeof(before)) == 0, label);
+}
+
+/*!
+ * @brief Filter of the decoders of a mask: accepts no pulse if the mask is empty
+ */
+static void referenceFilter(decoderMask_t mask, decoderDesc_t *filter)
+{
+	uint8_t	i;
+	
+	
+	filter->minPulseLen		= 0xFFFFFFFF;
+	filter->maxPulseLen		= 0;
+	filter->minNumPulses	= 0xFFFF;
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if (mask & DECODER_BIT(i))
+		{
+			filter->minPulseLen		= (decoders[i]->minPulseLen < filter->minPulseLen ? decoders[i]->minPulseLen : filter->minPulseLen);
+			filter->maxPulseLen		= (decoders[i]->maxPulseLen > filter->maxPulseLen ? decoders[i]->maxPulseLen : filter->maxPulseLen);
+			filter->minNumPulses	= (decoders[i]->minNumPulses < filter->minNumPulses ? decoders[i]->minNumPulses : filter->minNumPulses);
+		}
+	}
+}
+
+static uint8_t sameFilter(const decoderDesc_t *a, const decoderDesc_t *b)
+{
+	return (a->minPulseLen == b->minPulseLen && a->maxPulseLen == b->maxPulseLen && a->minNumPulses == b->minNumPulses);
+}
+
+/*!
+ * @brief Random ENABLE / DISABLE sequences, each followed by a rebuild
+ */
+static void checkSequences(uint32_t nbSequences)
+{
+	const captureConfig_t	*config, *previous = captureConfig;
+	captureConfig_t			published;
+	decoderDesc_t			expected;
+	decoderMask_t			mask = captureSettings.enabled;
+	char					line[MAX_LINE_LEN];
+	uint32_t				n, ok = 0;
+	uint8_t					i, c, nbCommands, enable;
+	
+	
+	for (n = 0; n < nbSequences; n++)
+	{
+		nbCommands = 1 + rand() % 4;
+		for (c = 0; c < nbCommands; c++)
+		{
+			i = rand() % NUM_DECODERS;
+			enable = rand() & 1;
+			snprintf(line, sizeof(line), "CMD %s %s", enable ? "ENABLE" : "DISABLE", (const char *)decoders[i]->name);
+			mask = (enable ? mask | DECODER_BIT(i) : mask & ~DECODER_BIT(i));
+			if (run(line) != COMMAND_REBUILD) {
+				break;
+			}
+		}
+	
+		published = *previous;
+		config = captureConfig_rebuild(decoders, NUM_DECODERS);
+		referenceFilter(mask, &expected);
+		ok += (config != previous && config->decoders == mask && sameFilter(&config->filter, &expected) &&
+			memcmp(&published, previous, sizeof(published)) == 0);
+		previous = config;
+	}
+	printf("%lu random sequences: %lu rebuilt as expected\n", (unsigned long)nbSequences, (unsigned long)ok);
+	check(ok == nbSequences, "Random sequences: filter of the enabled decoders, other buffer, previous one unchanged");
+}
+
+int main(int argc, char **argv)
+{
+	const captureConfig_t	*initial = captureConfig, *first, *second, *config;
+	captureConfig_t			published;
+	decoderDesc_t			expected;
+	char					line[MAX_LINE_LEN], expectedReply[96];
+	uint32_t				nbSequences = 100000;
+	unsigned int			seed = 1;
+	uint8_t					i;
+	int						a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbSequences = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbSequences == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <sequences>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	srand(seed);
+	
+	// Defaults
+	check(initial->filter.maxPulseLen == 0 && initial->decoders == 0, "Before the first rebuild: no pulse accepted");
+	first = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(first != initial && captureConfig == first, "First rebuild published in the spare buffer");
+	check(first->decoders == CAPTURE_ALL_DECODERS, "Every decoder enabled");
+	check(first->filter.minPulseLen == GLOBAL_MIN_PULSE_LEN && first->filter.maxPulseLen == GLOBAL_MAX_PULSE_LEN &&
+		first->filter.minNumPulses == GLOBAL_MIN_NUM_PULSES, "Filter of every decoder equals the GLOBAL_* limits");
+	check(first->settings.minSentenceLen == MIN_SENTENCE_LEN && first->settings.numJokers == NUM_JOKERS &&
+		first->settings.jokerPeriod == JOKER_PERIOD, "Default settings from defines.h");
+	
+	// Buffers alternate, the published configuration is left alone
+	published = *first;
+	second = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(second == initial, "Second rebuild back in the first buffer");
+	check(memcmp(&published, first, sizeof(published)) == 0, "Previous configuration unchanged");
+	check(captureConfig_rebuild(decoders, NUM_DECODERS) == first, "Third rebuild in the second buffer");
+	
+	// Settings: applied at the next rebuild only
+	check(run("CMD SET NUM_JOKERS 3") == COMMAND_REBUILD && strcmp(replies, "CMD,OK,NUM_JOKERS,3\n") == 0, "SET NUM_JOKERS");
+	check(captureSettings.numJokers == 3 && captureConfig->settings.numJokers == NUM_JOKERS, "Published settings unchanged before the rebuild");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(config->settings.numJokers == 3, "NUM_JOKERS applied by the rebuild");
+	check(run("CMD SET NUM_JOKERS 255") == COMMAND_REBUILD && captureSettings.numJokers == 255, "NUM_JOKERS upper bound");
+	check(run("CMD SET JOKER_PERIOD 1") == COMMAND_REBUILD && captureSettings.jokerPeriod == 1, "JOKER_PERIOD lower bound");
+	snprintf(line, sizeof(line), "CMD SET JOKER_PERIOD %d", MAX_NUM_PULSES);
+	check(run(line) == COMMAND_REBUILD && captureSettings.jokerPeriod == MAX_NUM_PULSES, "JOKER_PERIOD upper bound");
+	check(run("CMD SET MIN_SENTENCE_LEN 0") == COMMAND_REBUILD && captureSettings.minSentenceLen == 0, "MIN_SENTENCE_LEN lower bound");
+	check(run("CMD SET MIN_SENTENCE_LEN 4294967295") == COMMAND_REBUILD && captureSettings.minSentenceLen == 0xFFFFFFFF,
+		"MIN_SENTENCE_LEN upper bound");
+	check(run("CMD SET MIN_SENTENCE_LEN 5000\r\n") == COMMAND_REBUILD && strcmp(replies, "CMD,OK,MIN_SENTENCE_LEN,5000\n") == 0,
+		"SET with CRLF");
+	snprintf(expectedReply, sizeof(expectedReply), "CMD,OK,MIN_SENTENCE_LEN,5000\nCMD,OK,NUM_JOKERS,255\nCMD,OK,JOKER_PERIOD,%d\n",
+		MAX_NUM_PULSES);
+	check(run("CMD GET") == 0 && strcmp(replies, expectedReply) == 0, "GET");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(config->settings.minSentenceLen == 5000 && config->settings.numJokers == 255 && config->settings.jokerPeriod == MAX_NUM_PULSES,
+		"Settings applied by the rebuild");
+	
+	// Errors
+	checkError("CMD FOO", "CMD,ERROR,COMMAND,0\n");
+	checkError("CMD LISTX", "CMD,ERROR,COMMAND,0\n");
+	checkError("CMD", "CMD,ERROR,COMMAND,0\n");
+	checkError("CMD ENABLE Foo", "CMD,ERROR,DECODER,0\n");
+	checkError("CMD DISABLE", "CMD,ERROR,DECODER,0\n");
+	checkError("CMD DISABLE ALLX", "CMD,ERROR,DECODER,0\n");
+	snprintf(line, sizeof(line), "CMD DISABLE %sX", (const char *)decoders[0]->name);
+	checkError(line, "CMD,ERROR,DECODER,0\n");
+	checkError("CMD SET FOO 1", "CMD,ERROR,SETTING,0\n");
+	checkError("CMD SET NUM_JOKERS", "CMD,ERROR,VALUE,0\n");
+	checkError("CMD SET NUM_JOKERS 256", "CMD,ERROR,VALUE,0\n");
+	checkError("CMD SET NUM_JOKERS -1", "CMD,ERROR,VALUE,0\n");
+	checkError("CMD SET NUM_JOKERS 12x", "CMD,ERROR,VALUE,0\n");
+	checkError("CMD SET NUM_JOKERS  4", "CMD,ERROR,VALUE,0\n");
+	checkError("CMD SET JOKER_PERIOD 0", "CMD,ERROR,VALUE,0\n");
+	snprintf(line, sizeof(line), "CMD SET JOKER_PERIOD %d", MAX_NUM_PULSES + 1);
+	checkError(line, "CMD,ERROR,VALUE,0\n");
+	checkError("CMDX LIST", "");
+	checkError("PSTORE LIST", "");
+	
+	// Decoders
+	snprintf(line, sizeof(line), "CMD DISABLE %s", (const char *)decoders[1]->name);
+	check(run(line) == COMMAND_REBUILD, "DISABLE a decoder");
+	snprintf(expectedReply, sizeof(expectedReply), "CMD,OK,DISABLE,%lu\n", (unsigned long)(CAPTURE_ALL_DECODERS & ~DECODER_BIT(1)));
+	check(strcmp(replies, expectedReply) == 0, "DISABLE reply: enabled decoders");
+	check(run("CMD LIST") == 0, "LIST");
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		snprintf(expectedReply, sizeof(expectedReply), "CMD,OK,%s,%d\n", (const char *)decoders[i]->name, i != 1);
+		check(strstr(replies, expectedReply) != NULL, "LIST: decoder and its state");
+	}
+	snprintf(expectedReply, sizeof(expectedReply), "CMD,OK,LIST,%d\n", NUM_DECODERS);
+	check(strlen(replies) >= strlen(expectedReply) && strcmp(replies + strlen(replies) - strlen(expectedReply), expectedReply) == 0,
+		"LIST ends with the number of decoders");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	referenceFilter(CAPTURE_ALL_DECODERS & ~DECODER_BIT(1), &expected);
+	check(config->decoders == (CAPTURE_ALL_DECODERS & ~DECODER_BIT(1)) && sameFilter(&config->filter, &expected),
+		"Decoder left out of the rebuilt configuration");
+	
+	check(run("CMD DISABLE ALL") == COMMAND_REBUILD && strcmp(replies, "CMD,OK,DISABLE,0\n") == 0, "DISABLE ALL");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(config->decoders == 0 && config->filter.minPulseLen > config->filter.maxPulseLen, "No decoder: no pulse accepted");
+	check(run("CMD ENABLE ALL") == COMMAND_REBUILD, "ENABLE ALL");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check(config->decoders == CAPTURE_ALL_DECODERS && config->filter.minPulseLen == GLOBAL_MIN_PULSE_LEN &&
+		config->filter.maxPulseLen == GLOBAL_MAX_PULSE_LEN && config->filter.minNumPulses == GLOBAL_MIN_NUM_PULSES,
+		"Every decoder enabled again: GLOBAL_* limits");
+	
+	checkSequences(nbSequences);
+	
+	// Counters
+	check(run("CMD STATS") == 0 && strncmp(replies, "CMD,OK,FrameCacheHits,", 22) == 0 &&
+		strcmp(replies + strlen(replies) - 15, "CMD,OK,STATS,0\n") == 0, "STATS");
+	
+	// Lines read from the UART
+	run("CMD ENABLE ALL");
+	snprintf(rxLines[0], MAX_LINE_LEN, "CMD DISABLE %s\r\n", (const char *)decoders[0]->name);
+	snprintf(rxLines[1], MAX_LINE_LEN, "CMD FOO\r\n");
+	snprintf(rxLines[2], MAX_LINE_LEN, "CMD GET\r\n");
+	nbRxLines = 3;
+	nextRxLine = 0;
+	repliesLen = 0;
+	check(command_poll(decoders, NUM_DECODERS) == COMMAND_REBUILD, "Polled lines: rebuild");
+	snprintf(expectedReply, sizeof(expectedReply), "CMD,OK,DISABLE,%lu\nCMD,ERROR,COMMAND,0\n",
+		(unsigned long)(CAPTURE_ALL_DECODERS & ~DECODER_BIT(0)));
+	check(strncmp(replies, expectedReply, strlen(expectedReply)) == 0 && strstr(replies, "CMD,OK,JOKER_PERIOD,") != NULL,
+		"Polled lines: replies in order");
+	check(flashCalls == 0, "Flash left alone");
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,370 @@
+/*******************************************************************************
+ * OUTPUT DEDUPLICATION BENCHMARK                                              *
+ *******************************************************************************
+ * Host tool: measures the bytes the output deduplication (see User/output.h)
+ * saves and what it costs per line, by replaying the lines of a capture with
+ * and without it.
+ *
+ * The sentences of the captures are decoded once, as processSentence() does
+ * (decoders, default decoder, records), and the messages they give are kept.
+ * Every sentence stands for a button press: its messages are sent REPEATS
+ * times, REPEAT_PERIOD ms apart, and the presses are PRESS_GAP ms apart, more
+ * than the dedupe window. The messages are replayed twice:
+ * 	- without deduplication:	written as output_send() does after its dedupe
+ * 								stage (output_write()),
+ * 	- with deduplication:		through output_send(), output_flush() being
+ * 								called every REPEAT_PERIOD ms as the main loop
+ * 								does.
+ * Only the time spent in the output is measured (the UART is a stub which
+ * counts the bytes). Checked: once the repeat records ("Repeated,Count=<n>,")
+ * are expanded, both passes give the same lines, in the same number.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes User/output.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -DOUTPUT_PORTABLE -IUser -IUser/decoders -IUser/esp8266 \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o dedupe_bench tools/dedupe_bench.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "protocol_store\|router")
+ * Usage:	dedupe_bench [-r <repeats>] <capture> [...]
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines,
+ * e.g. written by tools/router_captures.c).
+ * Exits with 1 if the lines of both passes differ, or if nothing is saved with
+ * repeated presses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "main.h"
+#include "record.h"
+
+// The output is included with its output_send() renamed, so that the messages
+// of the decoders can be kept before they are replayed
+#define output_send			output_sendDeduped
+#include "output.c"
+#undef output_send
+
+#define MAX_SENTENCES		100000
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+//! Default copies of a frame per press
+#define REPEATS				8
+
+//! Time between two copies, and between two presses (ms)
+#define REPEAT_PERIOD		100
+#define PRESS_GAP			5000
+
+//! Text sent to the UART by a pass
+typedef struct {
+	char		*text;
+	uint32_t	len;
+	uint32_t	size;
+} outputText_t;
+
+//! Messages of a press, one after the other (each with its '\0')
+typedef struct {
+	char		*messages;
+	uint32_t	len;
+	uint16_t	nbMessages;
+} press_t;
+
+// Stubs of the target modules used by the decoders and the output
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+static outputText_t	outputs[2];
+static outputText_t	*output = &outputs[0];
+
+//! Press being decoded, NULL when replaying
+static press_t		*decoding = NULL;
+
+static press_t		presses[MAX_SENTENCES];
+static uint32_t		nbPresses = 0;
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES];
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+uint16_t	decode_default(uint16_t *pulseLens, uint16_t nbPulses);
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	if (output->len + len > output->size)
+	{
+		output->size = 2 * (output->len + len);
+		output->text = realloc(output->text, output->size);
+	}
+	memcpy(output->text + output->len, message, len);
+	output->len += len;
+	return 1;
+}
+
+/*!
+ * @brief Keep the messages of the press being decoded
+ */
+void output_send(char *message)
+{
+	uint32_t	len = strlen(message) + 1;
+	
+	
+	if (decoding == NULL || len == 1) {
+		return;
+	}
+	decoding->messages = realloc(decoding->messages, decoding->len + len);
+	memcpy(decoding->messages + decoding->len, message, len);
+	decoding->len += len;
+	decoding->nbMessages++;
+}
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode a sentence as processSentence() does, and keep its messages
+ */
+static void decodePress(uint16_t nbPulses, press_t *press)
+{
+	static uint16_t	work[MAX_NUM_PULSES];
+	decoderMask_t	mask = decoder_dispatchMask(nbPulses);
+	uint16_t		result = 0;
+	uint8_t			i;
+	
+	
+	decoding = press;
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if (mask & DECODER_BIT(i))
+		{
+			memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+			result += decoders[i]->decoderFunc(work, nbPulses);
+		}
+	}
+	if (result == 0)
+	{
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		decode_default(work, nbPulses);
+	}
+	record_poll();
+	decoding = NULL;
+}
+
+/*!
+ * @brief Replay every press, copy after copy
+ * @return Time spent in the output (ns)
+ */
+static double replay(uint8_t dedupe, uint16_t repeats)
+{
+	const char	*message;
+	uint32_t	p;
+	uint16_t	r, m;
+	double		time = 0, t;
+	
+	
+	output = &outputs[dedupe];
+	for (p = 0; p < nbPresses; p++)
+	{
+		for (r = 0; r < repeats; r++)
+		{
+			t = now();
+			for (m = 0, message = presses[p].messages; m < presses[p].nbMessages; m++, message += strlen(message) + 1)
+			{
+				if (dedupe) {
+					output_sendDeduped((char *)message);
+				} else {
+					output_write((char *)message);
+				}
+			}
+			if (dedupe) {
+				output_flush();
+			}
+			time += now() - t;
+			sysTickTime += REPEAT_PERIOD * 100;
+		}
+		sysTickTime += PRESS_GAP * 100;
+		t = now();
+		if (dedupe) {
+			output_flush();
+		}
+		time += now() - t;
+	}
+	return time;
+}
+
+/*!
+ * @brief Count the lines of a text, the repeat records expanded
+ * @param[out] bytes Their bytes
+ * @param[out] hash Sum of the hashes of the lines, independent of their order
+ * @param[out] records Number of repeat records
+ */
+static uint32_t expandLines(const outputText_t *text, uint64_t *bytes, uint64_t *hash, uint32_t *records)
+{
+	uint32_t	i, end, start, count, nbLines = 0, lineHash, k;
+	
+	
+	*bytes = *hash = 0;
+	*records = 0;
+	for (i = 0; i < text->len; i = end + 1)
+	{
+		for (end = i; end < text->len && text->text[end] != '\n'; end++)
+			;
+		start = i;
+		count = 1;
+		if (end - i > 15 && memcmp(text->text + i, "Repeated,Count=", 15) == 0)
+		{
+			count = atoi(text->text + i + 15);
+			start = (const char *)memchr(text->text + i + 15, ',', end - i - 15) + 1 - text->text;
+			(*records)++;
+		}
+	
+		lineHash = FNV_OFFSET_BASIS;
+		for (k = start; k < end; k++)
+		{
+			lineHash ^= (uint8_t)text->text[k];
+			lineHash *= FNV_PRIME;
+		}
+		nbLines	+= count;
+		*bytes	+= (uint64_t)count * (end - start + 1);
+		*hash	+= (uint64_t)count * lineHash;
+	}
+	return nbLines;
+}
+
+int main(int argc, char **argv)
+{
+	FILE		*file;
+	uint16_t	nbPulses, repeats = REPEATS;
+	uint32_t	nbLines[2], records[2], sentMessages = 0;
+	uint64_t	bytes[2], hashes[2];
+	double		times[2];
+	uint8_t		d;
+	int			a = 1;
+	
+	
+	for (; a + 1 < argc && argv[a][0] == '-'; a += 2)
+	{
+		if (strcmp(argv[a], "-r") == 0) {
+			repeats = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a >= argc || repeats == 0)
+	{
+		fprintf(stderr, "Usage: %s [-r <repeats>] <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+		while (nbPresses < MAX_SENTENCES && fgets(line, sizeof(line), file) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			decodePress(nbPulses, &presses[nbPresses]);
+			sentMessages += presses[nbPresses].nbMessages;
+			nbPresses++;
+		}
+		fclose(file);
+	}
+	if (sentMessages == 0)
+	{
+		fprintf(stderr, "No line decoded\n");
+		return 1;
+	}
+	
+	for (d = 0; d < 2; d++)
+	{
+		times[d]	= replay(d, repeats);
+		nbLines[d]	= expandLines(&outputs[d], &bytes[d], &hashes[d], &records[d]);
+	}
+	
+	printf("%lu presses, %lu messages, each press sent %d times (%d ms apart), dedupe window %d ms\n",
+		(unsigned long)nbPresses, (unsigned long)sentMessages, repeats, REPEAT_PERIOD, OUTPUT_DEDUPE_WINDOW);
+	printf("             %10s %10s %12s %10s\n", "lines", "bytes", "bytes/line", "ns/line");
+	for (d = 0; d < 2; d++)
+	{
+		printf("  %-10s %10lu %10lu %12.1f %10.1f\n", d ? "dedupe" : "no dedupe", (unsigned long)nbLines[d],
+			(unsigned long)outputs[d].len, (double)outputs[d].len / nbLines[d], times[d] / nbLines[d]);
+	}
+	printf("Saved %lu bytes (%.1f%%), %lu repeat records, %+.1f ns per line\n",
+		(unsigned long)(outputs[0].len - outputs[1].len), 100.0 * (outputs[0].len - (double)outputs[1].len) / outputs[0].len,
+		(unsigned long)records[1], (times[1] - times[0]) / nbLines[0]);
+	
+	check(nbLines[0] == nbLines[1], "Same number of lines, the repeat records expanded");
+	check(bytes[0] == bytes[1] && hashes[0] == hashes[1], "Same lines, the repeat records expanded");
+	check(records[0] == 0, "No repeat record without deduplication");
+	check(repeats == 1 || outputs[1].len < outputs[0].len, "Bytes saved with repeated presses");
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
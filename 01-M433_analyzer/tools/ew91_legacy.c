@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * OREGON EW91 DECODER BEFORE THE BIT REPAIR                                   *
+ *******************************************************************************
+ * The OregonEW91 decoder as it was just before the soft-decision bit repair
+ * (see User/decoders/repair.h): a low pulse outside both the short and the long
+ * window is dropped. It is the reference of tools/ew91_noise.c, which includes
+ * this file.
+ *
+ * The code is unchanged, apart from the names (prefixed with legacy_), the
+ * descriptor, left out, and the pulse lens, 16 bits as they are now.
+ */
+
+#define MIN_SHORT_LEN	1300
+#define MAX_SHORT_LEN	2500
+
+#define MIN_LONG_LEN	3500
+#define MAX_LONG_LEN	4500
+
+#define RAW_DATA_BYTES	8	// bytes
+#define MIN_NUM_PULSES	66	// at least 4 bytes * 2 pulses + 2 sync pulses
+
+#define CHANNEL_BYTE	1
+#define CHANNEL_MASK	48 //0b110000
+#define CHANNEL_SHIFT	4
+
+#define SIGN_BYTE		1
+#define SIGN_MASK		8 //0b1000
+#define SIGN_SHIFT		3
+
+#define THIGH_BYTE		2
+#define THIGH_MASK		7 //0b111
+#define THIGH_SHIFT		0
+
+#define TLOW_BYTE		3
+#define TLOW_MASK		240 //0b11110000
+#define TLOW_SHIFT		4
+
+#define TDEC_BYTE		3
+#define TDEC_MASK		15 //0b1111
+#define TDEC_SHIFT		0
+
+static uint8_t legacy_interpret_oregon_ew91(uint8_t rawData[RAW_DATA_BYTES], uint8_t nbBytes)
+{
+	if (nbBytes < 4) {
+		return 0;
+	}
+	
+	// Run the parity checks
+	if ((rawData[0] ^ rawData[4]) != 255 ||
+		(rawData[1] ^ rawData[5]) != 255 ||
+		(rawData[2] ^ rawData[6]) != 255 ||
+		(rawData[3] ^ rawData[7]) != 255)
+	{
+		if (BIN_VALUE_MB(THIGH) <= 9 && BIN_VALUE_MB(TLOW) <= 9 && BIN_VALUE_MB(TDEC) <= 9)
+		{
+			// Normal sentence seems good! Use this one anyway
+			PRINTF("%s,%d,%c%d%d.%d\n", "OregonEW91", BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+			return 1;
+		}
+		
+		if (nbBytes == RAW_DATA_BYTES)
+		{
+			// Otherwise, replace the normal sentence with the second sentence inverted
+			rawData[0] = (rawData[4] ^ 0xff);
+			rawData[1] = (rawData[5] ^ 0xff);
+			rawData[2] = (rawData[6] ^ 0xff);
+			rawData[3] = (rawData[7] ^ 0xff);
+			
+			if (BIN_VALUE_MB(THIGH) <= 9 && BIN_VALUE_MB(TLOW) <= 9 && BIN_VALUE_MB(TDEC) <= 9 && (BIN_VALUE_MB(CHANNEL) == 1 || BIN_VALUE_MB(CHANNEL) == 2))
+			{
+				// Normal sentence seems good! Use this one
+				PRINTF("%s,%d,%c%d%d.%d\n", "OregonEW91", BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+				return 1;
+			}
+		}
+		
+		// Neither sentence was valid => discard the data
+		return 0;
+	}
+	
+	// Parity check succeeded
+	PRINTF("%s,%d,%c%d%d.%d\n", "OregonEW91", BIN_VALUE_MB(CHANNEL), (BIN_VALUE_MB(SIGN) ? '-' : '0'), BIN_VALUE_MB(THIGH), BIN_VALUE_MB(TLOW), BIN_VALUE_MB(TDEC));
+	return 1;
+}
+
+/*!
+ * @param[in]	pulseLens	Durations of the pulses to decode
+ * @param[in]	nbPulses	Number of pulses in pulseLens
+ * @return		Number of pulses used, starting from offset 0
+ */
+static uint16_t legacy_ew91_synced_sentence(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i;
+	uint8_t		j;
+	uint8_t		rawData[RAW_DATA_BYTES];
+	bitvec_t	bits;
+	
+	
+	// First bit of first offset must be left to 0 for alignment
+	bitvec_reset(&bits);
+	bitvec_append(&bits, 0);
+	
+	// Decode the raw data
+	// pulseLens should point to the first data pulse
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (!IS_SHORT(pulseLens[i]))
+		{
+			if (bits.nbBits < 4 * 8)
+			{
+				// PRINTF("Oregon: Invalid pulse @%d, len=%dus\n", i, pulseLens[i]);
+				return 0;
+			}
+			else
+			{
+				// We have decoded enough data to try and decode the sentence, without error correction
+				break;
+			}
+		}
+		if (IS_SHORT(pulseLens[i+1]))
+		{
+			bitvec_append(&bits, 0);
+		}
+		else if (IS_LONG(pulseLens[i+1]))
+		{
+			bitvec_append(&bits, 1);
+		}
+		
+		if (bits.nbBits == 8 * RAW_DATA_BYTES)
+		{
+			break;
+		}
+	}
+	
+	// Only complete bytes are kept
+	bitvec_finish(&bits);
+	memset(rawData, 0, RAW_DATA_BYTES);
+	for (j = 0; j < bits.nbBits / 8; j++)
+	{
+		rawData[j] = bitvec_byte(&bits, j);
+	}
+	
+	if (legacy_interpret_oregon_ew91(rawData, j))
+	{
+		return i;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+static uint16_t legacy_decode_oregon_ew91(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{	
+		if (IS_LONG(pulseLens[syncOffset]) && IS_LONG(pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence 
+			syncOffset += 2;
+			result = legacy_ew91_synced_sentence(pulseLens + syncOffset, nbPulses - syncOffset);
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_LONG_LEN
+#undef MAX_LONG_LEN
+#undef RAW_DATA_BYTES
+#undef MIN_NUM_PULSES
+#undef CHANNEL_BYTE
+#undef CHANNEL_MASK
+#undef CHANNEL_SHIFT
+#undef SIGN_BYTE
+#undef SIGN_MASK
+#undef SIGN_SHIFT
+#undef THIGH_BYTE
+#undef THIGH_MASK
+#undef THIGH_SHIFT
+#undef TLOW_BYTE
+#undef TLOW_MASK
+#undef TLOW_SHIFT
+#undef TDEC_BYTE
+#undef TDEC_MASK
+#undef TDEC_SHIFT
@@ -0,0 +1,236 @@
+/*******************************************************************************
+ * EW91 NOISE INJECTION                                                        *
+ *******************************************************************************
+ * Host tool: measures the frames the soft-decision bit repair (see
+ * User/decoders/repair.h) recovers in the OregonEW91 decoder, against the
+ * decoder before it (see tools/ew91_legacy.c).
+ *
+ * Random EW91 frames are generated, with valid complements, each pulse moved by
+ * up to +/-JITTER us. For each number of errors N, N low pulses of data bits
+ * chosen at random are then moved into the gap between the short and the long
+ * windows, on either side of the threshold between them. Each sentence is
+ * decoded by both decoders, and counted as:
+ * 	- correct:	the line of the frame is printed,
+ * 	- flagged:	a line flagged as repaired or unchecked is printed (see
+ * 				User/decoders/oregon_ew91.c), with the values of the frame
+ * 				(right) or others (wrong),
+ * 	- wrong:	another line is printed, not flagged: a wrong reading which
+ * 				looks valid,
+ * 	- missed otherwise.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/ew91_legacy.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o ew91_noise tools/ew91_noise.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	ew91_noise [-n <frames>] [-j <jitter>] [-s <seed>]
+ *
+ * Prints a table of the counts for each number of errors. Exits with 1 if the
+ * current decoder misses a frame without errors, or, for any number of errors,
+ * gives the right values (correct or flagged right) for fewer frames, or more
+ * wrong lines, than the former one, or more than MAX_WRONG_PERMILLE wrong
+ * lines (two errors on both halves of a bit pass the complement check).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "decoder.h"
+#include "bitvec.h"
+#include "record.h"
+
+#include "ew91_legacy.c"
+
+#define EW91_SHORT			1900	// us
+#define EW91_LONG			4000
+#define EW91_GAP_MIN		2500	// Between the short and long windows of the decoder
+#define EW91_GAP_MAX		3500
+#define EW91_NB_BYTES		8
+#define EW91_NB_BITS		(8 * EW91_NB_BYTES - 1)		// The first bit, 0, is not sent
+#define EW91_MAX_LINE_LEN	64
+#define MAX_SENTENCE_LEN	(2 * EW91_NB_BITS + 8)
+
+//! Numbers of errors evaluated
+#define MAX_ERRORS			4
+
+//! Wrong lines allowed, per 1000 frames
+#define MAX_WRONG_PERMILLE	5
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Text printed by the decoder being run
+static char			printed[BUFFER_LEN];
+
+void output_send(char *message)
+{
+	snprintf(printed, sizeof(printed), "%s", message);
+}
+
+typedef struct {
+	uint8_t		bytes[EW91_NB_BYTES];
+	char		line[EW91_MAX_LINE_LEN];		// Printed by the decoder
+} ew91Frame_t;
+
+//! Counts per decoder
+enum { CORRECT, FLAGGED_RIGHT, FLAGGED_WRONG, WRONG, MISSED, NB_COUNTS };
+
+static uint16_t		pulseLens[MAX_SENTENCE_LEN], work[MAX_SENTENCE_LEN];
+
+
+/*!
+ * @brief Random frame (see the interpretation in User/decoders/oregon_ew91.c)
+ */
+static void randomFrame(ew91Frame_t *frame)
+{
+	uint8_t		*b = frame->bytes, i, channel = 1 + (rand() & 1), tLow = rand() % 10, tDec = rand() % 10;
+	
+	
+	b[0] = rand() & 0x7F;
+	b[1] = (rand() & 0xC7) | (channel << 4) | (rand() & 0x08);
+	b[2] = rand();
+	b[3] = (tLow << 4) | tDec;
+	for (i = 0; i < 4; i++) {
+		b[4 + i] = b[i] ^ 0xFF;
+	}
+	snprintf(frame->line, EW91_MAX_LINE_LEN, "OregonEW91,%d,%c%d%d.%d\n", channel, (b[1] & 0x08) ? '-' : '0', b[2] & 0x07, tLow, tDec);
+}
+
+/*!
+ * @brief Sentence of a frame, with N low pulses moved into the gap between the windows
+ * @return Number of pulses
+ */
+static uint16_t buildSentence(const ew91Frame_t *frame, uint16_t jitter, uint8_t nbErrors)
+{
+	uint16_t	nbPulses = 0, i, first, pos;
+	uint8_t		bit, n;
+	
+	
+	// Preamble and sync
+	for (i = 0; i < 4; i++) {
+		pulseLens[nbPulses++] = EW91_SHORT;
+	}
+	pulseLens[nbPulses++] = EW91_LONG;
+	pulseLens[nbPulses++] = EW91_LONG;
+	first = nbPulses;
+	
+	for (i = 1; i <= EW91_NB_BITS; i++)
+	{
+		bit = (frame->bytes[i / 8] >> (7 - i % 8)) & 1;
+		pulseLens[nbPulses++] = EW91_SHORT;
+		pulseLens[nbPulses++] = bit ? EW91_LONG : EW91_SHORT;
+	}
+	for (i = 0; i < nbPulses && jitter > 0; i++) {
+		pulseLens[i] += rand() % (2 * jitter + 1) - jitter;
+	}
+	
+	// Errors on distinct low pulses
+	for (n = 0; n < nbErrors; )
+	{
+		pos = first + 2 * (rand() % EW91_NB_BITS) + 1;
+		if (pulseLens[pos] > EW91_GAP_MIN && pulseLens[pos] < EW91_GAP_MAX) {
+			continue;
+		}
+		pulseLens[pos] = EW91_GAP_MIN + 1 + rand() % (EW91_GAP_MAX - EW91_GAP_MIN - 1);
+		n++;
+	}
+	return nbPulses;
+}
+
+static uint8_t result(const ew91Frame_t *frame)
+{
+	const char	*flag = strstr(printed, ",Repaired=");
+	uint16_t	len = strlen(frame->line) - 1;		// Without its '\n'
+	
+	
+	if (printed[0] == '\0') {
+		return MISSED;
+	}
+	if (flag == NULL) {
+		flag = strstr(printed, ",Unchecked=");
+	}
+	if (flag != NULL) {
+		return (flag - printed == len && strncmp(printed, frame->line, len) == 0 ? FLAGGED_RIGHT : FLAGGED_WRONG);
+	}
+	return strcmp(printed, frame->line) == 0 ? CORRECT : WRONG;
+}
+
+int main(int argc, char **argv)
+{
+	ew91Frame_t		frame;
+	uint32_t		nbFrames = 20000, n, counts[MAX_ERRORS + 1][2][NB_COUNTS];
+	uint16_t		nbPulses, jitter = 100;
+	uint8_t			e, failed = 0;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0 || jitter > 500)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter (us, up to 500)>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	memset(counts, 0, sizeof(counts));
+	for (e = 0; e <= MAX_ERRORS; e++)
+	{
+		for (n = 0; n < nbFrames; n++)
+		{
+			randomFrame(&frame);
+			nbPulses = buildSentence(&frame, jitter, e);
+	
+			printed[0] = '\0';
+			legacy_decode_oregon_ew91(pulseLens, nbPulses);
+			counts[e][0][result(&frame)]++;
+	
+			printed[0] = '\0';
+			memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+			decoder_OregonEW91.decoderFunc(work, nbPulses);
+			record_poll();
+			counts[e][1][result(&frame)]++;
+		}
+	}
+	
+	printf("%lu frames per number of errors, jitter +/-%d us\n", (unsigned long)nbFrames, jitter);
+	printf("Errors | correct before  correct after | flagged right  flagged wrong | wrong before  wrong after\n");
+	for (e = 0; e <= MAX_ERRORS; e++)
+	{
+		printf("%6d | %13.1f%% %13.1f%% | %12.1f%% %13.1f%% | %11.1f%% %11.1f%%\n", e,
+			100.0 * counts[e][0][CORRECT] / nbFrames, 100.0 * counts[e][1][CORRECT] / nbFrames,
+			100.0 * counts[e][1][FLAGGED_RIGHT] / nbFrames, 100.0 * counts[e][1][FLAGGED_WRONG] / nbFrames,
+			100.0 * counts[e][0][WRONG] / nbFrames, 100.0 * counts[e][1][WRONG] / nbFrames);
+		if ((e == 0 && counts[e][1][CORRECT] != nbFrames) ||
+			counts[e][1][CORRECT] + counts[e][1][FLAGGED_RIGHT] < counts[e][0][CORRECT] ||
+			counts[e][1][WRONG] > counts[e][0][WRONG] || counts[e][1][WRONG] * 1000 > MAX_WRONG_PERMILLE * nbFrames) {
+			failed = 1;
+		}
+	}
+	
+	if (failed)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
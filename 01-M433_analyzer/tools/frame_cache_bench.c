@@ -0,0 +1,368 @@
+/*******************************************************************************
+ * FRAME CACHE BENCHMARK                                                       *
+ *******************************************************************************
+ * Host tool: measures the decoding time the frame cache (see
+ * User/frame_cache.h) saves on button-press bursts, and checks that the output
+ * is the same with and without it.
+ *
+ * Every sentence of the captures stands for a button press: it is received
+ * REPEATS times, REPEAT_PERIOD ms apart, each copy with its pulse lens moved by
+ * up to +/-JITTER us. The presses are PRESS_GAP ms apart, more than the frame
+ * cache and output windows. The bursts are decoded twice as processSentence()
+ * does (decoders, default decoder, records, output deduplication), first
+ * without the cache, then with it. The decoded lines and the repeat records
+ * ("Repeated,Count=") of both passes must be the same (without jitter, any
+ * difference is an error): a repeat found in the cache counts as many repeats
+ * as a decoded one, and the decoders reporting once per press (CarKey1) keep
+ * their single line.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -DOUTPUT_PORTABLE -IUser -IUser/decoders -IUser/esp8266 \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o frame_cache_bench tools/frame_cache_bench.c User/frame_cache.c User/output.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "protocol_store\|router")
+ * Usage:	frame_cache_bench [-r <repeats>] [-j <jitter>] <capture> [...]
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines).
+ * Exits with 1 if the decoded lines or the repeat records differ without jitter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "main.h"
+#include "frame_cache.h"
+#include "record.h"
+
+#define MAX_SENTENCES		100000
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+//! Defaults: copies of a frame per press, and pulse len jitter between copies (us)
+#define REPEATS				8
+#define JITTER				0
+
+//! Time between two copies, and between two presses (ms)
+#define REPEAT_PERIOD		100
+#define PRESS_GAP			5000
+
+//! Output of a pass
+typedef struct {
+	char		*text;
+	uint32_t	len;
+	uint32_t	size;
+} outputText_t;
+
+//! Results of a pass
+typedef struct {
+	double		time;			// Decoding time (ns)
+	uint32_t	calls;			// Decoder calls
+	uint32_t	hits;			// Sentences found in the cache
+	uint32_t	len;			// Output length
+} passResult_t;
+
+// Stubs of the target modules used by the decoders and the output
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+static outputText_t	outputs[2];
+static outputText_t	*output;
+
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	if (output->len + len > output->size)
+	{
+		output->size = 2 * (output->len + len);
+		output->text = realloc(output->text, output->size);
+	}
+	memcpy(output->text + output->len, message, len);
+	output->len += len;
+	return 1;
+}
+
+uint16_t	decode_default(uint16_t *pulseLens, uint16_t nbPulses);
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], copy[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+
+//! Sentences of the captures
+static uint16_t		*sentences[MAX_SENTENCES];
+static uint16_t		sentenceLens[MAX_SENTENCES];
+static uint32_t		nbSentences = 0;
+
+static uint32_t		decoderCalls;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode a sentence as processSentence() does
+ */
+static void decodeSentence(uint16_t *sentence, uint16_t nbPulses, uint8_t useCache)
+{
+	decoderMask_t	mask = decoder_dispatchMask(nbPulses);
+	uint32_t		hash = 0, line;
+	uint16_t		result = 0, lineCount;
+	uint8_t			i;
+	
+	
+	if (useCache)
+	{
+		hash = frameCache_hash(sentence, nbPulses);
+		if (frameCache_reuse(hash, nbPulses)) {
+			return;
+		}
+	}
+	output_mark();
+	
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if (mask & DECODER_BIT(i))
+		{
+			memcpy(work, sentence, nbPulses * sizeof(sentence[0]));
+			result += decoders[i]->decoderFunc(work, nbPulses);
+			decoderCalls++;
+		}
+	}
+	if (result == 0)
+	{
+		memcpy(work, sentence, nbPulses * sizeof(sentence[0]));
+		decode_default(work, nbPulses);
+		decoderCalls++;
+	}
+	
+	record_poll();
+	if (useCache)
+	{
+		line = output_lastLine(&lineCount);
+		frameCache_store(hash, nbPulses, line, lineCount);
+	}
+}
+
+/*!
+ * @brief Decode every press, copy after copy
+ *
+ * The decoders keep state from a sentence to the next (learned protocols, key
+ * fobs): each pass runs in a child process, which starts from the same state.
+ */
+static void runPass(uint8_t useCache, uint16_t repeats, uint16_t jitter, passResult_t *result)
+{
+	FILE		*file = tmpfile();
+	uint32_t	s;
+	uint16_t	r, i;
+	int			len;
+	double		t;
+	
+	
+	output = &outputs[useCache];
+	if (fork() != 0)
+	{
+		// Get the results and the output of the child
+		wait(NULL);
+		rewind(file);
+		if (fread(result, sizeof(*result), 1, file) != 1) {
+			exit(1);
+		}
+		output->text = malloc(result->len + 1);
+		output->len = fread(output->text, 1, result->len, file);
+		fclose(file);
+		return;
+	}
+	
+	memset(result, 0, sizeof(*result));
+	srand(1);
+	for (s = 0; s < nbSentences; s++)
+	{
+		for (r = 0; r < repeats; r++)
+		{
+			for (i = 0; i < sentenceLens[s]; i++)
+			{
+				len = sentences[s][i] + (jitter > 0 ? rand() % (2 * jitter + 1) - jitter : 0);
+				copy[i] = (uint16_t)(len < 1 ? 1 : (len > 0xFFFF ? 0xFFFF : len));
+			}
+	
+			t = now();
+			decodeSentence(copy, sentenceLens[s], useCache);
+			result->time += now() - t;
+	
+			sysTickTime += REPEAT_PERIOD * 100;
+			output_flush();
+		}
+		sysTickTime += PRESS_GAP * 100;
+		output_flush();
+	}
+	
+	result->calls	= decoderCalls;
+	result->hits	= frameCacheHits;
+	result->len		= output->len;
+	fwrite(result, sizeof(*result), 1, file);
+	fwrite(output->text, 1, output->len, file);
+	fclose(file);
+	exit(0);
+}
+
+/*!
+ * @brief Split an output into its decoded lines and its repeat records
+ * @param[out] decoded The output without the repeat records
+ * @param[out] repeats Number of repeat records, and total of their counts
+ */
+static void splitOutput(const outputText_t *text, outputText_t *decoded, uint32_t *repeats)
+{
+	uint32_t	i, end;
+	
+	
+	decoded->text	= malloc(text->len + 1);
+	decoded->len	= 0;
+	repeats[0] = repeats[1] = 0;
+	for (i = 0; i < text->len; i = end)
+	{
+		for (end = i; end < text->len && text->text[end] != '\n'; end++)
+			;
+		if (end < text->len) {
+			end++;
+		}
+		if (end - i > 15 && memcmp(text->text + i, "Repeated,Count=", 15) == 0)
+		{
+			repeats[0]++;
+			repeats[1] += atoi(text->text + i + 15);
+			continue;
+		}
+		memcpy(decoded->text + decoded->len, text->text + i, end - i);
+		decoded->len += end - i;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE			*file;
+	uint16_t		nbPulses, repeats = REPEATS, jitter = JITTER;
+	uint32_t		diff, repeatCounts[2][2];
+	passResult_t	passes[2];
+	outputText_t	decoded[2];
+	uint8_t			failed = 0;
+	int				a = 1;
+	
+	
+	for (; a + 1 < argc && argv[a][0] == '-'; a += 2)
+	{
+		if (strcmp(argv[a], "-r") == 0) {
+			repeats = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a >= argc || repeats == 0)
+	{
+		fprintf(stderr, "Usage: %s [-r <repeats>] [-j <jitter>] <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+		while (nbSentences < MAX_SENTENCES && fgets(line, sizeof(line), file) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			sentences[nbSentences] = malloc(nbPulses * sizeof(pulseLens[0]));
+			memcpy(sentences[nbSentences], pulseLens, nbPulses * sizeof(pulseLens[0]));
+			sentenceLens[nbSentences++] = nbPulses;
+		}
+		fclose(file);
+	}
+	if (nbSentences == 0)
+	{
+		fprintf(stderr, "No sentence\n");
+		return 1;
+	}
+	
+	// Without the cache, then with it
+	runPass(0, repeats, jitter, &passes[0]);
+	runPass(1, repeats, jitter, &passes[1]);
+	
+	// The decoded lines and the repeat records must be the same (see User/frame_cache.h)
+	splitOutput(&outputs[0], &decoded[0], repeatCounts[0]);
+	splitOutput(&outputs[1], &decoded[1], repeatCounts[1]);
+	for (diff = 0; diff < decoded[0].len && diff < decoded[1].len && decoded[0].text[diff] == decoded[1].text[diff]; diff++)
+		;
+	
+	printf("Presses:          %lu, %d copies each, jitter +/-%dus\n", (unsigned long)nbSentences, repeats, jitter);
+	printf("Cache hits:       %lu of %lu sentences\n", (unsigned long)passes[1].hits, (unsigned long)nbSentences * repeats);
+	printf("Decoder calls:    %lu without the cache, %lu with it\n", (unsigned long)passes[0].calls, (unsigned long)passes[1].calls);
+	printf("Decoding time:    %.0f ns/sentence without the cache, %.0f ns/sentence with it (x%.2f)\n",
+		passes[0].time / (nbSentences * repeats), passes[1].time / (nbSentences * repeats), passes[0].time / passes[1].time);
+	printf("Repeat records:   %lu (%lu repeats) without the cache, %lu (%lu repeats) with it\n",
+		(unsigned long)repeatCounts[0][0], (unsigned long)repeatCounts[0][1],
+		(unsigned long)repeatCounts[1][0], (unsigned long)repeatCounts[1][1]);
+	if (repeatCounts[0][0] != repeatCounts[1][0] || repeatCounts[0][1] != repeatCounts[1][1])
+	{
+		printf("Repeat records:   differ\n");
+		failed = 1;
+	}
+	if (diff == decoded[0].len && diff == decoded[1].len)
+	{
+		printf("Decoded lines:    identical (%lu bytes)\n", (unsigned long)decoded[0].len);
+	}
+	else
+	{
+		printf("Decoded lines:    differ from byte %lu\n", (unsigned long)diff);
+		failed = 1;
+	}
+	return (jitter == 0 ? failed : 0);
+}
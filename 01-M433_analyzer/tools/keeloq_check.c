@@ -0,0 +1,357 @@
+/*******************************************************************************
+ * KEELOQ PARSING AND TRACKING CHECK                                           *
+ *******************************************************************************
+ * Host tool: checks the KeeLoq frame parsing and the fob table (see
+ * User/decoders/keeloq.h), and times them.
+ *
+ * keeloq.c is built in this tool with TEST_MANUFACTURER_KEY as
+ * KEELOQ_MANUFACTURER_KEY, so that the decryption is checked as well:
+ * 	- cipher:		keeloq_decrypt() on the published test vector, and on random
+ * 					words encrypted by the reference encryption below,
+ * 	- fields:		random frames of 64, 65 and 66 bits, built as the PWM engine
+ * 					does (LSB first), must give back their hopping code, serial,
+ * 					buttons, status bits, counter and check; a frame whose
+ * 					clear buttons differ from the encrypted ones is not valid,
+ * 	- eviction:		KEELOQ_FOB_MAX_PROBES + 1 fobs with the same hash slot: the
+ * 					last one replaces the fob seen the longest time ago, and the
+ * 					others keep their presses,
+ * 	- presses:		repeated frames within KEELOQ_PRESS_WINDOW are counted but
+ * 					not reported, and the same code is a new press past it,
+ * 	- counter gap:	gaps of 1 and 3, and a gap across the 16-bit wrap.
+ * The benchmark then parses and tracks random presses of BENCH_FOBS fobs (4
+ * frames each, several times the size of the table): there must be exactly one
+ * record per press.
+ *
+ * Build (from 01-M433_analyzer; this tool includes User/decoders/keeloq.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o keeloq_check tools/keeloq_check.c
+ * Usage:	keeloq_check [-n <frames>] [-s <seed>]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+
+// defines.h has been included: the key is not undefined again by keeloq.c
+#define TEST_MANUFACTURER_KEY		0x0123456789ABCDEFULL
+#undef KEELOQ_MANUFACTURER_KEY
+#define KEELOQ_MANUFACTURER_KEY		TEST_MANUFACTURER_KEY
+
+#include "keeloq.c"
+
+//! Published test vector
+#define VECTOR_KEY			0x5CEC6701B79FD949ULL
+#define VECTOR_PLAIN		0xF741E2DB
+#define VECTOR_CIPHER		0xE44F4CDF
+
+#define NB_CIPHER_CHECKS	1000
+#define BENCH_FOBS			100
+#define BENCH_FRAMES		4			// Frames per press
+#define FRAME_TICKS			10000		// 100ms between frames, in systick units
+
+volatile uint32_t	sysTickTime = 0;
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void check(uint32_t got, uint32_t expected, const char *what)
+{
+	nbChecks++;
+	if (got != expected && nbErrors++ < 10) {
+		printf("%s: 0x%08lX, expected 0x%08lX\n", what, (unsigned long)got, (unsigned long)expected);
+	}
+}
+
+/*!
+ * @brief Reference encryption, the inverse of keeloq_decrypt()
+ */
+static uint32_t encrypt(uint32_t data, uint64_t key)
+{
+	uint16_t	r;
+	
+	
+	for (r = 0; r < KEELOQ_ROUNDS; r++)
+	{
+		data = (data >> 1) | ((BIT(data, 0) ^ BIT(data, 16) ^ (uint32_t)BIT(key, r & 63) ^
+			BIT(KEELOQ_NLF, NLF_INDEX(data, 1, 9, 20, 26, 31))) << 31);
+	}
+	return data;
+}
+
+/*!
+ * @brief Hopping code of a press, encrypted with the device key of the fob
+ */
+static uint32_t hopCode(uint32_t serial, uint8_t buttons, uint16_t counter)
+{
+	return encrypt(((uint32_t)buttons << BUTTONS_SHIFT) | ((serial & 0x3FF) << DISC_SHIFT) | counter,
+		keeloq_deviceKey(serial));
+}
+
+/*!
+ * @brief Frame of nbBits (64 to 66) bits, each field sent LSB first
+ */
+static void buildFrame(bitvec_t *bits, uint16_t nbBits, uint32_t hop, uint32_t serial, uint8_t buttons,
+	uint8_t lowBattery, uint8_t repeat)
+{
+	uint8_t		i;
+	
+	
+	bitvec_reset(bits);
+	for (i = 0; i < 32; i++) {
+		bitvec_append(bits, (hop >> i) & 1);
+	}
+	for (i = 0; i < 28; i++) {
+		bitvec_append(bits, (serial >> i) & 1);
+	}
+	for (i = 0; i < 4; i++) {
+		bitvec_append(bits, (buttons >> i) & 1);
+	}
+	if (nbBits > 64) {
+		bitvec_append(bits, lowBattery);
+	}
+	if (nbBits > 65) {
+		bitvec_append(bits, repeat);
+	}
+	bitvec_finish(bits);
+}
+
+static void checkCipher(void)
+{
+	uint32_t	plain;
+	uint64_t	key;
+	uint16_t	n;
+	
+	
+	check(keeloq_decrypt(VECTOR_CIPHER, VECTOR_KEY), VECTOR_PLAIN, "Test vector decryption");
+	check(encrypt(VECTOR_PLAIN, VECTOR_KEY), VECTOR_CIPHER, "Test vector encryption");
+	for (n = 0; n < NB_CIPHER_CHECKS; n++)
+	{
+		plain = random32();
+		key = ((uint64_t)random32() << 32) | random32();
+		check(keeloq_decrypt(encrypt(plain, key), key), plain, "Round trip");
+	}
+}
+
+static void checkFields(uint32_t nbFrames)
+{
+	bitvec_t		bits;
+	keeloqFrame_t	frame;
+	uint32_t		n, serial;
+	uint16_t		nbBits, counter;
+	uint8_t			buttons, lowBattery, repeat, wrongButtons;
+	
+	
+	for (n = 0; n < nbFrames; n++)
+	{
+		nbBits		= KEELOQ_MIN_BITS + n % (KEELOQ_MAX_BITS - KEELOQ_MIN_BITS + 1);
+		serial		= random32() & 0x0FFFFFFF;
+		buttons		= rand() & 0xF;
+		counter		= rand();
+		lowBattery	= rand() & 1;
+		repeat		= rand() & 1;
+		wrongButtons = (n % 8 == 0);
+		buildFrame(&bits, nbBits, hopCode(serial, buttons ^ wrongButtons, counter), serial, buttons, lowBattery, repeat);
+	
+		keeloq_parse(&bits, &frame);
+		check(frame.serial, serial, "Serial");
+		check(frame.buttons, buttons, "Buttons");
+		check(frame.lowBattery, nbBits > 64 ? lowBattery : 0, "Low battery");
+		check(frame.repeat, nbBits > 65 ? repeat : 0, "Repeat");
+		check(frame.decrypted, 1, "Decrypted");
+		check(frame.counter, counter, "Counter");
+		check(frame.valid, !wrongButtons, "Valid");
+		check(frame.hop, hopCode(serial, buttons ^ wrongButtons, counter), "Hop");
+	}
+}
+
+/*!
+ * @brief Track a frame of a fob at a given time
+ * @return Its fob entry if it starts a press, NULL otherwise
+ */
+static keeloqFob_t *trackFrame(uint32_t serial, uint16_t counter, uint32_t time)
+{
+	keeloqFrame_t	frame;
+	
+	
+	memset(&frame, 0, sizeof(frame));
+	frame.serial	= serial;
+	frame.hop		= hopCode(serial, 1, counter);
+	frame.decrypted	= 1;
+	frame.counter	= counter;
+	frame.valid		= 1;
+	sysTickTime		= time;
+	return keeloq_track(&frame);
+}
+
+static void checkTracking(void)
+{
+	uint32_t	serials[KEELOQ_FOB_MAX_PROBES + 1], serial, time = 1;
+	uint8_t		nbSerials = 0, i;
+	keeloqFob_t	*fob;
+	
+	
+	// Fobs with the same hash slot
+	memset(fobs, 0, sizeof(fobs));
+	for (serial = 1; nbSerials < KEELOQ_FOB_MAX_PROBES + 1; serial++)
+	{
+		if (HASH_SLOT(serial) == HASH_SLOT(1)) {
+			serials[nbSerials++] = serial;
+		}
+	}
+	
+	// Eviction: fob 2 is seen the longest time ago once the others have pressed again
+	for (i = 0; i < KEELOQ_FOB_MAX_PROBES; i++) {
+		check(trackFrame(serials[i], 100, time++) != NULL, 1, "First press");
+	}
+	for (i = 0; i < KEELOQ_FOB_MAX_PROBES; i++)
+	{
+		if (i != 2) {
+			check(trackFrame(serials[i], 101, time++) != NULL, 1, "Second press");
+		}
+	}
+	fob = trackFrame(serials[KEELOQ_FOB_MAX_PROBES], 100, time++);
+	check(fob == &fobs[(HASH_SLOT(serials[0]) + 2) & (FOB_TABLE_SIZE - 1)], 1, "Evicted slot");
+	for (i = 0; i < KEELOQ_FOB_MAX_PROBES; i++)
+	{
+		if (i != 2)
+		{
+			fob = trackFrame(serials[i], 102, time++);
+			check(fob != NULL ? fob->presses : 0, 3, "Presses kept");
+		}
+	}
+	fob = trackFrame(serials[2], 102, time++);
+	check(fob != NULL ? fob->presses : 0, 1, "Evicted fob");
+	
+	// Presses: the same code is a repeat within the window, a new press past it
+	memset(fobs, 0, sizeof(fobs));
+	time = 1;
+	trackFrame(serials[0], 200, time);
+	check(trackFrame(serials[0], 200, time + WINDOW_TICKS / 2) == NULL, 1, "Repeat");
+	fob = trackFrame(serials[0], 200, time + WINDOW_TICKS / 2 + 1);
+	check(fob == NULL ? fobs[HASH_SLOT(serials[0])].frames : 0, 3, "Frames of a press");
+	fob = trackFrame(serials[0], 200, time + 2 * WINDOW_TICKS);
+	check(fob != NULL ? fob->presses : 0, 2, "Press past the window");
+	
+	// Counter gaps, and across the 16-bit wrap
+	memset(fobs, 0, sizeof(fobs));
+	trackFrame(serials[0], 0xFFF0, time++);
+	fob = trackFrame(serials[0], 0xFFF1, time++);
+	check(fob != NULL ? fob->gap : 0, 1, "Gap of 1");
+	fob = trackFrame(serials[0], 0xFFF4, time++);
+	check(fob != NULL ? fob->gap : 0, 3, "Gap of 3");
+	fob = trackFrame(serials[0], 0x0002, time++);
+	check(fob != NULL ? fob->gap : 0, 14, "Gap across the wrap");
+	check(fob != NULL ? fob->maxGap : 0, 14, "Max gap");
+	check(fob != NULL ? fob->counter : 0, 2, "Counter");
+	fob = trackFrame(serials[0], 0x0003, time++);
+	check(fob != NULL ? fob->maxGap : 0, 14, "Max gap kept");
+}
+
+/*!
+ * @brief Parse and track random presses
+ */
+static void bench(uint32_t nbFrames)
+{
+	static bitvec_t	frames[BENCH_FOBS * BENCH_FRAMES];
+	uint32_t		serials[BENCH_FOBS], n, nbPresses = 0, nbRecords = 0, time = 1;
+	uint16_t		counters[BENCH_FOBS], f, i;
+	keeloqFrame_t	frame;
+	double			parseTime = 0, trackTime = 0, t0;
+	
+	
+	memset(fobs, 0, sizeof(fobs));
+	for (f = 0; f < BENCH_FOBS; f++)
+	{
+		serials[f]	= random32() & 0x0FFFFFFF;
+		counters[f]	= rand();
+	}
+	
+	// Presses of random fobs, some of them missed
+	for (n = 0; n < nbFrames; n += BENCH_FRAMES)
+	{
+		f = rand() % BENCH_FOBS;
+		counters[f] += 1 + (rand() % 4 == 0);
+		buildFrame(&frames[0], KEELOQ_MAX_BITS, hopCode(serials[f], 1, counters[f]), serials[f], 1, 0, 0);
+		nbPresses++;
+		for (i = 0; i < BENCH_FRAMES; i++)
+		{
+			t0 = now();
+			keeloq_parse(&frames[0], &frame);
+			parseTime += now() - t0;
+			sysTickTime = time;
+			time += FRAME_TICKS;
+			t0 = now();
+			nbRecords += (keeloq_track(&frame) != NULL);
+			trackTime += now() - t0;
+		}
+		time += 2 * WINDOW_TICKS;
+	}
+	
+	printf("%lu frames of %d fobs, %d frames per press (%d entries in the table)\n", (unsigned long)nbFrames, BENCH_FOBS,
+		BENCH_FRAMES, FOB_TABLE_SIZE);
+	printf("Presses: %lu, records: %lu\n", (unsigned long)nbPresses, (unsigned long)nbRecords);
+	printf("Host time per frame: parse %.2f us (with decryption), track %.3f us\n", parseTime / (1000.0 * nbPresses * BENCH_FRAMES),
+		trackTime / (1000.0 * nbPresses * BENCH_FRAMES));
+	check(nbRecords, nbPresses, "Records");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t		nbFrames = 100000;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	checkCipher();
+	checkFields(nbFrames);
+	checkTracking();
+	bench(nbFrames);
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
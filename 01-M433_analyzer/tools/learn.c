@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * PROTOCOL LEARNER                                                            *
+ *******************************************************************************
+ * Host tool: runs the learner (User/decoders/learner.h) over capture files,
+ * and prints the same reports as the analyzer.
+ *
+ * Build:	gcc -O2 -IUser -IUser/decoders -o learn tools/learn.c User/decoders/learner.c
+ * Usage:	learn <capture> [...]
+ *
+ * A capture holds one sentence per line: its pulse lens in us, separated by
+ * commas, the first one being a high pulse. A leading word is skipped, and 0
+ * ends the sentence, so the "Raw,..." lines dumped by the analyzer can be used
+ * as is.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "learner.h"
+
+#define MAX_NUM_PULSES		1024
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+
+static char		line[MAX_LINE_LEN];
+static char		report[1024];
+static uint16_t	pulseLens[MAX_NUM_PULSES];
+
+
+/*!
+ * @brief Parse the pulse lens of a sentence
+ * @return Number of pulses
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	// Skip the leading word
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+int main(int argc, char **argv)
+{
+	FILE			*in;
+	int				a;
+	uint16_t		nbPulses;
+	uint32_t		nbSentences = 0, nbLearned = 0, nbNew = 0;
+	learnerResult_t	result;
+	
+	
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (a = 1; a < argc; a++)
+	{
+		if ((in = fopen(argv[a], "r")) == NULL)
+		{
+			fprintf(stderr, "cannot open %s\n", argv[a]);
+			return 1;
+		}
+	
+		while (fgets(line, sizeof(line), in) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			nbSentences++;
+	
+			if (learner_learn(pulseLens, nbPulses, &result))
+			{
+				nbLearned++;
+				nbNew += result.isNew;
+				learner_format(&result, report, sizeof(report));
+				fputs(report, stdout);
+			}
+		}
+		fclose(in);
+	}
+	
+	fprintf(stderr, "%lu sentences, %lu learned, %lu protocols\n",
+		(unsigned long)nbSentences, (unsigned long)nbLearned, (unsigned long)nbNew);
+	return 0;
+}
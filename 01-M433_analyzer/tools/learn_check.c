@@ -0,0 +1,388 @@
+/*******************************************************************************
+ * PROTOCOL LEARNER CHECK                                                      *
+ *******************************************************************************
+ * Host tool: checks the learner (see User/decoders/learner.h) on synthetic
+ * captures, and the descriptors it emits through the protocol store (see
+ * User/decoders/protocol_store.h).
+ *
+ * A capture holds sentences of three PWM protocols and of noise, in turn:
+ * 	- RCS350:	rcswitch protocol 1 (350 us, sync 1+31), 24 bits,
+ * 	- RCS650:	rcswitch protocol 2 (650 us, sync 1+10), 24 bits,
+ * 	- X10:		32 bits after a 8800+4400 us sync, each frame followed by a
+ * 				40 ms gap (the last one of every other sentence is left out),
+ * 	- noise:	random pulses of 100 to 6000 us.
+ * Each sentence has its own clock offset (within +/-10 %), and each pulse is
+ * moved by up to +/-8 %. Two captures are built from different seeds. Checked:
+ * 	- capture 1 is learned: every protocol sentence is learned with the bits
+ * 	  of its frame, three protocols are new, and no noise sentence is learned,
+ * 	- capture 2 gives the same signatures, protocol by protocol, for at least
+ * 	  MIN_SAME_SIGNATURE % of the sentences: a sentence whose timing ratio
+ * 	  falls on the other side of a rounding boundary of the signature gets
+ * 	  another one (the learner still counts it in the entry of its device),
+ * 	- the descriptors learned on capture 1, loaded by the protocol store,
+ * 	  decode the frames of capture 2.
+ * The time the learner takes per sentence is printed.
+ *
+ * Build (from 01-M433_analyzer):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders -IUser/esp8266 \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o learn_check tools/learn_check.c User/decoders/learner.c \
+ * 			User/decoders/protocol_store.c User/decoders/generic_pwm.c \
+ * 			User/decoders/combine.c User/decoders/record.c User/decoders/budget.c
+ * Usage:	learn_check [-n <sentences per protocol>] [-s <seed>]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "learner.h"
+#include "protocol_store.h"
+#include "record.h"
+
+#define X10_SYNC_HIGH		8800	// us
+#define X10_SYNC_LOW		4400
+#define X10_SHORT			550
+#define X10_LONG			1650
+#define X10_GAP				40000
+#define X10_REPEATS			5
+
+#define RCS_REPEATS			4
+
+#define JITTER				8		// % of each pulse
+#define CLOCK_OFFSET		10		// % of each sentence
+
+#define NOISE_MIN_LEN		100
+#define NOISE_MAX_LEN		6000
+
+//! Sentences of capture 2 with the signature of capture 1, at least (%)
+#define MIN_SAME_SIGNATURE	97
+
+#define MAX_SENTENCE_LEN	(X10_REPEATS * (2 + 2 * 32 + 2))
+
+//! Kinds of sentences of a capture
+enum { KIND_RCS350, KIND_RCS650, KIND_X10, KIND_NOISE, NB_KINDS };
+#define NB_PROTOCOLS		KIND_NOISE
+
+static const char * const	kindNames[NB_KINDS] = { "RCS350", "RCS650", "X10", "Noise" };
+
+//! Sentence of a capture
+typedef struct {
+	uint8_t		kind;
+	uint8_t		nbBits;
+	uint32_t	data;					// MSB first
+	uint16_t	nbPulses;
+	uint16_t	pulseLens[MAX_SENTENCE_LEN];
+} sentence_t;
+
+// Stubs of the target modules used by the protocol store
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+// The image is loaded from memory: the flash is never written
+void FLASH_Unlock(void)
+{
+}
+
+void FLASH_Lock(void)
+{
+}
+
+void FLASH_ClearFlag(uint32_t FLASH_FLAG)
+{
+	(void)FLASH_FLAG;
+}
+
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange)
+{
+	(void)FLASH_Sector;
+	(void)VoltageRange;
+	return FLASH_ERROR_OPERATION;
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+	(void)Address;
+	(void)Data;
+	return FLASH_ERROR_OPERATION;
+}
+
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	(void)message;
+	(void)len;
+	return 1;
+}
+
+//! Text printed by the protocol store
+static char			printed[4096];
+static uint16_t		printedLen;
+
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	
+	
+	if (printedLen + len < sizeof(printed))
+	{
+		memcpy(printed + printedLen, message, len + 1);
+		printedLen += len;
+	}
+}
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+static void addPulse(sentence_t *s, uint32_t len)
+{
+	if (s->nbPulses < MAX_SENTENCE_LEN) {
+		s->pulseLens[s->nbPulses++] = len;
+	}
+}
+
+/*!
+ * @brief rcswitch frames: 24 pairs (0: 1+3, 1: 3+1) then the sync, in units
+ */
+static void buildRcswitch(sentence_t *s, uint16_t unit, uint8_t syncUnits)
+{
+	uint8_t	r, i, bit;
+	
+	
+	s->nbBits	= 24;
+	s->data		= rand() & 0xFFFFFF;
+	addPulse(s, unit);
+	addPulse(s, syncUnits * unit);
+	for (r = 0; r < RCS_REPEATS; r++)
+	{
+		for (i = 0; i < 24; i++)
+		{
+			bit = (s->data >> (23 - i)) & 1;
+			addPulse(s, (bit ? 3 : 1) * unit);
+			addPulse(s, (bit ? 1 : 3) * unit);
+		}
+		addPulse(s, unit);
+		addPulse(s, syncUnits * unit);
+	}
+}
+
+static void buildX10(sentence_t *s, uint8_t lastGap)
+{
+	uint8_t	r, i;
+	
+	
+	s->nbBits	= 32;
+	s->data		= ((uint32_t)rand() << 16) ^ rand();
+	for (r = 0; r < X10_REPEATS; r++)
+	{
+		addPulse(s, X10_SYNC_HIGH);
+		addPulse(s, X10_SYNC_LOW);
+		for (i = 0; i < 32; i++)
+		{
+			addPulse(s, X10_SHORT);
+			addPulse(s, ((s->data >> (31 - i)) & 1) ? X10_LONG : X10_SHORT);
+		}
+		addPulse(s, X10_SHORT);
+		if (r + 1 < X10_REPEATS || lastGap) {
+			addPulse(s, X10_GAP);
+		}
+	}
+}
+
+static void buildNoise(sentence_t *s)
+{
+	uint16_t	n = 40 + rand() % 260;
+	
+	
+	s->nbBits = 0;
+	s->data = 0;
+	while (n--) {
+		addPulse(s, NOISE_MIN_LEN + rand() % (NOISE_MAX_LEN - NOISE_MIN_LEN));
+	}
+}
+
+/*!
+ * @brief Random sentence of a kind, with its clock offset and jitter
+ */
+static void buildSentence(sentence_t *s, uint8_t kind, uint32_t n)
+{
+	int32_t		offset = 100 - CLOCK_OFFSET + rand() % (2 * CLOCK_OFFSET + 1), len;
+	uint16_t	i;
+	
+	
+	s->kind = kind;
+	s->nbPulses = 0;
+	switch (kind)
+	{
+		case KIND_RCS350:	buildRcswitch(s, 350, 31);	break;
+		case KIND_RCS650:	buildRcswitch(s, 650, 10);	break;
+		case KIND_X10:		buildX10(s, n & 1);			break;
+		default:			buildNoise(s);				break;
+	}
+	
+	for (i = 0; i < s->nbPulses; i++)
+	{
+		len = (int32_t)s->pulseLens[i] * offset / 100;
+		len += len * (rand() % (2 * JITTER + 1) - JITTER) / 100;
+		s->pulseLens[i] = (len > 0xFFFF ? 0xFFFF : len);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static sentence_t	s;
+	static uint8_t		image[sizeof(protoStoreHeader_t) + PROTO_STORE_MAX_DESCS * sizeof(protoDesc_t)];
+	protoStoreHeader_t	*header = (protoStoreHeader_t *)image;
+	protoDesc_t			*descs = (protoDesc_t *)(header + 1);
+	learnerResult_t		result;
+	learnerShape_t		shape;
+	uint32_t			nbSentences = 50, n, learned[NB_KINDS] = { 0 }, sameSig[NB_KINDS] = { 0 }, decoded[NB_KINDS] = { 0 };
+	uint32_t			signatures[NB_PROTOCOLS] = { 0 }, data[2], nbNew = 0, nbLearned = 0;
+	uint8_t				kind, isLearned;
+	unsigned int		seed = 1;
+	double				learnTime = 0, t0;
+	char				label[80], expected[64];
+	int					a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbSentences = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbSentences == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <sentences per protocol>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	// Capture 1: learned, the new protocols described
+	srand(seed);
+	memset(header, 0, sizeof(*header));
+	for (n = 0; n < NB_KINDS * nbSentences; n++)
+	{
+		kind = n % NB_KINDS;
+		buildSentence(&s, kind, n / NB_KINDS);
+	
+		t0 = now();
+		isLearned = learner_learn(s.pulseLens, s.nbPulses, &result);
+		learnTime += now() - t0;
+		if (!isLearned) {
+			continue;
+		}
+		nbLearned++;
+		if (kind == KIND_NOISE)
+		{
+			learned[kind]++;
+			continue;
+		}
+	
+		learned[kind] += (result.nbBits == s.nbBits && result.data[0] == s.data << (32 - s.nbBits));
+		if (result.isNew)
+		{
+			nbNew++;
+			if (signatures[kind] == 0) {
+				signatures[kind] = result.entry->shape.signature;
+			}
+			if (header->nbDescs < PROTO_STORE_MAX_DESCS) {
+				learner_describe(&result.entry->shape, &descs[header->nbDescs++]);
+			}
+		}
+		sameSig[kind] += (result.entry->shape.signature == signatures[kind]);
+	}
+	
+	printf("Capture 1: %lu sentences, %lu learned, %lu protocols, %.2f us per sentence on the host\n",
+		(unsigned long)(NB_KINDS * nbSentences), (unsigned long)nbLearned, (unsigned long)nbNew, learnTime / (1000.0 * NB_KINDS * nbSentences));
+	check(nbNew == NB_PROTOCOLS, "Capture 1: three protocols learned");
+	check(learned[KIND_NOISE] == 0, "Capture 1: no noise sentence learned");
+	for (kind = 0; kind < NB_PROTOCOLS; kind++)
+	{
+		printf("  %-7s %3lu/%lu learned with their bits, signature %08lX\n", kindNames[kind], (unsigned long)learned[kind],
+			(unsigned long)nbSentences, (unsigned long)signatures[kind]);
+		snprintf(label, sizeof(label), "Capture 1: %s sentences learned with their bits", kindNames[kind]);
+		check(learned[kind] == nbSentences, label);
+		snprintf(label, sizeof(label), "Capture 1: %s signature stable", kindNames[kind]);
+		check(sameSig[kind] == nbSentences, label);
+	}
+	
+	// The descriptors, as uploaded
+	header->magic	= PROTO_STORE_MAGIC;
+	header->version	= PROTO_STORE_VERSION;
+	header->crc		= proto_crc32(descs, header->nbDescs * sizeof(protoDesc_t));
+	check(protoStore_loadImage(image, sizeof(image), NULL, 0) == header->nbDescs && header->nbDescs == NB_PROTOCOLS,
+		"Learned descriptors loaded");
+	
+	// Capture 2: the same signatures, and the frames decoded by the descriptors
+	srand(seed + 1);
+	memset(learned, 0, sizeof(learned));
+	memset(sameSig, 0, sizeof(sameSig));
+	for (n = 0; n < NB_KINDS * nbSentences; n++)
+	{
+		kind = n % NB_KINDS;
+		buildSentence(&s, kind, n / NB_KINDS);
+	
+		isLearned = learner_analyze(s.pulseLens, s.nbPulses, &shape, data);
+		learned[kind] += isLearned;
+		if (kind == KIND_NOISE) {
+			continue;
+		}
+		sameSig[kind] += (isLearned && shape.signature == signatures[kind]);
+	
+		printedLen = 0;
+		printed[0] = '\0';
+		protoStore_decode(s.pulseLens, s.nbPulses);
+		record_poll();
+		snprintf(expected, sizeof(expected), "L%06lX,%db,0x%08lX\n", (unsigned long)(signatures[kind] & 0xFFFFFF), s.nbBits,
+			(unsigned long)(s.data << (32 - s.nbBits)));
+		decoded[kind] += (strcmp(printed, expected) == 0);
+	}
+	
+	printf("Capture 2: same signature / decoded by the learned descriptors\n");
+	check(learned[KIND_NOISE] == 0, "Capture 2: no noise sentence learned");
+	for (kind = 0; kind < NB_PROTOCOLS; kind++)
+	{
+		printf("  %-7s %3lu/%lu  %3lu/%lu\n", kindNames[kind], (unsigned long)sameSig[kind], (unsigned long)nbSentences,
+			(unsigned long)decoded[kind], (unsigned long)nbSentences);
+		snprintf(label, sizeof(label), "Capture 2: %s signature as in capture 1", kindNames[kind]);
+		check(100 * sameSig[kind] >= MIN_SAME_SIGNATURE * nbSentences, label);
+		snprintf(label, sizeof(label), "Capture 2: %s frames decoded by the learned descriptor", kindNames[kind]);
+		check(decoded[kind] == nbSentences, label);
+	}
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
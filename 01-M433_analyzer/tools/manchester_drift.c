@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * MANCHESTER CLOCK DRIFT CORPUS                                               *
+ *******************************************************************************
+ * Host tool: measures how well the Manchester engine (see
+ * User/decoders/generic_manchester.h) follows a drifting transmitter clock,
+ * against the decoder it replaced.
+ *
+ * Random Oregon frames are generated (see tools/oregon_frames.c) for each
+ * drift rate: the half-bit period changes by RATE ppm at each pulse, faster or
+ * slower at random, and each pulse is moved by up to +/-JITTER us. Each
+ * sentence is decoded by:
+ * 	- the former OregonV2 decoder (see tools/oregon_legacy.c): fixed short/long
+ * 	  limits, V2.1 only,
+ * 	- the current OregonV2 decoder, on the Manchester engine, for V2.1 and V3.
+ * A frame counts as decoded if the data (former decoder) or the printed line
+ * (current decoder) is the one sent. The decoding times are the host's.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/oregon_legacy.c and tools/oregon_frames.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o manchester_drift tools/manchester_drift.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	manchester_drift [-n <frames>] [-j <jitter>] [-s <seed>]
+ *
+ * Prints a table of the decoded frames for each drift rate. Exits with 1 if the
+ * current decoder misses a frame without drift, or decodes fewer V2.1 frames
+ * than the former one at any rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "record.h"
+
+#include "oregon_legacy.c"
+#include "oregon_frames.c"
+
+#define MAX_SENTENCE_LEN	512
+
+//! Drift rates evaluated, in ppm of the half-bit period per pulse
+static const uint16_t	rates[] = { 0, 250, 500, 1000, 1500, 2000, 3000 };
+#define NB_RATES			(sizeof(rates) / sizeof(rates[0]))
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Line printed by the current decoder
+static char			printed[BUFFER_LEN];
+
+void output_send(char *message)
+{
+	strncpy(printed, message, BUFFER_LEN - 1);
+}
+
+static uint16_t		pulseLens[MAX_SENTENCE_LEN], work[MAX_SENTENCE_LEN];
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Decode a sentence with the current decoder
+ * @return 1 if it printed the line of the frame
+ */
+static uint8_t currentDecodes(const oregonFrame_t *frame, uint16_t nbPulses, double *time)
+{
+	double		t0;
+	
+	
+	memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+	printed[0] = '\0';
+	t0 = now();
+	if (nbPulses > decoder_OregonV2.minNumPulses) {
+		decoder_OregonV2.decoderFunc(work, nbPulses);
+	}
+	*time += now() - t0;
+	record_poll();
+	return strcmp(printed, frame->line) == 0;
+}
+
+/*!
+ * @brief Decode a sentence with the former decoder
+ * @return 1 if it decoded the data of the frame
+ */
+static uint8_t legacyDecodes(const oregonFrame_t *frame, uint16_t nbPulses, double *time)
+{
+	double		t0;
+	uint16_t	nbBits = 0;
+	
+	
+	t0 = now();
+	if (nbPulses > decoder_OregonV2.minNumPulses) {
+		nbBits = legacy_decode_oregon(pulseLens, nbPulses);
+	}
+	*time += now() - t0;
+	return nbBits > 0 && oregonFrame_legacyMatches(frame);
+}
+
+int main(int argc, char **argv)
+{
+	oregonFrame_t	frame;
+	uint32_t		nbFrames = 20000, n, counts[3];
+	uint16_t		nbPulses, jitter = 40;
+	uint8_t			r, failed = 0;
+	unsigned int	seed = 1;
+	int32_t			drift;
+	double			times[2] = { 0, 0 };
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	printf("%lu frames per rate, jitter +/-%d us\n", (unsigned long)nbFrames, jitter);
+	printf("Drift (ppm/pulse) | V2.1 former  V2.1 current  V3 current\n");
+	for (r = 0; r < NB_RATES; r++)
+	{
+		memset(counts, 0, sizeof(counts));
+		for (n = 0; n < nbFrames; n++)
+		{
+			drift = (rand() & 1) ? rates[r] : -(int32_t)rates[r];
+	
+			oregonFrame_random(&frame, 2);
+			nbPulses = oregonFrame_sentence(&frame, drift, jitter, pulseLens);
+			counts[0] += legacyDecodes(&frame, nbPulses, &times[0]);
+			counts[1] += currentDecodes(&frame, nbPulses, &times[1]);
+	
+			oregonFrame_random(&frame, 3);
+			nbPulses = oregonFrame_sentence(&frame, drift, jitter, pulseLens);
+			counts[2] += currentDecodes(&frame, nbPulses, &times[1]);
+		}
+	
+		printf("%17d | %10.2f%% %12.2f%% %10.2f%%\n", rates[r],
+			100.0 * counts[0] / nbFrames, 100.0 * counts[1] / nbFrames, 100.0 * counts[2] / nbFrames);
+		if ((rates[r] == 0 && (counts[1] != nbFrames || counts[2] != nbFrames)) || counts[1] < counts[0]) {
+			failed = 1;
+		}
+	}
+	printf("Host time: %.2f us former (V2.1), %.2f us current (V2.1 and V3) per sentence\n",
+		times[0] / (1000.0 * NB_RATES * nbFrames), times[1] / (2000.0 * NB_RATES * nbFrames));
+	
+	if (failed)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
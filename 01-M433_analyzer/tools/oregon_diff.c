@@ -0,0 +1,359 @@
+/*******************************************************************************
+ * OREGON DIFFERENTIAL CHECK                                                   *
+ *******************************************************************************
+ * Host tool: checks the one-pass OregonV2 decoder (see
+ * User/decoders/oregon_v2.c) against the decoder it replaced (see
+ * tools/oregon_legacy.c), and times both.
+ *
+ * Synthetic sentences (see tools/oregon_frames.c), each pulse moved by up to
+ * +/-JITTER us:
+ * 	- valid V2.1 frames: the line printed by the current decoder must be the
+ * 	  one of the frame, and the data left by the former decoder its bytes,
+ * 	- valid V3 frames (current decoder only),
+ * 	- the same V2.1 and V3 frames with one data pulse turned from short to long
+ * 	  or back: the checksum must reject them. A line of another reading of a
+ * 	  known sensor is wrong; a line of an unknown sensor (its raw nibbles, the
+ * 	  ID was hit and a generic checksum matched) is counted apart, and must
+ * 	  stay below MAX_UNKNOWN_SHARE of the frames,
+ * 	- noise: 300 pulses of 200 to 1200 us, no line must be printed.
+ * The former decoder is timed on the valid V2.1 frames, and the current one
+ * on the same frames, then on all the synthetic sentences.
+ * The sentences of the captures, if any, are decoded by both decoders. The
+ * bytes left by the former one are printed as the current one does if they
+ * are from a known sensor with a valid checksum (the former decoder did not
+ * check it), and the lines of known sensors compared: same, changed, lost
+ * (former decoder only) or found (current decoder only). The raw lines of
+ * unknown sensors are only counted.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/oregon_legacy.c and tools/oregon_frames.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o oregon_diff tools/oregon_diff.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	oregon_diff [-n <frames>] [-j <jitter>] [-s <seed>] [<capture> ...]
+ *
+ * Exits with 1 if a valid frame is missed or misread, if a corrupted frame or a
+ * noise sentence gives a wrong line, if too many corrupted frames give the
+ * line of an unknown sensor, or if the current decoder loses more captured
+ * sentences than it finds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "main.h"
+#include "record.h"
+
+#include "oregon_legacy.c"
+#include "oregon_frames.c"
+
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+#define NOISE_LEN			300
+#define NOISE_MIN_LEN		200		// us
+#define NOISE_MAX_LEN		1200
+
+//! Corrupted frames which may be reported as unknown sensors (1/1000)
+#define MAX_UNKNOWN_SHARE	5
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Line printed by the current decoder
+static char			printed[BUFFER_LEN];
+
+void output_send(char *message)
+{
+	snprintf(printed, sizeof(printed), "%s", message);
+}
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+
+//! Results of the synthetic sentences
+enum { CORRECT, WRONG, UNKNOWN, MISSED, NB_COUNTS };
+
+//! Host decoding times, and number of sentences timed (former, current)
+static double		times[2];
+static uint32_t		nbTimed[2];
+
+//! Host decoding time of the last sentence (current decoder)
+static double		lastTime;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode pulseLens with the current decoder
+ * @return 1 if it printed a line (in printed)
+ */
+static uint8_t currentDecode(uint16_t nbPulses)
+{
+	double		t0;
+	
+	
+	memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+	printed[0] = '\0';
+	t0 = now();
+	if (nbPulses > decoder_OregonV2.minNumPulses) {
+		decoder_OregonV2.decoderFunc(work, nbPulses);
+	}
+	lastTime = now() - t0;
+	times[1] += lastTime;
+	nbTimed[1]++;
+	record_poll();
+	return printed[0] != '\0';
+}
+
+/*!
+ * @brief Decode pulseLens with the former decoder
+ * @return Number of Manchester bits decoded (the data is in legacyOregonData)
+ */
+static uint16_t legacyDecode(uint16_t nbPulses)
+{
+	uint16_t	nbBits = 0;
+	double		t0;
+	
+	
+	t0 = now();
+	if (nbPulses > decoder_OregonV2.minNumPulses) {
+		nbBits = legacy_decode_oregon(pulseLens, nbPulses);
+	}
+	times[0] += now() - t0;
+	nbTimed[0]++;
+	return nbBits;
+}
+
+static uint8_t currentResult(const oregonFrame_t *frame, uint16_t nbPulses)
+{
+	if (!currentDecode(nbPulses)) {
+		return MISSED;
+	}
+	if (strcmp(printed, frame->line) == 0) {
+		return CORRECT;
+	}
+	return strstr(printed, ",Nibbles=") != NULL ? UNKNOWN : WRONG;
+}
+
+/*!
+ * @brief Turn a short data pulse into a long one, or a long one into a short one
+ */
+static void corruptPulse(const oregonFrame_t *frame, uint16_t nbPulses)
+{
+	uint16_t	preamble = (frame->version == 3 ? OREGON_PREAMBLE_V3 : 2 * OREGON_PREAMBLE_V2);
+	uint16_t	i;
+	
+	
+	// Past the preamble (one pulse per half bit), before the gap
+	i = preamble + rand() % (nbPulses - 1 - preamble);
+	pulseLens[i] = (pulseLens[i] < 3 * OREGON_HALF_BIT / 2) ? 2 * OREGON_HALF_BIT : OREGON_HALF_BIT;
+}
+
+/*!
+ * @brief Line of the data left by the former decoder, as the current decoder prints it
+ * @return 0 if the sensor is unknown or the checksum wrong (the former decoder did not check it)
+ */
+static uint8_t legacyLine(char *text, uint16_t len)
+{
+	uint8_t		n[OREGON_NB_NIBBLES], i, humidity = 0, checksum, sum = 0;
+	uint16_t	id, temp;
+	
+	
+	for (i = 0; i < OREGON_NB_NIBBLES; i++) {
+		n[i] = (legacyOregonData[i / 2] >> (4 * (i & 1))) & 0xF;
+	}
+	id = (legacyOregonData[0] << 8) | legacyOregonData[1];
+	if (id == 0xEA4C || id == 0xCA48) {
+		checksum = 13;
+	} else if (id == 0x1A2D || id == 0x1A3D || id == 0xFA28) {
+		checksum = 16;
+	} else {
+		return 0;
+	}
+	for (i = 1; i < checksum; i++) {
+		sum += n[i];
+	}
+	if (sum != (n[checksum] | (n[checksum + 1] << 4))) {
+		return 0;
+	}
+	
+	if (checksum == 16) {
+		humidity = 10 * n[14] + n[13];
+	}
+	temp = 100 * n[11] + 10 * n[10] + n[9];
+	snprintf(text, len, "OregonV2,Version=2,Sensor=0x%04X,Channel=%d,Temp=%c%d.%d,Humid=%d,LowBattery=%d\n",
+		id, n[5] == 4 ? 3 : n[5], n[12] ? '-' : '+', temp / 10, temp % 10, humidity, (n[8] & 0x4) ? 1 : 0);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	static uint32_t	counts[4][NB_COUNTS];
+	static const char	*names[4] = { "V2.1", "V3", "V2.1 corrupted", "V3 corrupted" };
+	oregonFrame_t	frame;
+	FILE			*file;
+	char			legacyText[OREGON_MAX_LINE_LEN];
+	uint32_t		nbFrames = 20000, n, nbNoise = 0, nbUnknown = 0, capture[4] = { 0, 0, 0, 0 };
+	uint16_t		nbPulses, jitter = 40, i;
+	double			v2Time = 0;
+	uint8_t			v, k, failed = 0, legacy;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc && argv[a][0] == '-'; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if ((a < argc && argv[a][0] == '-') || nbFrames == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter>] [-s <seed>] [<capture> ...]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	for (n = 0; n < nbFrames; n++)
+	{
+		for (v = 0; v < 2; v++)
+		{
+			oregonFrame_random(&frame, v == 0 ? 2 : 3);
+			nbPulses = oregonFrame_sentence(&frame, 0, jitter, pulseLens);
+			if (v == 0 && !(legacyDecode(nbPulses) > 0 && oregonFrame_legacyMatches(&frame))) {
+				failed = 1;
+			}
+			counts[v][currentResult(&frame, nbPulses)]++;
+			if (v == 0) {
+				v2Time += lastTime;
+			}
+	
+			corruptPulse(&frame, nbPulses);
+			counts[2 + v][currentResult(&frame, nbPulses)]++;
+		}
+	
+		for (i = 0; i < NOISE_LEN; i++) {
+			pulseLens[i] = NOISE_MIN_LEN + rand() % (NOISE_MAX_LEN - NOISE_MIN_LEN + 1);
+		}
+		nbNoise += currentDecode(NOISE_LEN);
+	}
+	
+	printf("%lu frames of each kind, jitter +/-%d us\n", (unsigned long)nbFrames, jitter);
+	printf("Frames         |  correct    wrong  unknown   missed\n");
+	for (k = 0; k < 4; k++)
+	{
+		printf("%-14s | %8lu %8lu %8lu %8lu\n", names[k], (unsigned long)counts[k][CORRECT], (unsigned long)counts[k][WRONG],
+			(unsigned long)counts[k][UNKNOWN], (unsigned long)counts[k][MISSED]);
+		if ((k < 2 && counts[k][CORRECT] != nbFrames) || counts[k][WRONG] > 0 || 1000 * counts[k][UNKNOWN] > MAX_UNKNOWN_SHARE * nbFrames) {
+			failed = 1;
+		}
+	}
+	printf("Noise sentences with a line: %lu\n", (unsigned long)nbNoise);
+	if (nbNoise > 0) {
+		failed = 1;
+	}
+	printf("Host time (valid V2.1 frames): %.2f us former, %.2f us current per sentence\n",
+		times[0] / (1000.0 * nbTimed[0]), v2Time / (1000.0 * nbFrames));
+	printf("Host time (all synthetic sentences, noise included): %.2f us current per sentence\n",
+		times[1] / (1000.0 * nbTimed[1]));
+	
+	// Captures: same, changed, lost, found
+	if (a < argc)
+	{
+		times[0] = times[1] = 0;
+		nbTimed[0] = nbTimed[1] = 0;
+		for (; a < argc; a++)
+		{
+			if ((file = fopen(argv[a], "r")) == NULL)
+			{
+				perror(argv[a]);
+				return 1;
+			}
+			while (fgets(line, sizeof(line), file) != NULL)
+			{
+				if ((nbPulses = parseSentence(line)) == 0) {
+					continue;
+				}
+				legacy = (legacyDecode(nbPulses) > 0 && legacyLine(legacyText, sizeof(legacyText)));
+				if (currentDecode(nbPulses) && strstr(printed, ",Nibbles=") != NULL)
+				{
+					nbUnknown++;
+					printed[0] = '\0';
+				}
+				if (printed[0] != '\0') {
+					capture[legacy ? (strcmp(legacyText, printed) == 0 ? 0 : 1) : 3]++;
+				} else if (legacy) {
+					capture[2]++;
+				}
+			}
+			fclose(file);
+		}
+		printf("Captured sentences: %lu same, %lu changed, %lu lost, %lu found (%lu unknown sensors, not compared)\n",
+			(unsigned long)capture[0], (unsigned long)capture[1], (unsigned long)capture[2], (unsigned long)capture[3],
+			(unsigned long)nbUnknown);
+		printf("Host time (captures): %.2f us former, %.2f us current per sentence\n",
+			times[0] / (1000.0 * nbTimed[0]), times[1] / (1000.0 * nbTimed[1]));
+		if (capture[2] > capture[3]) {
+			failed = 1;
+		}
+	}
+	
+	if (failed)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
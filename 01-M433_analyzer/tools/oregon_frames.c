@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * SYNTHETIC OREGON SENTENCES                                                  *
+ *******************************************************************************
+ * Random Oregon V2.1 and V3 frames from temperature + humidity sensors, with a
+ * valid checksum, the line the OregonV2 decoder prints for them, and their
+ * sentence (see User/decoders/oregon_v2.c for the encoding). The transmitter
+ * clock can drift along the sentence, and each pulse be moved by some jitter.
+ *
+ * Included by tools/manchester_drift.c, tools/oregon_diff.c and
+ * tools/oregon_latency.c.
+ */
+
+#define OREGON_NB_NIBBLES		18		// Temperature + humidity: checksum in nibbles 16-17
+#define OREGON_HALF_BIT			488		// us
+#define OREGON_PREAMBLE_V2		16		// bits, each one sent twice
+#define OREGON_PREAMBLE_V3		32		// bits
+#define OREGON_GAP				10000	// us, after the frame
+#define OREGON_MAX_LINE_LEN		128
+
+typedef struct {
+	uint8_t		version;
+	uint8_t		nibbles[OREGON_NB_NIBBLES];
+	char		line[OREGON_MAX_LINE_LEN];		// Printed by the decoder
+} oregonFrame_t;
+
+
+/*!
+ * @brief Random frame: a THGR228N for V2.1, a THGR810 for V3
+ */
+static void oregonFrame_random(oregonFrame_t *frame, uint8_t version)
+{
+	static const uint8_t	channels[] = { 1, 2, 4 };
+	uint8_t					*n = frame->nibbles;
+	uint16_t				id = (version == 3 ? 0xFA28 : 0x1A2D), temp;
+	uint8_t					i, sum = 0, humidity;
+	
+	
+	frame->version = version;
+	n[0] = (id >> 8) & 0xF;
+	n[1] = id >> 12;
+	n[2] = id & 0xF;
+	n[3] = (id >> 4) & 0xF;
+	n[4] = rand() & 0xF;
+	n[5] = channels[rand() % 3];
+	n[6] = rand() & 0xF;
+	n[7] = rand() & 0xF;
+	n[8] = rand() & 0x4;
+	temp = rand() % 1000;
+	n[9] = temp % 10;
+	n[10] = (temp / 10) % 10;
+	n[11] = temp / 100;
+	n[12] = (rand() & 1) ? 0x8 : 0;
+	humidity = rand() % 100;
+	n[13] = humidity % 10;
+	n[14] = humidity / 10;
+	n[15] = rand() & 0xF;
+	for (i = 1; i <= 15; i++) {
+		sum += n[i];
+	}
+	n[16] = sum & 0xF;
+	n[17] = sum >> 4;
+	
+	snprintf(frame->line, OREGON_MAX_LINE_LEN, "OregonV2,Version=%d,Sensor=0x%04X,Channel=%d,Temp=%c%d.%d,Humid=%d,LowBattery=%d\n",
+		version, id, n[5] == 4 ? 3 : n[5], n[12] ? '-' : '+', temp / 10, temp % 10, humidity, n[8] ? 1 : 0);
+}
+
+/*!
+ * @brief Sentence of a frame
+ * @param[in]	drift	Change of the half-bit period at each pulse (ppm, signed)
+ * @param[in]	jitter	Each pulse is moved by up to +/-jitter us
+ * @return Number of pulses
+ */
+static uint16_t oregonFrame_sentence(const oregonFrame_t *frame, int32_t drift, uint16_t jitter, uint16_t *pulseLens)
+{
+	uint8_t		halves[2 * 2 * (OREGON_PREAMBLE_V3 + 4 * OREGON_NB_NIBBLES)];
+	uint16_t	nbHalves = 0, nbPulses = 0, i, run;
+	uint16_t	preamble = (frame->version == 3 ? OREGON_PREAMBLE_V3 : OREGON_PREAMBLE_V2);
+	uint8_t		bit, copy, nbCopies = (frame->version == 3 ? 1 : 2);
+	double		halfBit = OREGON_HALF_BIT;
+	int32_t		len;
+	
+	
+	// Manchester bits, as half-bit levels. V2.1: each bit is followed by its inverted copy
+	for (i = 0; i < preamble + 4 * OREGON_NB_NIBBLES; i++)
+	{
+		bit = (i < preamble ? 1 : (frame->nibbles[(i - preamble) / 4] >> ((i - preamble) & 3)) & 1);
+		for (copy = 0; copy < nbCopies; copy++, bit ^= 1)
+		{
+			halves[nbHalves++] = bit;
+			halves[nbHalves++] = !bit;
+		}
+	}
+	
+	// Pulses: runs of the same level
+	for (i = 0; i < nbHalves; i += run)
+	{
+		for (run = 1; i + run < nbHalves && halves[i + run] == halves[i]; run++) {
+		}
+		len = (int32_t)(run * halfBit) + (jitter > 0 ? rand() % (2 * jitter + 1) - jitter : 0);
+		pulseLens[nbPulses++] = (uint16_t)(len > 1 ? len : 1);
+		halfBit *= 1.0 + drift / 1e6;
+	}
+	pulseLens[nbPulses++] = OREGON_GAP;
+	
+	return nbPulses;
+}
+
+#ifdef LEGACY_OREGON_DATA_LEN
+/*!
+ * @brief Check the data left by legacy_decode_oregon() (see tools/oregon_legacy.c,
+ * included before this file)
+ */
+static uint8_t oregonFrame_legacyMatches(const oregonFrame_t *frame)
+{
+	uint8_t		i;
+	
+	
+	for (i = 0; i < OREGON_NB_NIBBLES / 2; i++)
+	{
+		if (legacyOregonData[i] != (frame->nibbles[2 * i] | (frame->nibbles[2 * i + 1] << 4))) {
+			return 0;
+		}
+	}
+	return 1;
+}
+#endif
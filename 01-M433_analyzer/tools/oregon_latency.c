@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * OREGON STREAM / BATCH LATENCY                                               *
+ *******************************************************************************
+ * Host tool: compares the streaming OregonV2 decoder (see
+ * User/decoders/stream.h), fed pulse by pulse as the receiver interrupt does,
+ * with the batch decoder run on the whole sentence, in latency and memory.
+ *
+ * Synthetic V2.1 and V3 frames (see tools/oregon_frames.c), each pulse moved by
+ * up to +/-jitter us, are decoded both ways. Both must give the same result:
+ * the line of the frame, or nothing (the jitter is beyond the tolerance of the
+ * decoder, only counted). The latencies are counted from the first pulse:
+ * 	- stream:	end of the pulse which completed the frame (its checksum),
+ * 	- batch:	end of the sentence, i.e. of the gap after the frame (the edge
+ * 				which ends it queues the sentence), plus the decoding time. Only
+ * 				the host decoding time is added: the wait for the main loop,
+ * 				which depends on the other sentences, is not counted.
+ * The memory is the state of the streaming decoder and a mailbox entry,
+ * against the pulses of the sentence a batch decoder needs (a sentence slot).
+ *
+ * A frame whose levels don't alternate (the interrupt missed an edge) must be
+ * dropped by the streaming decoder, although its pulse lens are valid.
+ *
+ * Build (from 01-M433_analyzer; this tool includes User/decoders/oregon_v2.c
+ * and tools/oregon_frames.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o oregon_latency tools/oregon_latency.c \
+ * 			User/decoders/generic_manchester.c User/decoders/record.c
+ * Usage:	oregon_latency [-n <frames>] [-j <jitter>] [-s <seed>]
+ *
+ * Exits with 1 if the two ways give different results or a wrong line, if the
+ * stream reports a frame later than the batch decoder, or if a frame with a
+ * missed edge is reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "sentence_queue.h"
+
+#include "oregon_v2.c"
+#include "oregon_frames.c"
+
+//! Pulses of the checksum and of the gap, at least
+#define LAST_PULSES			10
+
+// Stubs of the target modules used by the decoder
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Line printed by the decoder
+static char			printed[BUFFER_LEN];
+
+void output_send(char *message)
+{
+	snprintf(printed, sizeof(printed), "%s", message);
+}
+
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+/*!
+ * @brief Feed the sentence to the streaming decoder, as the receiver interrupt does
+ * @param[in]	lostEdge	Index of a pulse fed with the level of the previous one (0: none)
+ * @param[out]	latency		End of the pulse which completed the frame, or of the sentence (us)
+ * @return 1 if a frame was reported (printed)
+ */
+static uint8_t streamDecode(uint16_t nbPulses, uint16_t lostEdge, uint32_t *latency)
+{
+	oregonDecoder_t	dec;
+	streamFrame_t	frame;
+	uint16_t		i;
+	uint8_t			level = 1, found = 0;
+	
+	
+	printed[0] = '\0';
+	*latency = 0;
+	reset_oregon(&dec);
+	for (i = 0; i < nbPulses && !found; i++)
+	{
+		if (i != lostEdge) {
+			level = !(i & 1);
+		}
+		*latency += pulseLens[i];
+		found = feed_oregon(&dec, pulseLens[i], level, &frame);
+	}
+	if (!found) {
+		found = flush_oregon(&dec, &frame);
+	}
+	
+	if (found)
+	{
+		report_oregon(&frame);
+		record_poll();
+	}
+	return found;
+}
+
+/*!
+ * @brief Decode the whole sentence with the batch decoder
+ * @param[out]	latency		End of the sentence (us)
+ * @param[out]	time		Host decoding time (ns)
+ * @return 1 if a line was printed
+ */
+static uint8_t batchDecode(uint16_t nbPulses, uint32_t *latency, double *time)
+{
+	uint16_t	i;
+	double		t0;
+	
+	
+	*latency = 0;
+	for (i = 0; i < nbPulses; i++) {
+		*latency += pulseLens[i];
+	}
+	
+	memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+	printed[0] = '\0';
+	t0 = now();
+	decoder_OregonV2.decoderFunc(work, nbPulses);
+	*time = now() - t0;
+	record_poll();
+	return printed[0] != '\0';
+}
+
+int main(int argc, char **argv)
+{
+	oregonFrame_t	frame;
+	uint32_t		nbFrames = 2000, n, streamLatency, batchLatency, earlier, sumPulses = 0;
+	double			sumStream[2] = { 0, 0 }, sumBatch[2] = { 0, 0 }, sumTime = 0, time;
+	uint32_t		nbVersion[2] = { 0, 0 }, maxEarlier = 0, minEarlier = 0xFFFFFFFF;
+	uint16_t		jitter = 50, nbPulses, lostEdge;
+	unsigned int	seed = 1;
+	uint32_t		nbMissed = 0;
+	uint8_t			v, dropped, streamFound, batchFound;
+	char			label[80], streamLine[BUFFER_LEN];
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0 || jitter >= OREGON_HALF_BIT / 2)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter (< %d us)>] [-s <seed>]\n", argv[0], OREGON_HALF_BIT / 2);
+		return 1;
+	}
+	srand(seed);
+	
+	for (n = 0; n < nbFrames; n++)
+	{
+		v = n & 1;
+		oregonFrame_random(&frame, v ? 3 : 2);
+		nbPulses = oregonFrame_sentence(&frame, 0, jitter, pulseLens);
+		sumPulses += nbPulses;
+	
+		streamFound = streamDecode(nbPulses, 0, &streamLatency);
+		strcpy(streamLine, printed);
+		batchFound = batchDecode(nbPulses, &batchLatency, &time);
+		sumTime += time;
+		snprintf(label, sizeof(label), "V%s frame %lu: same result", v ? "3" : "2.1", (unsigned long)n);
+		check(streamFound == batchFound && strcmp(streamLine, printed) == 0, label);
+		if (!streamFound && !batchFound)
+		{
+			// Beyond the tolerance of the decoder, both ways
+			nbMissed++;
+			continue;
+		}
+		snprintf(label, sizeof(label), "V%s frame %lu: line", v ? "3" : "2.1", (unsigned long)n);
+		check(strcmp(streamLine, frame.line) == 0, label);
+		snprintf(label, sizeof(label), "V%s frame %lu: stream not later", v ? "3" : "2.1", (unsigned long)n);
+		check(streamLatency <= batchLatency, label);
+		
+		earlier = batchLatency - streamLatency;
+		if (earlier > maxEarlier) {
+			maxEarlier = earlier;
+		}
+		if (earlier < minEarlier) {
+			minEarlier = earlier;
+		}
+		sumStream[v] += streamLatency;
+		sumBatch[v] += batchLatency;
+		nbVersion[v]++;
+	
+		// A data pulse (past the preamble, before the checksum) fed with the level of the previous one
+		lostEdge = nbPulses / 2 + rand() % (nbPulses / 2 - LAST_PULSES);
+		dropped = !streamDecode(nbPulses, lostEdge, &streamLatency);
+		snprintf(label, sizeof(label), "V%s frame %lu: missed edge at pulse %d dropped", v ? "3" : "2.1", (unsigned long)n, lostEdge);
+		check(dropped, label);
+	}
+	
+	printf("%lu frames, jitter +/-%d us, %lu missed both ways\n", (unsigned long)nbFrames, jitter, (unsigned long)nbMissed);
+	printf("Latency after the first pulse (ms): stream / batch\n");
+	for (v = 0; v < 2; v++)
+	{
+		if (nbVersion[v] > 0) {
+			printf("  V%-3s %6.1f / %6.1f\n", v ? "3" : "2.1", sumStream[v] / (1000.0 * nbVersion[v]), sumBatch[v] / (1000.0 * nbVersion[v]));
+		}
+	}
+	printf("Stream earlier by %.1f to %.1f ms, the batch decoding takes %.2f us on the host\n",
+		minEarlier / 1000.0, maxEarlier / 1000.0, sumTime / (1000.0 * nbFrames));
+	printf("Memory (bytes): stream state %d + mailbox entry %d (with a 4-byte pointer on the target),\n",
+		(int)sizeof(oregonDecoder_t), (int)(sizeof(streamFrame_t) + 4));
+	printf("                batch pulses %.0f per sentence (%d bytes), in a slot of %d\n",
+		(double)sumPulses / nbFrames, (int)(2 * sumPulses / nbFrames), (int)sizeof(((sentence_t *)0)->pulseLens));
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
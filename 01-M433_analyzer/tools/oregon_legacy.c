@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * OREGON V2 DECODER BEFORE THE MANCHESTER ENGINE                              *
+ *******************************************************************************
+ * The Oregon V2.1 decoder replaced by the Manchester engine (see
+ * User/decoders/generic_manchester.h), as it was just before it: the jcw pulse
+ * state machine, with fixed short/long limits. It is the reference of
+ * tools/manchester_drift.c and tools/oregon_diff.c, which include this file.
+ *
+ * The state machine is unchanged, apart from the names (prefixed with legacy_)
+ * and the data buffer, unsigned: the signed char was sign extended when the
+ * data was printed. The print buffer overflowed (indexed by the pulse number):
+ * legacy_decode_oregon() leaves the data in legacyOregonData instead.
+ */
+
+// 2010-04-11 <jcw@equi4.com> http://opensource.org/licenses/mit-license.php
+// $Id: ookDecoder.pde 5331 2010-04-17 10:45:17Z jcw $
+
+#define LEGACY_OREGON_DATA_LEN	32
+
+static uint8_t	legacyTotalBits, legacyFlip, legacyState, legacyPos;
+static uint8_t	legacyOregonData[LEGACY_OREGON_DATA_LEN];
+enum { LEGACY_UNKNOWN, LEGACY_T0, LEGACY_OK, LEGACY_DONE };
+
+static uint8_t legacy_isDone(void)
+{
+	return legacyState == LEGACY_DONE;
+}
+
+static void legacy_resetDecoder(void)
+{
+	legacyTotalBits = legacyPos = legacyFlip = 0;
+	memset(legacyOregonData, 0, LEGACY_OREGON_DATA_LEN);
+	legacyState = LEGACY_UNKNOWN;
+}
+
+// add one bit to the packet data buffer
+static void legacy_gotBit(char value)
+{
+	if (!(legacyTotalBits & 0x01))
+	{
+		legacyOregonData[legacyPos] = (legacyOregonData[legacyPos] >> 1) | (value ? 0x80 : 00);
+	}
+	legacyTotalBits++;
+	legacyPos = legacyTotalBits >> 4;
+	if (legacyPos >= sizeof legacyOregonData)
+	{
+		legacy_resetDecoder();
+		return;
+	}
+	legacyState = LEGACY_OK;
+}
+
+static void legacy_done(void)
+{
+	legacyState = LEGACY_DONE;
+}
+
+// store a bit using Manchester encoding
+static void legacy_manchester(char value)
+{
+	legacyFlip ^= value; // manchester code, long pulse flips the bit
+	legacy_gotBit(legacyFlip);
+}
+
+static int8_t legacy_decode(uint16_t width)
+{
+	if (200 <= width && width < 1200)
+	{
+		uint8_t isLongPulse = width >= 700;
+	
+		switch (legacyState)
+		{
+		case LEGACY_UNKNOWN:
+			if (isLongPulse) {
+				// Long pulse
+				++legacyFlip;
+			} else if (!isLongPulse && 24 <= legacyFlip) {
+				// Short pulse, start bit
+				legacyFlip = 0;
+				legacyState = LEGACY_T0;
+			} else {
+				// Reset decoder
+				return -1;
+			}
+			break;
+		case LEGACY_OK:
+			if (!isLongPulse) {
+				// Short pulse
+				legacyState = LEGACY_T0;
+			} else {
+				// Long pulse
+				legacy_manchester(1);
+			}
+			break;
+		case LEGACY_T0:
+			if (!isLongPulse) {
+				// Second short pulse
+				legacy_manchester(0);
+			} else {
+				// Reset decoder
+				return -1;
+			}
+			break;
+		}
+	}
+	else if (width >= 2500 && legacyPos >= 8)
+	{
+		return 1;
+	}
+	else
+	{
+		return -1;
+	}
+	return 0;
+}
+
+static uint8_t legacy_nextPulse(uint16_t width)
+{
+	if (legacyState != LEGACY_DONE)
+	{
+		switch (legacy_decode(width))
+		{
+			case -1: legacy_resetDecoder(); break;
+			case 1:  legacy_done(); break;
+		}
+	}
+	return legacy_isDone();
+}
+
+/*!
+ * @brief Decode a sentence as the former decoder did
+ * @return Number of Manchester bits received (each data bit is sent twice), 0 if
+ * 		   no frame was decoded. The data is left in legacyOregonData.
+ */
+static uint16_t legacy_decode_oregon(const uint16_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i;
+	
+	
+	legacy_resetDecoder();
+	for (i = 0; i < nbPulses; i++)
+	{
+		if (legacy_nextPulse(pulseLens[i])) {
+			return legacyTotalBits;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,239 @@
+/*******************************************************************************
+ * PROTOCOL DESCRIPTOR COMPILER                                                *
+ *******************************************************************************
+ * Host tool: compiles a text description of PWM protocols into a store image
+ * (see User/decoders/protocol_desc.h), and prints the PSTORE command lines which
+ * upload it on the computer UART.
+ *
+ * Build:	gcc -O2 -o protoc tools/protoc.c
+ * Usage:	protoc <description.ini> [image.bin] > upload.txt
+ *
+ * Each protocol is a section, named after the protocol (11 characters max).
+ * Pulse windows are "min,max" with exclusive bounds, in us:
+ *
+ * 		[Chacon]
+ * 		sync_shape = low			; low, high_low, pair, ratio
+ * 		sync = 9000,11000			; low sync pulse, or whole sync pair
+ * 		nominal_sync = 10000		; optional, scales the other windows
+ * 		encoding = second			; second, both, ratio
+ * 		first = 200,500
+ * 		short = 200,500
+ * 		long = 1000,1500
+ * 		max_bits = 24
+ * 		min_bits = 24				; optional, shorter frames are not printed
+ * 		min_num_pulses = 48
+ * 		pulse_len = 150,12000		; global filter limits
+ * 		first_frame_only = 1
+ *
+ * 		[Came]
+ * 		disable_builtin = 1			; only disables the built-in decoder
+ *
+ * Other keys: sync_high, sync_ratio, pair_len_divider, pair_tolerance,
+ * bit_ratio, revert.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../User/decoders/protocol_desc.h"
+
+static struct {
+	protoStoreHeader_t	header;
+	protoDesc_t			descs[PROTO_STORE_MAX_DESCS];
+} image;
+
+
+static int fail(int lineNum, const char *msg, const char *arg)
+{
+	fprintf(stderr, "line %d: %s%s\n", lineNum, msg, arg);
+	exit(1);
+}
+
+static int keyword(const char *value, const char * const *names, int lineNum)
+{
+	int	i;
+	
+	
+	for (i = 0; names[i] != NULL; i++)
+	{
+		if (strcmp(value, names[i]) == 0) {
+			return i;
+		}
+	}
+	return fail(lineNum, "unknown value ", value);
+}
+
+static void window(const char *value, uint32_t *min, uint32_t *max, uint32_t limit, int lineNum)
+{
+	unsigned long	a, b;
+	
+	
+	if (sscanf(value, "%lu , %lu", &a, &b) != 2 || a >= b || b > limit) {
+		fail(lineNum, "invalid window ", value);
+	}
+	*min = a;
+	*max = b;
+}
+
+static void window16(const char *value, uint16_t *min, uint16_t *max, int lineNum)
+{
+	uint32_t	a, b;
+	
+	
+	window(value, &a, &b, 0xFFFF, lineNum);
+	*min = (uint16_t)a;
+	*max = (uint16_t)b;
+}
+
+static uint32_t number(const char *value, uint32_t limit, int lineNum)
+{
+	char			*end;
+	unsigned long	n = strtoul(value, &end, 0);
+	
+	
+	if (*end != '\0' || n > limit) {
+		fail(lineNum, "invalid number ", value);
+	}
+	return n;
+}
+
+static void setKey(protoDesc_t *d, const char *key, const char *value, int lineNum)
+{
+	static const char * const shapes[] = { "low", "high_low", "pair", "ratio", NULL };
+	static const char * const encodings[] = { "second", "both", "ratio", NULL };
+	
+	
+	if		(strcmp(key, "sync_shape") == 0)		d->syncShape = keyword(value, shapes, lineNum);
+	else if	(strcmp(key, "encoding") == 0)			d->encoding = keyword(value, encodings, lineNum);
+	else if	(strcmp(key, "sync") == 0)				window(value, &d->syncMin, &d->syncMax, 0x1FFFF, lineNum);
+	else if	(strcmp(key, "sync_high") == 0)			window16(value, &d->syncHighMin, &d->syncHighMax, lineNum);
+	else if	(strcmp(key, "nominal_sync") == 0)		d->nominalSync = number(value, 0x1FFFF, lineNum);
+	else if	(strcmp(key, "sync_ratio") == 0)		d->syncRatio = number(value, 255, lineNum);
+	else if	(strcmp(key, "first") == 0)				window16(value, &d->firstMin, &d->firstMax, lineNum);
+	else if	(strcmp(key, "short") == 0)				window16(value, &d->shortMin, &d->shortMax, lineNum);
+	else if	(strcmp(key, "long") == 0)				window16(value, &d->longMin, &d->longMax, lineNum);
+	else if	(strcmp(key, "pair_len_divider") == 0)	d->pairLenDivider = number(value, 255, lineNum);
+	else if	(strcmp(key, "pair_tolerance") == 0)	d->pairTolerance = number(value, 100, lineNum);
+	else if	(strcmp(key, "bit_ratio") == 0)			d->bitRatio = number(value, 255, lineNum);
+	else if	(strcmp(key, "max_bits") == 0)			d->maxBits = number(value, 256, lineNum);
+	else if	(strcmp(key, "min_bits") == 0)			d->minBits = number(value, 256, lineNum);
+	else if	(strcmp(key, "min_num_pulses") == 0)	d->minNumPulses = number(value, 0xFFFF, lineNum);
+	else if	(strcmp(key, "pulse_len") == 0)			window16(value, &d->minPulseLen, &d->maxPulseLen, lineNum);
+	else if	(strcmp(key, "revert") == 0)			d->revert = number(value, 1, lineNum);
+	else if	(strcmp(key, "first_frame_only") == 0)	d->flags |= (number(value, 1, lineNum) ? PROTO_FIRST_FRAME_ONLY : 0);
+	else if	(strcmp(key, "disable_builtin") == 0)	d->flags |= (number(value, 1, lineNum) ? PROTO_DISABLE_BUILTIN : 0);
+	else fail(lineNum, "unknown key ", key);
+}
+
+static char *trim(char *s)
+{
+	char	*end;
+	
+	
+	while (isspace((unsigned char)*s)) {
+		s++;
+	}
+	end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1])) {
+		*--end = '\0';
+	}
+	return s;
+}
+
+static void check(const protoDesc_t *d)
+{
+	if (d->flags & PROTO_DISABLE_BUILTIN) {
+		return;
+	}
+	if (d->maxBits == 0 || d->minNumPulses == 0 || d->maxPulseLen == 0) {
+		fprintf(stderr, "%s: max_bits, min_num_pulses and pulse_len are required\n", d->name);
+		exit(1);
+	}
+	if (d->minBits > d->maxBits) {
+		fprintf(stderr, "%s: min_bits > max_bits\n", d->name);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	char		line[256], *p, *eq;
+	protoDesc_t	*d = NULL;
+	FILE		*in, *out;
+	int			lineNum = 0;
+	uint32_t	i, len;
+	
+	
+	if (argc < 2 || (in = fopen(argv[1], "r")) == NULL)
+	{
+		fprintf(stderr, "usage: %s <description.ini> [image.bin]\n", argv[0]);
+		return 1;
+	}
+	
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		lineNum++;
+		if ((p = strpbrk(line, ";#")) != NULL) {
+			*p = '\0';
+		}
+		p = trim(line);
+		if (*p == '\0') {
+			continue;
+		}
+	
+		if (*p == '[')
+		{
+			if (image.header.nbDescs == PROTO_STORE_MAX_DESCS) {
+				fail(lineNum, "too many protocols", "");
+			}
+			if (d != NULL) {
+				check(d);
+			}
+			d = &image.descs[image.header.nbDescs++];
+			p = trim(p + 1);
+			if (p[strlen(p) - 1] != ']' || strlen(p) - 1 >= PROTO_DESC_NAME_LEN) {
+				fail(lineNum, "invalid section ", p);
+			}
+			memcpy(d->name, p, strlen(p) - 1);
+			continue;
+		}
+	
+		if (d == NULL || (eq = strchr(p, '=')) == NULL) {
+			fail(lineNum, "expected [name] or key = value: ", p);
+		}
+		*eq = '\0';
+		setKey(d, trim(p), trim(eq + 1), lineNum);
+	}
+	fclose(in);
+	if (d != NULL) {
+		check(d);
+	}
+	
+	image.header.magic		= PROTO_STORE_MAGIC;
+	image.header.version	= PROTO_STORE_VERSION;
+	image.header.crc		= proto_crc32(image.descs, image.header.nbDescs * sizeof(protoDesc_t));
+	len = sizeof(image.header) + image.header.nbDescs * sizeof(protoDesc_t);
+	
+	if (argc > 2)
+	{
+		if ((out = fopen(argv[2], "wb")) == NULL || fwrite(&image, 1, len, out) != len) {
+			fprintf(stderr, "cannot write %s\n", argv[2]);
+			return 1;
+		}
+		fclose(out);
+	}
+	
+	// Upload lines: wait for the "PSTORE,OK" reply to each of them
+	printf("PSTORE BEGIN\n");
+	for (d = image.descs; d < image.descs + image.header.nbDescs; d++)
+	{
+		printf("PSTORE DESC ");
+		for (i = 0; i < sizeof(*d); i++) {
+			printf("%02X", ((const uint8_t *)d)[i]);
+		}
+		printf("\n");
+	}
+	printf("PSTORE COMMIT\n");
+	return 0;
+}
@@ -0,0 +1,573 @@
+/*******************************************************************************
+ * PROTOCOL STORE CHECK                                                        *
+ *******************************************************************************
+ * Host tool: checks the protocol store (see User/decoders/protocol_store.h)
+ * end to end, with the FLASH and USART functions stubbed.
+ *
+ * The store sector is mapped at its address on the target (PROTO_STORE_ADDRESS)
+ * and the FLASH_* functions program it as the flash does: an erase sets every
+ * byte to 0xFF, and programming only clears bits, only while the flash is
+ * unlocked. The PSTORE lines are read by command_poll() from a stubbed
+ * TM_USART_Gets(), and the replies sent by uartTx_write() are checked. After each
+ * line changing the store, the protocols are loaded again and the capture
+ * configuration rebuilt, as the main loop does. Checked:
+ * 	- upload:		an X10 clone of the built-in X10 decoder (same windows, with
+ * 					a lower min pulse len) and a descriptor disabling the built-in
+ * 					one are uploaded and committed: the clone is loaded, the X10
+ * 					decoder is left out of the capture configuration, and the
+ * 					global filter is widened,
+ * 	- decoding:		random X10 sentences (timebase scaled by 0.85 to 1.15) are
+ * 					decoded by the built-in decoder and by the clone, which must
+ * 					print the bits of the same frame,
+ * 	- sorting:		protocols are listed by minNumPulses, and an invalid
+ * 					descriptor is rejected by the upload,
+ * 	- bad windows:	descriptors with an empty or zero window used by their
+ * 					sync or bits, a pair tolerance over 100 %, or a nominal sync
+ * 					so short that the scaled windows overflow, are rejected by
+ * 					the upload, and skipped by the load,
+ * 	- corrupt image: a bit flipped in a descriptor (CRC error), a bad magic or
+ * 					version, too many descriptors: nothing is loaded, and no
+ * 					built-in decoder is disabled,
+ * 	- errors:		bad hex, too many descriptors, unknown command, and a failing
+ * 					erase, after which nothing is reloaded,
+ * 	- erase:		PSTORE ERASE leaves the built-in decoders only.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the decoders and of the
+ * command modules):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders -IUser/esp8266 \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o pstore_check tools/pstore_check.c User/command.c User/capture_config.c \
+ * 			User/frame_cache.c User/sentence_queue.c $(ls User/decoders/[a-z]*.c)
+ * Usage:	pstore_check [-n <frames>] [-s <seed>]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "main.h"
+#include "generic_pwm.h"
+#include "protocol_store.h"
+#include "capture_config.h"
+#include "command.h"
+#include "record.h"
+
+#define STORE_SECTOR_SIZE	0x20000		// 128kB
+
+//! X10 frames, as sent by the remotes (see User/decoders/x10rf.c)
+#define X10_SYNC_HIGH		8800	// us
+#define X10_SYNC_LOW		4400
+#define X10_SHORT			550
+#define X10_LONG			1650
+#define X10_GAP				40000
+#define X10_REPEATS			3
+#define MAX_SENTENCE_LEN	(X10_REPEATS * (2 + 2 * 32 + 2))
+#define MIN_SCALE			85		// %
+#define MAX_SCALE			115
+
+//! Min pulse len of the clone, below the one of every built-in decoder
+#define CLONE_MIN_PULSE_LEN	100
+
+#define MAX_LINES			32
+#define MAX_LINE_LEN		(PROTO_STORE_LINE_LEN + 2)
+
+// Stubs of the target modules
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+uint32_t			outputSuppressed = 0;
+uartTxStats_t		uartTxStats;
+
+//! Text printed by the decoders
+static char			printed[4096];
+static uint16_t		printedLen;
+
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	
+	
+	if (printedLen + len < sizeof(printed))
+	{
+		memcpy(printed + printedLen, message, len + 1);
+		printedLen += len;
+	}
+}
+
+uint8_t output_repeat(uint32_t line, uint16_t count)
+{
+	(void)line;
+	(void)count;
+	return 0;
+}
+
+//! Flash sector, at its address on the target
+static uint8_t		*flash;
+static uint8_t		flashLocked = 1, failErase = 0;
+static uint32_t		flashViolations = 0, nbErases = 0;
+
+void FLASH_Unlock(void)
+{
+	flashLocked = 0;
+}
+
+void FLASH_Lock(void)
+{
+	flashLocked = 1;
+}
+
+void FLASH_ClearFlag(uint32_t FLASH_FLAG)
+{
+	(void)FLASH_FLAG;
+}
+
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange)
+{
+	(void)VoltageRange;
+	if (flashLocked || FLASH_Sector != PROTO_STORE_SECTOR)
+	{
+		flashViolations++;
+		return FLASH_ERROR_PROGRAM;
+	}
+	if (failErase) {
+		return FLASH_ERROR_OPERATION;
+	}
+	memset(flash, 0xFF, STORE_SECTOR_SIZE);
+	nbErases++;
+	return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data)
+{
+	uint32_t	word;
+	
+	
+	if (flashLocked || Address < PROTO_STORE_ADDRESS || Address + 4 > PROTO_STORE_ADDRESS + STORE_SECTOR_SIZE || (Address & 3))
+	{
+		flashViolations++;
+		return FLASH_ERROR_PROGRAM;
+	}
+	// Programming only clears bits
+	memcpy(&word, flash + (Address - PROTO_STORE_ADDRESS), sizeof(word));
+	if ((word & Data) != Data) {
+		flashViolations++;
+	}
+	word &= Data;
+	memcpy(flash + (Address - PROTO_STORE_ADDRESS), &word, sizeof(word));
+	return FLASH_COMPLETE;
+}
+
+//! Lines received on the computer UART, and replies sent on it
+static char			rxLines[MAX_LINES][MAX_LINE_LEN];
+static uint8_t		nbRxLines, nextRxLine;
+static char			replies[MAX_LINES * 64];
+static uint16_t		repliesLen;
+
+uint16_t TM_USART_Gets(USART_TypeDef *USARTx, char *buffer, uint16_t bufsize)
+{
+	(void)USARTx;
+	if (nextRxLine == nbRxLines) {
+		return 0;
+	}
+	snprintf(buffer, bufsize, "%s", rxLines[nextRxLine++]);
+	return strlen(buffer);
+}
+
+uint8_t uartTx_write(const char *message, uint16_t len)
+{
+	if (repliesLen + len < sizeof(replies))
+	{
+		memcpy(replies + repliesLen, message, len);
+		repliesLen += len;
+		replies[repliesLen] = '\0';
+	}
+	return 1;
+}
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static uint16_t		pulseLens[MAX_SENTENCE_LEN], work[MAX_SENTENCE_LEN];
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+/*!
+ * @brief Descriptor of the X10 protocol, as protoc compiles it
+ */
+static void x10Desc(protoDesc_t *d, const char *name, uint16_t minNumPulses)
+{
+	memset(d, 0, sizeof(*d));
+	snprintf(d->name, PROTO_DESC_NAME_LEN, "%s", name);
+	d->syncShape	= PROTO_SYNC_HIGH_LOW;
+	d->syncHighMin	= 7500;
+	d->syncHighMax	= 10000;
+	d->syncMin		= PWM_SYNC_MIN(X10_SYNC_LOW, 20);
+	d->syncMax		= PWM_SYNC_MAX(X10_SYNC_LOW, 20);
+	d->nominalSync	= X10_SYNC_LOW;
+	d->encoding		= PROTO_BIT_SECOND;
+	d->firstMin		= 400;
+	d->firstMax		= 750;
+	d->shortMin		= 400;
+	d->shortMax		= 800;
+	d->longMin		= 1300;
+	d->longMax		= 2000;
+	d->maxBits		= 32;
+	d->minBits		= 32;
+	d->minNumPulses	= minNumPulses;
+	d->minPulseLen	= CLONE_MIN_PULSE_LEN;
+	d->maxPulseLen	= 12000;
+	d->flags		= PROTO_FIRST_FRAME_ONLY;
+}
+
+static void disableDesc(protoDesc_t *d, const char *name)
+{
+	memset(d, 0, sizeof(*d));
+	snprintf(d->name, PROTO_DESC_NAME_LEN, "%s", name);
+	d->flags = PROTO_DISABLE_BUILTIN;
+}
+
+/*!
+ * @brief Queue a PSTORE DESC line
+ */
+static void rxDesc(const protoDesc_t *d)
+{
+	const uint8_t	*bytes = (const uint8_t *)d;
+	char			*line = rxLines[nbRxLines++];
+	uint8_t			i;
+	
+	
+	strcpy(line, "PSTORE DESC ");
+	for (i = 0; i < sizeof(*d); i++) {
+		sprintf(line + 12 + 2 * i, "%02X", bytes[i]);
+	}
+	strcat(line, "\n");
+}
+
+static void rxLine(const char *line)
+{
+	snprintf(rxLines[nbRxLines++], MAX_LINE_LEN, "%s\n", line);
+}
+
+/*!
+ * @brief Run the queued lines as the main loop does
+ * @return What they changed
+ */
+static uint8_t runLines(void)
+{
+	uint8_t	changes;
+	
+	
+	nextRxLine = 0;
+	repliesLen = 0;
+	replies[0] = '\0';
+	changes = command_poll(decoders, NUM_DECODERS);
+	if (changes & COMMAND_RELOAD) {
+		protoStore_load(decoders, NUM_DECODERS);
+	}
+	if (changes & (COMMAND_RELOAD | COMMAND_REBUILD)) {
+		captureConfig_rebuild(decoders, NUM_DECODERS);
+	}
+	nbRxLines = 0;
+	return changes;
+}
+
+static uint8_t x10Index(void)
+{
+	uint8_t	i;
+	
+	
+	for (i = 0; i < NUM_DECODERS && decoders[i] != &decoder_X10Rf; i++);
+	return i;
+}
+
+/*!
+ * @brief Sentence of a random X10 frame
+ * @return Number of pulses
+ */
+static uint16_t buildSentence(uint32_t *data)
+{
+	uint8_t		b0 = rand(), b2 = rand(), r;
+	uint16_t	nbPulses = 0, i, scale = MIN_SCALE + rand() % (MAX_SCALE - MIN_SCALE + 1);
+	
+	
+	*data = ((uint32_t)b0 << 24) | ((uint32_t)(b0 ^ 0xFF) << 16) | ((uint32_t)b2 << 8) | (b2 ^ 0xFF);
+	for (r = 0; r < X10_REPEATS; r++)
+	{
+		pulseLens[nbPulses++] = X10_SYNC_HIGH;
+		pulseLens[nbPulses++] = X10_SYNC_LOW;
+		for (i = 0; i < 32; i++)
+		{
+			pulseLens[nbPulses++] = X10_SHORT;
+			pulseLens[nbPulses++] = ((*data >> (31 - i)) & 1) ? X10_LONG : X10_SHORT;
+		}
+		pulseLens[nbPulses++] = X10_SHORT;
+		pulseLens[nbPulses++] = X10_GAP;
+	}
+	for (i = 0; i < nbPulses; i++) {
+		pulseLens[i] = (uint32_t)pulseLens[i] * scale / 100;
+	}
+	return nbPulses;
+}
+
+static void checkDecoding(uint32_t nbFrames)
+{
+	uint32_t	n, data, builtin = 0, clone = 0;
+	uint16_t	nbPulses;
+	char		expected[64];
+	
+	
+	for (n = 0; n < nbFrames; n++)
+	{
+		nbPulses = buildSentence(&data);
+	
+		printedLen = 0;
+		printed[0] = '\0';
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		builtin += (decoder_X10Rf.decoderFunc(work, nbPulses) != 0);
+		record_poll();
+	
+		printedLen = 0;
+		printed[0] = '\0';
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		protoStore_decode(work, nbPulses);
+		record_poll();
+		snprintf(expected, sizeof(expected), "X10Clone,32b,0x%08lX\n", (unsigned long)data);
+		clone += (strcmp(printed, expected) == 0);
+	}
+	printf("%lu X10 sentences: %lu decoded by the built-in decoder, %lu by the clone\n", (unsigned long)nbFrames,
+		(unsigned long)builtin, (unsigned long)clone);
+	check(clone == nbFrames, "Clone decodes every frame");
+	check(builtin == clone, "Built-in decoder and clone agree");
+}
+
+/*!
+ * @brief Load a copy of the committed image, altered
+ */
+static uint8_t loadAltered(uint32_t offset, uint32_t value, uint8_t size)
+{
+	static uint8_t	image[sizeof(protoStoreHeader_t) + PROTO_STORE_MAX_DESCS * sizeof(protoDesc_t)];
+	
+	
+	memcpy(image, flash, sizeof(image));
+	if (size == 1) {
+		image[offset] ^= value;
+	} else {
+		memcpy(image + offset, &value, size);
+	}
+	return protoStore_loadImage(image, sizeof(image), decoders, NUM_DECODERS);
+}
+
+/*!
+ * @brief Check that a descriptor is rejected by the upload and by the load
+ */
+static uint8_t descRejected(const protoDesc_t *d)
+{
+	static uint8_t		image[sizeof(protoStoreHeader_t) + sizeof(protoDesc_t)];
+	protoStoreHeader_t	*header = (protoStoreHeader_t *)image;
+	
+	
+	rxLine("PSTORE BEGIN");
+	rxDesc(d);
+	runLines();
+	if (strcmp(replies, "PSTORE,OK,BEGIN,0\nPSTORE,ERROR,DESC,0\n") != 0) {
+		return 0;
+	}
+	
+	header->magic	= PROTO_STORE_MAGIC;
+	header->version	= PROTO_STORE_VERSION;
+	header->nbDescs	= 1;
+	header->crc		= proto_crc32(d, sizeof(*d));
+	memcpy(header + 1, d, sizeof(*d));
+	return (protoStore_loadImage(image, sizeof(image), decoders, NUM_DECODERS) == 0);
+}
+
+int main(int argc, char **argv)
+{
+	protoDesc_t			desc;
+	const captureConfig_t	*config;
+	uint32_t			nbFrames = 10000, erases;
+	uint8_t				x10, i;
+	unsigned int		seed = 1;
+	int					a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	flash = mmap((void *)(uintptr_t)PROTO_STORE_ADDRESS, STORE_SECTOR_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (flash != (uint8_t *)(uintptr_t)PROTO_STORE_ADDRESS)
+	{
+		fprintf(stderr, "Cannot map the store sector at 0x%08X\n", PROTO_STORE_ADDRESS);
+		return 1;
+	}
+	memset(flash, 0xFF, STORE_SECTOR_SIZE);
+	srand(seed);
+	x10 = x10Index();
+	
+	// Blank sector: built-in decoders only
+	check(protoStore_load(decoders, NUM_DECODERS) == 0, "Blank sector loads nothing");
+	config = captureConfig_rebuild(decoders, NUM_DECODERS);
+	check((config->decoders & DECODER_BIT(x10)) != 0, "X10 enabled on a blank sector");
+	check(config->filter.minPulseLen > CLONE_MIN_PULSE_LEN, "Filter of the built-in decoders");
+	
+	// Upload of the clone, disabling the built-in decoder
+	rxLine("PSTORE BEGIN");
+	x10Desc(&desc, "X10Clone", 64);
+	rxDesc(&desc);
+	disableDesc(&desc, "X10");
+	rxDesc(&desc);
+	rxLine("PSTORE COMMIT");
+	rxLine("PSTORE LIST");
+	check(runLines() & COMMAND_RELOAD, "Commit reloads");
+	check(strcmp(replies, "PSTORE,OK,BEGIN,0\nPSTORE,OK,DESC,1\nPSTORE,OK,DESC,2\nPSTORE,OK,COMMIT,2\n"
+		"PSTORE,OK,LIST,0\n") == 0, "Upload replies (LIST before the reload)");
+	rxLine("PSTORE LIST");
+	runLines();
+	check(strcmp(replies, "PSTORE,OK,X10Clone,64\nPSTORE,OK,LIST,1\n") == 0, "Clone listed");
+	check(protoStore_disabledBuiltins() == DECODER_BIT(x10), "X10 disabled by the store");
+	config = captureConfig;
+	check((config->decoders & DECODER_BIT(x10)) == 0, "X10 left out of the capture configuration");
+	check(config->filter.minPulseLen == CLONE_MIN_PULSE_LEN, "Filter widened by the clone");
+	check(flashLocked && flashViolations == 0, "Flash programmed unlocked, then locked");
+	
+	checkDecoding(nbFrames);
+	
+	// Sorting, and an invalid descriptor
+	rxLine("PSTORE BEGIN");
+	x10Desc(&desc, "Long", 200);
+	rxDesc(&desc);
+	x10Desc(&desc, "Invalid", 64);
+	desc.maxBits = 0;
+	rxDesc(&desc);
+	x10Desc(&desc, "Short", 20);
+	rxDesc(&desc);
+	x10Desc(&desc, "X10Clone", 64);
+	rxDesc(&desc);
+	rxLine("PSTORE COMMIT");
+	runLines();
+	check(strstr(replies, "PSTORE,OK,DESC,1\nPSTORE,ERROR,DESC,1\nPSTORE,OK,DESC,2\n") != NULL, "Invalid descriptor rejected");
+	rxLine("PSTORE LIST");
+	runLines();
+	check(strcmp(replies, "PSTORE,OK,Short,20\nPSTORE,OK,X10Clone,64\nPSTORE,OK,Long,200\nPSTORE,OK,LIST,3\n") == 0,
+		"Sorted by minNumPulses");
+	check(protoStore_disabledBuiltins() == 0, "No built-in decoder disabled");
+	
+	// Bad windows
+	x10Desc(&desc, "BadWindow", 64);
+	desc.syncMax = desc.syncMin;
+	check(descRejected(&desc), "Empty sync window rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.syncHighMax = 0;
+	check(descRejected(&desc), "Zero max of the high sync window rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.firstMin = desc.firstMax;
+	check(descRejected(&desc), "Empty first pulse window rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.shortMax = 0;
+	check(descRejected(&desc), "Zero max of the short window rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.longMin = desc.longMax + 1;
+	check(descRejected(&desc), "Reversed long window rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.pairTolerance = 101;
+	check(descRejected(&desc), "Pair tolerance over 100 % rejected");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.nominalSync = desc.syncMax / 256;
+	check(descRejected(&desc), "Nominal sync overflowing the scaled windows rejected");
+	desc.nominalSync = desc.syncMax / 256 + 1;
+	check(!descRejected(&desc), "Shortest nominal sync accepted");
+	x10Desc(&desc, "BadWindow", 64);
+	desc.nominalSync = 0;
+	desc.syncHighMax = 0;
+	desc.encoding = PROTO_BIT_BOTH;
+	desc.firstMin = desc.firstMax = 0;
+	desc.syncShape = PROTO_SYNC_LOW;
+	check(!descRejected(&desc), "Fixed windows, unused windows left empty, accepted");
+	
+	// Corrupt images
+	rxLine("PSTORE BEGIN");
+	x10Desc(&desc, "X10Clone", 64);
+	rxDesc(&desc);
+	disableDesc(&desc, "X10");
+	rxDesc(&desc);
+	rxLine("PSTORE COMMIT");
+	runLines();
+	check(loadAltered(0, 0, 1) == 1 && protoStore_disabledBuiltins() == DECODER_BIT(x10), "Unaltered copy loads");
+	for (i = 0; i < 2 * sizeof(protoDesc_t); i += 7) {
+		check(loadAltered(sizeof(protoStoreHeader_t) + i, 1 << (i & 7), 1) == 0 && protoStore_disabledBuiltins() == 0,
+			"CRC error rejected");
+	}
+	check(loadAltered(offsetof(protoStoreHeader_t, crc), 0x80, 1) == 0, "Wrong CRC rejected");
+	check(loadAltered(offsetof(protoStoreHeader_t, magic), 0x01, 1) == 0, "Bad magic rejected");
+	check(loadAltered(offsetof(protoStoreHeader_t, version), PROTO_STORE_VERSION + 1, 2) == 0, "Bad version rejected");
+	check(loadAltered(offsetof(protoStoreHeader_t, nbDescs), PROTO_STORE_MAX_DESCS + 1, 2) == 0, "Too many descriptors rejected");
+	check(protoStore_loadImage(flash, sizeof(protoStoreHeader_t) + sizeof(protoDesc_t), decoders, NUM_DECODERS) == 0,
+		"Truncated image rejected");
+	
+	// Command errors: nothing is written
+	erases = nbErases;
+	rxLine("PSTORE BEGIN");
+	rxLine("PSTORE DESC 0123");
+	rxLine("PSTORE FOO");
+	check(runLines() == 0, "Errors change nothing");
+	check(strcmp(replies, "PSTORE,OK,BEGIN,0\nPSTORE,ERROR,DESC,0\nPSTORE,ERROR,COMMAND,0\n") == 0, "Error replies");
+	x10Desc(&desc, "X10Clone", 64);
+	for (i = 0; i <= PROTO_STORE_MAX_DESCS; i++) {
+		rxDesc(&desc);
+	}
+	runLines();
+	check(strstr(replies, "PSTORE,OK,DESC,16\nPSTORE,ERROR,FULL,16\n") != NULL, "Upload full");
+	failErase = 1;
+	rxLine("PSTORE COMMIT");
+	check(runLines() == 0, "Failed commit not reloaded");
+	check(strcmp(replies, "PSTORE,ERROR,FLASH,0\n") == 0, "Flash error reply");
+	failErase = 0;
+	check(nbErases == erases && flashLocked, "Failed commit left the flash locked");
+	
+	// Erase
+	rxLine("PSTORE ERASE");
+	check(runLines() & COMMAND_RELOAD, "Erase reloads");
+	rxLine("PSTORE LIST");
+	runLines();
+	check(strcmp(replies, "PSTORE,OK,LIST,0\n") == 0, "Nothing loaded once erased");
+	check((captureConfig->decoders & DECODER_BIT(x10)) != 0, "X10 enabled again");
+	check(flashViolations == 0, "Flash programmed as the hardware allows");
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,308 @@
+/*******************************************************************************
+ * PULSE PAIR CLASSIFICATION CHECK                                             *
+ *******************************************************************************
+ * Host tool: checks the classification of two pulses at once (see
+ * User/decoders/pulse_simd.h) with the emulated __UQSUB16, and times it against
+ * the scalar window checks it replaced in the PWM engine.
+ *
+ * 	- pulse_uqsub16() is compared with a halfword by halfword saturating
+ * 	  subtraction, on the values around 0, 0x7FFF/0x8000 and 0xFFFF in each
+ * 	  halfword (all combinations), then on random words,
+ * 	- pulse_inWindow2() is compared with the scalar exclusive-bound checks (as
+ * 	  the IS_* macros do) on random windows, with bounds up to and above 0xFFFF,
+ * 	  and pulses at random or at the bounds of their windows,
+ * 	- pulse_loadPair() is checked at every offset of a buffer, aligned on a word
+ * 	  or not.
+ * The benchmark classifies the pairs of random pulses as a 0, a 1 or neither
+ * (PWM_BIT_BOTH windows of CarKey1), with the packed windows and with four
+ * scalar comparisons per window. The emulated __UQSUB16 is not faster than the
+ * scalar checks on the host: the time only shows the emulation overhead, the
+ * gain is on the Cortex-M4 where it is one instruction.
+ *
+ * Build (from 01-M433_analyzer; pulse_simd.h is self-contained, no decoder needed):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o pulse_simd_check tools/pulse_simd_check.c
+ * Usage:	pulse_simd_check [-n <checks>] [-s <seed>]
+ *
+ * Exits with 1 if any result differs from the reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "pulse_simd.h"
+
+#define NB_BENCH_PULSES		(1 << 16)
+#define BENCH_RUNS			20
+
+//! CarKey1 windows (us)
+#define SHORT_MIN			400
+#define SHORT_MAX			600
+#define LONG_MIN			1100
+#define LONG_MAX			1300
+
+static uint32_t		nbErrors = 0;
+static uint64_t		nbChecks = 0;
+
+static uint16_t		benchPulses[NB_BENCH_PULSES + 1];
+static volatile uint32_t	timingSink;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint32_t random32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void check(uint32_t got, uint32_t expected, const char *what, uint32_t a, uint32_t b)
+{
+	nbChecks++;
+	if (got != expected && nbErrors++ < 10)
+	{
+		printf("%s (0x%08lX, 0x%08lX): 0x%08lX, expected 0x%08lX\n", what, (unsigned long)a, (unsigned long)b,
+			(unsigned long)got, (unsigned long)expected);
+	}
+}
+
+/*!
+ * @brief Reference saturating subtraction of each halfword
+ */
+static uint32_t referenceUqsub16(uint32_t a, uint32_t b)
+{
+	int32_t		lo = (int32_t)(a & 0xFFFF) - (int32_t)(b & 0xFFFF),
+				hi = (int32_t)(a >> 16) - (int32_t)(b >> 16);
+	
+	
+	return (uint32_t)(lo < 0 ? 0 : lo) | ((uint32_t)(hi < 0 ? 0 : hi) << 16);
+}
+
+static void checkUqsub16(uint32_t nbRandom)
+{
+	static const uint16_t	edges[] = { 0, 1, 2, 0x7FFE, 0x7FFF, 0x8000, 0x8001, 0xFFFD, 0xFFFE, 0xFFFF };
+	uint8_t		i, j, k, l, n = sizeof(edges) / sizeof(edges[0]);
+	uint32_t	a, b, c;
+	
+	
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			for (k = 0; k < n; k++) {
+				for (l = 0; l < n; l++)
+				{
+					a = PULSE_PACK(edges[i], edges[j]);
+					b = PULSE_PACK(edges[k], edges[l]);
+					check(pulse_uqsub16(a, b), referenceUqsub16(a, b), "pulse_uqsub16 (edges)", a, b);
+				}
+			}
+		}
+	}
+	for (c = 0; c < nbRandom; c++)
+	{
+		a = random32();
+		b = random32();
+		check(pulse_uqsub16(a, b), referenceUqsub16(a, b), "pulse_uqsub16", a, b);
+	}
+}
+
+/*!
+ * @brief Random exclusive window, max > min (as the IS_* macros use them)
+ */
+static void randomWindow(uint32_t *min, uint32_t *max)
+{
+	*min = rand() % 0x10010;
+	*max = *min + 1 + (rand() % 4 == 0 ? rand() % 4 : rand() % 0x2000);
+}
+
+/*!
+ * @brief Random pulse len, in its window, at a bound, or anywhere
+ */
+static uint16_t randomPulse(uint32_t min, uint32_t max)
+{
+	uint32_t	len;
+	
+	
+	switch (rand() % 6)
+	{
+		case 0:		len = min;			break;
+		case 1:		len = min + 1;		break;
+		case 2:		len = max - 1;		break;
+		case 3:		len = max;			break;
+		case 4:		len = min + rand() % (max - min + 1);	break;
+		default:	len = rand() & 0xFFFF;	break;
+	}
+	return (uint16_t)(len > 0xFFFF ? 0xFFFF : len);
+}
+
+static void checkWindows(uint32_t nbRandom)
+{
+	pulseWindow2_t	w;
+	uint32_t		c, firstMin, firstMax, secondMin, secondMax;
+	uint16_t		pulses[2];
+	
+	
+	for (c = 0; c < nbRandom; c++)
+	{
+		randomWindow(&firstMin, &firstMax);
+		randomWindow(&secondMin, &secondMax);
+		pulse_window2(&w, firstMin, firstMax, secondMin, secondMax);
+		pulses[0] = randomPulse(firstMin, firstMax);
+		pulses[1] = randomPulse(secondMin, secondMax);
+	
+		check(pulse_inWindow2(pulse_loadPair(pulses), &w),
+			pulses[0] > firstMin && pulses[0] < firstMax && pulses[1] > secondMin && pulses[1] < secondMax,
+			"pulse_inWindow2", PULSE_PACK(firstMin, firstMax), PULSE_PACK(secondMin, secondMax));
+	}
+}
+
+static void checkLoadPair(void)
+{
+	uint16_t	buffer[9];
+	uint8_t		i;
+	
+	
+	for (i = 0; i < 9; i++) {
+		buffer[i] = random32();
+	}
+	for (i = 0; i < 8; i++) {
+		check(pulse_loadPair(buffer + i), PULSE_PACK(buffer[i], buffer[i + 1]), "pulse_loadPair", i, 0);
+	}
+}
+
+/*!
+ * @brief Classify the pairs of benchPulses as PWM_BIT_BOTH does
+ * @return Number of 1 * 2^16 + number of 0
+ */
+static uint32_t classifyPacked(void)
+{
+	pulseWindow2_t	zero, one;
+	uint32_t		i, pair, nbZeros = 0, nbOnes = 0;
+	
+	
+	pulse_window2(&zero, SHORT_MIN, SHORT_MAX, LONG_MIN, LONG_MAX);
+	pulse_window2(&one, LONG_MIN, LONG_MAX, SHORT_MIN, SHORT_MAX);
+	for (i = 0; i < NB_BENCH_PULSES; i += 2)
+	{
+		pair = pulse_loadPair(benchPulses + i);
+		if (pulse_inWindow2(pair, &zero)) {
+			nbZeros++;
+		} else if (pulse_inWindow2(pair, &one)) {
+			nbOnes++;
+		}
+	}
+	return (nbOnes << 16) + nbZeros;
+}
+
+static uint32_t classifyScalar(void)
+{
+	uint32_t	i, high, low, nbZeros = 0, nbOnes = 0;
+	
+	
+	for (i = 0; i < NB_BENCH_PULSES; i += 2)
+	{
+		high	= benchPulses[i];
+		low		= benchPulses[i + 1];
+		if (high > SHORT_MIN && high < SHORT_MAX && low > LONG_MIN && low < LONG_MAX) {
+			nbZeros++;
+		} else if (high > LONG_MIN && high < LONG_MAX && low > SHORT_MIN && low < SHORT_MAX) {
+			nbOnes++;
+		}
+	}
+	return (nbOnes << 16) + nbZeros;
+}
+
+static void bench(void)
+{
+	uint32_t	i, packed = 0, scalar = 0;
+	uint8_t		run;
+	double		t0, packedTime = 1e12, scalarTime = 1e12, t;
+	
+	
+	// Mostly valid pairs, some noise
+	for (i = 0; i < NB_BENCH_PULSES; i += 2)
+	{
+		if (rand() % 8 == 0)
+		{
+			benchPulses[i]		= rand() % 2000;
+			benchPulses[i + 1]	= rand() % 2000;
+		}
+		else
+		{
+			benchPulses[i]		= (rand() & 1) ? 450 + rand() % 100 : 1150 + rand() % 100;
+			benchPulses[i + 1]	= (benchPulses[i] < 1000) ? 1150 + rand() % 100 : 450 + rand() % 100;
+		}
+	}
+	
+	for (run = 0; run < BENCH_RUNS; run++)
+	{
+		t0 = now();
+		packed = classifyPacked();
+		t = now() - t0;
+		if (t < packedTime) {
+			packedTime = t;
+		}
+		t0 = now();
+		scalar = classifyScalar();
+		t = now() - t0;
+		if (t < scalarTime) {
+			scalarTime = t;
+		}
+		timingSink += packed + scalar;
+	}
+	
+	printf("%d pairs: %lu zeros, %lu ones\n", NB_BENCH_PULSES / 2, (unsigned long)(packed & 0xFFFF), (unsigned long)(packed >> 16));
+	printf("Host time per pair: packed (emulated) %.2f ns, scalar %.2f ns\n", packedTime * 2 / NB_BENCH_PULSES,
+		scalarTime * 2 / NB_BENCH_PULSES);
+	check(packed, scalar, "Classification", 0, 0);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t		nbRandom = 10000000;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbRandom = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbRandom == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <checks>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	checkUqsub16(nbRandom);
+	checkWindows(nbRandom);
+	checkLoadPair();
+	bench();
+	
+	printf("%llu checks, %lu errors\n", (unsigned long long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*******************************************************************************
+ * PWM ENGINE BENCHMARK                                                        *
+ *******************************************************************************
+ * Host tool: times the PWM decoders before the engine (see tools/pwm_legacy.c)
+ * against the current ones, built either on the shared engine or on the
+ * kernels specialized per protocol (see User/decoders/generic_pwm_kernel.h).
+ *
+ * Every sentence of the captures is decoded by the former decoders, then by
+ * the current decoders which replaced them, each one only called on the
+ * sentences long enough for it. Both times include the printing of the lines
+ * (the current decoders queue records, printed by record_poll()). Each
+ * sentence is decoded TIMING_RUNS times, the fastest run is kept.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/pwm_legacy.c), once as is, for the specialized kernels,
+ * and once with -DPWM_SHARED_ENGINE, for the shared engine:
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o pwm_bench tools/pwm_bench.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	pwm_bench <capture> [...]
+ *
+ * Code size: the specialized kernels trade code for speed. Build the objects of
+ * the PWM decoders and of the engine both ways, with the same flags plus -Os -c
+ * (the target compiler if available, the host one as a proxy), and compare the
+ * text sizes given by size:
+ * 		for f in came_432na carKey1 dipswitch generic_bilen rcswitch x10rf generic_pwm; do
+ * 			gcc -Os -c <flags above> -o $f.o User/decoders/$f.c; done; size *.o
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "main.h"
+#include "decoder.h"
+#include "combine.h"
+#include "record.h"
+
+//! Not in the decoder table: declared here for the legacy table
+extern const decoderDesc_t	decoder_UnknownTemp;
+
+#include "pwm_legacy.c"
+
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+//! Runs of each sentence: the fastest run is kept, the others met noise
+#define TIMING_RUNS			20
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Lines printed
+static uint32_t		nbLines;
+
+void output_send(char *message)
+{
+	(void)message;
+	nbLines++;
+}
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+static uint32_t		legacyWork[MAX_NUM_PULSES];
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode a sentence with the former decoders
+ * @return Time taken (ns)
+ */
+static double runLegacy(uint16_t nbPulses)
+{
+	double		t0;
+	uint16_t	i;
+	uint8_t		d;
+	
+	
+	t0 = now();
+	for (d = 0; d < LEGACY_NB_DECODERS; d++)
+	{
+		if (nbPulses > legacyDecoders[d].minNumPulses)
+		{
+			for (i = 0; i < nbPulses; i++) {
+				legacyWork[i] = pulseLens[i];
+			}
+			legacyDecoders[d].decoderFunc(legacyWork, nbPulses);
+		}
+	}
+	return now() - t0;
+}
+
+/*!
+ * @brief Decode a sentence with the current decoders
+ * @return Time taken (ns)
+ */
+static double runCurrent(uint16_t nbPulses)
+{
+	const decoderDesc_t	*current;
+	double				t0;
+	uint8_t				d;
+	
+	
+	t0 = now();
+	for (d = 0; d < LEGACY_NB_DECODERS; d++)
+	{
+		current = legacyDecoders[d].current;
+		if (nbPulses > current->minNumPulses)
+		{
+			memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+			current->decoderFunc(work, nbPulses);
+		}
+	}
+	record_poll();
+	return now() - t0;
+}
+
+int main(int argc, char **argv)
+{
+	FILE		*file;
+	uint32_t	nbSentences = 0, nbLegacyLines = 0, nbCurrentLines = 0, lines;
+	uint16_t	nbPulses;
+	uint8_t		run;
+	double		t, legacy, current, legacyTime = 0, currentTime = 0;
+	int			a;
+	
+	
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (a = 1; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+	
+		while (fgets(line, sizeof(line), file) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			nbSentences++;
+			legacy = current = 1e12;
+	
+			for (run = 0; run < TIMING_RUNS; run++)
+			{
+				lines = nbLines;
+				if ((t = runLegacy(nbPulses)) < legacy) {
+					legacy = t;
+				}
+				nbLegacyLines += nbLines - lines;
+	
+				// Far enough apart not to be taken for repeats (KeeLoq presses)
+				sysTickTime += 1000000;
+				lines = nbLines;
+				if ((t = runCurrent(nbPulses)) < current) {
+					current = t;
+				}
+				nbCurrentLines += nbLines - lines;
+			}
+			legacyTime	+= legacy;
+			currentTime	+= current;
+		}
+		fclose(file);
+	}
+	
+	if (nbSentences == 0)
+	{
+		fprintf(stderr, "No sentence\n");
+		return 1;
+	}
+	
+#ifdef PWM_SPECIALIZED_KERNELS
+	printf("Current decoders: specialized kernels\n");
+#else
+	printf("Current decoders: shared engine\n");
+#endif
+	printf("Sentences:        %lu, lines printed %lu before the engine, %lu now (per run)\n", (unsigned long)nbSentences,
+		(unsigned long)(nbLegacyLines / TIMING_RUNS), (unsigned long)(nbCurrentLines / TIMING_RUNS));
+	printf("Before the engine: %.0f ns/sentence\n", legacyTime / nbSentences);
+	printf("Current:           %.0f ns/sentence (x%.2f)\n", currentTime / nbSentences, currentTime / legacyTime);
+	
+	return 0;
+}
@@ -0,0 +1,381 @@
+/*******************************************************************************
+ * PWM ENGINE DIFFERENTIAL CHECK                                               *
+ *******************************************************************************
+ * Host tool: decodes the sentences of the captures with the decoders replaced
+ * by the PWM engine (see tools/pwm_legacy.c) and with the current ones, and
+ * compares the lines they print.
+ *
+ * Each former decoder is run on the sentences long enough for it, then the
+ * decoder which replaced it, and the lines each one printed for the sentence
+ * are compared as sets (the engine decodes the repeated frames once). The
+ * lines of the current decoders which differ in form are brought back to the
+ * former one first:
+ * 	- CarKey1: the 64-bit frames were printed raw, they are now printed as
+ * 	  KeeLoq fields, once per press. The raw frames are split into fields, and
+ * 	  the battery and press count of the current lines are left out. The
+ * 	  sentences are far enough apart not to be taken for repeats.
+ * Each sentence decoded by either one is counted, per decoder, as:
+ * 	- same:		the same lines are printed,
+ * 	- changed:	both print lines, which differ (more or less bits read on a
+ * 				corrupted frame, the engine reading the pulses against the
+ * 				timebase given by the sync),
+ * 	- lost:		only the former decoder prints lines,
+ * 	- found:	only the current decoder prints lines.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/pwm_legacy.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o pwm_engine_diff tools/pwm_engine_diff.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	pwm_engine_diff [-v] <capture> [...]
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines).
+ * With -v, the lines of the changed and lost sentences are printed. Exits with 1
+ * if a current decoder loses more sentences than it finds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "main.h"
+#include "decoder.h"
+#include "combine.h"
+#include "bitvec.h"
+#include "keeloq.h"
+#include "record.h"
+
+//! Not in the decoder table: declared here for the legacy table
+extern const decoderDesc_t	decoder_UnknownTemp;
+
+#include "pwm_legacy.c"
+
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+#define MAX_PRINTED_LEN		4096
+#define MAX_SEGMENTS		64
+#define MAX_SEGMENT_LEN		128
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Text printed by the decoder being run
+static char			printed[MAX_PRINTED_LEN];
+static uint16_t		printedLen;
+
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	
+	
+	if (printedLen + len < MAX_PRINTED_LEN)
+	{
+		memcpy(printed + printedLen, message, len + 1);
+		printedLen += len;
+	}
+}
+
+//! Lines printed for a sentence, split and deduplicated
+typedef struct {
+	char		text[MAX_SEGMENTS][MAX_SEGMENT_LEN];
+	uint8_t		nbSegments;
+} segments_t;
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+static uint32_t		legacyWork[MAX_NUM_PULSES];
+static segments_t	legacySegments, currentSegments;
+
+//! Counts per decoder
+enum { SAME, CHANGED, LOST, FOUND, NB_COUNTS };
+
+static uint32_t		counts[LEGACY_NB_DECODERS][NB_COUNTS];
+static uint8_t		verbose = 0;
+
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Bring a former CarKey1 line to the current bits and fields
+ *
+ * The bits are now reverted (short high + long low reads as 1, as in KeeLoq).
+ */
+static void normalizeLegacyCarKey1(char *text)
+{
+	bitvec_t		bits;
+	keeloqFrame_t	keeloq;
+	unsigned int	raw[2], nbBits = 64;
+	uint64_t		mask;
+	
+	
+	if (strlen(text) == strlen("CarKey1,") + 16)
+	{
+		if (sscanf(text, "CarKey1,%8X%8X", &raw[0], &raw[1]) != 2) {
+			return;
+		}
+	}
+	else if (sscanf(text, "CarKey1,%u,%8X%8X", &nbBits, &raw[0], &raw[1]) != 3 || nbBits > 64) {
+		return;
+	}
+	mask = ~(uint64_t)0 << (64 - nbBits);
+	raw[0] ^= (uint32_t)(mask >> 32);
+	raw[1] ^= (uint32_t)mask;
+	if (nbBits < KEELOQ_MIN_BITS)
+	{
+		snprintf(text, MAX_SEGMENT_LEN, "CarKey1,%u,%08X%08X", nbBits, raw[0], raw[1]);
+		return;
+	}
+	
+	bitvec_reset(&bits);
+	bitvec_appendBits(&bits, raw[0], 32);
+	bitvec_appendBits(&bits, raw[1], 32);
+	bitvec_finish(&bits);
+	keeloq_parse(&bits, &keeloq);
+	snprintf(text, MAX_SEGMENT_LEN, "CarKey1,Serial=0x%07X,Buttons=0x%X,Hop=0x%08X",
+		(unsigned int)keeloq.serial, (unsigned int)keeloq.buttons, (unsigned int)keeloq.hop);
+}
+
+/*!
+ * @brief Leave the battery and press count out of a current CarKey1 line
+ */
+static void normalizeCurrentCarKey1(char *text)
+{
+	char	*p;
+	
+	
+	if (strncmp(text, "CarKey1,Serial=", strlen("CarKey1,Serial=")) == 0 && (p = strstr(text, ",LowBattery=")) != NULL) {
+		*p = '\0';
+	}
+}
+
+/*!
+ * @brief Split the printed text in lines, and at each record of the decoder
+ *
+ * Some records do not end their line (DIP switch codes).
+ */
+static void splitPrinted(const char *name, uint8_t legacy, segments_t *segments)
+{
+	char		*p = printed, *end, *next;
+	char		text[MAX_SEGMENT_LEN];
+	uint16_t	nameLen = strlen(name), len;
+	uint8_t		i;
+	
+	
+	segments->nbSegments = 0;
+	while (*p != '\0')
+	{
+		// Segment end: end of line, or next record of the decoder
+		end = strchr(p, '\n');
+		if (end == NULL) {
+			end = p + strlen(p);
+		}
+		next = strstr(p + 1, name);
+		if (next != NULL && next < end && next[nameLen] != '\0' && strchr(",:", next[nameLen]) != NULL) {
+			end = next;
+		}
+	
+		// Trimmed copy
+		len = end - p;
+		while (len > 0 && isspace((unsigned char)p[len - 1])) {
+			len--;
+		}
+		if (len >= MAX_SEGMENT_LEN) {
+			len = MAX_SEGMENT_LEN - 1;
+		}
+		memcpy(text, p, len);
+		text[len] = '\0';
+		p = (*end == '\n') ? end + 1 : end;
+		if (len == 0) {
+			continue;
+		}
+	
+		if (legacy) {
+			normalizeLegacyCarKey1(text);
+		} else {
+			normalizeCurrentCarKey1(text);
+		}
+	
+		// Deduplicated
+		for (i = 0; i < segments->nbSegments && strcmp(segments->text[i], text) != 0; i++) {
+		}
+		if (i == segments->nbSegments && segments->nbSegments < MAX_SEGMENTS) {
+			strcpy(segments->text[segments->nbSegments++], text);
+		}
+	}
+}
+
+static uint8_t hasSegment(const segments_t *segments, const char *text)
+{
+	uint8_t		i;
+	
+	
+	for (i = 0; i < segments->nbSegments; i++)
+	{
+		if (strcmp(segments->text[i], text) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * @brief Decode a sentence with a former decoder and its replacement, and count the result
+ */
+static void compareSentence(uint8_t d, uint16_t nbPulses, uint32_t lineNb)
+{
+	const decoderDesc_t	*current = legacyDecoders[d].current;
+	uint16_t			i;
+	uint8_t				result = SAME, s;
+	
+	
+	// Former decoder
+	for (i = 0; i < nbPulses; i++) {
+		legacyWork[i] = pulseLens[i];
+	}
+	printedLen = 0;
+	printed[0] = '\0';
+	legacyDecoders[d].decoderFunc(legacyWork, nbPulses);
+	splitPrinted((const char *)current->name, 1, &legacySegments);
+	
+	// Current decoder
+	printedLen = 0;
+	printed[0] = '\0';
+	if (nbPulses > current->minNumPulses)
+	{
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		current->decoderFunc(work, nbPulses);
+		record_poll();
+	}
+	splitPrinted((const char *)current->name, 0, &currentSegments);
+	
+	if (legacySegments.nbSegments == 0)
+	{
+		if (currentSegments.nbSegments > 0) {
+			counts[d][FOUND]++;
+		}
+		return;
+	}
+	if (currentSegments.nbSegments == 0) {
+		result = LOST;
+	} else if (currentSegments.nbSegments != legacySegments.nbSegments) {
+		result = CHANGED;
+	}
+	for (s = 0; s < legacySegments.nbSegments && result == SAME; s++)
+	{
+		if (!hasSegment(&currentSegments, legacySegments.text[s])) {
+			result = CHANGED;
+		}
+	}
+	counts[d][result]++;
+	
+	if (verbose && result != SAME)
+	{
+		printf("%lu: %s\n", (unsigned long)lineNb, result == LOST ? "lost" : "changed");
+		for (s = 0; s < legacySegments.nbSegments; s++) {
+			printf("\t- %s\n", legacySegments.text[s]);
+		}
+		for (s = 0; s < currentSegments.nbSegments; s++) {
+			printf("\t+ %s\n", currentSegments.text[s]);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE		*file;
+	uint32_t	nbSentences = 0, lineNb;
+	uint16_t	nbPulses;
+	uint8_t		d, nbWorse = 0;
+	int			a = 1;
+	
+	
+	if (a < argc && strcmp(argv[a], "-v") == 0)
+	{
+		verbose = 1;
+		a++;
+	}
+	if (a >= argc)
+	{
+		fprintf(stderr, "Usage: %s [-v] <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+		for (lineNb = 1; fgets(line, sizeof(line), file) != NULL; lineNb++)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			nbSentences++;
+			for (d = 0; d < LEGACY_NB_DECODERS; d++)
+			{
+				if (nbPulses > legacyDecoders[d].minNumPulses) {
+					compareSentence(d, nbPulses, lineNb);
+				}
+			}
+	
+			// Far enough apart not to be taken for repeats
+			sysTickTime += 1000000;
+		}
+		fclose(file);
+	}
+	
+	printf("Sentences: %lu\n", (unsigned long)nbSentences);
+	printf("Decoder      |     same  changed     lost    found\n");
+	for (d = 0; d < LEGACY_NB_DECODERS; d++)
+	{
+		printf("%-12s | %8lu %8lu %8lu %8lu\n", (const char *)legacyDecoders[d].current->name, (unsigned long)counts[d][SAME],
+			(unsigned long)counts[d][CHANGED], (unsigned long)counts[d][LOST], (unsigned long)counts[d][FOUND]);
+		if (counts[d][LOST] > counts[d][FOUND]) {
+			nbWorse++;
+		}
+	}
+	
+	if (nbWorse > 0)
+	{
+		printf("%d decoders lose more sentences than they find\n", nbWorse);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
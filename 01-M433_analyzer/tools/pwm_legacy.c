@@ -0,0 +1,836 @@
+/*******************************************************************************
+ * PWM DECODERS BEFORE THE ENGINE                                              *
+ *******************************************************************************
+ * The decoders replaced by the PWM engine (see User/decoders/generic_pwm.h), as
+ * they were just before it: each one had its own sync search and bit loop. They
+ * are the reference of tools/pwm_engine_diff.c, which includes this file.
+ *
+ * The code is unchanged, apart from the names (prefixed with legacy_, so that
+ * the current decoders can be linked too) and the descriptors, replaced by the
+ * legacyDecoders table, and the frame offsets zeroed (the host compiler warns
+ * about them). Pulse lens are 32 bits, as they were then.
+ */
+
+//! Former combining of the repeated frames (see User/decoders/combine.c)
+#define LEGACY_COMBINE_MAX_PULSES	160
+
+static uint32_t	legacyCombined[LEGACY_COMBINE_MAX_PULSES];
+
+static uint32_t *legacy_combine_frames(uint32_t *pulseLens, uint16_t nbPulses, const uint16_t *frameOffsets, uint8_t nbFrames, uint16_t *frameLen)
+{
+	uint16_t	i, len = LEGACY_COMBINE_MAX_PULSES;
+	uint8_t		j, k, nbCopies;
+	uint32_t	values[COMBINE_MAX_FRAMES], v;
+	
+	
+	if (nbFrames < COMBINE_MIN_FRAMES) {
+		return NULL;
+	}
+	if (nbFrames > COMBINE_MAX_FRAMES) {
+		nbFrames = COMBINE_MAX_FRAMES;
+	}
+	
+	for (j = 0; j < nbFrames - 1; j++)
+	{
+		if (frameOffsets[j+1] - frameOffsets[j] < len) {
+			len = frameOffsets[j+1] - frameOffsets[j];
+		}
+	}
+	
+	nbCopies = nbFrames;
+	if (nbPulses - frameOffsets[nbFrames-1] < len) {
+		nbCopies--;
+	}
+	if (nbCopies < COMBINE_MIN_FRAMES) {
+		return NULL;
+	}
+	
+	// Median of each pulse: insertion sort of the copies
+	for (i = 0; i < len; i++)
+	{
+		for (j = 0; j < nbCopies; j++)
+		{
+			v = pulseLens[frameOffsets[j] + i];
+			for (k = j; k > 0 && values[k-1] > v; k--) {
+				values[k] = values[k-1];
+			}
+			values[k] = v;
+		}
+		legacyCombined[i] = values[nbCopies / 2];
+	}
+	
+	*frameLen = len;
+	return legacyCombined;
+}
+
+/*******************************************************************************
+ * GENERIC RCSWITCH                                                            *
+ ******************************************************************************/
+#define LONG_SHORT_MIN_RATIO	2
+#define PULSE_TOLERANCE			10		// Pulse len tolerance (%)
+#define RAW_DATA_LEN			32		// bits
+
+#undef 	IS_PAIR
+#define	IS_PAIR(n)		((n) > minPairLen && (n) < maxPairLen)
+
+static uint16_t legacy_generic_rcswitch_sentence(uint32_t *pulseLens, uint16_t nbPulses, uint32_t pairLen, ui32InterpreterFunc_t dataHandler, uint32_t revert)
+{
+	uint16_t	i,
+				dataBitOffset	= RAW_DATA_LEN; // Bits to receive
+	uint32_t	rawData 		= 0;
+	uint32_t	minPairLen,
+				maxPairLen;
+	
+	
+	if (pairLen > 0)
+	{
+		minPairLen 		= pairLen * (100 - PULSE_TOLERANCE) / 100,
+		maxPairLen 		= pairLen * (100 + PULSE_TOLERANCE) / 100;
+	}
+	else
+	{
+		// Get the first pair length and use it as the reference
+		minPairLen 	= (pulseLens[0] + pulseLens[1]) * (100 - PULSE_TOLERANCE) / 100;
+		maxPairLen 	= (pulseLens[0] + pulseLens[1]) * (100 + PULSE_TOLERANCE) / 100;
+	}
+	
+	
+	// Each bit can be:
+	// short low+long high (1)
+	// long low+short high (0)
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (IS_PAIR(pulseLens[i]+pulseLens[i+1]))
+		{
+			// Ratios are cross-multiplied: no division, no floating point
+			if (pulseLens[i] > LONG_SHORT_MIN_RATIO * pulseLens[i+1])
+			{
+				rawData |= ((1 - revert) << --dataBitOffset);
+			}
+			else if (pulseLens[i+1] > LONG_SHORT_MIN_RATIO * pulseLens[i])
+			{
+				rawData |= (revert << --dataBitOffset);
+			}
+			else
+			{
+				// Pulse len is invalid
+				break;
+			}
+		}
+		else
+		{
+			// Pulse len is invalid
+			break;
+		}
+	
+		if (!dataBitOffset)
+		{
+			i += 2;
+			break;
+		}
+	}
+	
+	if (dataHandler(rawData, RAW_DATA_LEN - dataBitOffset))
+	{
+		return i;
+	}
+	
+	return 0;
+}
+
+#undef LONG_SHORT_MIN_RATIO
+#undef PULSE_TOLERANCE
+#undef RAW_DATA_LEN
+#undef IS_PAIR
+
+/*******************************************************************************
+ * CAME432                                                                     *
+ ******************************************************************************/
+#define NAME			"Came432Na"
+#define RAW_DATA_LEN	32		// bits
+
+#define MIN_SHORT_LEN	300		// Measured: 345us
+#define MAX_SHORT_LEN	400
+
+#define MIN_LONG_LEN	600
+#define MAX_LONG_LEN	750
+
+#define MIN_SYNC_LEN	14600	// Measured: 15.6ms
+#define MAX_SYNC_LEN	16600
+
+#define MIN_NUM_PULSES	26		// 2 * 12
+
+#define PROLOGUE		(rawData & 0x80000000)
+
+static uint8_t legacy_interpret_came432(uint32_t rawData, uint8_t nbBits)
+{
+	if (nbBits == 13 && PROLOGUE)
+	{
+		PRINTF("%s,%db,0x%08X\n", NAME, nbBits-1, rawData << 1);
+		return 1;
+	}
+	else if (nbBits == 12)
+	{
+		PRINTF("%s,%db,0x%08X\n", NAME, nbBits, rawData);
+		return 1;
+	}
+	else if (nbBits >= 8)
+	{
+		PRINTF("%s,%db,x%08X\n", NAME, nbBits, rawData);
+		return 1;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+static uint16_t legacy_came432_2ndPulse(uint32_t *pulseLens, uint16_t nbPulses, ui32InterpreterFunc_t dataHandler, uint32_t revert)
+{
+	uint16_t	i,
+				dataBitOffset	= RAW_DATA_LEN; // Bits to receive
+	uint32_t	rawData 		= 0;
+	
+	
+	// Each bit can be:
+	// short low+long high (1)
+	// long low+short high (0)
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (IS_SHORT(pulseLens[i+1]))
+		{
+			rawData |= (revert << --dataBitOffset);
+		}
+		else if (IS_LONG(pulseLens[i+1]))
+		{
+			rawData |= ((1 - revert) << --dataBitOffset);
+		}
+		else
+		{
+			// Pulse len is invalid
+			break;
+		}
+	
+		if (!dataBitOffset)
+		{
+			i += 2;
+			break;
+		}
+	}
+	
+	if (dataHandler(rawData, RAW_DATA_LEN - dataBitOffset))
+	{
+		return i;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_decode_came432(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	uint16_t	frameOffsets[COMBINE_MAX_FRAMES] = { 0 }, frameLen;
+	uint8_t		nbFrames = 0;
+	uint32_t	*frame;
+	
+	// Combine the repeated frames and decode them once
+	for (syncOffset = 0; nbPulses - syncOffset > MIN_NUM_PULSES && nbFrames < COMBINE_MAX_FRAMES; syncOffset += 2)
+	{
+		if (IS_SYNC(pulseLens[syncOffset+1])) {
+			frameOffsets[nbFrames++] = syncOffset;
+		}
+	}
+	
+	frame = legacy_combine_frames(pulseLens, nbPulses, frameOffsets, nbFrames, &frameLen);
+	if (frame != NULL && legacy_came432_2ndPulse(frame + 2, frameLen - 2, legacy_interpret_came432, 0) > 0) {
+		return 1;
+	}
+	
+	// Otherwise, decode each frame on its own
+	syncOffset = 0;
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{
+		if (IS_SYNC(pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence
+			// start @syncOffset+2)
+			syncOffset += 2;
+			result = legacy_came432_2ndPulse(pulseLens + syncOffset, nbPulses - syncOffset, legacy_interpret_came432, 0);
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#define LEGACY_CAME432_MIN_NUM_PULSES	26
+
+#undef NAME
+#undef RAW_DATA_LEN
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_LONG_LEN
+#undef MAX_LONG_LEN
+#undef MIN_SYNC_LEN
+#undef MAX_SYNC_LEN
+#undef MIN_NUM_PULSES
+#undef PROLOGUE
+
+/*******************************************************************************
+ * DIP SWITCH                                                                  *
+ ******************************************************************************/
+#define NAME			"DIPswitch"
+
+#define MIN_SHORT_LEN	610		// Measured: 710us
+#define MAX_SHORT_LEN	810
+
+#define MIN_LONG_LEN	1320
+#define MAX_LONG_LEN	1520
+
+#define MIN_SYNC_LEN	25000	// Measured: 26ms
+#define MAX_SYNC_LEN	27000
+
+#define MIN_NUM_PULSES	28		// 2 sync + 2 * 12
+#define RAW_DATA_LEN	32
+
+#define PROLOGUE		(rawData & 0x80000000)
+#define	EPILOGUE		(rawData & 0x00100000)
+
+#define DIPCODE_MASK	0x7FE00000
+#define DIPCODE_SHIFT	21
+
+static uint8_t legacy_interpret_dipswitch(uint32_t rawData, uint8_t nbBits)
+{
+	// Decode the raw data
+	if (nbBits == 12 && !PROLOGUE && EPILOGUE)
+	{
+		// None of the odd bits is set (we don't check the last 2 since the state value may be 0b00 or 0b11)
+		PRINTF("%s: DIPcode value=0x%3X ", NAME, BIN_VALUE(DIPCODE));
+		return 1;
+	}
+	else if (nbBits >= 10)
+	{
+		// Decode the raw data
+		PRINTF("%s: Valid code (%db): 0x%08X\n", NAME, nbBits, rawData);
+		return 1;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_dipswitch_2ndPulse(uint32_t *pulseLens, uint16_t nbPulses, ui32InterpreterFunc_t dataHandler, uint32_t revert)
+{
+	uint16_t	i,
+				dataBitOffset	= RAW_DATA_LEN; // Bits to receive
+	uint32_t	rawData 		= 0;
+	
+	
+	// Each bit can be:
+	// short low+long high (1)
+	// long low+short high (0)
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (IS_SHORT(pulseLens[i+1]))
+		{
+			rawData |= (revert << --dataBitOffset);
+		}
+		else if (IS_LONG(pulseLens[i+1]))
+		{
+			rawData |= ((1 - revert) << --dataBitOffset);
+		}
+		else
+		{
+			// Pulse len is invalid
+			break;
+		}
+	
+		if (!dataBitOffset)
+		{
+			i += 2;
+			break;
+		}
+	}
+	
+	if (dataHandler(rawData, RAW_DATA_LEN - dataBitOffset))
+	{
+		return i;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_decode_dipswitch(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	uint16_t	frameOffsets[COMBINE_MAX_FRAMES] = { 0 }, frameLen;
+	uint8_t		nbFrames = 0;
+	uint32_t	*frame;
+	
+	// Combine the repeated frames and decode them once
+	for (syncOffset = 0; nbPulses - syncOffset > MIN_NUM_PULSES && nbFrames < COMBINE_MAX_FRAMES; syncOffset += 2)
+	{
+		if (IS_SHORT(pulseLens[syncOffset]) && IS_SYNC(pulseLens[syncOffset+1])) {
+			frameOffsets[nbFrames++] = syncOffset;
+		}
+	}
+	
+	frame = legacy_combine_frames(pulseLens, nbPulses, frameOffsets, nbFrames, &frameLen);
+	if (frame != NULL && legacy_dipswitch_2ndPulse(frame + 2, frameLen - 2, legacy_interpret_dipswitch, 1) > 0) {
+		return 1;
+	}
+	
+	// Otherwise, decode each frame on its own
+	syncOffset = 0;
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{
+		if (IS_SHORT(pulseLens[syncOffset]) && IS_SYNC(pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence
+	
+			// start @syncOffset+2
+			syncOffset += 2;
+			result = legacy_dipswitch_2ndPulse(pulseLens + syncOffset, nbPulses - syncOffset, legacy_interpret_dipswitch, 1);
+			// syncOffset must be aligned back to a high pulse
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#define LEGACY_DIPSWITCH_MIN_NUM_PULSES	28
+
+#undef NAME
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_LONG_LEN
+#undef MAX_LONG_LEN
+#undef MIN_SYNC_LEN
+#undef MAX_SYNC_LEN
+#undef MIN_NUM_PULSES
+#undef RAW_DATA_LEN
+#undef PROLOGUE
+#undef EPILOGUE
+#undef DIPCODE_MASK
+#undef DIPCODE_SHIFT
+
+/*******************************************************************************
+ * CARKEY1                                                                     *
+ ******************************************************************************/
+#define NAME			"CarKey1"
+
+#define MIN_SHORT_LEN	400
+#define MAX_SHORT_LEN	600
+
+#define MIN_LONG_LEN	1100
+#define MAX_LONG_LEN	1300
+
+#define MIN_SYNC_LEN	2900
+#define MAX_SYNC_LEN	3100
+
+#define RAW_DATA_LEN	64	// bits
+#define MIN_NUM_PULSES	130	// at least 64b + 2 sync pulses
+
+static uint8_t legacy_interpret_CarKey1(uint32_t rawData, uint32_t rawData2, uint8_t nbBits)
+{
+	if (nbBits < 12)
+	{
+		return 0;
+	}
+	
+	if (nbBits == 64)
+	{
+		PRINTF("%s,%08X%08X\n", NAME, rawData, rawData2);
+	}
+	else
+	{
+		PRINTF("%s,%d,%08X%08X\n", NAME, nbBits, rawData, rawData2);
+	}
+	return 1;
+}
+
+static uint16_t legacy_synced_CarKey1(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	i,
+				dataByteOffset  = 0,
+				dataBitOffset	= 32; // Bits to receive
+	uint32_t	rawData[2]		= {0, 0};
+	
+	
+	// Each bit can be:
+	// short low+long high (1)
+	// long low+short high (0)
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (IS_SHORT(pulseLens[i]) && IS_LONG(pulseLens[i+1]))
+		{
+			--dataBitOffset;
+		}
+		else if (IS_LONG(pulseLens[i]) && IS_SHORT(pulseLens[i+1]))
+		{
+			rawData[dataByteOffset] |= (1 << --dataBitOffset);
+		}
+		else
+		{
+			// Pulse len is invalid
+			break;
+		}
+	
+		if (dataBitOffset == 0)
+		{
+			dataBitOffset = 32;
+			dataByteOffset++;
+		}
+	
+		if (dataByteOffset == 2)
+		{
+			i += 2;
+			break;
+		}
+	}
+	
+	if (legacy_interpret_CarKey1(rawData[0], rawData[1], (32*dataByteOffset)+(32-dataBitOffset)))
+	{
+		return i;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_decode_CarKey1(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	uint16_t	frameOffsets[COMBINE_MAX_FRAMES] = { 0 }, frameLen;
+	uint8_t		nbFrames = 0;
+	uint32_t	*frame;
+	
+	// Combine the repeated frames and decode them once
+	for (syncOffset = 0; nbPulses - syncOffset > MIN_NUM_PULSES && nbFrames < COMBINE_MAX_FRAMES; syncOffset += 2)
+	{
+		if (IS_SYNC(pulseLens[syncOffset] + pulseLens[syncOffset+1])) {
+			frameOffsets[nbFrames++] = syncOffset;
+		}
+	}
+	
+	frame = legacy_combine_frames(pulseLens, nbPulses, frameOffsets, nbFrames, &frameLen);
+	if (frame != NULL && legacy_synced_CarKey1(frame + 2, frameLen - 2) > 0) {
+		return 1;
+	}
+	
+	// Otherwise, decode each frame on its own
+	syncOffset = 0;
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{
+		if (IS_SYNC(pulseLens[syncOffset] + pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence
+			syncOffset += 2;
+			result = legacy_synced_CarKey1(pulseLens + syncOffset, nbPulses - syncOffset);
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	
+		if (result > 0) {
+			break;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#define LEGACY_CARKEY1_MIN_NUM_PULSES	130
+
+#undef NAME
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_LONG_LEN
+#undef MAX_LONG_LEN
+#undef MIN_SYNC_LEN
+#undef MAX_SYNC_LEN
+#undef RAW_DATA_LEN
+#undef MIN_NUM_PULSES
+
+/*******************************************************************************
+ * UNKNOWN TEMPERATURE SENSOR                                                  *
+ ******************************************************************************/
+#define NAME			"UnknownTemp"
+
+#define MIN_HIGH_LEN	430
+#define MAX_HIGH_LEN	600
+
+#define MIN_SHORT_LEN	1800
+#define MAX_SHORT_LEN	2100
+
+#define MIN_LONG_LEN	3900
+#define MAX_LONG_LEN	4200
+
+#define MIN_SYNC_LEN	8500
+#define MAX_SYNC_LEN	8700
+
+#define RAW_DATA_LEN	32	// bits
+#define MIN_NUM_PULSES	20	// at least 4 bytes * 2 pulses + 2 sync pulses
+
+#define TLOW_MASK		0x00FF0000
+#define TLOW_SHIFT		16
+
+#define TDEC_MASK		0x0000FF00
+#define TDEC_SHIFT		8
+
+static uint8_t legacy_interpret_UnknownTemp(uint32_t rawData, uint8_t nbBits)
+{
+	if (nbBits == 24)
+	{
+		if (BIN_VALUE(TDEC) <= 9 && ((rawData & 0xFF) == 0))
+		{
+			PRINTF("%s,%08X,Humid=%d.%d %%\n", NAME, rawData, BIN_VALUE(TLOW), BIN_VALUE(TDEC));
+		}
+		else
+		{
+			PRINTF("%s,%d,%08X\n", NAME, nbBits, rawData);
+		}
+		return 1;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_synced_UnknownTemp(uint32_t *pulseLens, uint16_t nbPulses, uint32_t revert)
+{
+	uint16_t	i;
+	
+	uint8_t		dataBitOffset	= RAW_DATA_LEN; // Bits to receive
+	uint32_t	rawData 		= 0;
+	
+	// Decode the raw data
+	// pulseLens should point to the first data pulse
+	for (i = 0; i < nbPulses-1; i += 2)
+	{
+		if (!IS_HIGH_PULSE(pulseLens[i]))
+		{
+			// Invalid high pulse len
+			break;
+		}
+		else if (IS_SHORT(pulseLens[i+1]))
+		{
+			// Nothing to do
+			rawData |= (revert << --dataBitOffset);
+		}
+		else if (IS_LONG(pulseLens[i+1]))
+		{
+			rawData |= ((1 - revert) << --dataBitOffset);
+		}
+		else
+		{
+			// Invalid low pulse len
+			break;
+		}
+	
+		// If the receive buffer is full => break
+		if (!dataBitOffset)
+		{
+			break;
+		}
+	}
+	
+	if (legacy_interpret_UnknownTemp(rawData, RAW_DATA_LEN-dataBitOffset))
+	{
+		return i;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+static uint16_t legacy_decode_UnknownTemp(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{
+		if (IS_HIGH_PULSE(pulseLens[syncOffset]) && IS_SYNC(pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence
+			syncOffset += 2;
+			result = legacy_synced_UnknownTemp(pulseLens + syncOffset, nbPulses - syncOffset, 0);
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	
+		if (result > 0) {
+			break;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#define LEGACY_UNKNOWNTEMP_MIN_NUM_PULSES	20
+
+#undef NAME
+#undef MIN_HIGH_LEN
+#undef MAX_HIGH_LEN
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_LONG_LEN
+#undef MAX_LONG_LEN
+#undef MIN_SYNC_LEN
+#undef MAX_SYNC_LEN
+#undef RAW_DATA_LEN
+#undef MIN_NUM_PULSES
+#undef TLOW_MASK
+#undef TLOW_SHIFT
+#undef TDEC_MASK
+#undef TDEC_SHIFT
+
+/*******************************************************************************
+ * RCSWITCH                                                                    *
+ ******************************************************************************/
+#define NAME			"RCswitch"
+
+#define MIN_SHORT_LEN	300
+#define MAX_SHORT_LEN	500
+#define MIN_NUM_PULSES	50		// 2 sync + 2 * 24
+
+// The sync low is more than SYNC_MIN_RATIO times longer than the sync high
+#define SYNC_MIN_RATIO	20
+#define IS_SYNC_PAIR(h, l)	((l) > SYNC_MIN_RATIO * (h))
+
+#define CHANNEL_MASK	0xFF000000
+#define CHANNEL_SHIFT	24
+
+#define ADDR_MASK		0xFC0000	// 11111100 00000000 00000000
+#define ADDR_SHIFT		18
+
+#define PAD_MASK		0x3FC00		// 11 11111100 00000000
+#define PAD_SHIFT		10
+
+#define STATE_MASK		0x300 		// 11 00000000
+#define STATE_SHIFT		8
+
+#define EVEN_BITS_MASK	0x55555700	// 01010101 01010101 01010111 00000000
+
+static uint32_t	legacyPairLen;
+
+static uint8_t legacy_interpret_rcswitch(uint32_t rawData, uint8_t nbBits)
+{
+	// Decode the raw data
+	if (nbBits == 24 && ((rawData & EVEN_BITS_MASK) == rawData))
+	{
+		// None of the odd bits is set (we don't check the last 2 since the state value may be 0b00 or 0b11)
+		PRINTF("%s,Channel=%d,Addr=%d,Padd85=%d,Data=%d,PairLen=%d\n", NAME, BIN_VALUE(CHANNEL), BIN_VALUE(ADDR), BIN_VALUE(PAD), BIN_VALUE(STATE), legacyPairLen);
+		return 1;
+	}
+	else if (nbBits >= 10)
+	{
+		// Decode the raw data
+		PRINTF("%s,Length=%d,Data=0x%08x,PairLen=%d\n", NAME, nbBits, rawData, legacyPairLen);
+		return 1;
+	}
+	
+	return 0;
+}
+
+static uint16_t legacy_decode_rcswitch(uint32_t *pulseLens, uint16_t nbPulses)
+{
+	uint16_t	result = 0;
+	uint16_t	syncOffset = 0;
+	uint16_t	frameOffsets[COMBINE_MAX_FRAMES] = { 0 }, frameLen;
+	uint8_t		nbFrames = 0;
+	uint32_t	*frame;
+	
+	// Combine the repeated frames and decode them once
+	for (syncOffset = 0; nbPulses - syncOffset > MIN_NUM_PULSES && nbFrames < COMBINE_MAX_FRAMES; syncOffset += 2)
+	{
+		if (IS_SYNC_PAIR(pulseLens[syncOffset], pulseLens[syncOffset+1])) {
+			frameOffsets[nbFrames++] = syncOffset;
+		}
+	}
+	
+	frame = legacy_combine_frames(pulseLens, nbPulses, frameOffsets, nbFrames, &frameLen);
+	if (frame != NULL)
+	{
+		legacyPairLen = (frame[0] + frame[1]) / 8;
+		if (legacy_generic_rcswitch_sentence(frame + 2, frameLen - 2, legacyPairLen, legacy_interpret_rcswitch, 0) > 0) {
+			return 1;
+		}
+	}
+	
+	// Otherwise, decode each frame on its own
+	syncOffset = 0;
+	while (nbPulses - syncOffset > MIN_NUM_PULSES)
+	{
+		if (IS_SYNC_PAIR(pulseLens[syncOffset], pulseLens[syncOffset+1]))
+		{
+			// Valid sync pulses found - try and decode the sentence
+			// Each pair of pulses must last (pulseLens[syncOffset] + pulseLens[syncOffset+1]) / 32 * 4
+			legacyPairLen = (pulseLens[syncOffset] + pulseLens[syncOffset+1]) / 8;
+	
+			// Shift to the first data pair
+			syncOffset += 2;
+			result = legacy_generic_rcswitch_sentence(pulseLens + syncOffset, nbPulses - syncOffset, legacyPairLen, legacy_interpret_rcswitch, 0);
+			syncOffset += result;
+		}
+		else
+		{
+			syncOffset += 2;
+		}
+	}
+	
+	return (result > 0);
+}
+
+#define LEGACY_RCSWITCH_MIN_NUM_PULSES	50
+
+#undef NAME
+#undef MIN_SHORT_LEN
+#undef MAX_SHORT_LEN
+#undef MIN_NUM_PULSES
+#undef SYNC_MIN_RATIO
+#undef IS_SYNC_PAIR
+#undef CHANNEL_MASK
+#undef CHANNEL_SHIFT
+#undef ADDR_MASK
+#undef ADDR_SHIFT
+#undef PAD_MASK
+#undef PAD_SHIFT
+#undef STATE_MASK
+#undef STATE_SHIFT
+#undef EVEN_BITS_MASK
+
+/******************************************************************************/
+
+typedef uint16_t (*legacyDecoderFunc_t)(uint32_t *pulseLens, uint16_t nbPulses);
+
+//! Former decoders, and the current decoder which replaces each one
+static const struct {
+	legacyDecoderFunc_t		decoderFunc;
+	uint16_t				minNumPulses;
+	const decoderDesc_t		*current;
+} legacyDecoders[] = {
+	{ legacy_decode_came432,		LEGACY_CAME432_MIN_NUM_PULSES,		&decoder_Came432Na },
+	{ legacy_decode_dipswitch,		LEGACY_DIPSWITCH_MIN_NUM_PULSES,	&decoder_dipSwitch },
+	{ legacy_decode_CarKey1,		LEGACY_CARKEY1_MIN_NUM_PULSES,		&decoder_CarKey1 },
+	{ legacy_decode_UnknownTemp,	LEGACY_UNKNOWNTEMP_MIN_NUM_PULSES,	&decoder_UnknownTemp },
+	{ legacy_decode_rcswitch,		LEGACY_RCSWITCH_MIN_NUM_PULSES,		&decoder_RCSwitch }
+};
+
+#define LEGACY_NB_DECODERS	(sizeof(legacyDecoders) / sizeof(legacyDecoders[0]))
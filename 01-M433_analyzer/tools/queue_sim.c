@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * SENTENCE QUEUE OVERLOAD SIMULATION                                          *
+ *******************************************************************************
+ * Host tool: simulates bursts of sentences arriving faster than the main loop
+ * decodes them, through the priority queue (see User/sentence_queue.h) and
+ * through a FIFO of the same size which drops the new sentences when full.
+ *
+ * Sentences arrive in bursts of BURST_LEN, one every <gap> ms within a burst,
+ * the bursts BURST_PERIOD ms apart. Half of them are decodable: some decoder
+ * matches them (they have candidates) and prints a line. The others are noise:
+ * more jokers, any number of pulses, and candidates for NOISE_CANDIDATES % of
+ * them (the pulse count fits a decoder which then rejects the sentence). They
+ * are scored as the receiver interrupt does (sentenceQueue_score()). Decoding
+ * a sentence takes DECODE_TIME, plus LINE_TIME per printed line (the UART
+ * ring fills up at 57600 bauds).
+ *
+ * The simulation is event driven: each arrival is queued (the index of the
+ * sentence is written into its first two pulses), and the decoder takes the
+ * next sentence as soon as it is free. For each queue, it reports the
+ * decodable sentences decoded, the shed sentences and their share of noise,
+ * and the mean and worst wait of the decoded decodable sentences.
+ *
+ * Build (from 01-M433_analyzer):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o queue_sim tools/queue_sim.c User/sentence_queue.c
+ * Usage:	queue_sim [-n <sentences>] [-s <seed>]
+ *
+ * Exits with 1 if, for any gap, the priority queue decodes fewer decodable
+ * sentences than the FIFO, or sheds fewer noise sentences.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "sentence_queue.h"
+
+//! Traffic (times in us)
+#define BURST_LEN			20
+#define BURST_PERIOD		200000
+#define NOISE_CANDIDATES	20			// %
+
+//! Arrival times must fit in 32 bits
+#define MAX_SENTENCES		300000
+
+//! Decoding time
+#define DECODE_TIME			200
+#define LINE_TIME			5000
+
+//! Gaps between the sentences of a burst
+static const uint32_t		gaps[] = { 1000, 2000 };
+#define NB_GAPS				(sizeof(gaps) / sizeof(gaps[0]))
+
+//! Simulated sentence
+typedef struct {
+	uint32_t		arrival;
+	uint16_t		nbPulses;
+	uint8_t			nbJokers;
+	uint8_t			nbLines;		// Printed when decoded: 1 if decodable
+	decoderMask_t	candidates;
+} simSentence_t;
+
+//! Results of a queue
+typedef struct {
+	uint32_t	decoded;			// Decodable sentences decoded
+	uint32_t	shed;
+	uint32_t	shedNoise;
+	double		waitSum;			// Wait of the decoded decodable sentences (us)
+	uint32_t	maxWait;
+} simResult_t;
+
+enum { PRIORITY, FIFO, NB_QUEUES };
+
+static simSentence_t	*sentences;
+static uint32_t			nbSentences = 20000, nbDecodable;
+
+//! FIFO dropping the new sentences when full
+static uint32_t			fifo[SENTENCE_QUEUE_SIZE];
+static uint8_t			fifoHead, fifoDepth;
+
+
+/*!
+ * @brief Random traffic
+ */
+static void buildTraffic(uint32_t gap)
+{
+	uint32_t		n, t = 0;
+	simSentence_t	*s;
+	
+	
+	nbDecodable = 0;
+	for (n = 0; n < nbSentences; n++)
+	{
+		s = &sentences[n];
+		if (n % BURST_LEN == 0) {
+			t += BURST_PERIOD;
+		} else {
+			t += gap;
+		}
+		s->arrival = t;
+	
+		if (rand() & 1)
+		{
+			s->nbPulses		= 48 + rand() % 150;
+			s->nbJokers		= rand() % 2;
+			s->nbLines		= 1;
+			s->candidates	= 1 + rand() % 0xFF;
+			nbDecodable++;
+		}
+		else
+		{
+			s->nbPulses		= 20 + rand() % (MAX_NUM_PULSES - 20);
+			s->nbJokers		= rand() % 9;
+			s->nbLines		= 0;
+			s->candidates	= (rand() % 100 < NOISE_CANDIDATES) ? 1 + rand() % 0xFF : 0;
+		}
+	}
+}
+
+static uint32_t decodeTime(const simSentence_t *s)
+{
+	return DECODE_TIME + s->nbLines * LINE_TIME;
+}
+
+/*!
+ * @brief Queue an arrival
+ * @return The slot to record the next sentence into (priority queue)
+ */
+static sentence_t *queueArrival(uint8_t queue, sentence_t *recording, uint32_t n, simResult_t *result)
+{
+	const simSentence_t	*s = &sentences[n];
+	
+	
+	if (queue == FIFO)
+	{
+		if (fifoDepth == SENTENCE_QUEUE_SIZE)
+		{
+			result->shed++;
+			result->shedNoise += (s->candidates == 0);
+			return recording;
+		}
+		fifo[(fifoHead + fifoDepth++) % SENTENCE_QUEUE_SIZE] = n;
+		return recording;
+	}
+	
+	recording->pulseLens[0]	= n & 0xFFFF;
+	recording->pulseLens[1]	= n >> 16;
+	recording->nbPulses		= s->nbPulses;
+	recording->candidates	= s->candidates;
+	recording->streamed		= 0;
+	recording->score		= sentenceQueue_score(s->nbPulses, s->candidates, s->nbJokers);
+	return sentenceQueue_push(recording);
+}
+
+/*!
+ * @brief Take the next sentence to decode
+ * @return Its index, or -1 if the queue is empty
+ */
+static int32_t takeNext(uint8_t queue, sentence_t **decoding)
+{
+	int32_t	n;
+	
+	
+	if (queue == FIFO)
+	{
+		if (fifoDepth == 0) {
+			return -1;
+		}
+		n = fifo[fifoHead];
+		fifoHead = (fifoHead + 1) % SENTENCE_QUEUE_SIZE;
+		fifoDepth--;
+		return n;
+	}
+	
+	if ((*decoding = sentenceQueue_pop()) == NULL) {
+		return -1;
+	}
+	return (*decoding)->pulseLens[0] | ((int32_t)(*decoding)->pulseLens[1] << 16);
+}
+
+static void simulate(uint8_t queue, simResult_t *result)
+{
+	sentence_t		*recording, *decoding = NULL;
+	uint32_t		next = 0, busyUntil = 0, wait;
+	int32_t			current = -1;
+	
+	
+	memset(result, 0, sizeof(*result));
+	memset(&sentenceQueueStats, 0, sizeof(sentenceQueueStats));
+	recording = sentenceQueue_init();
+	fifoHead = fifoDepth = 0;
+	
+	while (next < nbSentences || current >= 0)
+	{
+		if (current >= 0 && (next == nbSentences || busyUntil <= sentences[next].arrival))
+		{
+			// End of a decoding, the decoder takes the next sentence
+			if (sentences[current].nbLines > 0)
+			{
+				result->decoded++;
+				wait = busyUntil - decodeTime(&sentences[current]) - sentences[current].arrival;
+				result->waitSum += wait;
+				if (wait > result->maxWait) {
+					result->maxWait = wait;
+				}
+			}
+			if (queue == PRIORITY) {
+				sentenceQueue_release(decoding);
+			}
+			current = takeNext(queue, &decoding);
+			if (current >= 0) {
+				busyUntil += decodeTime(&sentences[current]);
+			}
+			continue;
+		}
+	
+		// Arrival
+		recording = queueArrival(queue, recording, next, result);
+		if (current < 0 && (current = takeNext(queue, &decoding)) >= 0) {
+			busyUntil = sentences[next].arrival + decodeTime(&sentences[current]);
+		}
+		next++;
+	}
+	
+	if (queue == PRIORITY)
+	{
+		result->shed		= sentenceQueueStats.shed;
+		result->shedNoise	= sentenceQueueStats.shedNoise;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static const char * const	queueNames[NB_QUEUES] = { "priority", "FIFO" };
+	simResult_t		results[NB_QUEUES];
+	unsigned int	seed = 1;
+	uint8_t			g, q, failed = 0;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbSentences = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbSentences == 0 || nbSentences > MAX_SENTENCES)
+	{
+		fprintf(stderr, "Usage: %s [-n <sentences (up to %d)>] [-s <seed>]\n", argv[0], MAX_SENTENCES);
+		return 1;
+	}
+	sentences = malloc(nbSentences * sizeof(*sentences));
+	if (sentences == NULL) {
+		return 1;
+	}
+	
+	printf("%lu sentences in bursts of %d every %d ms, queue of %d, decoding %.1f ms + %.1f ms per line\n",
+		(unsigned long)nbSentences, BURST_LEN, BURST_PERIOD / 1000, SENTENCE_QUEUE_SIZE, DECODE_TIME / 1000.0, LINE_TIME / 1000.0);
+	printf("Gap  | queue    | decodable decoded | shed  (noise)          | wait (ms): mean  worst\n");
+	for (g = 0; g < NB_GAPS; g++)
+	{
+		for (q = 0; q < NB_QUEUES; q++)
+		{
+			srand(seed);
+			buildTraffic(gaps[g]);
+			simulate(q, &results[q]);
+			printf("%d ms | %-8s | %7lu  %6.1f%%   | %5lu (%5lu, %5.1f%%) | %14.1f %6.1f\n", (int)(gaps[g] / 1000), queueNames[q],
+				(unsigned long)results[q].decoded, 100.0 * results[q].decoded / nbDecodable,
+				(unsigned long)results[q].shed, (unsigned long)results[q].shedNoise,
+				results[q].shed ? 100.0 * results[q].shedNoise / results[q].shed : 0.0,
+				results[q].decoded ? results[q].waitSum / (1000.0 * results[q].decoded) : 0.0, results[q].maxWait / 1000.0);
+		}
+		if (results[PRIORITY].decoded < results[FIFO].decoded || results[PRIORITY].shedNoise < results[FIFO].shedNoise) {
+			failed = 1;
+		}
+	}
+	
+	free(sentences);
+	if (failed)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * INTEGER TOLERANCE CHECKS                                                    *
+ *******************************************************************************
+ * Host tool: checks the integer tolerance and ratio tests of the decoders
+ * against the double-precision expressions they replaced, and times both.
+ *
+ * The former expressions are copied below. Each check is run on every value
+ * around its boundaries, over the whole range of the pulse lens (16 bits), and
+ * on random values:
+ * 	- SIMILAR() of the default decoder: v/ref within 1 +/- 15%,
+ * 	- PWM_BIT_RATIO pairs (generic RCSwitch, RCSwitch): pair len within 10% of
+ * 	  the reference, then long/short ratio above 2, through pwm_decode_frame(),
+ * 	- PWM_SYNC_RATIO sync (RCSwitch): low/high ratio above 20.
+ * Any accept/reject decision which differs is printed.
+ *
+ * The times are the host's: a Cortex-M4F has no double-precision FPU, the
+ * former expressions were emulated in software there.
+ *
+ * Build (from 01-M433_analyzer; this tool includes default.c, for SIMILAR()):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o ratio_check tools/ratio_check.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|protocol_store\|router")
+ * Usage:	ratio_check
+ *
+ * Exits with 1 if any decision differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "default.c"
+#include "generic_pwm_kernel.h"
+
+#define NB_RANDOM			10000000
+#define NB_TIMED			1000000
+#define MAX_PULSE_LEN		0xFFFF
+
+// Former expressions (double precision)
+#define OLD_PULSE_TOLERANCE		0.15
+#define OLD_SIMILAR(v,ref)		(((double)v / (double)ref) > (1-OLD_PULSE_TOLERANCE) && ((double)v / (double)ref) < (1+OLD_PULSE_TOLERANCE))
+
+#define OLD_PAIR_TOLERANCE		0.10
+#define OLD_LONG_SHORT_RATIO	2.0
+#define OLD_SYNC_RATIO			20.0
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+void output_send(char *message)
+{
+	(void)message;
+}
+
+//! PWM_BIT_RATIO pairs, as the generic RCSwitch decoder
+static const pwmProtocol_t	ratioProtocol = {
+	.encoding		= PWM_BIT_RATIO,
+	.pairTolerance	= 10,
+	.bitRatio		= 2,
+	.maxBits		= 32
+};
+
+//! PWM_SYNC_RATIO sync, as the RCSwitch decoder
+static const pwmProtocol_t	syncProtocol = {
+	.syncShape		= PWM_SYNC_RATIO,
+	.syncRatio		= 20
+};
+
+static uint32_t		nbErrors = 0, nbChecks = 0;
+
+//! Random pulse lens, for the timings, and their results (not to be optimized out)
+static uint16_t				timed[NB_TIMED][2];
+static volatile uint32_t	timingSink;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint32_t random16(void)
+{
+	return (uint32_t)rand() & MAX_PULSE_LEN;
+}
+
+/*!
+ * @brief Former decision on a pair: -1 if rejected, else the bit
+ */
+static int oldPairBit(uint32_t high, uint32_t low, uint32_t pairLen)
+{
+	uint32_t	minPairLen, maxPairLen;
+	
+	
+	if (pairLen == 0) {
+		pairLen = high + low;
+	}
+	minPairLen = (uint32_t)(pairLen * (1.0 - OLD_PAIR_TOLERANCE));
+	maxPairLen = (uint32_t)(pairLen * (1.0 + OLD_PAIR_TOLERANCE));
+	if (high + low <= minPairLen || high + low >= maxPairLen) {
+		return -1;
+	}
+	if ((double)high / (double)low > OLD_LONG_SHORT_RATIO) {
+		return 1;
+	}
+	if ((double)low / (double)high > OLD_LONG_SHORT_RATIO) {
+		return 0;
+	}
+	return -1;
+}
+
+/*!
+ * @brief Decision of the PWM engine on a pair: -1 if rejected, else the bit
+ */
+static int newPairBit(uint32_t high, uint32_t low, uint32_t pairLen)
+{
+	uint16_t	pulseLens[2] = { (uint16_t)high, (uint16_t)low };
+	pwmFrame_t	frame;
+	
+	
+	if (pwm_decode_frame(&ratioProtocol, pulseLens, 2, pairLen, &frame) != 2) {
+		return -1;
+	}
+	return frame.bits.words[0] >> 31;
+}
+
+static uint8_t oldSync(uint32_t high, uint32_t low)
+{
+	return OLD_SYNC_RATIO < (double)low / (double)high;
+}
+
+static uint8_t newSync(uint32_t high, uint32_t low)
+{
+	uint16_t	pulseLens[2] = { (uint16_t)high, (uint16_t)low };
+	
+	
+	return pwm_kernel_isSync(&syncProtocol, pulseLens);
+}
+
+static void checkSimilar(uint32_t v, uint32_t ref)
+{
+	if (v > MAX_PULSE_LEN) {
+		return;
+	}
+	nbChecks++;
+	if ((SIMILAR(v, ref) != 0) != (OLD_SIMILAR(v, ref) != 0))
+	{
+		if (nbErrors++ < 10) {
+			printf("SIMILAR(%lu, %lu): %d, was %d\n", (unsigned long)v, (unsigned long)ref, SIMILAR(v, ref) != 0, OLD_SIMILAR(v, ref) != 0);
+		}
+	}
+}
+
+static void checkPair(uint32_t high, uint32_t low, uint32_t pairLen)
+{
+	int		bit, oldBit;
+	
+	
+	if (high > MAX_PULSE_LEN || low > MAX_PULSE_LEN) {
+		return;
+	}
+	nbChecks++;
+	bit		= newPairBit(high, low, pairLen);
+	oldBit	= oldPairBit(high, low, pairLen);
+	if (bit != oldBit)
+	{
+		if (nbErrors++ < 10) {
+			printf("Pair %lu/%lu (pair len %lu): %d, was %d\n", (unsigned long)high, (unsigned long)low, (unsigned long)pairLen, bit, oldBit);
+		}
+	}
+}
+
+static void checkSync(uint32_t high, uint32_t low)
+{
+	if (high > MAX_PULSE_LEN || low > MAX_PULSE_LEN) {
+		return;
+	}
+	nbChecks++;
+	if (newSync(high, low) != oldSync(high, low))
+	{
+		if (nbErrors++ < 10) {
+			printf("Sync %lu/%lu: %d, was %d\n", (unsigned long)high, (unsigned long)low, newSync(high, low), oldSync(high, low));
+		}
+	}
+}
+
+int main(void)
+{
+	uint32_t	ref, pairLen, n, i, sum = 0;
+	int32_t		d;
+	double		t0, t1, t2;
+	
+	
+	// Around the boundaries, over the whole range
+	for (ref = 0; ref <= MAX_PULSE_LEN; ref++)
+	{
+		checkSimilar(0, ref);
+		checkSimilar(ref, ref);
+		checkSimilar(MAX_PULSE_LEN, ref);
+		for (d = -3; d <= 3; d++)
+		{
+			checkSimilar(ref * 85 / 100 + d, ref);
+			checkSimilar(ref * 115 / 100 + d, ref);
+	
+			// Long/short ratio: the pair len matches
+			checkPair(2 * ref + d, ref, 0);
+			checkPair(ref, 2 * ref + d, 0);
+	
+			// Sync ratio
+			checkSync(ref, 20 * ref + d);
+		}
+	}
+	for (pairLen = 0; pairLen <= 2 * MAX_PULSE_LEN; pairLen++)
+	{
+		// Pair len window: a long/short pair which only depends on it
+		for (d = -3; d <= 3; d++)
+		{
+			n = pairLen * 90 / 100 + d;
+			checkPair(n - n / 4, n / 4, pairLen);
+			n = pairLen * 110 / 100 + d;
+			checkPair(n - n / 4, n / 4, pairLen);
+		}
+	}
+	printf("Boundaries: %lu checks\n", (unsigned long)nbChecks);
+	
+	// Random values
+	srand(1);
+	for (i = 0; i < NB_RANDOM; i++)
+	{
+		checkSimilar(random16(), random16());
+		checkPair(random16(), random16(), (i & 1) ? 0 : random16() + random16());
+		checkSync(random16() >> (rand() % 16), random16());
+	}
+	printf("Random:     %lu checks in total\n", (unsigned long)nbChecks);
+	
+	// Times of the ratio tests alone
+	for (i = 0; i < NB_TIMED; i++)
+	{
+		timed[i][0] = random16();
+		timed[i][1] = random16();
+	}
+	t0 = now();
+	for (i = 0; i < NB_TIMED; i++) {
+		sum += SIMILAR((uint32_t)timed[i][0], (uint32_t)timed[i][1]) + (timed[i][0] > 2 * (uint32_t)timed[i][1]) + (timed[i][1] > 20 * (uint32_t)timed[i][0]);
+	}
+	t1 = now();
+	for (i = 0; i < NB_TIMED; i++) {
+		sum += OLD_SIMILAR(timed[i][0], timed[i][1]) + ((double)timed[i][0] / (double)timed[i][1] > OLD_LONG_SHORT_RATIO) +
+				(OLD_SYNC_RATIO < (double)timed[i][1] / (double)timed[i][0]);
+	}
+	t2 = now();
+	timingSink = sum;
+	printf("Host time:  %.2f ns integer, %.2f ns double (SIMILAR + bit ratio + sync ratio)\n",
+		(t1 - t0) / NB_TIMED, (t2 - t1) / NB_TIMED);
+	
+	if (nbErrors > 0)
+	{
+		printf("%lu decisions differ\n", (unsigned long)nbErrors);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*******************************************************************************
+ * DECODED RECORDS BENCHMARK                                                   *
+ *******************************************************************************
+ * Host tool: measures the time the records (see User/decoders/record.h) remove
+ * from the decode path.
+ *
+ * Every sentence of the captures is decoded by the decoders enabled in
+ * defines.h, as dispatched by the firmware, then by the default decoder if none
+ * matched (learner, DefaultRCS and raw pulses...): they only queue records.
+ * The sinks then print the records (record_poll()), as the main loop does once
+ * the decoders are done. Both are timed: before the records, the decoders
+ * formatted their lines themselves, so the sink time is what left the decode
+ * path. The sentences which reach the default decoder are also given apart.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o record_bench tools/record_bench.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "protocol_store\|router")
+ * Usage:	record_bench <capture> [...]
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "main.h"
+#include "record.h"
+
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+//! Runs of each sentence: the fastest run is kept, the others met noise
+#define TIMING_RUNS			20
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Lines printed by the sinks
+static uint32_t		nbLines;
+
+void output_send(char *message)
+{
+	(void)message;
+	nbLines++;
+}
+
+uint16_t	decode_default(uint16_t *pulseLens, uint16_t nbPulses);
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+int main(int argc, char **argv)
+{
+	FILE			*file;
+	decoderMask_t	mask;
+	uint32_t		nbSentences = 0, nbDecoded = 0, nbDefault = 0, emitted;
+	uint16_t		nbPulses, result;
+	uint8_t			i, run;
+	double			t0, t1, t2, decode, sink;
+	double			decodeTime = 0, sinkTime = 0, decodedTime = 0, decodedSinkTime = 0;
+	double			defaultTime = 0, defaultSinkTime = 0;
+	int				a;
+	
+	
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <capture> [...]\n", argv[0]);
+		return 1;
+	}
+	
+	for (a = 1; a < argc; a++)
+	{
+		if ((file = fopen(argv[a], "r")) == NULL)
+		{
+			perror(argv[a]);
+			return 1;
+		}
+	
+		while (fgets(line, sizeof(line), file) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) == 0) {
+				continue;
+			}
+			nbSentences++;
+			mask = decoder_dispatchMask(nbPulses);
+			emitted = recordStats.emitted + recordStats.merged;
+			decode = sink = 1e12;
+	
+			for (run = 0; run < TIMING_RUNS; run++)
+			{
+				// Decode path: the decoders, which only queue records
+				t0 = now();
+				result = 0;
+				for (i = 0; i < NUM_DECODERS; i++)
+				{
+					if (mask & DECODER_BIT(i))
+					{
+						memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+						result += decoders[i]->decoderFunc(work, nbPulses);
+					}
+				}
+				if (result == 0)
+				{
+					memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+					decode_default(work, nbPulses);
+				}
+				t1 = now();
+	
+				// Main loop, after the decoders: the sinks
+				record_poll();
+				t2 = now();
+	
+				if (t1 - t0 < decode) {
+					decode = t1 - t0;
+				}
+				if (t2 - t1 < sink) {
+					sink = t2 - t1;
+				}
+			}
+			decodeTime	+= decode;
+			sinkTime	+= sink;
+			if (recordStats.emitted + recordStats.merged != emitted)
+			{
+				nbDecoded++;
+				decodedTime		+= decode;
+				decodedSinkTime	+= sink;
+			}
+			if (result == 0)
+			{
+				nbDefault++;
+				defaultTime		+= decode;
+				defaultSinkTime	+= sink;
+			}
+			sysTickTime += 100000;
+		}
+		fclose(file);
+	}
+	
+	if (nbSentences == 0)
+	{
+		fprintf(stderr, "No sentence\n");
+		return 1;
+	}
+	
+	printf("Sentences:        %lu, decoded %lu\n", (unsigned long)nbSentences, (unsigned long)nbDecoded);
+	printf("Records:          %lu emitted, %lu merged, %lu lost, %lu lines printed (per pass)\n",
+		(unsigned long)(recordStats.emitted / TIMING_RUNS), (unsigned long)(recordStats.merged / TIMING_RUNS),
+		(unsigned long)(recordStats.lost / TIMING_RUNS), (unsigned long)(nbLines / TIMING_RUNS));
+	printf("Decode path:      %.0f ns/sentence (%.0f ns/decoded sentence)\n",
+		decodeTime / nbSentences, (nbDecoded > 0 ? decodedTime / nbDecoded : 0));
+	printf("Sinks:            %.0f ns/sentence (%.0f ns/decoded sentence)\n",
+		sinkTime / nbSentences, (nbDecoded > 0 ? decodedSinkTime / nbDecoded : 0));
+	printf("Default decoder:  %lu sentences, %.0f ns/sentence decode path, %.0f ns/sentence sinks\n", (unsigned long)nbDefault,
+		(nbDefault > 0 ? defaultTime / nbDefault : 0), (nbDefault > 0 ? defaultSinkTime / nbDefault : 0));
+	printf("Removed from the decode path: %.1f%% of the former decode time (%.1f%% on the default decoder sentences)\n",
+		100 * sinkTime / (decodeTime + sinkTime), (nbDefault > 0 ? 100 * defaultSinkTime / (defaultTime + defaultSinkTime) : 0));
+	
+	return 0;
+}
@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * DECODER REGISTRY CHECK                                                      *
+ *******************************************************************************
+ * Host tool: checks the tables generated from DECODER_TABLE (see
+ * User/decoders/decoder.h) against the decoder descriptors.
+ *
+ * The decoders enabled in defines.h are registered at run time, the way main()
+ * used to do it, from their USE_* switches and their descriptors. The
+ * compile-time tables must give the same result:
+ * 	- the decoder list holds every enabled decoder once, in the call order,
+ * 	- the GLOBAL_* limits are the union of the descriptor limits,
+ * 	- decoder_dispatchMask() selects, for every pulse count, the decoders whose
+ * 	  minNumPulses is below it.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o registry_check tools/registry_check.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	registry_check
+ *
+ * Prints the tables, and exits with 1 if any of them differs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+void output_send(char *message)
+{
+	(void)message;
+}
+
+//! Decoder list, as built by main()
+static const decoderDesc_t * const	decoderList[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+//! Limits of the rows of the table
+#define ROW_LIMITS(desc, minLen, maxLen, minNum)	{ &desc, minLen, maxLen, minNum },
+
+static const struct {
+	const decoderDesc_t	*desc;
+	uint32_t			minPulseLen;
+	uint32_t			maxPulseLen;
+	uint16_t			minNumPulses;
+} rows[NUM_DECODERS] = {
+	DECODER_TABLE(ROW_LIMITS)
+};
+
+//! Registered decoders and global filter, as main() did at boot
+static const decoderDesc_t	*registered[8 * sizeof(decoderMask_t)];
+static uint8_t				nbRegistered = 0;
+static decoderDesc_t		globalFilter = {
+	.minPulseLen	= 0xFFFFFFFF,
+	.maxPulseLen	= 0,
+	.minNumPulses	= 0xFFFF
+};
+
+static uint32_t				nbErrors = 0;
+
+
+static void registerDecoder(const decoderDesc_t *decoder)
+{
+	registered[nbRegistered++] = decoder;
+	if (decoder->minNumPulses < globalFilter.minNumPulses) {
+		globalFilter.minNumPulses = decoder->minNumPulses;
+	}
+	if (decoder->minPulseLen < globalFilter.minPulseLen) {
+		globalFilter.minPulseLen = decoder->minPulseLen;
+	}
+	if (decoder->maxPulseLen > globalFilter.maxPulseLen) {
+		globalFilter.maxPulseLen = decoder->maxPulseLen;
+	}
+}
+
+/*!
+ * @brief Register the enabled decoders in the call order
+ */
+static void registerDecoders(void)
+{
+	// Sensors
+#ifdef USE_OREGON_EW91
+	registerDecoder(&decoder_OregonEW91);
+#endif
+#ifdef USE_OREGON_V2
+	registerDecoder(&decoder_OregonV2);
+#endif
+	// Home automation
+#ifdef USE_RCSWITCH
+	registerDecoder(&decoder_RCSwitch);
+#endif
+#ifdef USE_HOME_EASY
+	registerDecoder(&decoder_HomeEasy);
+#endif
+#ifdef USE_X10_RF
+	registerDecoder(&decoder_X10Rf);
+#endif
+	// Garage doors
+#ifdef USE_CAME_432NA
+	registerDecoder(&decoder_Came432Na);
+#endif
+#ifdef USE_DIP_SWITCH
+	registerDecoder(&decoder_dipSwitch);
+#endif
+	// Car key fobs
+#ifdef USE_CARKEY_1
+	registerDecoder(&decoder_CarKey1);
+#endif
+#ifdef USE_SIEMENS_VDO
+	registerDecoder(&decoder_siemensVdo);
+#endif
+}
+
+static void check(int ok, const char *what, long expected, long got)
+{
+	if (!ok)
+	{
+		printf("MISMATCH %s: expected %ld, got %ld\n", what, expected, got);
+		nbErrors++;
+	}
+}
+
+int main(void)
+{
+	decoderMask_t	mask, expected;
+	uint16_t		nbPulses;
+	uint8_t			i;
+	char			what[64];
+	
+	
+	registerDecoders();
+	
+	// Decoder list
+	printf("%d decoders:\n", NUM_DECODERS);
+	check(nbRegistered == NUM_DECODERS, "NUM_DECODERS", nbRegistered, NUM_DECODERS);
+	for (i = 0; i < NUM_DECODERS && i < nbRegistered; i++)
+	{
+		printf("  %2d %-16s minPulseLen=%5lu maxPulseLen=%5lu minNumPulses=%4d\n", i, (const char *)decoderList[i]->name,
+			(unsigned long)decoderList[i]->minPulseLen, (unsigned long)decoderList[i]->maxPulseLen, decoderList[i]->minNumPulses);
+		if (decoderList[i] != registered[i])
+		{
+			printf("MISMATCH decoder %d: expected %s\n", i, (const char *)registered[i]->name);
+			nbErrors++;
+		}
+	
+		// The rows must hold the limits of their descriptor
+		snprintf(what, sizeof(what), "%s row minPulseLen", (const char *)decoderList[i]->name);
+		check(rows[i].desc == decoderList[i] && rows[i].minPulseLen == decoderList[i]->minPulseLen, what, decoderList[i]->minPulseLen, rows[i].minPulseLen);
+		snprintf(what, sizeof(what), "%s row maxPulseLen", (const char *)decoderList[i]->name);
+		check(rows[i].maxPulseLen == decoderList[i]->maxPulseLen, what, decoderList[i]->maxPulseLen, rows[i].maxPulseLen);
+		snprintf(what, sizeof(what), "%s row minNumPulses", (const char *)decoderList[i]->name);
+		check(rows[i].minNumPulses == decoderList[i]->minNumPulses, what, decoderList[i]->minNumPulses, rows[i].minNumPulses);
+	}
+	
+	// Global filter
+	printf("Global filter: minPulseLen=%lu maxPulseLen=%lu minNumPulses=%d\n",
+		(unsigned long)GLOBAL_MIN_PULSE_LEN, (unsigned long)GLOBAL_MAX_PULSE_LEN, GLOBAL_MIN_NUM_PULSES);
+	check(GLOBAL_MIN_PULSE_LEN == globalFilter.minPulseLen, "GLOBAL_MIN_PULSE_LEN", globalFilter.minPulseLen, GLOBAL_MIN_PULSE_LEN);
+	check(GLOBAL_MAX_PULSE_LEN == globalFilter.maxPulseLen, "GLOBAL_MAX_PULSE_LEN", globalFilter.maxPulseLen, GLOBAL_MAX_PULSE_LEN);
+	check(GLOBAL_MIN_NUM_PULSES == globalFilter.minNumPulses, "GLOBAL_MIN_NUM_PULSES", globalFilter.minNumPulses, GLOBAL_MIN_NUM_PULSES);
+	
+	// Dispatch masks, for every sentence length the receiver can capture
+	for (nbPulses = 0; nbPulses <= MAX_NUM_PULSES; nbPulses++)
+	{
+		expected = 0;
+		for (i = 0; i < nbRegistered; i++)
+		{
+			if (nbPulses > registered[i]->minNumPulses) {
+				expected |= DECODER_BIT(i);
+			}
+		}
+		mask = decoder_dispatchMask(nbPulses);
+		snprintf(what, sizeof(what), "dispatch mask of %d pulses", nbPulses);
+		check(mask == expected, what, expected, mask);
+		if (nbPulses == 0 || mask != decoder_dispatchMask(nbPulses - 1)) {
+			printf("Dispatch from %4d pulses: 0x%08lX\n", nbPulses, (unsigned long)mask);
+		}
+	}
+	
+	if (nbErrors > 0)
+	{
+		printf("%lu mismatches\n", (unsigned long)nbErrors);
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,292 @@
+/*******************************************************************************
+ * SYNTHETIC ROUTER CAPTURES                                                   *
+ *******************************************************************************
+ * Host tool: writes a synthetic capture for tools/router_train.c, with the
+ * sentences of every built-in decoder and noise, in random order:
+ * 	- OregonEW91:	63 bits of 1.9/4.0 ms pulses after a 4-pulse preamble
+ * 					(see tools/ew91_noise.c),
+ * 	- OregonV2:		V2.1 and V3 frames (see tools/oregon_frames.c),
+ * 	- RCSwitch, Came432Na, DIPswitch, CarKey1: PWM frames after their sync
+ * 					(see tools/timebase_yield.c),
+ * 	- HomeEasy:		32 Manchester bits, one half-bit per pair, after a
+ * 					275+2675 us sync,
+ * 	- X10:			32 bits after a 8800+4400 us sync, each frame followed by
+ * 					a 40 ms gap,
+ * 	- SiemensVdo:	64 pulses of 250/500 us after a 2500+2500 us sync,
+ * 	- noise:		40 to 300 random pulses of 100 to 5000 us.
+ * The protocol sentences hold 1 to MAX_FRAMES frames (OregonV2: one), with the
+ * timebase of each sentence scaled by 0.9 to 1.1, and each pulse moved by up to
+ * +/-JITTER %.
+ *
+ * The lines are "Raw,<pulse lens>,0", as dumped by the analyzer. The committed
+ * router_tree.h was trained on the default capture:
+ * 		router_captures > capture.txt
+ * 		router_train capture.txt > User/decoders/router_tree.h
+ * It must be trained again on captures of the actual transmitters.
+ *
+ * Build:	gcc -O2 -o router_captures tools/router_captures.c
+ * Usage:	router_captures [-n <sentences>] [-s <seed>] > <capture>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "oregon_frames.c"
+
+#define MAX_SENTENCE_LEN	1024
+#define MAX_FRAMES			5
+
+#define JITTER				5		// % of each pulse
+#define MIN_SCALE			90		// % of the nominal timebase
+#define MAX_SCALE			110
+
+#define EW91_SHORT			1900	// us
+#define EW91_LONG			4000
+#define EW91_NB_BITS		63
+
+#define HOME_EASY_HIGH		275
+#define HOME_EASY_SYNC		2675
+#define HOME_EASY_SHORT		240
+#define HOME_EASY_LONG		1300
+#define HOME_EASY_GAP		10000
+
+#define X10_SYNC_HIGH		8800
+#define X10_SYNC_LOW		4400
+#define X10_SHORT			550
+#define X10_LONG			1650
+#define X10_GAP				40000
+
+#define SIEMENS_SHORT		250
+#define SIEMENS_LONG		500
+#define SIEMENS_SYNC		2500
+
+#define NOISE_MIN_LEN		100
+#define NOISE_MAX_LEN		5000
+
+//! PWM frame: a sync before each frame, and a last one after them (see tools/timebase_yield.c)
+typedef struct {
+	uint16_t	syncHigh, syncLow;
+	uint16_t	first;			// 0: pairLen - second pulse
+	uint16_t	pairLen;
+	uint16_t	zero, one;		// Second pulse of a 0 and of a 1
+	uint8_t		nbBits;
+} pwmFrame_t;
+
+enum {
+	KIND_OREGON_EW91, KIND_OREGON_V2, KIND_RCSWITCH, KIND_HOME_EASY, KIND_X10,
+	KIND_CAME_432NA, KIND_DIP_SWITCH, KIND_CARKEY_1, KIND_SIEMENS_VDO, KIND_NOISE,
+	NB_KINDS
+};
+
+static const pwmFrame_t		rcswitch	= { 350,	10850,	0,		1400,	1050,	350,	24 };
+static const pwmFrame_t		came432Na	= { 345,	15600,	0,		1020,	345,	675,	13 };
+static const pwmFrame_t		dipSwitch	= { 710,	26000,	0,		2130,	1420,	710,	12 };
+static const pwmFrame_t		carKey1		= { 1000,	2000,	0,		1700,	1200,	500,	66 };
+
+static uint16_t		pulseLens[MAX_SENTENCE_LEN];
+static uint16_t		nbPulses;
+
+
+static void addPulse(uint32_t len)
+{
+	if (nbPulses < MAX_SENTENCE_LEN) {
+		pulseLens[nbPulses++] = len;
+	}
+}
+
+static void buildPwm(const pwmFrame_t *protocol, uint8_t nbFrames)
+{
+	uint8_t		bits[80], i, frame;
+	uint16_t	second;
+	
+	
+	for (i = 0; i < protocol->nbBits; i++) {
+		bits[i] = rand() & 1;
+	}
+	for (frame = 0; frame <= nbFrames; frame++)
+	{
+		addPulse(protocol->syncHigh);
+		addPulse(protocol->syncLow);
+		for (i = 0; frame < nbFrames && i < protocol->nbBits; i++)
+		{
+			second = bits[i] ? protocol->one : protocol->zero;
+			addPulse(protocol->first ? protocol->first : protocol->pairLen - second);
+			addPulse(second);
+		}
+	}
+}
+
+static void buildEw91(void)
+{
+	uint8_t		bytes[8], i;
+	
+	
+	// Bytes 4-7 are the complements of bytes 0-3 (see User/decoders/oregon_ew91.c)
+	for (i = 0; i < 4; i++)
+	{
+		bytes[i] = rand() & (i == 0 ? 0x7F : 0xFF);
+		bytes[4 + i] = bytes[i] ^ 0xFF;
+	}
+	for (i = 0; i < 4; i++) {
+		addPulse(EW91_SHORT);
+	}
+	addPulse(EW91_LONG);
+	addPulse(EW91_LONG);
+	for (i = 1; i <= EW91_NB_BITS; i++)
+	{
+		addPulse(EW91_SHORT);
+		addPulse(((bytes[i / 8] >> (7 - i % 8)) & 1) ? EW91_LONG : EW91_SHORT);
+	}
+}
+
+static void buildOregonV2(void)
+{
+	oregonFrame_t	frame;
+	
+	
+	oregonFrame_random(&frame, (rand() & 1) ? 3 : 2);
+	nbPulses = oregonFrame_sentence(&frame, 0, 0, pulseLens);
+}
+
+static void buildHomeEasy(uint8_t nbFrames)
+{
+	uint32_t	data = ((uint32_t)rand() << 16) ^ rand();
+	uint8_t		r, i, bit;
+	
+	
+	for (r = 0; r < nbFrames; r++)
+	{
+		addPulse(HOME_EASY_HIGH);
+		addPulse(HOME_EASY_SYNC);
+		for (i = 0; i < 32; i++)
+		{
+			bit = (data >> (31 - i)) & 1;
+			addPulse(HOME_EASY_HIGH);
+			addPulse(bit ? HOME_EASY_LONG : HOME_EASY_SHORT);
+			addPulse(HOME_EASY_HIGH);
+			addPulse(bit ? HOME_EASY_SHORT : HOME_EASY_LONG);
+		}
+		addPulse(HOME_EASY_HIGH);
+		addPulse(HOME_EASY_GAP);
+	}
+}
+
+static void buildX10(uint8_t nbFrames)
+{
+	uint8_t		b0 = rand(), b2 = rand(), r, i;
+	uint32_t	data = ((uint32_t)b0 << 24) | ((uint32_t)(b0 ^ 0xFF) << 16) | ((uint32_t)b2 << 8) | (b2 ^ 0xFF);
+	
+	
+	for (r = 0; r < nbFrames; r++)
+	{
+		addPulse(X10_SYNC_HIGH);
+		addPulse(X10_SYNC_LOW);
+		for (i = 0; i < 32; i++)
+		{
+			addPulse(X10_SHORT);
+			addPulse(((data >> (31 - i)) & 1) ? X10_LONG : X10_SHORT);
+		}
+		addPulse(X10_SHORT);
+		addPulse(X10_GAP);
+	}
+}
+
+static void buildSiemensVdo(uint8_t nbFrames)
+{
+	uint8_t		r, i;
+	
+	
+	for (r = 0; r < nbFrames; r++)
+	{
+		addPulse(SIEMENS_SYNC);
+		addPulse(SIEMENS_SYNC);
+		for (i = 0; i < 64; i++) {
+			addPulse((rand() & 1) ? SIEMENS_LONG : SIEMENS_SHORT);
+		}
+	}
+}
+
+static void buildNoise(void)
+{
+	uint16_t	n = 40 + rand() % 261;
+	
+	
+	while (n--) {
+		addPulse(NOISE_MIN_LEN + rand() % (NOISE_MAX_LEN - NOISE_MIN_LEN + 1));
+	}
+}
+
+/*!
+ * @brief Random sentence, scaled and moved
+ */
+static void buildSentence(void)
+{
+	int32_t		scale = MIN_SCALE + rand() % (MAX_SCALE - MIN_SCALE + 1), len;
+	uint8_t		kind = rand() % NB_KINDS, nbFrames = 1 + rand() % MAX_FRAMES;
+	uint16_t	i;
+	
+	
+	nbPulses = 0;
+	switch (kind)
+	{
+		case KIND_OREGON_EW91:	buildEw91();						break;
+		case KIND_OREGON_V2:	buildOregonV2();					break;
+		case KIND_RCSWITCH:		buildPwm(&rcswitch, nbFrames);		break;
+		case KIND_HOME_EASY:	buildHomeEasy(nbFrames);			break;
+		case KIND_X10:			buildX10(nbFrames);					break;
+		case KIND_CAME_432NA:	buildPwm(&came432Na, nbFrames);		break;
+		case KIND_DIP_SWITCH:	buildPwm(&dipSwitch, nbFrames);		break;
+		case KIND_CARKEY_1:		buildPwm(&carKey1, nbFrames);		break;
+		case KIND_SIEMENS_VDO:	buildSiemensVdo(nbFrames);			break;
+		default:				buildNoise();						break;
+	}
+	
+	if (kind == KIND_NOISE) {
+		return;
+	}
+	for (i = 0; i < nbPulses; i++)
+	{
+		len = (int32_t)pulseLens[i] * scale / 100;
+		len += len * (rand() % (2 * JITTER + 1) - JITTER) / 100;
+		pulseLens[i] = (len < 1 ? 1 : len > 0xFFFF ? 0xFFFF : len);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t		nbSentences = 20000, n;
+	uint16_t		i;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbSentences = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbSentences == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <sentences>] [-s <seed>] > <capture>\n", argv[0]);
+		return 1;
+	}
+	srand(seed);
+	
+	for (n = 0; n < nbSentences; n++)
+	{
+		buildSentence();
+		printf("Raw,");
+		for (i = 0; i < nbPulses; i++) {
+			printf("%d,", pulseLens[i]);
+		}
+		printf("0\n");
+	}
+	return 0;
+}
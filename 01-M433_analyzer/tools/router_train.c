@@ -0,0 +1,498 @@
+/*******************************************************************************
+ * DECODER ROUTER TRAINING                                                     *
+ *******************************************************************************
+ * Host tool: trains the decision tree of the decoder router (see
+ * User/decoders/router.h) on capture files, and writes router_tree.h.
+ *
+ * Every sentence is labeled by running the decoders enabled in defines.h on it
+ * (the labels are the decoders which matched it, or none). Even sentences train
+ * the tree, odd ones evaluate it: routing errors (a sentence whose decoder was
+ * not called), and decoder calls and time saved against the full dispatch.
+ * A split whose two sides end in leaves with the same labels is pruned back to
+ * a leaf, and the nodes are numbered again.
+ *
+ * The committed router_tree.h was trained on a synthetic capture (see
+ * tools/router_captures.c):
+ * 		router_captures > capture.txt
+ * 		router_train capture.txt > User/decoders/router_tree.h
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o router_train tools/router_train.c User/decoders/router.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	router_train <capture> [...] > User/decoders/router_tree.h
+ *
+ * Captures hold one sentence per line, as for tools/learn.c ("Raw,..." lines).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "main.h"
+#include "router.h"
+
+#define MAX_SENTENCES		200000
+#define MAX_LINE_LEN		(8 * MAX_NUM_PULSES)
+
+//! Tree limits
+#define MAX_NODES			ROUTER_LEAF
+#define MAX_DEPTH			10
+#define MIN_LEAF_SIZE		32
+
+//! Share of the sentences of a leaf its labels must cover (1/1000)
+#define MIN_COVERAGE		995
+
+//! Runs of each sentence when timing the decoders
+#define TIMING_RUNS			20
+
+//! Labeled sentence
+typedef struct {
+	uint16_t	features[ROUTER_NB_FEATURES];
+	uint16_t	labels;				// Decoders which matched (ROUTER_LABEL_NONE if none)
+	uint8_t		label;				// Main label: the first decoder which matched
+	uint32_t	nbCalls;			// Decoder calls of the full dispatch
+	double		callTime[NUM_DECODERS];	// Time of each decoder (ns)
+	double		routeTime;			// Time of the router (ns)
+} sample_t;
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+void output_send(char *message)
+{
+	(void)message;
+}
+
+#define TRAIN_DECODER(desc, minLen, maxLen, minNum)		{ &desc, ROUTER_LABEL_ ## desc, #desc },
+
+static const struct {
+	const decoderDesc_t	*desc;
+	uint8_t				label;
+	const char			*name;
+} decoders[NUM_DECODERS] = {
+	DECODER_TABLE(TRAIN_DECODER)
+};
+
+static char			line[MAX_LINE_LEN];
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+static sample_t		*samples;
+static uint32_t		nbSamples;
+
+static routerNode_t	tree[MAX_NODES], pruned[MAX_NODES];
+static uint16_t		nbNodes;
+
+static uint8_t		sortFeature;
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Parse the pulse lens of a sentence (see tools/learn.c)
+ */
+static uint16_t parseSentence(const char *p)
+{
+	uint16_t	nbPulses = 0;
+	long		len;
+	char		*end;
+	
+	
+	if (isalpha((unsigned char)*p) && (p = strchr(p, ',')) == NULL) {
+		return 0;
+	}
+	
+	while (*p != '\0' && nbPulses < MAX_NUM_PULSES)
+	{
+		if (*p == ',' || isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		len = strtol(p, &end, 10);
+		if (end == p || len <= 0 || len > 0xFFFF) {
+			break;
+		}
+		pulseLens[nbPulses++] = (uint16_t)len;
+		p = end;
+	}
+	
+	return nbPulses;
+}
+
+/*!
+ * @brief Label a sentence with the full dispatch, and time the decoders and the router
+ */
+static void labelSentence(uint16_t nbPulses, sample_t *s)
+{
+	decoderMask_t	mask = decoder_dispatchMask(nbPulses);
+	uint8_t			i, run;
+	double			t;
+	
+	
+	memset(s, 0, sizeof(*s));
+	router_features(pulseLens, nbPulses, s->features);
+	
+	t = now();
+	for (run = 0; run < TIMING_RUNS; run++) {
+		router_route(pulseLens, nbPulses);
+	}
+	s->routeTime = (now() - t) / TIMING_RUNS;
+	
+	s->label = ROUTER_LABEL_NONE;
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if (!(mask & DECODER_BIT(i))) {
+			continue;
+		}
+		s->nbCalls++;
+	
+		t = now();
+		for (run = 0; run < TIMING_RUNS; run++)
+		{
+			memcpy(work, pulseLens, nbPulses * sizeof(*work));
+			if (decoders[i].desc->decoderFunc(work, nbPulses) > 0 && run == 0)
+			{
+				s->labels |= ROUTER_LABEL_BIT(decoders[i].label);
+				if (s->label == ROUTER_LABEL_NONE) {
+					s->label = decoders[i].label;
+				}
+			}
+		}
+		s->callTime[i] = (now() - t) / TIMING_RUNS;
+	}
+	if (s->labels == 0) {
+		s->labels = ROUTER_LABEL_BIT(ROUTER_LABEL_NONE);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+static int compareSamples(const void *a, const void *b)
+{
+	return (int)(*(sample_t * const *)a)->features[sortFeature] - (int)(*(sample_t * const *)b)->features[sortFeature];
+}
+
+static double gini(const uint32_t *counts, uint32_t n)
+{
+	double		g = 1;
+	uint8_t		l;
+	
+	
+	for (l = 0; l < ROUTER_NB_LABELS && n > 0; l++) {
+		g -= ((double)counts[l] / n) * ((double)counts[l] / n);
+	}
+	return g;
+}
+
+/*!
+ * @brief Labels of a leaf: the fewest labels (at most 2) covering its sentences
+ */
+static uint16_t leafLabels(sample_t **set, uint32_t n)
+{
+	uint32_t	i, covered, best = 0;
+	uint16_t	labels, bestLabels = ROUTER_ALL_LABELS;
+	uint8_t		a, b, pairs;
+	
+	
+	// Single labels first
+	for (pairs = 0; pairs <= 1 && bestLabels == ROUTER_ALL_LABELS; pairs++)
+	{
+		for (a = 0; a < ROUTER_NB_LABELS; a++)
+		{
+			for (b = (pairs ? a + 1 : a); b < (pairs ? ROUTER_NB_LABELS : a + 1); b++)
+			{
+				labels = ROUTER_LABEL_BIT(a) | ROUTER_LABEL_BIT(b);
+				for (i = 0, covered = 0; i < n; i++) {
+					covered += ((set[i]->labels & ~labels) == 0);
+				}
+				if (1000 * covered >= MIN_COVERAGE * n && covered > best)
+				{
+					best = covered;
+					bestLabels = labels;
+				}
+			}
+		}
+	}
+	return bestLabels;
+}
+
+/*!
+ * @brief Grow the tree on a set of sentences, from a node
+ */
+static void grow(sample_t **set, uint32_t n, uint8_t depth, uint8_t node)
+{
+	uint32_t	counts[ROUTER_NB_LABELS] = { 0 }, left[ROUTER_NB_LABELS], right[ROUTER_NB_LABELS];
+	uint32_t	i, bestSplit = 0;
+	double		score, bestScore;
+	uint8_t		f, bestFeature = ROUTER_LEAF;
+	uint16_t	bestValue = 0;
+	
+	
+	for (i = 0; i < n; i++) {
+		counts[set[i]->label]++;
+	}
+	bestScore = gini(counts, n);
+	
+	if (depth < MAX_DEPTH && n >= 2 * MIN_LEAF_SIZE && bestScore > 0 && nbNodes + 2 <= MAX_NODES)
+	{
+		for (f = 0; f < ROUTER_NB_FEATURES; f++)
+		{
+			sortFeature = f;
+			qsort(set, n, sizeof(*set), compareSamples);
+			memset(left, 0, sizeof(left));
+			memcpy(right, counts, sizeof(right));
+			
+			for (i = 0; i + 1 < n; i++)
+			{
+				left[set[i]->label]++;
+				right[set[i]->label]--;
+				if (set[i]->features[f] == set[i+1]->features[f] || i + 1 < MIN_LEAF_SIZE || n - i - 1 < MIN_LEAF_SIZE) {
+					continue;
+				}
+				score = ((i + 1) * gini(left, i + 1) + (n - i - 1) * gini(right, n - i - 1)) / n;
+				if (score < bestScore - 1e-9)
+				{
+					bestScore	= score;
+					bestFeature	= f;
+					bestValue	= set[i]->features[f];
+					bestSplit	= i + 1;
+				}
+			}
+		}
+	}
+	
+	if (bestFeature == ROUTER_LEAF)
+	{
+		tree[node].feature	= ROUTER_LEAF;
+		tree[node].value	= leafLabels(set, n);
+		return;
+	}
+	
+	// Both children are allocated now, so that the tree never outgrows MAX_NODES
+	sortFeature = bestFeature;
+	qsort(set, n, sizeof(*set), compareSamples);
+	tree[node].feature	= bestFeature;
+	tree[node].value	= bestValue;
+	tree[node].left		= nbNodes++;
+	tree[node].right	= nbNodes++;
+	grow(set, bestSplit, depth + 1, tree[node].left);
+	grow(set + bestSplit, n - bestSplit, depth + 1, tree[node].right);
+}
+
+/*!
+ * @brief Prune the splits whose two sides end in leaves with the same labels
+ */
+static void prune(uint8_t node)
+{
+	routerNode_t	*left, *right;
+	
+	
+	if (tree[node].feature == ROUTER_LEAF) {
+		return;
+	}
+	prune(tree[node].left);
+	prune(tree[node].right);
+	
+	left	= &tree[tree[node].left];
+	right	= &tree[tree[node].right];
+	if (left->feature == ROUTER_LEAF && right->feature == ROUTER_LEAF && left->value == right->value)
+	{
+		tree[node].feature	= ROUTER_LEAF;
+		tree[node].value	= left->value;
+		tree[node].left		= 0;
+		tree[node].right	= 0;
+	}
+}
+
+/*!
+ * @brief Copy the nodes reached from a node, in depth-first order
+ * @return Index of the node in the copy
+ */
+static uint8_t renumber(uint8_t node, routerNode_t *copy, uint16_t *nbCopied)
+{
+	uint8_t		index = (*nbCopied)++;
+	
+	
+	copy[index] = tree[node];
+	if (tree[node].feature != ROUTER_LEAF)
+	{
+		copy[index].left	= renumber(tree[node].left, copy, nbCopied);
+		copy[index].right	= renumber(tree[node].right, copy, nbCopied);
+	}
+	return index;
+}
+
+/*----------------------------------------------------------------------------*/
+static uint16_t predict(const uint16_t *features)
+{
+	const routerNode_t	*node = &tree[0];
+	
+	
+	while (node->feature != ROUTER_LEAF) {
+		node = &tree[features[node->feature] <= node->value ? node->left : node->right];
+	}
+	return node->value;
+}
+
+static void printLabels(uint16_t labels)
+{
+	uint8_t		i, first = 1;
+	
+	
+	if (labels == ROUTER_ALL_LABELS)
+	{
+		printf("ROUTER_ALL_LABELS");
+		return;
+	}
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if (labels & ROUTER_LABEL_BIT(decoders[i].label))
+		{
+			printf("%sROUTER_LABEL_BIT(ROUTER_LABEL_%s)", first ? "" : " | ", decoders[i].name);
+			first = 0;
+		}
+	}
+	if (labels & ROUTER_LABEL_BIT(ROUTER_LABEL_NONE)) {
+		printf("%sROUTER_LABEL_BIT(ROUTER_LABEL_NONE)", first ? "" : " | ");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static const char * const featureNames[ROUTER_NB_FEATURES] = {
+		"ROUTER_FEATURE_NB_PULSES", "ROUTER_FEATURE_PEAK_BIN", "ROUTER_FEATURE_SECOND_BIN",
+		"ROUTER_FEATURE_MAX_LEN", "ROUTER_FEATURE_SYNC_RATIO", "ROUTER_FEATURE_DUTY_CYCLE"
+	};
+	sample_t	**train;
+	FILE		*in;
+	int			a;
+	uint16_t	nbPulses, labels;
+	uint32_t	i, nbTrain = 0, nbTest = 0, lost = 0, fallbacks = 0, lostBy[NUM_DECODERS] = { 0 };
+	double		fullCalls = 0, routedCalls = 0, fullTime = 0, routedTime = 0;
+	uint8_t		d;
+	
+	
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <capture> [...] > router_tree.h\n", argv[0]);
+		return 1;
+	}
+	
+	samples = calloc(MAX_SENTENCES, sizeof(*samples));
+	train = calloc(MAX_SENTENCES, sizeof(*train));
+	for (a = 1; a < argc; a++)
+	{
+		if ((in = fopen(argv[a], "r")) == NULL)
+		{
+			fprintf(stderr, "cannot open %s\n", argv[a]);
+			return 1;
+		}
+		while (nbSamples < MAX_SENTENCES && fgets(line, sizeof(line), in) != NULL)
+		{
+			if ((nbPulses = parseSentence(line)) <= GLOBAL_MIN_NUM_PULSES) {
+				continue;
+			}
+			labelSentence(nbPulses, &samples[nbSamples]);
+			if (nbSamples % 2 == 0) {
+				train[nbTrain++] = &samples[nbSamples];
+			}
+			nbSamples++;
+		}
+		fclose(in);
+	}
+	
+	nbNodes = 1;
+	grow(train, nbTrain, 0, 0);
+	prune(0);
+	nbNodes = 0;
+	renumber(0, pruned, &nbNodes);
+	memcpy(tree, pruned, nbNodes * sizeof(*tree));
+	
+	// Evaluation on the odd sentences
+	for (i = 1; i < nbSamples; i += 2)
+	{
+		sample_t		*s = &samples[i];
+		decoderMask_t	mask = decoder_dispatchMask(s->features[ROUTER_FEATURE_NB_PULSES]);
+	
+	
+		labels = predict(s->features);
+		nbTest++;
+		fallbacks += (labels == ROUTER_ALL_LABELS);
+		if (s->labels & ~labels & ~ROUTER_LABEL_BIT(ROUTER_LABEL_NONE)) {
+			lost++;
+		}
+	
+		fullCalls	+= s->nbCalls;
+		routedTime	+= s->routeTime;
+		for (d = 0; d < NUM_DECODERS; d++)
+		{
+			if (!(mask & DECODER_BIT(d))) {
+				continue;
+			}
+			fullTime += s->callTime[d];
+			if (labels & ROUTER_LABEL_BIT(decoders[d].label))
+			{
+				routedCalls++;
+				routedTime += s->callTime[d];
+			}
+			else if (s->labels & ROUTER_LABEL_BIT(decoders[d].label))
+			{
+				lostBy[d]++;
+			}
+		}
+	}
+	
+	fprintf(stderr, "%lu sentences, %lu training, %lu test, %u nodes\n",
+		(unsigned long)nbSamples, (unsigned long)nbTrain, (unsigned long)nbTest, nbNodes);
+	fprintf(stderr, "test: %.2f%% routed to all their decoders, %.2f%% full dispatch fallbacks\n",
+		100.0 * (nbTest - lost) / nbTest, 100.0 * fallbacks / nbTest);
+	for (d = 0; d < NUM_DECODERS; d++)
+	{
+		if (lostBy[d] > 0) {
+			fprintf(stderr, "test: %s not called on %lu sentences it matches\n", decoders[d].name, (unsigned long)lostBy[d]);
+		}
+	}
+	fprintf(stderr, "test: decoder calls %.2f -> %.2f per sentence, decoding time %.1f -> %.1f us per sentence (router included)\n",
+		fullCalls / nbTest, routedCalls / nbTest, fullTime / nbTest / 1000, routedTime / nbTest / 1000);
+	
+	printf("#ifndef ROUTER_TREE_H\n#define ROUTER_TREE_H\n\n");
+	printf("#include \"router.h\"\n\n");
+	printf("/*\n * Decision tree of the decoder router: generated by tools/router_train.c, do\n * not edit.\n");
+	printf(" * Trained on %lu sentences, tested on %lu: %.2f%% routed to all their\n",
+		(unsigned long)nbTrain, (unsigned long)nbTest, 100.0 * (nbTest - lost) / nbTest);
+	printf(" * decoders, %.2f decoder calls per sentence instead of %.2f.\n */\n\n", routedCalls / nbTest, fullCalls / nbTest);
+	printf("//! Decoders the tree was trained with (see router.c)\n#define ROUTER_TREE_LABELS");
+	for (d = 0; d < NUM_DECODERS; d++) {
+		printf("%s\tROUTER_LABEL_BIT(ROUTER_LABEL_%s)", d == 0 ? " ( \\\n" : " | \\\n", decoders[d].name);
+	}
+	printf(")\n\n");
+	printf("static const routerNode_t routerTree[] = {\n");
+	for (i = 0; i < nbNodes; i++)
+	{
+		if (tree[i].feature == ROUTER_LEAF)
+		{
+			printf("\t/* %3lu */ { ROUTER_LEAF, 0, 0, ", (unsigned long)i);
+			printLabels(tree[i].value);
+			printf(" },\n");
+		}
+		else
+		{
+			printf("\t/* %3lu */ { %s, %d, %d, %d },\n", (unsigned long)i, featureNames[tree[i].feature],
+				tree[i].left, tree[i].right, tree[i].value);
+		}
+	}
+	printf("};\n\n\n#endif // ROUTER_TREE_H\n");
+	return 0;
+}
@@ -0,0 +1,236 @@
+/*******************************************************************************
+ * SIEMENS VDO WORST CASE BENCHMARK                                            *
+ *******************************************************************************
+ * Host tool: times the single-pass SiemensVdo decoder (see
+ * User/decoders/siemensVdo.c) on adversarial sentences of MAX_NUM_PULSES
+ * pulses, to check that its time stays linear before it is enabled.
+ *
+ * Each kind of sentence is built at random, then decoded TIMING_RUNS times, the
+ * fastest run being kept:
+ * 	- random:		pulse lens from 100 to 5000 us,
+ * 	- syncs:		sync lens only,
+ * 	- sync/short:	sync and short pulses, alternating,
+ * 	- sync pairs:	sync pairs each followed by one data pulse, then a pulse
+ * 					ending the frame (a restart every 4 pulses),
+ * 	- data only:	short and long pulses, without sync,
+ * 	- 41 bits:		frames of 41 bits, each one cut by a pulse of noise,
+ * 	- 64 bits:		complete frames.
+ * The frames of the last two kinds must all be decoded (records queued, merged
+ * or lost when the pool is full). Each kind is also timed on sentences of
+ * MAX_NUM_PULSES / 4 pulses: a linear decoder takes 4 times longer on the full
+ * sentences. The decoder it replaced is not timed: it does not end on random
+ * sentences.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o siemens_bench tools/siemens_bench.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	siemens_bench [-n <sentences>] [-s <seed>]
+ *
+ * Exits with 1 if a frame is missed, or if the time of a kind grows more than
+ * MAX_GROWTH times from the short to the full sentences.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "record.h"
+
+#define TIMING_RUNS			5
+
+//! Pulse lens (us): the middle of the decoder windows
+#define SIEMENS_SHORT		250
+#define SIEMENS_LONG		500
+#define SIEMENS_SYNC		2500
+#define SIEMENS_NOISE		1000	// In no window
+#define SYNC_MIN_LEN		1700
+#define SYNC_MAX_LEN		4000
+
+//! Time growth allowed from MAX_NUM_PULSES / 4 to MAX_NUM_PULSES pulses (4 when linear)
+#define MAX_GROWTH			6
+
+enum { RANDOM, SYNCS, SYNC_SHORT, SYNC_PAIRS, DATA_ONLY, FRAMES_41, FRAMES_64, NB_KINDS };
+
+static const char * const	kindNames[NB_KINDS] = {
+	"random", "syncs", "sync/short", "sync pairs", "data only", "41 bits", "64 bits"
+};
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+void output_send(char *message)
+{
+	(void)message;
+}
+
+static uint16_t		pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint16_t dataPulse(void)
+{
+	return (rand() & 1) ? SIEMENS_LONG : SIEMENS_SHORT;
+}
+
+/*!
+ * @brief Sentence of a kind
+ * @return Number of complete frames in it
+ */
+static uint16_t buildSentence(uint8_t kind, uint16_t nbPulses)
+{
+	uint16_t	i = 0, nbFrames = 0, frameLen = (kind == FRAMES_41 ? 41 : 64), b;
+	
+	
+	while (i < nbPulses)
+	{
+		switch (kind)
+		{
+			case RANDOM:
+				pulseLens[i++] = 100 + rand() % 4901;
+				break;
+			case SYNCS:
+				pulseLens[i++] = SYNC_MIN_LEN + 1 + rand() % (SYNC_MAX_LEN - SYNC_MIN_LEN - 1);
+				break;
+			case SYNC_SHORT:
+				pulseLens[i] = (i & 1) ? SIEMENS_SHORT : SIEMENS_SYNC;
+				i++;
+				break;
+			case SYNC_PAIRS:
+				pulseLens[i] = (i & 3) < 2 ? SIEMENS_SYNC : (i & 3) == 2 ? dataPulse() : SIEMENS_NOISE;
+				i++;
+				break;
+			case DATA_ONLY:
+				pulseLens[i++] = dataPulse();
+				break;
+			default:
+				// Frames, then a pulse of noise if cut, as long as they fit
+				if (i + 2 + frameLen + (kind == FRAMES_41) > nbPulses)
+				{
+					pulseLens[i++] = SIEMENS_NOISE;
+					break;
+				}
+				pulseLens[i++] = SIEMENS_SYNC;
+				pulseLens[i++] = SIEMENS_SYNC;
+				for (b = 0; b < frameLen; b++) {
+					pulseLens[i++] = dataPulse();
+				}
+				if (kind == FRAMES_41) {
+					pulseLens[i++] = SIEMENS_NOISE;
+				}
+				nbFrames++;
+				break;
+		}
+	}
+	return nbFrames;
+}
+
+/*!
+ * @brief Decode pulseLens
+ * @return Fastest run (ns)
+ */
+static double timeSentence(uint16_t nbPulses)
+{
+	double		t, t0, best = 1e12;
+	uint8_t		run;
+	
+	
+	for (run = 0; run < TIMING_RUNS; run++)
+	{
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		t0 = now();
+		decoder_siemensVdo.decoderFunc(work, nbPulses);
+		t = now() - t0;
+		if (t < best) {
+			best = t;
+		}
+		record_poll();
+	}
+	return best;
+}
+
+static uint32_t recordsEmitted(void)
+{
+	return recordStats.emitted + recordStats.merged + recordStats.lost;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t		nbSentences = 2000, n, nbFrames, nbDecoded, records;
+	uint8_t			kind, failed = 0;
+	unsigned int	seed = 1;
+	double			t, sum, shortSum, worst;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbSentences = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbSentences == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <sentences>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	printf("%lu sentences of %d pulses per kind, fastest of %d runs\n", (unsigned long)nbSentences, MAX_NUM_PULSES, TIMING_RUNS);
+	printf("Kind        | mean (us)  worst (us)  x from %d pulses | frames decoded\n", MAX_NUM_PULSES / 4);
+	for (kind = 0; kind < NB_KINDS; kind++)
+	{
+		sum = shortSum = worst = 0;
+		nbFrames = nbDecoded = 0;
+		for (n = 0; n < nbSentences; n++)
+		{
+			nbFrames += buildSentence(kind, MAX_NUM_PULSES);
+			records = recordsEmitted();
+			t = timeSentence(MAX_NUM_PULSES);
+			nbDecoded += (recordsEmitted() - records) / TIMING_RUNS;
+			sum += t;
+			if (t > worst) {
+				worst = t;
+			}
+	
+			buildSentence(kind, MAX_NUM_PULSES / 4);
+			shortSum += timeSentence(MAX_NUM_PULSES / 4);
+		}
+	
+		printf("%-11s | %9.2f  %10.2f  %16.2f |", kindNames[kind], sum / (1000.0 * nbSentences), worst / 1000.0, sum / shortSum);
+		if (kind == FRAMES_41 || kind == FRAMES_64) {
+			printf(" %lu / %lu", (unsigned long)nbDecoded, (unsigned long)nbFrames);
+		}
+		printf("\n");
+		if (nbDecoded < nbFrames || sum > MAX_GROWTH * shortSum) {
+			failed = 1;
+		}
+	}
+	
+	if (failed)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,404 @@
+/*******************************************************************************
+ * PWM TIMEBASE YIELD                                                          *
+ *******************************************************************************
+ * Host tool: measures how much of a transmitter clock error the PWM decoders
+ * take, now that the engine reads the pulses against the timebase given by the
+ * sync (see User/decoders/generic_pwm.h), against the decoders it replaced
+ * (see tools/pwm_legacy.c).
+ *
+ * Random frames of each protocol are sent in sentences of a few repeats, each
+ * one after its sync, with a last sync after them. For each scale, all the
+ * pulses of the sentence are multiplied by the scale, then moved by up to
+ * +/-JITTER % each. A sentence counts as decoded if the decoder prints the
+ * lines it prints for the same sentence, neither scaled nor moved. The former
+ * and the current decoder are each compared with their own lines, without the
+ * battery and press count of the CarKey1 lines, and without the pair length
+ * measured by RCswitch.
+ *
+ * Each scaled sentence is also given to all the other current decoders: any
+ * line they print is counted as a cross acceptance.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; this
+ * tool includes tools/pwm_legacy.c):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o timebase_yield tools/timebase_yield.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "default\|learner\|protocol_store\|router")
+ * Usage:	timebase_yield [-n <frames>] [-j <jitter>] [-s <seed>]
+ *
+ * Prints the decoded sentences (%, former / current) for each scale and
+ * protocol, and the cross acceptances. Exits with 1 if a current decoder
+ * decodes fewer sentences than the former one over all the scales, or at the
+ * nominal scale, or if a sentence is accepted by another decoder. At the other
+ * scales, the current one can lose a few sentences: the jitter of the syncs
+ * moves the timebase.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "main.h"
+#include "decoder.h"
+#include "combine.h"
+#include "record.h"
+
+//! Not in the decoder table: declared here for the legacy table
+extern const decoderDesc_t	decoder_UnknownTemp;
+
+#include "pwm_legacy.c"
+
+#define MAX_PRINTED_LEN		4096
+#define MAX_SEGMENTS		64
+#define MAX_SEGMENT_LEN		128
+#define MAX_FRAME_BITS		66
+
+//! Scales evaluated, in % of the nominal pulse lengths
+#define MIN_SCALE			75
+#define MAX_SCALE			125
+#define SCALE_STEP			5
+#define NB_SCALES			((MAX_SCALE - MIN_SCALE) / SCALE_STEP + 1)
+#define NOMINAL_SCALE		((100 - MIN_SCALE) / SCALE_STEP)	// Index of the 100 % scale
+
+/*!
+ * Sentence of a protocol, in the order of legacyDecoders. Each bit is sent as
+ * a pair of pulses: the second one gives the bit read by the former decoder,
+ * the first one is fixed, or makes up the pair length.
+ */
+typedef struct {
+	uint16_t	syncHigh, syncLow;
+	uint16_t	first;			// 0: pairLen - second pulse
+	uint16_t	pairLen;
+	uint16_t	zero, one;		// Second pulse of a 0 and of a 1
+	uint8_t		nbBits, nbFrames;
+	uint32_t	setBits, clearBits;	// Bits of the first 32 fixed by the protocol (bit i: sent i-th)
+} pwmSentence_t;
+
+static const pwmSentence_t	protocols[] = {
+	// Came432Na: prologue bit 1
+	{ 345,	15600,	0,		1020,	345,	675,	13,	4,	0x00000001,	0 },
+	// DIPswitch: reverted, prologue bit 0, epilogue bit 1
+	{ 710,	26000,	0,		2130,	1420,	710,	12,	4,	0x00000800,	0x00000001 },
+	// CarKey1: sync pair of 3 ms, the bits of the former decoder are inverted
+	{ 1000,	2000,	0,		1700,	1200,	500,	66,	3,	0,			0 },
+	// UnknownTemp
+	{ 500,	8600,	500,	0,		1950,	4050,	24,	3,	0,			0 },
+	// RCswitch: h = 350 us, sync (h, 31h), 1 = (3h, h)
+	{ 350,	10850,	0,		1400,	1050,	350,	24,	4,	0,			0 }
+};
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Text printed by the decoder being run
+static char			printed[MAX_PRINTED_LEN];
+static uint16_t		printedLen;
+
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	
+	
+	if (printedLen + len < MAX_PRINTED_LEN)
+	{
+		memcpy(printed + printedLen, message, len + 1);
+		printedLen += len;
+	}
+}
+
+//! Lines printed for a sentence, split and deduplicated
+typedef struct {
+	char		text[MAX_SEGMENTS][MAX_SEGMENT_LEN];
+	uint8_t		nbSegments;
+} segments_t;
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static uint16_t		nominal[MAX_NUM_PULSES], pulseLens[MAX_NUM_PULSES], work[MAX_NUM_PULSES];
+static uint32_t		legacyWork[MAX_NUM_PULSES];
+static segments_t	legacyReference, currentReference, segments;
+
+
+/*!
+ * @brief Nominal sentence of a random frame
+ * @return Number of pulses
+ */
+static uint16_t buildSentence(const pwmSentence_t *protocol)
+{
+	uint8_t		bits[MAX_FRAME_BITS], i, frame;
+	uint16_t	nbPulses = 0, second;
+	
+	
+	for (i = 0; i < protocol->nbBits; i++)
+	{
+		bits[i] = rand() & 1;
+		if (i < 32 && (protocol->setBits >> i) & 1) {
+			bits[i] = 1;
+		}
+		if (i < 32 && (protocol->clearBits >> i) & 1) {
+			bits[i] = 0;
+		}
+	}
+	
+	for (frame = 0; frame <= protocol->nbFrames; frame++)
+	{
+		nominal[nbPulses++] = protocol->syncHigh;
+		nominal[nbPulses++] = protocol->syncLow;
+		for (i = 0; frame < protocol->nbFrames && i < protocol->nbBits; i++)
+		{
+			second = bits[i] ? protocol->one : protocol->zero;
+			nominal[nbPulses++] = protocol->first ? protocol->first : protocol->pairLen - second;
+			nominal[nbPulses++] = second;
+		}
+	}
+	return nbPulses;
+}
+
+/*!
+ * @brief Scale the nominal sentence, and move each pulse by up to +/-jitter %
+ */
+static void scaleSentence(uint16_t nbPulses, uint16_t scale, uint16_t jitter)
+{
+	uint16_t	i;
+	int32_t		move;
+	
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		move = (jitter > 0 ? rand() % (2 * 100 * jitter + 1) - 100 * jitter : 0);
+		pulseLens[i] = (uint16_t)((uint64_t)nominal[i] * scale * (10000 + move) / 1000000);
+	}
+}
+
+/*!
+ * @brief Split the printed text in lines, and at each record of the decoder
+ *
+ * Some records do not end their line (DIP switch codes). See tools/pwm_engine_diff.c.
+ */
+static void splitPrinted(const char *name, segments_t *segments)
+{
+	char		*p = printed, *end, *next;
+	char		text[MAX_SEGMENT_LEN];
+	uint16_t	nameLen = strlen(name), len;
+	uint8_t		i;
+	
+	
+	segments->nbSegments = 0;
+	while (*p != '\0')
+	{
+		end = strchr(p, '\n');
+		if (end == NULL) {
+			end = p + strlen(p);
+		}
+		next = strstr(p + 1, name);
+		if (next != NULL && next < end && next[nameLen] != '\0' && strchr(",:", next[nameLen]) != NULL) {
+			end = next;
+		}
+	
+		len = end - p;
+		while (len > 0 && isspace((unsigned char)p[len - 1])) {
+			len--;
+		}
+		if (len >= MAX_SEGMENT_LEN) {
+			len = MAX_SEGMENT_LEN - 1;
+		}
+		memcpy(text, p, len);
+		text[len] = '\0';
+		p = (*end == '\n') ? end + 1 : end;
+		if (len == 0) {
+			continue;
+		}
+	
+		// The battery and press count of the KeeLoq lines change from press to press, the pair length with the scale
+		if (strncmp(text, "CarKey1,Serial=", strlen("CarKey1,Serial=")) == 0 && (next = strstr(text, ",LowBattery=")) != NULL) {
+			*next = '\0';
+		}
+		if (strncmp(text, "RCswitch,", strlen("RCswitch,")) == 0 && (next = strstr(text, ",PairLen=")) != NULL) {
+			*next = '\0';
+		}
+	
+		for (i = 0; i < segments->nbSegments && strcmp(segments->text[i], text) != 0; i++) {
+		}
+		if (i == segments->nbSegments && segments->nbSegments < MAX_SEGMENTS) {
+			strcpy(segments->text[segments->nbSegments++], text);
+		}
+	}
+}
+
+static uint8_t sameSegments(const segments_t *a, const segments_t *b)
+{
+	uint8_t		i, j;
+	
+	
+	if (a->nbSegments == 0 || a->nbSegments != b->nbSegments) {
+		return 0;
+	}
+	for (i = 0; i < a->nbSegments; i++)
+	{
+		for (j = 0; j < b->nbSegments && strcmp(a->text[i], b->text[j]) != 0; j++) {
+		}
+		if (j == b->nbSegments) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*!
+ * @brief Decode pulseLens with a former decoder
+ */
+static void runLegacy(uint8_t d, uint16_t nbPulses, segments_t *segments)
+{
+	uint16_t	i;
+	
+	
+	printedLen = 0;
+	printed[0] = '\0';
+	if (nbPulses > legacyDecoders[d].minNumPulses)
+	{
+		for (i = 0; i < nbPulses; i++) {
+			legacyWork[i] = pulseLens[i];
+		}
+		legacyDecoders[d].decoderFunc(legacyWork, nbPulses);
+	}
+	splitPrinted((const char *)legacyDecoders[d].current->name, segments);
+}
+
+/*!
+ * @brief Decode pulseLens with a current decoder
+ */
+static void runCurrent(const decoderDesc_t *decoder, uint16_t nbPulses, segments_t *segments)
+{
+	printedLen = 0;
+	printed[0] = '\0';
+	if (nbPulses > decoder->minNumPulses)
+	{
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		decoder->decoderFunc(work, nbPulses);
+		record_poll();
+	}
+	splitPrinted((const char *)decoder->name, segments);
+	
+	// Far enough apart not to be taken for repeats (KeeLoq presses)
+	sysTickTime += 1000000;
+}
+
+/*!
+ * @brief Give pulseLens to the current decoders other than the one of the protocol
+ * @return 1 if any of them printed a line
+ */
+static uint8_t crossAccepted(uint8_t d, uint16_t nbPulses)
+{
+	const decoderDesc_t	*other;
+	uint8_t				i;
+	
+	
+	for (i = 0; i <= NUM_DECODERS; i++)
+	{
+		other = (i < NUM_DECODERS ? decoders[i] : &decoder_UnknownTemp);
+		if (other == legacyDecoders[d].current) {
+			continue;
+		}
+		runCurrent(other, nbPulses, &segments);
+		if (printedLen > 0)
+		{
+			printf("%s sentence accepted by %s: %s", (const char *)legacyDecoders[d].current->name,
+				(const char *)other->name, printed);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static uint32_t	decoded[NB_SCALES][LEGACY_NB_DECODERS][2], total[LEGACY_NB_DECODERS][2];
+	uint32_t		nbFrames = 1000, n, nbCross = 0;
+	uint16_t		nbPulses, jitter = 5, scale;
+	uint8_t			d, s, failed = 0;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0 || jitter > 20)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter (%%, up to 20)>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	srand(seed);
+	for (d = 0; d < LEGACY_NB_DECODERS; d++)
+	{
+		for (n = 0; n < nbFrames; n++)
+		{
+			nbPulses = buildSentence(&protocols[d]);
+			scaleSentence(nbPulses, 100, 0);
+			runLegacy(d, nbPulses, &legacyReference);
+			runCurrent(legacyDecoders[d].current, nbPulses, &currentReference);
+	
+			for (s = 0; s < NB_SCALES; s++)
+			{
+				scaleSentence(nbPulses, MIN_SCALE + s * SCALE_STEP, jitter);
+				runLegacy(d, nbPulses, &segments);
+				decoded[s][d][0] += sameSegments(&legacyReference, &segments);
+				runCurrent(legacyDecoders[d].current, nbPulses, &segments);
+				decoded[s][d][1] += sameSegments(&currentReference, &segments);
+				nbCross += crossAccepted(d, nbPulses);
+			}
+		}
+	}
+	
+	printf("%lu sentences per scale and protocol, jitter +/-%d %%, decoded (%%) former / current\n",
+		(unsigned long)nbFrames, jitter);
+	printf("Scale |");
+	for (d = 0; d < LEGACY_NB_DECODERS; d++) {
+		printf(" %13s", (const char *)legacyDecoders[d].current->name);
+	}
+	printf("\n");
+	for (s = 0; s < NB_SCALES; s++)
+	{
+		scale = MIN_SCALE + s * SCALE_STEP;
+		printf(" %3d%% |", scale);
+		for (d = 0; d < LEGACY_NB_DECODERS; d++)
+		{
+			printf("   %5.1f/%5.1f", 100.0 * decoded[s][d][0] / nbFrames, 100.0 * decoded[s][d][1] / nbFrames);
+			total[d][0] += decoded[s][d][0];
+			total[d][1] += decoded[s][d][1];
+		}
+		printf("\n");
+	}
+	for (d = 0; d < LEGACY_NB_DECODERS; d++)
+	{
+		if (total[d][1] < total[d][0] || decoded[NOMINAL_SCALE][d][1] < decoded[NOMINAL_SCALE][d][0]) {
+			failed = 1;
+		}
+	}
+	printf("Cross acceptances: %lu\n", (unsigned long)nbCross);
+	
+	if (failed || nbCross > 0)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
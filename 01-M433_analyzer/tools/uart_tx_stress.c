@@ -0,0 +1,282 @@
+/*******************************************************************************
+ * UART TX RING STRESS TEST                                                    *
+ *******************************************************************************
+ * Host tool: pushes random messages through the UART TX ring (see
+ * User/uart_tx.h), built with UART_TX_PORTABLE: the DMA engine is a stand-in
+ * which ends its transfers at random points between the writes.
+ *
+ * The messages are 1 to MAX_MESSAGE_LEN random letters, a third of them
+ * ending a line. The traffic runs in phases of PHASE_LEN messages, each with
+ * its own drain rate, from a stalled DMA to one which keeps up, so that the
+ * ring fills and empties. A model of the ring follows the overflow policy:
+ * a message is queued if the ring has room for it (with UART_TX_OVERFLOW_WAIT:
+ * if it can ever fit) and the line it belongs to was not dropped, else it is
+ * dropped, and a line left open is closed by a '\n'. Checked:
+ * 	- each message queued or dropped as the model says,
+ * 	- the bytes of each transfer, when it completes, are the next bytes the
+ * 	  model expects: no byte lost, duplicated or overwritten while in flight,
+ * 	- a single transfer at a time, never empty,
+ * 	- the counters of uartTxStats, maxUsed included, and the bytes and calls
+ * 	  reported to the completion function,
+ * 	- the ring drained at the end.
+ *
+ * Build (from 01-M433_analyzer; add -DUART_TX_OVERFLOW_WAIT to check the
+ * waiting policy):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -DUART_TX_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o uart_tx_stress tools/uart_tx_stress.c User/uart_tx.c
+ * Usage:	uart_tx_stress [-n <messages>] [-s <seed>]
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "uart_tx.h"
+
+#ifndef UART_TX_PORTABLE
+	#error "Build with -DUART_TX_PORTABLE"
+#endif
+
+#define MAX_MESSAGE_LEN		1400
+#define PHASE_LEN			1000
+
+//! Chance (%) that the DMA ends a transfer, checked again after each one, per phase
+static const uint8_t		drainRates[] = { 0, 20, 50, 80, 95 };
+#define NB_DRAIN_RATES		(sizeof(drainRates) / sizeof(drainRates[0]))
+
+//! Transfer in progress, none if dmaLen is 0
+static const char			*dmaData;
+static uint16_t				dmaLen;
+static uint32_t				dmaErrors = 0;
+
+//! Model of the ring: the bytes queued and not sent yet
+static char					expected[UART_TX_RING_SIZE];
+static uint32_t				expectedHead = 0, expectedUsed = 0, expectedMaxUsed = 0;
+static char					lastQueued = '\n';
+
+//! Bytes sent, and the ones which differ from the model
+static uint64_t				wireBytes = 0, wireErrors = 0;
+static uint32_t				nbTransfers = 0;
+
+//! Reported to the completion function
+static uint64_t				completedBytes = 0;
+static uint32_t				completedCalls = 0;
+
+static uint32_t				nbErrors = 0, nbChecks = 0;
+
+
+void uartTx_fakeDmaStart(const char *data, uint16_t len)
+{
+	if (dmaLen != 0 || len == 0) {
+		dmaErrors++;
+	}
+	dmaData	= data;
+	dmaLen	= len;
+}
+
+/*!
+ * @brief End the transfer in progress: its bytes go on the wire
+ * @return 0 if the DMA was idle
+ */
+static uint8_t dmaComplete(void)
+{
+	uint32_t	tail;
+	uint16_t	i;
+	
+	
+	if (dmaLen == 0) {
+		return 0;
+	}
+	
+	if (dmaLen > expectedUsed) {
+		wireErrors += dmaLen;
+	}
+	tail = (expectedHead + UART_TX_RING_SIZE - expectedUsed) % UART_TX_RING_SIZE;
+	for (i = 0; i < dmaLen && i < expectedUsed; i++) {
+		wireErrors += (dmaData[i] != expected[(tail + i) % UART_TX_RING_SIZE]);
+	}
+	expectedUsed -= (dmaLen < expectedUsed ? dmaLen : expectedUsed);
+	wireBytes += dmaLen;
+	nbTransfers++;
+	
+	dmaLen = 0;
+	uartTx_complete();
+	return 1;
+}
+
+void uartTx_fakeDmaWait(void)
+{
+	if (!dmaComplete())
+	{
+		// Nothing would ever make room
+		printf("Failed: waiting for room with the DMA idle\nFAILED\n");
+		exit(1);
+	}
+}
+
+static void onComplete(uint16_t len)
+{
+	completedBytes += len;
+	completedCalls++;
+}
+
+static void check(uint32_t ok, const char *what)
+{
+	nbChecks++;
+	if (!ok && nbErrors++ < 20) {
+		printf("Failed: %s\n", what);
+	}
+}
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Append bytes to the model of the ring
+ */
+static void expect(const char *data, uint16_t len)
+{
+	uint16_t	i;
+	
+	
+	for (i = 0; i < len; i++)
+	{
+		expected[expectedHead] = data[i];
+		expectedHead = (expectedHead + 1) % UART_TX_RING_SIZE;
+	}
+	expectedUsed += len;
+	if (expectedUsed > expectedMaxUsed) {
+		expectedMaxUsed = expectedUsed;
+	}
+	lastQueued = data[len - 1];
+}
+
+/*!
+ * @brief Random message: letters, and a third of them end a line
+ */
+static uint16_t randomMessage(char *message)
+{
+	uint16_t	len, i;
+	
+	
+	len = (rand() % 4 == 0 ? 1 + rand() % MAX_MESSAGE_LEN : 1 + rand() % 80);
+	for (i = 0; i < len; i++) {
+		message[i] = 'A' + rand() % 26;
+	}
+	if (rand() % 3 == 0) {
+		message[len - 1] = '\n';
+	}
+	return len;
+}
+
+int main(int argc, char **argv)
+{
+	static char		message[MAX_MESSAGE_LEN];
+	uint32_t		nbMessages = 2000000, n, queued = 0, dropped = 0, policyErrors = 0;
+	uint64_t		queuedBytes = 0, droppedBytes = 0;
+	uint16_t		len;
+	uint8_t			drainRate = 0, dropping = 0, accept;
+	unsigned int	seed = 1;
+	double			t0;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbMessages = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbMessages == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <messages>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	srand(seed);
+	memset(&uartTxStats, 0, sizeof(uartTxStats));
+	uartTx_init();
+	uartTx_setCompleteFunc(onComplete);
+	
+	t0 = now();
+	for (n = 0; n < nbMessages; n++)
+	{
+		if (n % PHASE_LEN == 0) {
+			drainRate = drainRates[rand() % NB_DRAIN_RATES];
+		}
+		len = randomMessage(message);
+	
+		// Policy: the ring has one byte always empty, and one kept to close a line
+#ifdef UART_TX_OVERFLOW_WAIT
+		accept = (!dropping && len <= UART_TX_RING_SIZE - 2);
+#else
+		accept = (!dropping && len + expectedUsed <= UART_TX_RING_SIZE - 2);
+#endif
+		policyErrors += (uartTx_write(message, len) != accept);
+		if (accept)
+		{
+			expect(message, len);
+			queued++;
+			queuedBytes += len;
+		}
+		else
+		{
+			if (lastQueued != '\n') {
+				expect("\n", 1);
+			}
+			dropping = (message[len - 1] != '\n');
+			dropped++;
+			droppedBytes += len;
+		}
+	
+		while ((uint8_t)(rand() % 100) < drainRate && dmaComplete());
+	}
+	while (dmaComplete());
+	
+	printf("%lu messages of 1 to %d bytes, ring of %d bytes%s: %lu dropped (%.2f%%), %lu transfers, max used %d\n",
+		(unsigned long)nbMessages, MAX_MESSAGE_LEN, UART_TX_RING_SIZE,
+#ifdef UART_TX_OVERFLOW_WAIT
+		" (waiting for room)",
+#else
+		"",
+#endif
+		(unsigned long)dropped, 100.0 * dropped / nbMessages, (unsigned long)nbTransfers, uartTxStats.maxUsed);
+	printf("Host time: %.0f ns per message, DMA stand-in included\n", (now() - t0) / nbMessages);
+	
+	check(policyErrors == 0, "Messages queued or dropped as the policy says");
+	check(wireErrors == 0, "Bytes sent in order, none lost or overwritten");
+	check(dmaErrors == 0, "One transfer at a time, never empty");
+	check(expectedUsed == 0 && dmaLen == 0, "Ring drained");
+	check(uartTxStats.messages == queued && uartTxStats.bytes == (uint32_t)queuedBytes, "Counters: messages and bytes queued");
+	check(uartTxStats.dropped == dropped && uartTxStats.droppedBytes == (uint32_t)droppedBytes, "Counters: dropped");
+	check(uartTxStats.transfers == nbTransfers && uartTxStats.maxUsed == expectedMaxUsed, "Counters: transfers and max used");
+	check(completedCalls == nbTransfers && completedBytes == wireBytes, "Completion function: calls and bytes");
+#ifdef UART_TX_OVERFLOW_WAIT
+	check(dropped == 0, "Waiting for room: every message fits, none dropped");
+#endif
+	
+	printf("%lu checks, %lu errors\n", (unsigned long)nbChecks, (unsigned long)nbErrors);
+	if (nbErrors)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}
@@ -0,0 +1,310 @@
+/*******************************************************************************
+ * X10 DEFAULT PATH CHECK                                                      *
+ *******************************************************************************
+ * Host tool: measures the output and the time of the default decoder (see
+ * User/decoders/default.c) the X10 decoder (see User/decoders/x10rf.c) saves
+ * on X10 traffic.
+ *
+ * Random X10 frames (unit on/off and house commands) are sent in sentences of
+ * X10_REPEATS copies, with the timebase of each sentence scaled by 0.85 to
+ * 1.15 and each pulse moved by up to +/-JITTER us. Each sentence is decoded as
+ * processSentence() does (decoders, then the default decoder if none matched,
+ * then the records), twice:
+ * 	- without the X10 decoder, as before it: the sentence goes to the default
+ * 	  decoder,
+ * 	- with it: the line of the frame must be printed.
+ * The output and the time of the default decoder (with the printing of its
+ * records) are measured apart. The
+ * decoders keep state from a sentence to the next (learned protocols): each
+ * pass runs in a child process, which starts from the same state.
+ *
+ * The default decoder of the build is measured: the learner, or with
+ * -DRAW_DUMP_ONLY (USE_LEARNER undefined, see defines.h) the raw pulse dump
+ * X10 traffic used to fall through to.
+ *
+ * Build (from 01-M433_analyzer, with the sources of the enabled decoders; add
+ * -DRAW_DUMP_ONLY to measure the raw dump):
+ * 		D=../00-STM32F4xx_STANDARD_PERIPHERAL_DRIVERS
+ * 		gcc -O2 -DSTM32F40_41xxx -DUSE_STDPERIPH_DRIVER -DTM_DISCO_STM32F4_DISCOVERY \
+ * 			-DPULSE_SIMD_PORTABLE -DBITVEC_PORTABLE -IUser -IUser/decoders \
+ * 			-I../00-STM32F429_LIBRARIES -I$D/STM32F4xx_StdPeriph_Driver/inc \
+ * 			-I$D/CMSIS/Device/ST/STM32F4xx/Include -I$D/CMSIS/Include \
+ * 			-o x10_dump tools/x10_dump.c \
+ * 			$(ls User/decoders/[a-z]*.c | grep -v "protocol_store\|router")
+ * Usage:	x10_dump [-n <frames>] [-j <jitter>] [-s <seed>]
+ *
+ * Exits with 1 if the X10 decoder misses a frame, if the default decoder
+ * prints more with it than without it, if no output is avoided, or if the
+ * default decoder reports a sentence without printing it (or the other way
+ * round).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "main.h"
+#include "record.h"
+
+#define X10_SYNC_HIGH		8800	// us
+#define X10_SYNC_LOW		4400
+#define X10_SHORT			550
+#define X10_LONG			1650
+#define X10_GAP				40000
+#define X10_REPEATS			5
+#define X10_MAX_LINE_LEN	64
+#define MAX_SENTENCE_LEN	(X10_REPEATS * (2 + 2 * 32 + 2))
+
+//! Timebase scales (%)
+#define MIN_SCALE			85
+#define MAX_SCALE			115
+
+//! Results of a pass
+typedef struct {
+	double		time;				// Decoding time (ns), all of it and the default decoder's
+	double		defaultTime;
+	uint32_t	defaultCalls;
+	uint32_t	defaultLen;			// Output of the default decoder
+	uint32_t	defaultLines;
+	uint32_t	defaultSilent;		// Default calls whose result doesn't match their output
+	uint32_t	decoded;			// Sentences with the line of their frame
+} passResult_t;
+
+// Stubs of the target modules used by the decoders
+char				UartBuffer[BUFFER_LEN];
+uint16_t			UartBufSz;
+volatile uint32_t	sysTickTime = 0;
+
+//! Text printed for the sentence being decoded
+static char			printed[4096];
+static uint16_t		printedLen;
+
+void output_send(char *message)
+{
+	uint16_t	len = strlen(message);
+	
+	
+	if (printedLen + len < sizeof(printed))
+	{
+		memcpy(printed + printedLen, message, len + 1);
+		printedLen += len;
+	}
+}
+
+uint16_t	decode_default(uint16_t *pulseLens, uint16_t nbPulses);
+
+static const decoderDesc_t * const	decoders[NUM_DECODERS] = {
+	DECODER_TABLE(DECODER_ADDRESS)
+};
+
+static uint16_t		pulseLens[MAX_SENTENCE_LEN], work[MAX_SENTENCE_LEN];
+static char			frameLine[X10_MAX_LINE_LEN];
+
+
+static double now(void)
+{
+	struct timespec	t;
+	
+	
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*!
+ * @brief Sentence of a random frame, and its line in frameLine
+ * @return Number of pulses
+ */
+static uint16_t buildSentence(uint16_t jitter)
+{
+	static const char	houseCodes[16] = "MNOPCDABEFGHKLIJ";
+	static const struct {
+		uint8_t		code;
+		const char	*name;
+	} commands[] = { { 0x80, "AllUnitsOff" }, { 0x90, "AllLightsOn" }, { 0x88, "Bright" }, { 0x98, "Dim" } };
+	uint8_t		house = rand() & 0xF, unit = rand() & 0xF, off = rand() & 1, b0, b2, r;
+	uint16_t	nbPulses = 0, i, scale = MIN_SCALE + rand() % (MAX_SCALE - MIN_SCALE + 1);
+	uint32_t	data;
+	int32_t		len;
+	
+	
+	b0 = (house << 4) | ((unit & 0x8) ? 0x04 : 0);
+	if (rand() % 4 == 0)
+	{
+		i = rand() % 4;
+		b2 = commands[i].code;
+		snprintf(frameLine, X10_MAX_LINE_LEN, "X10,House=%c,Cmd=%s\n", houseCodes[house], commands[i].name);
+	}
+	else
+	{
+		b2 = ((unit & 0x4) ? 0x40 : 0) | (off ? 0x20 : 0) | ((unit & 0x1) ? 0x10 : 0) | ((unit & 0x2) ? 0x08 : 0);
+		snprintf(frameLine, X10_MAX_LINE_LEN, "X10,House=%c,Unit=%d,Cmd=%s\n", houseCodes[house], unit + 1, off ? "Off" : "On");
+	}
+	data = ((uint32_t)b0 << 24) | ((uint32_t)(b0 ^ 0xFF) << 16) | ((uint32_t)b2 << 8) | (b2 ^ 0xFF);
+	
+	for (r = 0; r < X10_REPEATS; r++)
+	{
+		pulseLens[nbPulses++] = X10_SYNC_HIGH;
+		pulseLens[nbPulses++] = X10_SYNC_LOW;
+		for (i = 0; i < 32; i++)
+		{
+			pulseLens[nbPulses++] = X10_SHORT;
+			pulseLens[nbPulses++] = ((data >> (31 - i)) & 1) ? X10_LONG : X10_SHORT;
+		}
+		pulseLens[nbPulses++] = X10_SHORT;
+		pulseLens[nbPulses++] = X10_GAP;
+	}
+	
+	for (i = 0; i < nbPulses; i++)
+	{
+		len = (int32_t)pulseLens[i] * scale / 100 + (jitter > 0 ? rand() % (2 * jitter + 1) - jitter : 0);
+		pulseLens[i] = (uint16_t)(len < 1 ? 1 : len > 0xFFFF ? 0xFFFF : len);
+	}
+	return nbPulses;
+}
+
+/*!
+ * @brief Decode a sentence as processSentence() does
+ */
+static void decodeSentence(uint16_t nbPulses, uint8_t useX10, passResult_t *result)
+{
+	decoderMask_t	mask = decoder_dispatchMask(nbPulses);
+	uint16_t		decoded = 0, start, reported = 0, c;
+	uint8_t			i;
+	double			t0, t1;
+	
+	
+	printedLen = 0;
+	printed[0] = '\0';
+	t0 = now();
+	for (i = 0; i < NUM_DECODERS; i++)
+	{
+		if ((mask & DECODER_BIT(i)) && (useX10 || decoders[i] != &decoder_X10Rf))
+		{
+			memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+			decoded += decoders[i]->decoderFunc(work, nbPulses);
+		}
+	}
+	record_poll();
+	start = printedLen;
+	if (decoded == 0)
+	{
+		t1 = now();
+		memcpy(work, pulseLens, nbPulses * sizeof(pulseLens[0]));
+		reported = decode_default(work, nbPulses);
+		record_poll();
+		result->defaultTime += now() - t1;
+		result->defaultCalls++;
+		result->defaultSilent += ((reported != 0) != (printedLen != start));
+	}
+	result->time += now() - t0;
+	
+	// The records of the default decoder, printed after the others'
+	result->defaultLen += printedLen - start;
+	for (c = start; c < printedLen; c++) {
+		result->defaultLines += (printed[c] == '\n');
+	}
+	result->decoded += (strstr(printed, frameLine) != NULL);
+}
+
+/*!
+ * @brief Decode all the frames, in a child process
+ */
+static void runPass(uint32_t nbFrames, uint16_t jitter, unsigned int seed, uint8_t useX10, passResult_t *result)
+{
+	FILE		*file = tmpfile();
+	uint32_t	n;
+	uint16_t	nbPulses;
+	pid_t		pid;
+	
+	
+	memset(result, 0, sizeof(*result));
+	if (file == NULL || (pid = fork()) < 0)
+	{
+		perror("x10_dump");
+		exit(1);
+	}
+	if (pid == 0)
+	{
+		srand(seed);
+		for (n = 0; n < nbFrames; n++)
+		{
+			nbPulses = buildSentence(jitter);
+			decodeSentence(nbPulses, useX10, result);
+		}
+		fwrite(result, sizeof(*result), 1, file);
+		fflush(file);
+		exit(0);
+	}
+	waitpid(pid, NULL, 0);
+	rewind(file);
+	if (fread(result, sizeof(*result), 1, file) != 1)
+	{
+		fprintf(stderr, "Pass failed\n");
+		exit(1);
+	}
+	fclose(file);
+}
+
+int main(int argc, char **argv)
+{
+	passResult_t	results[2];
+	uint32_t		nbFrames = 10000;
+	uint16_t		jitter = 20;
+	uint8_t			p;
+	unsigned int	seed = 1;
+	int				a;
+	
+	
+	for (a = 1; a + 1 < argc; a += 2)
+	{
+		if (strcmp(argv[a], "-n") == 0) {
+			nbFrames = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-j") == 0) {
+			jitter = atoi(argv[a + 1]);
+		} else if (strcmp(argv[a], "-s") == 0) {
+			seed = atoi(argv[a + 1]);
+		} else {
+			break;
+		}
+	}
+	if (a < argc || nbFrames == 0)
+	{
+		fprintf(stderr, "Usage: %s [-n <frames>] [-j <jitter>] [-s <seed>]\n", argv[0]);
+		return 1;
+	}
+	
+	runPass(nbFrames, jitter, seed, 0, &results[0]);
+	runPass(nbFrames, jitter, seed, 1, &results[1]);
+	
+	printf("%lu X10 sentences of %d frames, timebase %d-%d%%, jitter +/-%d us, default decoder: %s\n", (unsigned long)nbFrames,
+		X10_REPEATS, MIN_SCALE, MAX_SCALE, jitter,
+#ifdef USE_LEARNER
+		"learner"
+#else
+		"raw dump"
+#endif
+	);
+	printf("X10 decoder | decoded  default calls  default output (bytes, lines)  host time (us/sentence, default)\n");
+	for (p = 0; p < 2; p++)
+	{
+		printf("%-11s | %7lu  %13lu  %14lu %8lu  %22.2f %8.2f\n", p ? "with" : "without", (unsigned long)results[p].decoded,
+			(unsigned long)results[p].defaultCalls, (unsigned long)results[p].defaultLen, (unsigned long)results[p].defaultLines,
+			results[p].time / (1000.0 * nbFrames), results[p].defaultTime / (1000.0 * nbFrames));
+	}
+	printf("Default output avoided: %lu bytes (%.1f per sentence)\n",
+		(unsigned long)(results[0].defaultLen - results[1].defaultLen), (double)(results[0].defaultLen - results[1].defaultLen) / nbFrames);
+	
+	printf("Default calls reporting without printing, or the other way round: %lu\n",
+		(unsigned long)(results[0].defaultSilent + results[1].defaultSilent));
+	
+	if (results[1].decoded != nbFrames || results[1].defaultLen >= results[0].defaultLen ||
+		results[0].defaultSilent != 0 || results[1].defaultSilent != 0)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}